@@ -0,0 +1,382 @@
+// Created on: 2025-04-14
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_AnalyticSurface.hxx>
+
+#include <Adaptor3d_Surface.hxx>
+#include <ElCLib.hxx>
+#include <ElSLib.hxx>
+#include <Precision.hxx>
+#include <gp_Cone.hxx>
+#include <gp_Cylinder.hxx>
+#include <gp_Pln.hxx>
+#include <gp_Sphere.hxx>
+#include <gp_Torus.hxx>
+#include <math_DirectPolynomialRoots.hxx>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+//! Real roots of theA * s^2 + theB * s + theC = 0. The root of smaller magnitude is
+//! derived from the larger one (c / q) to avoid cancellation, so that a root close to
+//! zero keeps its relative precision.
+Standard_Integer SolveQuadratic(const Standard_Real theA,
+                                const Standard_Real theB,
+                                const Standard_Real theC,
+                                Standard_Real       theRoots[2])
+{
+  if (std::abs(theA) < 1.0e-12)
+  {
+    // Ray parallel to the axis of a cylinder or to a generatrix of a cone
+    if (std::abs(theB) < 1.0e-12)
+      return 0;
+    theRoots[0] = -theC / theB;
+    return 1;
+  }
+
+  const Standard_Real aDisc = theB * theB - 4.0 * theA * theC;
+  if (aDisc < 0.0)
+    return 0;
+
+  const Standard_Real aQ = -0.5 * (theB + std::copysign(std::sqrt(aDisc), theB));
+  theRoots[0]            = aQ / theA;
+  theRoots[1]            = aQ != 0.0 ? theC / aQ : theRoots[0];
+  return 2;
+}
+
+//! Real roots of s^4 + theB * s^3 + theC * s^2 + theD * s + theE = 0, polished by
+//! Newton steps on the polynomial
+Standard_Integer SolveQuartic(const Standard_Real theB,
+                              const Standard_Real theC,
+                              const Standard_Real theD,
+                              const Standard_Real theE,
+                              Standard_Real       theRoots[4])
+{
+  math_DirectPolynomialRoots aSolver(1.0, theB, theC, theD, theE);
+  if (!aSolver.IsDone() || aSolver.InfiniteRoots())
+    return 0;
+
+  const Standard_Integer aNbRoots = aSolver.NbSolutions();
+  for (Standard_Integer i = 0; i < aNbRoots; ++i)
+  {
+    Standard_Real aRoot = aSolver.Value(i + 1);
+    for (int aStep = 0; aStep < 2; ++aStep)
+    {
+      const Standard_Real aValue = (((aRoot + theB) * aRoot + theC) * aRoot + theD) * aRoot + theE;
+      const Standard_Real aDeriv =
+        ((4.0 * aRoot + 3.0 * theB) * aRoot + 2.0 * theC) * aRoot + theD;
+      if (aDeriv == 0.0)
+        break;
+      aRoot -= aValue / aDeriv;
+    }
+    theRoots[i] = aRoot;
+  }
+  return aNbRoots;
+}
+} // namespace
+
+//=================================================================================================
+
+void BRepIntCurveSurface_AnalyticSurface::Init(const Adaptor3d_Surface& theSurface)
+{
+  myType = theSurface.GetType();
+  switch (myType)
+  {
+    case GeomAbs_Plane:
+      myPosition = theSurface.Plane().Position();
+      break;
+    case GeomAbs_Cylinder: {
+      const gp_Cylinder aCylinder = theSurface.Cylinder();
+      myPosition                  = aCylinder.Position();
+      myRadius                    = aCylinder.Radius();
+      break;
+    }
+    case GeomAbs_Cone: {
+      const gp_Cone aCone = theSurface.Cone();
+      myPosition          = aCone.Position();
+      myRadius            = aCone.RefRadius();
+      mySemiAngle         = aCone.SemiAngle();
+      break;
+    }
+    case GeomAbs_Sphere: {
+      const gp_Sphere aSphere = theSurface.Sphere();
+      myPosition              = aSphere.Position();
+      myRadius                = aSphere.Radius();
+      break;
+    }
+    case GeomAbs_Torus: {
+      const gp_Torus aTorus = theSurface.Torus();
+      myPosition            = aTorus.Position();
+      myRadius              = aTorus.MajorRadius();
+      myMinorRadius         = aTorus.MinorRadius();
+      break;
+    }
+    default:
+      myType = GeomAbs_OtherSurface;
+      return;
+  }
+
+  myUMin = theSurface.FirstUParameter();
+  myUMax = theSurface.LastUParameter();
+  myVMin = theSurface.FirstVParameter();
+  myVMax = theSurface.LastVParameter();
+}
+
+//=================================================================================================
+
+Standard_Boolean BRepIntCurveSurface_AnalyticSurface::Intersect(const gp_Pnt&       theOrigin,
+                                                                const gp_Dir&       theDir,
+                                                                const Standard_Real theHintT,
+                                                                Standard_Real&      theU,
+                                                                Standard_Real&      theV,
+                                                                Standard_Real&      theT,
+                                                                gp_Pnt&             thePnt) const
+{
+  if (!IsElementary())
+    return Standard_False;
+
+  // Ray from the tessellation hit (s = t - theHintT) in the frame of the surface
+  const gp_Pnt        aStart = theOrigin.Translated(theHintT * gp_Vec(theDir));
+  const gp_Vec        aP(myPosition.Location(), aStart);
+  const Standard_Real px = aP.Dot(gp_Vec(myPosition.XDirection()));
+  const Standard_Real py = aP.Dot(gp_Vec(myPosition.YDirection()));
+  const Standard_Real pz = aP.Dot(gp_Vec(myPosition.Direction()));
+  const Standard_Real dx = theDir.Dot(myPosition.XDirection());
+  const Standard_Real dy = theDir.Dot(myPosition.YDirection());
+  const Standard_Real dz = theDir.Dot(myPosition.Direction());
+
+  Standard_Real    aRoots[4];
+  Standard_Integer aNbRoots = 0;
+  switch (myType)
+  {
+    case GeomAbs_Plane:
+      if (std::abs(dz) > Precision::Angular())
+      {
+        aRoots[0] = -pz / dz;
+        aNbRoots  = 1;
+      }
+      break;
+    case GeomAbs_Cylinder:
+      aNbRoots = SolveQuadratic(dx * dx + dy * dy,
+                                2.0 * (px * dx + py * dy),
+                                px * px + py * py - myRadius * myRadius,
+                                aRoots);
+      break;
+    case GeomAbs_Cone: {
+      // Radius R + z * tan(angle) at the start and its rate along the ray
+      const Standard_Real aTan = std::tan(mySemiAngle);
+      const Standard_Real aR   = myRadius + pz * aTan;
+      const Standard_Real aDR  = dz * aTan;
+
+      aNbRoots = SolveQuadratic(dx * dx + dy * dy - aDR * aDR,
+                                2.0 * (px * dx + py * dy - aR * aDR),
+                                px * px + py * py - aR * aR,
+                                aRoots);
+
+      // Discard the roots on the opposite nappe
+      Standard_Integer aNbKept = 0;
+      for (Standard_Integer i = 0; i < aNbRoots; ++i)
+      {
+        if (aR + aRoots[i] * aDR >= -Precision::Confusion())
+          aRoots[aNbKept++] = aRoots[i];
+      }
+      aNbRoots = aNbKept;
+      break;
+    }
+    case GeomAbs_Sphere:
+      aNbRoots = SolveQuadratic(1.0,
+                                2.0 * (px * dx + py * dy + pz * dz),
+                                px * px + py * py + pz * pz - myRadius * myRadius,
+                                aRoots);
+      break;
+    case GeomAbs_Torus: {
+      // (|p|^2 + R^2 - r^2)^2 = 4 R^2 (x^2 + y^2) along the ray
+      const Standard_Real aR2 = myRadius * myRadius;
+      const Standard_Real aG  = px * dx + py * dy + pz * dz;
+      const Standard_Real aK  = px * px + py * py + pz * pz + aR2 - myMinorRadius * myMinorRadius;
+
+      aNbRoots = SolveQuartic(4.0 * aG,
+                              4.0 * aG * aG + 2.0 * aK - 4.0 * aR2 * (dx * dx + dy * dy),
+                              4.0 * aG * aK - 8.0 * aR2 * (px * dx + py * dy),
+                              aK * aK - 4.0 * aR2 * (px * px + py * py),
+                              aRoots);
+      break;
+    }
+    default:
+      break;
+  }
+  if (aNbRoots == 0)
+    return Standard_False;
+
+  // The tessellation hit lies next to the intersection it approximates
+  Standard_Real aS = aRoots[0];
+  for (Standard_Integer i = 1; i < aNbRoots; ++i)
+  {
+    if (std::abs(aRoots[i]) < std::abs(aS))
+      aS = aRoots[i];
+  }
+
+  const gp_Pnt  aPnt = aStart.Translated(aS * gp_Vec(theDir));
+  Standard_Real aU = 0.0, aV = 0.0;
+  switch (myType)
+  {
+    case GeomAbs_Plane:
+      ElSLib::PlaneParameters(myPosition, aPnt, aU, aV);
+      break;
+    case GeomAbs_Cylinder:
+      ElSLib::CylinderParameters(myPosition, myRadius, aPnt, aU, aV);
+      break;
+    case GeomAbs_Cone:
+      ElSLib::ConeParameters(myPosition, myRadius, mySemiAngle, aPnt, aU, aV);
+      break;
+    case GeomAbs_Sphere:
+      ElSLib::SphereParameters(myPosition, myRadius, aPnt, aU, aV);
+      break;
+    default:
+      ElSLib::TorusParameters(myPosition, myRadius, myMinorRadius, aPnt, aU, aV);
+      break;
+  }
+  if (!toFaceBounds(aU, aV))
+    return Standard_False;
+
+  theU   = aU;
+  theV   = aV;
+  theT   = theHintT + aS;
+  thePnt = aPnt;
+  return Standard_True;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_AnalyticSurface::D1(const Standard_Real theU,
+                                             const Standard_Real theV,
+                                             gp_Pnt&             thePnt,
+                                             gp_Vec&             theD1U,
+                                             gp_Vec&             theD1V) const
+{
+  switch (myType)
+  {
+    case GeomAbs_Plane:
+      ElSLib::PlaneD1(theU, theV, myPosition, thePnt, theD1U, theD1V);
+      break;
+    case GeomAbs_Cylinder:
+      ElSLib::CylinderD1(theU, theV, myPosition, myRadius, thePnt, theD1U, theD1V);
+      break;
+    case GeomAbs_Cone:
+      ElSLib::ConeD1(theU, theV, myPosition, myRadius, mySemiAngle, thePnt, theD1U, theD1V);
+      break;
+    case GeomAbs_Sphere:
+      ElSLib::SphereD1(theU, theV, myPosition, myRadius, thePnt, theD1U, theD1V);
+      break;
+    default:
+      ElSLib::TorusD1(theU, theV, myPosition, myRadius, myMinorRadius, thePnt, theD1U, theD1V);
+      break;
+  }
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_AnalyticSurface::D2(const Standard_Real theU,
+                                             const Standard_Real theV,
+                                             gp_Pnt&             thePnt,
+                                             gp_Vec&             theD1U,
+                                             gp_Vec&             theD1V,
+                                             gp_Vec&             theD2U,
+                                             gp_Vec&             theD2V,
+                                             gp_Vec&             theD2UV) const
+{
+  switch (myType)
+  {
+    case GeomAbs_Plane:
+      ElSLib::PlaneD1(theU, theV, myPosition, thePnt, theD1U, theD1V);
+      theD2U.SetCoord(0.0, 0.0, 0.0);
+      theD2V.SetCoord(0.0, 0.0, 0.0);
+      theD2UV.SetCoord(0.0, 0.0, 0.0);
+      break;
+    case GeomAbs_Cylinder:
+      ElSLib::CylinderD2(theU,
+                         theV,
+                         myPosition,
+                         myRadius,
+                         thePnt,
+                         theD1U,
+                         theD1V,
+                         theD2U,
+                         theD2V,
+                         theD2UV);
+      break;
+    case GeomAbs_Cone:
+      ElSLib::ConeD2(theU,
+                     theV,
+                     myPosition,
+                     myRadius,
+                     mySemiAngle,
+                     thePnt,
+                     theD1U,
+                     theD1V,
+                     theD2U,
+                     theD2V,
+                     theD2UV);
+      break;
+    case GeomAbs_Sphere:
+      ElSLib::SphereD2(theU,
+                       theV,
+                       myPosition,
+                       myRadius,
+                       thePnt,
+                       theD1U,
+                       theD1V,
+                       theD2U,
+                       theD2V,
+                       theD2UV);
+      break;
+    default:
+      ElSLib::TorusD2(theU,
+                      theV,
+                      myPosition,
+                      myRadius,
+                      myMinorRadius,
+                      thePnt,
+                      theD1U,
+                      theD1V,
+                      theD2U,
+                      theD2V,
+                      theD2UV);
+      break;
+  }
+}
+
+//=================================================================================================
+
+Standard_Boolean BRepIntCurveSurface_AnalyticSurface::toFaceBounds(Standard_Real& theU,
+                                                                   Standard_Real& theV) const
+{
+  // ElSLib returns angles in [0, 2*PI); faces may start anywhere in the period
+  const Standard_Real aTol = Precision::PConfusion();
+  if (myType != GeomAbs_Plane)
+    theU = ElCLib::InPeriod(theU, myUMin - aTol, myUMin - aTol + 2.0 * M_PI);
+  if (myType == GeomAbs_Torus)
+    theV = ElCLib::InPeriod(theV, myVMin - aTol, myVMin - aTol + 2.0 * M_PI);
+
+  if (theU < myUMin - aTol || theU > myUMax + aTol || theV < myVMin - aTol
+      || theV > myVMax + aTol)
+    return Standard_False;
+
+  theU = std::max(myUMin, std::min(myUMax, theU));
+  theV = std::max(myVMin, std::min(myVMax, theV));
+  return Standard_True;
+}
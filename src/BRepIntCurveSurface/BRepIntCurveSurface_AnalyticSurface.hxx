@@ -0,0 +1,119 @@
+// Created on: 2025-04-14
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_AnalyticSurface_HeaderFile
+#define _BRepIntCurveSurface_AnalyticSurface_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+
+#include <GeomAbs_SurfaceType.hxx>
+#include <gp_Ax3.hxx>
+#include <gp_Dir.hxx>
+#include <gp_Pnt.hxx>
+#include <gp_Vec.hxx>
+
+class Adaptor3d_Surface;
+
+//! Cached parameters of an elementary face surface (plane, cylinder, cone, sphere or
+//! torus) for the refinement of tessellation hits without adaptor calls.
+//!
+//! Rays are intersected in closed form: linear for planes, quadratic for cylinders,
+//! cones and spheres, quartic for tori. The ray is re-expressed from the tessellation
+//! hit, which is close to the wanted root, so that the root is well conditioned and
+//! is picked as the one nearest to the hit.
+class BRepIntCurveSurface_AnalyticSurface
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Empty constructor; the surface is not elementary until Init()
+  BRepIntCurveSurface_AnalyticSurface()
+      : myType(GeomAbs_OtherSurface),
+        myRadius(0.0),
+        myMinorRadius(0.0),
+        mySemiAngle(0.0),
+        myUMin(0.0),
+        myUMax(0.0),
+        myVMin(0.0),
+        myVMax(0.0)
+  {
+  }
+
+  //! Classify the surface of a face and cache its parameters and UV bounds if it is
+  //! elementary
+  Standard_EXPORT void Init(const Adaptor3d_Surface& theSurface);
+
+  //! Returns true if the surface is a plane, cylinder, cone, sphere or torus
+  Standard_Boolean IsElementary() const { return myType != GeomAbs_OtherSurface; }
+
+  //! Returns the surface type, GeomAbs_OtherSurface if not elementary
+  GeomAbs_SurfaceType Type() const { return myType; }
+
+  //! Intersect a ray with the surface, keeping the root nearest to a hint.
+  //! Outputs are left untouched on failure.
+  //! @param theOrigin Ray origin
+  //! @param theDir Ray direction
+  //! @param theHintT Ray parameter of the tessellation hit
+  //! @param theU Output: U of the intersection
+  //! @param theV Output: V of the intersection
+  //! @param theT Output: ray parameter of the intersection
+  //! @param thePnt Output: intersection point
+  //! @return false if the surface is not elementary, the ray misses it or the nearest
+  //! root lies outside the UV bounds of the face
+  Standard_EXPORT Standard_Boolean Intersect(const gp_Pnt&       theOrigin,
+                                             const gp_Dir&       theDir,
+                                             const Standard_Real theHintT,
+                                             Standard_Real&      theU,
+                                             Standard_Real&      theV,
+                                             Standard_Real&      theT,
+                                             gp_Pnt&             thePnt) const;
+
+  //! Point and first derivatives at (theU, theV); the surface must be elementary
+  Standard_EXPORT void D1(const Standard_Real theU,
+                          const Standard_Real theV,
+                          gp_Pnt&             thePnt,
+                          gp_Vec&             theD1U,
+                          gp_Vec&             theD1V) const;
+
+  //! Point and derivatives up to the second order at (theU, theV);
+  //! the surface must be elementary
+  Standard_EXPORT void D2(const Standard_Real theU,
+                          const Standard_Real theV,
+                          gp_Pnt&             thePnt,
+                          gp_Vec&             theD1U,
+                          gp_Vec&             theD1V,
+                          gp_Vec&             theD2U,
+                          gp_Vec&             theD2V,
+                          gp_Vec&             theD2UV) const;
+
+private:
+  //! Map the parameters of a point into the UV bounds of the face, shifting periodic
+  //! parameters by whole periods; returns false if they stay outside
+  Standard_Boolean toFaceBounds(Standard_Real& theU, Standard_Real& theV) const;
+
+private:
+  gp_Ax3              myPosition;
+  GeomAbs_SurfaceType myType;
+  Standard_Real       myRadius;      //!< Radius; reference radius of cones, major of tori
+  Standard_Real       myMinorRadius; //!< Minor radius of tori
+  Standard_Real       mySemiAngle;   //!< Semi-angle of cones
+  Standard_Real       myUMin;        //!< UV bounds of the face
+  Standard_Real       myUMax;
+  Standard_Real       myVMin;
+  Standard_Real       myVMax;
+};
+
+#endif // _BRepIntCurveSurface_AnalyticSurface_HeaderFile
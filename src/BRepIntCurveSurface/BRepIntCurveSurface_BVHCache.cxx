@@ -0,0 +1,371 @@
+// Created on: 2025-03-24
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_BVHCache.hxx>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+const char          FILE_MAGIC[8]   = {'O', 'C', 'C', 'T', 'R', 'T', 'B', 'V'};
+const Standard_Size SECTION_ALIGNED = 64;
+
+//! Fixed-size file header
+struct FileHeader
+{
+  char     Magic[8];
+  uint32_t Version;
+  uint32_t NbSections;
+  uint64_t Key;
+};
+
+//! Entry of the section table following the header
+struct SectionEntry
+{
+  uint32_t Id;
+  uint32_t ElemSize;
+  uint64_t Offset; //!< From the start of the file, multiple of SECTION_ALIGNED
+  uint64_t Size;   //!< In bytes, multiple of ElemSize
+};
+
+constexpr uint64_t HASH_PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t HASH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+inline uint64_t RotateLeft(const uint64_t theValue, const int theBits)
+{
+  return (theValue << theBits) | (theValue >> (64 - theBits));
+}
+
+//! Mix one 64-bit word into a hash lane
+inline uint64_t MixWord(const uint64_t theLane, const uint64_t theWord)
+{
+  return RotateLeft(theLane + theWord * HASH_PRIME2, 31) * HASH_PRIME1;
+}
+
+inline Standard_Size AlignUp(const Standard_Size theValue)
+{
+  return (theValue + SECTION_ALIGNED - 1) / SECTION_ALIGNED * SECTION_ALIGNED;
+}
+
+//! Suffix of a temporary file unique to this write: process id and a counter, so that
+//! processes and threads writing the same cache file never share a temporary file
+TCollection_AsciiString TemporarySuffix()
+{
+  static std::atomic<unsigned int> THE_COUNTER(0);
+#ifdef _WIN32
+  const unsigned long aPid = static_cast<unsigned long>(GetCurrentProcessId());
+#else
+  const unsigned long aPid = static_cast<unsigned long>(getpid());
+#endif
+  char aSuffix[64];
+  std::snprintf(aSuffix, sizeof(aSuffix), ".%lu.%u.tmp", aPid, THE_COUNTER++);
+  return TCollection_AsciiString(aSuffix);
+}
+} // namespace
+
+//=================================================================================================
+
+BRepIntCurveSurface_BVHCache::BRepIntCurveSurface_BVHCache()
+    : myData(nullptr),
+      mySize(0),
+      myHandle(nullptr)
+{
+}
+
+//=================================================================================================
+
+BRepIntCurveSurface_BVHCache::~BRepIntCurveSurface_BVHCache()
+{
+  Close();
+}
+
+//=================================================================================================
+
+TCollection_AsciiString BRepIntCurveSurface_BVHCache::FilePath(
+  const TCollection_AsciiString& theDirectory,
+  const uint64_t                 theKey)
+{
+  char aName[32];
+  std::snprintf(aName,
+                sizeof(aName),
+                "bvh_%08x%08x.bin",
+                static_cast<unsigned>(theKey >> 32),
+                static_cast<unsigned>(theKey & 0xFFFFFFFFu));
+
+  TCollection_AsciiString aPath = theDirectory;
+  if (!aPath.IsEmpty() && aPath.Value(aPath.Length()) != '/'
+      && aPath.Value(aPath.Length()) != '\\')
+  {
+    aPath += "/";
+  }
+  aPath += aName;
+  return aPath;
+}
+
+//=================================================================================================
+
+uint64_t BRepIntCurveSurface_BVHCache::Hash(const void*         theData,
+                                            const Standard_Size theSize,
+                                            const uint64_t      theSeed)
+{
+  // Four independent lanes over 32-byte blocks keep the multiplier pipeline busy
+  const unsigned char* aBytes = static_cast<const unsigned char*>(theData);
+  uint64_t             aLanes[4] = {theSeed + HASH_PRIME1,
+                                    theSeed ^ HASH_PRIME2,
+                                    theSeed,
+                                    theSeed - HASH_PRIME1};
+
+  Standard_Size aPos = 0;
+  for (; aPos + 32 <= theSize; aPos += 32)
+  {
+    for (int k = 0; k < 4; ++k)
+    {
+      uint64_t aWord;
+      std::memcpy(&aWord, aBytes + aPos + 8 * k, 8);
+      aLanes[k] = MixWord(aLanes[k], aWord);
+    }
+  }
+
+  uint64_t aHash = RotateLeft(aLanes[0], 1) + RotateLeft(aLanes[1], 7) + RotateLeft(aLanes[2], 12)
+                   + RotateLeft(aLanes[3], 18);
+  for (; aPos + 8 <= theSize; aPos += 8)
+  {
+    uint64_t aWord;
+    std::memcpy(&aWord, aBytes + aPos, 8);
+    aHash = MixWord(aHash, aWord);
+  }
+  if (aPos < theSize)
+  {
+    uint64_t aWord = 0;
+    std::memcpy(&aWord, aBytes + aPos, theSize - aPos);
+    aHash = MixWord(aHash, aWord);
+  }
+
+  // Final avalanche, so that close inputs give unrelated keys
+  aHash = MixWord(aHash, static_cast<uint64_t>(theSize));
+  aHash ^= aHash >> 33;
+  aHash *= HASH_PRIME2;
+  aHash ^= aHash >> 29;
+  return aHash;
+}
+
+//=================================================================================================
+
+Standard_Boolean BRepIntCurveSurface_BVHCache::Open(const TCollection_AsciiString& thePath,
+                                                    const uint64_t                 theKey)
+{
+  Close();
+
+#ifdef _WIN32
+  HANDLE aFile = CreateFileA(thePath.ToCString(),
+                             GENERIC_READ,
+                             FILE_SHARE_READ,
+                             nullptr,
+                             OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+  if (aFile == INVALID_HANDLE_VALUE)
+    return Standard_False;
+
+  LARGE_INTEGER aFileSize;
+  if (!GetFileSizeEx(aFile, &aFileSize) || aFileSize.QuadPart < (LONGLONG)sizeof(FileHeader))
+  {
+    CloseHandle(aFile);
+    return Standard_False;
+  }
+
+  HANDLE aMapping = CreateFileMappingA(aFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(aFile);
+  if (aMapping == nullptr)
+    return Standard_False;
+
+  const void* aView = MapViewOfFile(aMapping, FILE_MAP_READ, 0, 0, 0);
+  if (aView == nullptr)
+  {
+    CloseHandle(aMapping);
+    return Standard_False;
+  }
+  myHandle = aMapping;
+  myData   = static_cast<const char*>(aView);
+  mySize   = static_cast<Standard_Size>(aFileSize.QuadPart);
+#else
+  const int aFile = ::open(thePath.ToCString(), O_RDONLY);
+  if (aFile < 0)
+    return Standard_False;
+
+  struct stat aStat;
+  if (::fstat(aFile, &aStat) != 0 || aStat.st_size < (off_t)sizeof(FileHeader))
+  {
+    ::close(aFile);
+    return Standard_False;
+  }
+
+  void* aView =
+    ::mmap(nullptr, static_cast<size_t>(aStat.st_size), PROT_READ, MAP_SHARED, aFile, 0);
+  ::close(aFile);
+  if (aView == MAP_FAILED)
+    return Standard_False;
+
+  myData = static_cast<const char*>(aView);
+  mySize = static_cast<Standard_Size>(aStat.st_size);
+#endif
+
+  // Validate the header and that the section table and every section lie within the file
+  FileHeader aHeader;
+  std::memcpy(&aHeader, myData, sizeof(aHeader));
+  Standard_Boolean isValid = std::memcmp(aHeader.Magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0
+                             && aHeader.Version == Version && aHeader.Key == theKey
+                             && aHeader.NbSections
+                                  <= (mySize - sizeof(FileHeader)) / sizeof(SectionEntry);
+  for (uint32_t i = 0; isValid && i < aHeader.NbSections; ++i)
+  {
+    SectionEntry anEntry;
+    std::memcpy(&anEntry, myData + sizeof(FileHeader) + i * sizeof(SectionEntry), sizeof(anEntry));
+    isValid = anEntry.ElemSize > 0 && anEntry.Offset % SECTION_ALIGNED == 0
+              && anEntry.Size % anEntry.ElemSize == 0 && anEntry.Offset <= mySize
+              && anEntry.Size <= mySize - anEntry.Offset;
+  }
+  if (!isValid)
+  {
+    Close();
+    return Standard_False;
+  }
+  return Standard_True;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_BVHCache::Close()
+{
+  if (myData == nullptr)
+    return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(myData);
+  CloseHandle(static_cast<HANDLE>(myHandle));
+#else
+  ::munmap(const_cast<char*>(myData), mySize);
+#endif
+  myData   = nullptr;
+  mySize   = 0;
+  myHandle = nullptr;
+}
+
+//=================================================================================================
+
+const void* BRepIntCurveSurface_BVHCache::Section(const uint32_t      theId,
+                                                  const Standard_Size theElemSize,
+                                                  Standard_Size&      theNbElems) const
+{
+  theNbElems = 0;
+  if (myData == nullptr)
+    return nullptr;
+
+  FileHeader aHeader;
+  std::memcpy(&aHeader, myData, sizeof(aHeader));
+  for (uint32_t i = 0; i < aHeader.NbSections; ++i)
+  {
+    SectionEntry anEntry;
+    std::memcpy(&anEntry, myData + sizeof(FileHeader) + i * sizeof(SectionEntry), sizeof(anEntry));
+    if (anEntry.Id != theId)
+      continue;
+    if (anEntry.ElemSize != theElemSize)
+      return nullptr;
+
+    theNbElems = static_cast<Standard_Size>(anEntry.Size / anEntry.ElemSize);
+    return myData + anEntry.Offset;
+  }
+  return nullptr;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_BVHCache::AddSection(const uint32_t      theId,
+                                              const void*         theData,
+                                              const Standard_Size theElemSize,
+                                              const Standard_Size theNbElems)
+{
+  myPending.push_back({theId, theData, theElemSize, theNbElems});
+}
+
+//=================================================================================================
+
+Standard_Boolean BRepIntCurveSurface_BVHCache::Write(const TCollection_AsciiString& thePath,
+                                                     const uint64_t                 theKey)
+{
+  FileHeader aHeader;
+  std::memcpy(aHeader.Magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  aHeader.Version    = Version;
+  aHeader.NbSections = static_cast<uint32_t>(myPending.size());
+  aHeader.Key        = theKey;
+
+  std::vector<SectionEntry> anEntries(myPending.size());
+  Standard_Size             anOffset =
+    AlignUp(sizeof(FileHeader) + myPending.size() * sizeof(SectionEntry));
+  for (size_t i = 0; i < myPending.size(); ++i)
+  {
+    anEntries[i].Id       = myPending[i].Id;
+    anEntries[i].ElemSize = static_cast<uint32_t>(myPending[i].ElemSize);
+    anEntries[i].Offset   = anOffset;
+    anEntries[i].Size     = myPending[i].ElemSize * myPending[i].NbElems;
+    anOffset              = AlignUp(anOffset + anEntries[i].Size);
+  }
+
+  // Write under a temporary name in the same directory, then move the complete file into
+  // place; concurrent writers of the same key each publish a complete file
+  const TCollection_AsciiString aTmpPath = thePath + TemporarySuffix();
+  Standard_Boolean              isDone   = Standard_False;
+  {
+    std::ofstream aStream(aTmpPath.ToCString(), std::ios::binary | std::ios::trunc);
+    if (aStream)
+    {
+      const char aPadding[SECTION_ALIGNED] = {};
+      aStream.write(reinterpret_cast<const char*>(&aHeader), sizeof(aHeader));
+      aStream.write(reinterpret_cast<const char*>(anEntries.data()),
+                    anEntries.size() * sizeof(SectionEntry));
+      Standard_Size aPos = sizeof(aHeader) + anEntries.size() * sizeof(SectionEntry);
+      for (size_t i = 0; i < myPending.size(); ++i)
+      {
+        aStream.write(aPadding, static_cast<std::streamsize>(anEntries[i].Offset - aPos));
+        aStream.write(static_cast<const char*>(myPending[i].Data),
+                      static_cast<std::streamsize>(anEntries[i].Size));
+        aPos = static_cast<Standard_Size>(anEntries[i].Offset + anEntries[i].Size);
+      }
+      isDone = aStream.good();
+    }
+  }
+  myPending.clear();
+
+  if (isDone)
+  {
+    // rename() does not replace an existing file on Windows
+    std::remove(thePath.ToCString());
+    isDone = std::rename(aTmpPath.ToCString(), thePath.ToCString()) == 0;
+  }
+  if (!isDone)
+    std::remove(aTmpPath.ToCString());
+  return isDone;
+}
@@ -0,0 +1,178 @@
+// Created on: 2025-03-24
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_BVHCache_HeaderFile
+#define _BRepIntCurveSurface_BVHCache_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//! Versioned binary file of typed sections, written once and mapped read-only.
+//!
+//! The file starts with a magic string, the format version, the number of sections
+//! and a 64-bit key identifying the data it was built from, followed by a table
+//! giving the identifier, element size, offset and byte size of every section.
+//! Section data is aligned to 64 bytes. A file is accepted only if the magic,
+//! version and key match and every section lies within the file; sections whose
+//! element size differs from the reader's (another build configuration) are
+//! rejected when read.
+//!
+//! Files are written to a temporary name and renamed, so a reader never sees a
+//! partially written file. The data is in host byte order.
+class BRepIntCurveSurface_BVHCache
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Format version; increase when the layout of any cached structure changes
+  static constexpr uint32_t Version = 1;
+
+  //! Empty constructor
+  Standard_EXPORT BRepIntCurveSurface_BVHCache();
+
+  //! Unmap the file
+  Standard_EXPORT ~BRepIntCurveSurface_BVHCache();
+
+  //! Returns the path of the file with the given key in a directory
+  Standard_EXPORT static TCollection_AsciiString FilePath(
+    const TCollection_AsciiString& theDirectory,
+    const uint64_t                 theKey);
+
+  //! Fold a block of bytes into a running 64-bit hash
+  Standard_EXPORT static uint64_t Hash(const void*        theData,
+                                       const Standard_Size theSize,
+                                       const uint64_t     theSeed);
+
+  //! Fold the contents of a vector into a running 64-bit hash
+  template <class T>
+  static uint64_t Hash(const std::vector<T>& theData, const uint64_t theSeed)
+  {
+    const uint64_t aSize = theData.size();
+    const uint64_t aSeed = Hash(&aSize, sizeof(aSize), theSeed);
+    return theData.empty() ? aSeed : Hash(theData.data(), theData.size() * sizeof(T), aSeed);
+  }
+
+  //! Fold a scalar into a running 64-bit hash
+  template <class T>
+  static uint64_t Hash(const T& theValue, const uint64_t theSeed)
+  {
+    return Hash(&theValue, sizeof(T), theSeed);
+  }
+
+  //! @name Reading
+
+  //! Map a file read-only and validate its header and section table.
+  //! @return false if the file does not exist or is not a valid file with this key
+  Standard_EXPORT Standard_Boolean Open(const TCollection_AsciiString& thePath,
+                                        const uint64_t                 theKey);
+
+  //! Unmap the file
+  Standard_EXPORT void Close();
+
+  //! Returns true if a file is mapped
+  Standard_Boolean IsOpen() const { return myData != nullptr; }
+
+  //! Returns the mapped data of a section, or null if there is no such section or its
+  //! element size differs.
+  //! @param theId Section identifier
+  //! @param theElemSize Expected element size in bytes
+  //! @param theNbElems Output: number of elements
+  Standard_EXPORT const void* Section(const uint32_t     theId,
+                                      const Standard_Size theElemSize,
+                                      Standard_Size&     theNbElems) const;
+
+  //! Copy a section into a vector.
+  //! @return false if the section is missing or has another element size
+  template <class T>
+  Standard_Boolean Read(const uint32_t theId, std::vector<T>& theData) const
+  {
+    Standard_Size aNbElems = 0;
+    const void*   aData    = Section(theId, sizeof(T), aNbElems);
+    if (aData == nullptr)
+      return Standard_False;
+
+    theData.resize(aNbElems);
+    if (aNbElems > 0)
+      std::memcpy(static_cast<void*>(theData.data()), aData, aNbElems * sizeof(T));
+    return Standard_True;
+  }
+
+  //! Copy a single-element section into a value.
+  //! @return false if the section is missing or does not hold exactly one T
+  template <class T>
+  Standard_Boolean Read(const uint32_t theId, T& theValue) const
+  {
+    Standard_Size aNbElems = 0;
+    const void*   aData    = Section(theId, sizeof(T), aNbElems);
+    if (aData == nullptr || aNbElems != 1)
+      return Standard_False;
+
+    std::memcpy(static_cast<void*>(&theValue), aData, sizeof(T));
+    return Standard_True;
+  }
+
+  //! @name Writing
+
+  //! Register a section for Write(); the data must stay valid until then
+  Standard_EXPORT void AddSection(const uint32_t      theId,
+                                  const void*         theData,
+                                  const Standard_Size theElemSize,
+                                  const Standard_Size theNbElems);
+
+  //! Register the contents of a vector as a section
+  template <class T>
+  void AddSection(const uint32_t theId, const std::vector<T>& theData)
+  {
+    AddSection(theId, theData.data(), sizeof(T), theData.size());
+  }
+
+  //! Register a single value as a section
+  template <class T>
+  void AddSection(const uint32_t theId, const T& theValue)
+  {
+    AddSection(theId, &theValue, sizeof(T), 1);
+  }
+
+  //! Write the registered sections to a file and forget them.
+  //! @return false if the file could not be written
+  Standard_EXPORT Standard_Boolean Write(const TCollection_AsciiString& thePath,
+                                         const uint64_t                 theKey);
+
+private:
+  BRepIntCurveSurface_BVHCache(const BRepIntCurveSurface_BVHCache&)            = delete;
+  BRepIntCurveSurface_BVHCache& operator=(const BRepIntCurveSurface_BVHCache&) = delete;
+
+  //! Section registered for writing
+  struct PendingSection
+  {
+    uint32_t      Id;
+    const void*   Data;
+    Standard_Size ElemSize;
+    Standard_Size NbElems;
+  };
+
+private:
+  const char*                 myData;   //!< Start of the mapping
+  Standard_Size               mySize;   //!< Size of the mapping in bytes
+  void*                       myHandle; //!< File mapping handle (Windows only)
+  std::vector<PendingSection> myPending;
+};
+
+#endif // _BRepIntCurveSurface_BVHCache_HeaderFile
@@ -0,0 +1,109 @@
+// Created on: 2025-03-10
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_BVHStatistics.hxx>
+
+#include <algorithm>
+
+namespace
+{
+//! Half surface area of an axis-aligned box (zero for empty boxes)
+inline Standard_Real HalfArea(const BVH_Vec3d& theMin, const BVH_Vec3d& theMax)
+{
+  const Standard_Real aX = std::max(theMax[0] - theMin[0], 0.0);
+  const Standard_Real aY = std::max(theMax[1] - theMin[1], 0.0);
+  const Standard_Real aZ = std::max(theMax[2] - theMin[2], 0.0);
+  return aX * aY + aY * aZ + aZ * aX;
+}
+
+//! Half surface area of the intersection of two boxes; zero as soon as the boxes are
+//! disjoint along any axis, where HalfArea() would still count the other two extents
+inline Standard_Real OverlapHalfArea(const BVH_Vec3d& theMinA,
+                                     const BVH_Vec3d& theMaxA,
+                                     const BVH_Vec3d& theMinB,
+                                     const BVH_Vec3d& theMaxB)
+{
+  const BVH_Vec3d aMin = theMinA.cwiseMax(theMinB);
+  const BVH_Vec3d aMax = theMaxA.cwiseMin(theMaxB);
+  for (int anAxis = 0; anAxis < 3; ++anAxis)
+  {
+    if (aMax[anAxis] < aMin[anAxis])
+      return 0.0;
+  }
+  return HalfArea(aMin, aMax);
+}
+} // namespace
+
+//=================================================================================================
+
+void BRepIntCurveSurface_BVHStatistics::Perform(const BVH_Tree<Standard_Real, 3>& theTree)
+{
+  *this = BRepIntCurveSurface_BVHStatistics();
+  if (theTree.Length() == 0)
+    return;
+
+  const Standard_Real aRootArea = HalfArea(theTree.MinPoint(0), theTree.MaxPoint(0));
+  // Flat root (planar part): fall back to unit weights instead of dividing by zero
+  const Standard_Real anInvRoot = aRootArea > 0.0 ? 1.0 / aRootArea : 1.0;
+
+  Standard_Real aSAH      = 0.0;
+  Standard_Real anOverlap = 0.0;
+
+  // Explicit stack of (node, level) pairs; children are listed by index in BVH_Tree
+  std::vector<std::pair<Standard_Integer, Standard_Integer>> aStack;
+  aStack.emplace_back(0, 0);
+  while (!aStack.empty())
+  {
+    const Standard_Integer aNode  = aStack.back().first;
+    const Standard_Integer aLevel = aStack.back().second;
+    aStack.pop_back();
+
+    ++NbNodes;
+    Depth = std::max(Depth, aLevel);
+
+    const Standard_Real aWeight =
+      HalfArea(theTree.MinPoint(aNode), theTree.MaxPoint(aNode)) * anInvRoot;
+    if (theTree.IsOuter(aNode))
+    {
+      const Standard_Integer aSize =
+        theTree.EndPrimitive(aNode) - theTree.BegPrimitive(aNode) + 1;
+      if (aSize >= static_cast<Standard_Integer>(LeafSizes.size()))
+        LeafSizes.resize(aSize + 1, 0);
+      ++LeafSizes[aSize];
+      ++NbLeaves;
+      NbPrimitives += aSize;
+      aSAH += aWeight * aSize * IntersectionCost;
+      continue;
+    }
+
+    aSAH += aWeight * TraversalCost;
+
+    const Standard_Integer aLeft  = theTree.template Child<0>(aNode);
+    const Standard_Integer aRight = theTree.template Child<1>(aNode);
+
+    // Overlap of the sibling boxes: rays in it must visit both subtrees
+    anOverlap += OverlapHalfArea(theTree.MinPoint(aLeft),
+                                 theTree.MaxPoint(aLeft),
+                                 theTree.MinPoint(aRight),
+                                 theTree.MaxPoint(aRight))
+                 * anInvRoot;
+
+    aStack.emplace_back(aRight, aLevel + 1);
+    aStack.emplace_back(aLeft, aLevel + 1);
+  }
+
+  SAHCost      = aSAH;
+  OverlapRatio = anOverlap;
+}
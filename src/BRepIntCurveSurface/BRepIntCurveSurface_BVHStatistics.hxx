@@ -0,0 +1,73 @@
+// Created on: 2025-03-10
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_BVHStatistics_HeaderFile
+#define _BRepIntCurveSurface_BVHStatistics_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+
+#include <BVH_Tree.hxx>
+
+#include <vector>
+
+//! Quality metrics of a binary BVH.
+//!
+//! Areas are taken relative to the root box, so the SAH cost is the expected
+//! number of node visits and triangle tests of a random ray entering the root:
+//! every inner node costs TraversalCost, every primitive IntersectionCost,
+//! both weighted by the probability that the ray enters the node box.
+struct BRepIntCurveSurface_BVHStatistics
+{
+  DEFINE_STANDARD_ALLOC
+
+  //! Cost of one node visit relative to one ray-triangle test
+  static constexpr Standard_Real TraversalCost = 1.0;
+
+  //! Cost of one ray-triangle test
+  static constexpr Standard_Real IntersectionCost = 1.0;
+
+  Standard_Real    SAHCost;      //!< Surface area heuristic cost of the tree
+  Standard_Real    OverlapRatio; //!< Sum of sibling box overlap areas divided by the root area
+  Standard_Integer NbNodes;      //!< Number of nodes (inner and leaves)
+  Standard_Integer NbLeaves;     //!< Number of leaves
+  Standard_Integer NbPrimitives; //!< Number of primitives referenced by the leaves
+  Standard_Integer Depth;        //!< Depth of the deepest leaf (root is level 0)
+
+  //! Leaf-size histogram: LeafSizes[n] is the number of leaves holding n primitives
+  std::vector<Standard_Integer> LeafSizes;
+
+  //! Empty constructor
+  BRepIntCurveSurface_BVHStatistics()
+      : SAHCost(0.0),
+        OverlapRatio(0.0),
+        NbNodes(0),
+        NbLeaves(0),
+        NbPrimitives(0),
+        Depth(0)
+  {
+  }
+
+  //! Compute the metrics of the given tree (resets the structure first)
+  Standard_EXPORT void Perform(const BVH_Tree<Standard_Real, 3>& theTree);
+
+  //! Returns the average number of primitives per leaf
+  Standard_Real AverageLeafSize() const
+  {
+    return NbLeaves > 0 ? static_cast<Standard_Real>(NbPrimitives) / NbLeaves : 0.0;
+  }
+};
+
+#endif // _BRepIntCurveSurface_BVHStatistics_HeaderFile
@@ -0,0 +1,233 @@
+// Created on: 2025-01-20
+// Created by: Andrea Pozzetti (with Claude Code assistance)
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_FlatBVH.hxx>
+
+#include <Standard_ProgramError.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace
+{
+inline void SetBounds(BRepIntCurveSurface_FlatNodeF& theNode,
+                      const BVH_Vec3d&               theMin,
+                      const BVH_Vec3d&               theMax)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    theNode.MinPoint[i] = BRepIntCurveSurface_FlatBVH::RoundDown(theMin[i]);
+    theNode.MaxPoint[i] = BRepIntCurveSurface_FlatBVH::RoundUp(theMax[i]);
+  }
+}
+
+inline void SetBounds(BRepIntCurveSurface_FlatNodeD& theNode,
+                      const BVH_Vec3d&               theMin,
+                      const BVH_Vec3d&               theMax)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    theNode.MinPoint[i] = theMin[i];
+    theNode.MaxPoint[i] = theMax[i];
+  }
+}
+
+//! Emit the subtree rooted at theNode in depth-first order (left child first)
+template <class NodeT>
+void EmitSubtree(const BVH_Tree<Standard_Real, 3>& theTree,
+                 const Standard_Integer            theNode,
+                 const Standard_Integer            theLevel,
+                 std::vector<NodeT>&               theNodes,
+                 Standard_Integer&                 theDepth)
+{
+  theDepth                        = std::max(theDepth, theLevel);
+  const Standard_Integer aFlatIdx = static_cast<Standard_Integer>(theNodes.size());
+  theNodes.emplace_back();
+  SetBounds(theNodes[aFlatIdx], theTree.MinPoint(theNode), theTree.MaxPoint(theNode));
+
+  if (theTree.IsOuter(theNode))
+  {
+    theNodes[aFlatIdx].Offset  = theTree.BegPrimitive(theNode);
+    theNodes[aFlatIdx].NbPrims = theTree.EndPrimitive(theNode) - theTree.BegPrimitive(theNode) + 1;
+    return;
+  }
+
+  theNodes[aFlatIdx].NbPrims = 0;
+  EmitSubtree(theTree, theTree.template Child<0>(theNode), theLevel + 1, theNodes, theDepth);
+
+  // Right child starts after the whole left subtree
+  theNodes[aFlatIdx].Offset = static_cast<Standard_Integer>(theNodes.size());
+  EmitSubtree(theTree, theTree.template Child<1>(theNode), theLevel + 1, theNodes, theDepth);
+}
+
+//! Record the parent of every node and the leaf of every primitive
+template <class NodeT>
+void IndexNodes(const std::vector<NodeT>&      theNodes,
+                std::vector<Standard_Integer>& theParents,
+                std::vector<Standard_Integer>& thePrimLeaves)
+{
+  const Standard_Integer aNbNodes = static_cast<Standard_Integer>(theNodes.size());
+  theParents.assign(aNbNodes, -1);
+  for (Standard_Integer aNode = 0; aNode < aNbNodes; ++aNode)
+  {
+    const NodeT& aFlat = theNodes[aNode];
+    if (aFlat.IsLeaf())
+    {
+      std::fill(thePrimLeaves.begin() + aFlat.Offset,
+                thePrimLeaves.begin() + aFlat.Offset + aFlat.NbPrims,
+                aNode);
+    }
+    else
+    {
+      theParents[aNode + 1]    = aNode;
+      theParents[aFlat.Offset] = aNode;
+    }
+  }
+}
+
+//! Set the leaf boxes, then merge the child boxes of every ancestor. A parent always
+//! precedes its children in depth-first order, so ancestors are processed in
+//! decreasing index order.
+template <class NodeT>
+void RefitNodes(std::vector<NodeT>&                  theNodes,
+                const std::vector<Standard_Integer>& theParents,
+                const std::vector<Standard_Integer>& theLeaves,
+                const std::vector<BVH_Vec3d>&        theMins,
+                const std::vector<BVH_Vec3d>&        theMaxs)
+{
+  std::vector<Standard_Integer> anAncestors;
+  for (size_t i = 0; i < theLeaves.size(); ++i)
+  {
+    SetBounds(theNodes[theLeaves[i]], theMins[i], theMaxs[i]);
+    for (Standard_Integer aNode = theParents[theLeaves[i]]; aNode >= 0; aNode = theParents[aNode])
+      anAncestors.push_back(aNode);
+  }
+  std::sort(anAncestors.begin(), anAncestors.end(), std::greater<Standard_Integer>());
+  anAncestors.erase(std::unique(anAncestors.begin(), anAncestors.end()), anAncestors.end());
+
+  // Child boxes are already rounded outwards, so their union needs no rounding
+  for (const Standard_Integer aNode : anAncestors)
+  {
+    NodeT&       anInner = theNodes[aNode];
+    const NodeT& aLeft   = theNodes[aNode + 1];
+    const NodeT& aRight  = theNodes[anInner.Offset];
+    for (int k = 0; k < 3; ++k)
+    {
+      anInner.MinPoint[k] = std::min(aLeft.MinPoint[k], aRight.MinPoint[k]);
+      anInner.MaxPoint[k] = std::max(aLeft.MaxPoint[k], aRight.MaxPoint[k]);
+    }
+  }
+}
+} // namespace
+
+//=================================================================================================
+
+Standard_ShortReal BRepIntCurveSurface_FlatBVH::RoundDown(const Standard_Real theValue)
+{
+  Standard_ShortReal aValue = static_cast<Standard_ShortReal>(theValue);
+  if (static_cast<Standard_Real>(aValue) > theValue)
+    aValue = std::nextafter(aValue, -std::numeric_limits<Standard_ShortReal>::infinity());
+  return aValue;
+}
+
+//=================================================================================================
+
+Standard_ShortReal BRepIntCurveSurface_FlatBVH::RoundUp(const Standard_Real theValue)
+{
+  Standard_ShortReal aValue = static_cast<Standard_ShortReal>(theValue);
+  if (static_cast<Standard_Real>(aValue) < theValue)
+    aValue = std::nextafter(aValue, std::numeric_limits<Standard_ShortReal>::infinity());
+  return aValue;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_FlatBVH::Build(const BVH_Tree<Standard_Real, 3>& theTree,
+                                        const Standard_Boolean            theUseFloat)
+{
+  Clear();
+  myIsFloat = theUseFloat;
+
+  if (theTree.Length() == 0)
+    return;
+
+  // Recursion depth is bounded by the builder's maximum tree depth
+  if (myIsFloat)
+  {
+    myNodesF.reserve(theTree.Length());
+    EmitSubtree(theTree, 0, 0, myNodesF, myDepth);
+  }
+  else
+  {
+    myNodesD.reserve(theTree.Length());
+    EmitSubtree(theTree, 0, 0, myNodesD, myDepth);
+  }
+
+  // Traversal keeps at most one deferred sibling per level on a fixed stack
+  if (myDepth >= MaxStackSize)
+  {
+    Clear();
+    throw Standard_ProgramError(
+      "BRepIntCurveSurface_FlatBVH::Build - tree is too deep for traversal stack");
+  }
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_FlatBVH::InitRefit(const Standard_Integer theNbPrims)
+{
+  myPrimLeaves.assign(theNbPrims, -1);
+  if (myIsFloat)
+    IndexNodes(myNodesF, myParents, myPrimLeaves);
+  else
+    IndexNodes(myNodesD, myParents, myPrimLeaves);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_FlatBVH::LeafRange(const Standard_Integer theLeaf,
+                                            Standard_Integer&      theFirst,
+                                            Standard_Integer&      theNbPrims) const
+{
+  theFirst   = myIsFloat ? myNodesF[theLeaf].Offset : myNodesD[theLeaf].Offset;
+  theNbPrims = myIsFloat ? myNodesF[theLeaf].NbPrims : myNodesD[theLeaf].NbPrims;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_FlatBVH::LeafBox(const Standard_Integer theLeaf,
+                                          BVH_Vec3d&             theMin,
+                                          BVH_Vec3d&             theMax) const
+{
+  for (int k = 0; k < 3; ++k)
+  {
+    theMin[k] = myIsFloat ? myNodesF[theLeaf].MinPoint[k] : myNodesD[theLeaf].MinPoint[k];
+    theMax[k] = myIsFloat ? myNodesF[theLeaf].MaxPoint[k] : myNodesD[theLeaf].MaxPoint[k];
+  }
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_FlatBVH::Refit(const std::vector<Standard_Integer>& theLeaves,
+                                        const std::vector<BVH_Vec3d>&        theMins,
+                                        const std::vector<BVH_Vec3d>&        theMaxs)
+{
+  if (myIsFloat)
+    RefitNodes(myNodesF, myParents, theLeaves, theMins, theMaxs);
+  else
+    RefitNodes(myNodesD, myParents, theLeaves, theMins, theMaxs);
+}
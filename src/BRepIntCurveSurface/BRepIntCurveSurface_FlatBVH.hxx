@@ -0,0 +1,188 @@
+// Created on: 2025-01-20
+// Created by: Andrea Pozzetti (with Claude Code assistance)
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_FlatBVH_HeaderFile
+#define _BRepIntCurveSurface_FlatBVH_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+
+#include <BVH_Tree.hxx>
+
+#include <vector>
+
+//! Node of the flattened triangle BVH.
+//! Nodes are stored in depth-first order: the left child of an inner node
+//! immediately follows its parent, the right child is referenced by index.
+//! With float bounds a node takes 32 bytes (two nodes per cache line).
+template <class T>
+struct BRepIntCurveSurface_FlatNode
+{
+  T                MinPoint[3]; //!< Box minimum corner
+  T                MaxPoint[3]; //!< Box maximum corner
+  Standard_Integer Offset;      //!< Inner node: index of right child; leaf: first primitive
+  Standard_Integer NbPrims;     //!< 0 for inner nodes, number of primitives for leaves
+
+  //! Returns true if the node is a leaf
+  Standard_Boolean IsLeaf() const { return NbPrims > 0; }
+};
+
+//! Single-precision node (bounds rounded outwards, 32 bytes)
+typedef BRepIntCurveSurface_FlatNode<Standard_ShortReal> BRepIntCurveSurface_FlatNodeF;
+
+//! Double-precision node (exact bounds, 56 bytes)
+typedef BRepIntCurveSurface_FlatNode<Standard_Real> BRepIntCurveSurface_FlatNodeD;
+
+//! Cache-friendly copy of a binary BVH_Tree.
+//!
+//! BVH_Tree keeps min/max points, child links and primitive ranges in separate
+//! arrays, so every node visit touches several cache lines. This class packs
+//! all data of a node into one record and lays the nodes out depth-first.
+//! Primitive indices are the same as in the source tree.
+class BRepIntCurveSurface_FlatBVH
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Capacity of the fixed traversal stack; trees must be shallower than this
+  static constexpr Standard_Integer MaxStackSize = 64;
+
+  //! Empty constructor
+  BRepIntCurveSurface_FlatBVH()
+      : myIsFloat(Standard_True),
+        myDepth(0)
+  {
+  }
+
+  //! Flatten the given tree.
+  //! @param theTree Binary BVH tree to flatten
+  //! @param theUseFloat If true, store bounds as float32 rounded outwards
+  //!        (conservative), otherwise keep double precision
+  //! @throw Standard_ProgramError if the tree is not shallower than MaxStackSize
+  Standard_EXPORT void Build(const BVH_Tree<Standard_Real, 3>& theTree,
+                             const Standard_Boolean            theUseFloat);
+
+  //! Take over single-precision nodes built earlier, e.g. read back from a cache file
+  void Assign(std::vector<BRepIntCurveSurface_FlatNodeF>&& theNodes,
+              const Standard_Integer                       theDepth)
+  {
+    Clear();
+    myNodesF  = std::move(theNodes);
+    myIsFloat = Standard_True;
+    myDepth   = theDepth;
+  }
+
+  //! Take over double-precision nodes built earlier, e.g. read back from a cache file
+  void Assign(std::vector<BRepIntCurveSurface_FlatNodeD>&& theNodes,
+              const Standard_Integer                       theDepth)
+  {
+    Clear();
+    myNodesD  = std::move(theNodes);
+    myIsFloat = Standard_False;
+    myDepth   = theDepth;
+  }
+
+  //! Release all nodes
+  void Clear()
+  {
+    myDepth = 0;
+    myNodesF.clear();
+    myNodesF.shrink_to_fit();
+    myNodesD.clear();
+    myNodesD.shrink_to_fit();
+    myParents.clear();
+    myParents.shrink_to_fit();
+    myPrimLeaves.clear();
+    myPrimLeaves.shrink_to_fit();
+  }
+
+  //! Returns true if no nodes are stored
+  Standard_Boolean IsEmpty() const { return NbNodes() == 0; }
+
+  //! Returns true if bounds are stored in single precision
+  Standard_Boolean IsFloat() const { return myIsFloat; }
+
+  //! Returns the number of nodes
+  Standard_Integer NbNodes() const
+  {
+    return static_cast<Standard_Integer>(myIsFloat ? myNodesF.size() : myNodesD.size());
+  }
+
+  //! Returns the depth of the deepest leaf (root is level 0)
+  Standard_Integer Depth() const { return myDepth; }
+
+  //! Returns single-precision nodes (empty unless IsFloat())
+  const BRepIntCurveSurface_FlatNodeF* NodesF() const { return myNodesF.data(); }
+
+  //! Returns double-precision nodes (empty if IsFloat())
+  const BRepIntCurveSurface_FlatNodeD* NodesD() const { return myNodesD.data(); }
+
+  //! Index the leaf of every primitive and the parent of every node for PrimitiveLeaf()
+  //! and Refit(). Linear in the number of nodes; the index is released with the nodes.
+  //! @param theNbPrims Number of primitives referenced by the leaves
+  Standard_EXPORT void InitRefit(const Standard_Integer theNbPrims);
+
+  //! Returns true if InitRefit() was called since the nodes were last replaced
+  Standard_Boolean IsRefitReady() const { return !myParents.empty(); }
+
+  //! Returns the leaf node holding primitive thePrim (requires InitRefit())
+  Standard_Integer PrimitiveLeaf(const Standard_Integer thePrim) const
+  {
+    return myPrimLeaves[thePrim];
+  }
+
+  //! Returns the first primitive and the number of primitives of leaf node theLeaf
+  Standard_EXPORT void LeafRange(const Standard_Integer theLeaf,
+                                 Standard_Integer&      theFirst,
+                                 Standard_Integer&      theNbPrims) const;
+
+  //! Returns the box of leaf node theLeaf
+  Standard_EXPORT void LeafBox(const Standard_Integer theLeaf,
+                               BVH_Vec3d&             theMin,
+                               BVH_Vec3d&             theMax) const;
+
+  //! Set new boxes of leaf nodes and recompute the boxes of their ancestors; the work
+  //! is proportional to the number of leaves times the tree depth (requires InitRefit()).
+  //! @param theLeaves Leaf nodes
+  //! @param theMins New box minimum of each leaf
+  //! @param theMaxs New box maximum of each leaf
+  Standard_EXPORT void Refit(const std::vector<Standard_Integer>& theLeaves,
+                             const std::vector<BVH_Vec3d>&        theMins,
+                             const std::vector<BVH_Vec3d>&        theMaxs);
+
+  //! Returns the size of the node array (and of the refit index) in bytes
+  Standard_Size MemorySize() const
+  {
+    return myNodesF.capacity() * sizeof(BRepIntCurveSurface_FlatNodeF)
+           + myNodesD.capacity() * sizeof(BRepIntCurveSurface_FlatNodeD)
+           + (myParents.capacity() + myPrimLeaves.capacity()) * sizeof(Standard_Integer);
+  }
+
+  //! Round a double down to the nearest float that is not greater than it
+  Standard_EXPORT static Standard_ShortReal RoundDown(const Standard_Real theValue);
+
+  //! Round a double up to the nearest float that is not less than it
+  Standard_EXPORT static Standard_ShortReal RoundUp(const Standard_Real theValue);
+
+private:
+  std::vector<BRepIntCurveSurface_FlatNodeF> myNodesF;
+  std::vector<BRepIntCurveSurface_FlatNodeD> myNodesD;
+  std::vector<Standard_Integer>              myParents;    //!< Parent of each node (root: -1)
+  std::vector<Standard_Integer>              myPrimLeaves; //!< Leaf node of each primitive
+  Standard_Boolean                           myIsFloat;
+  Standard_Integer                           myDepth;
+};
+
+#endif // _BRepIntCurveSurface_FlatBVH_HeaderFile
@@ -0,0 +1,166 @@
+// Created on: 2025-03-31
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_InstanceSet.hxx>
+
+#include <BVH_BinnedBuilder.hxx>
+#include <BVH_BoxSet.hxx>
+#include <Standard_OutOfRange.hxx>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+//! Instances of one leaf: each instance test is a full part traversal, so leaves
+//! hold a single instance
+constexpr int TOP_LEVEL_LEAF_SIZE = 1;
+} // namespace
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InstanceSet::Clear()
+{
+  myPrototypes.clear();
+  myPrototypes.shrink_to_fit();
+  myInstances.clear();
+  myInstances.shrink_to_fit();
+  myFaces.clear();
+  myFaces.shrink_to_fit();
+  myLeafInstances.clear();
+  myLeafInstances.shrink_to_fit();
+  myTopLevel.Clear();
+  myNbInstanceTriangles = 0;
+}
+
+//=================================================================================================
+
+Standard_Integer BRepIntCurveSurface_InstanceSet::AddInstance(
+  const Standard_Integer               thePrototype,
+  const gp_Trsf&                       theLocation,
+  const std::vector<Standard_Integer>& theFaces)
+{
+  const BRepIntCurveSurface_Prototype& aPrototype = myPrototypes[thePrototype];
+  if (static_cast<int64_t>(myNbInstanceTriangles) + aPrototype.NbTriangles > IntegerLast())
+  {
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InstanceSet::AddInstance - too many instanced triangles");
+  }
+
+  BRepIntCurveSurface_Instance anInstance;
+  anInstance.Prototype     = thePrototype;
+  anInstance.FirstFace     = static_cast<Standard_Integer>(myFaces.size());
+  anInstance.FirstTriangle = myNbInstanceTriangles;
+
+  const gp_Trsf aToPart = theLocation.Inverted();
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      anInstance.ToPart[i][j] = aToPart.Value(i + 1, j + 1);
+    }
+  }
+
+  // World box of the eight corners of the part box
+  for (int aCorner = 0; aCorner < 8; ++aCorner)
+  {
+    const BVH_Vec3d aLocal((aCorner & 1) ? aPrototype.MaxPoint[0] : aPrototype.MinPoint[0],
+                           (aCorner & 2) ? aPrototype.MaxPoint[1] : aPrototype.MinPoint[1],
+                           (aCorner & 4) ? aPrototype.MaxPoint[2] : aPrototype.MinPoint[2]);
+    BVH_Vec3d       aWorld;
+    for (int i = 0; i < 3; ++i)
+    {
+      aWorld[i] = theLocation.Value(i + 1, 1) * aLocal[0] + theLocation.Value(i + 1, 2) * aLocal[1]
+                  + theLocation.Value(i + 1, 3) * aLocal[2] + theLocation.Value(i + 1, 4);
+    }
+    anInstance.MinPoint = aCorner == 0 ? aWorld : anInstance.MinPoint.cwiseMin(aWorld);
+    anInstance.MaxPoint = aCorner == 0 ? aWorld : anInstance.MaxPoint.cwiseMax(aWorld);
+  }
+
+  myFaces.insert(myFaces.end(), theFaces.begin(), theFaces.end());
+  myNbInstanceTriangles += aPrototype.NbTriangles;
+  myInstances.push_back(anInstance);
+  return static_cast<Standard_Integer>(myInstances.size()) - 1;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InstanceSet::Build()
+{
+  myTopLevel.Clear();
+  myLeafInstances.clear();
+  if (myNbInstanceTriangles == 0)
+    return;
+
+  opencascade::handle<BVH_Builder<Standard_Real, 3>> aBuilder =
+    new BVH_BinnedBuilder<Standard_Real, 3, 32>(TOP_LEVEL_LEAF_SIZE,
+                                                BRepIntCurveSurface_FlatBVH::MaxStackSize - 1);
+  opencascade::handle<BVH_BoxSet<Standard_Real, 3, Standard_Integer>> aBoxSet =
+    new BVH_BoxSet<Standard_Real, 3, Standard_Integer>(aBuilder);
+  for (size_t i = 0; i < myInstances.size(); ++i)
+  {
+    // Instances of untessellated parts have no box and are never hit
+    if (myPrototypes[myInstances[i].Prototype].NbTriangles == 0)
+      continue;
+
+    aBoxSet->Add(static_cast<Standard_Integer>(i),
+                 BVH_Box<Standard_Real, 3>(myInstances[i].MinPoint, myInstances[i].MaxPoint));
+  }
+  aBoxSet->Build();
+
+  // The build reorders the boxes; keep the instance of every primitive
+  myLeafInstances.resize(aBoxSet->Size());
+  for (Standard_Integer p = 0; p < aBoxSet->Size(); ++p)
+  {
+    myLeafInstances[p] = aBoxSet->Element(p);
+  }
+  myTopLevel.Build(*aBoxSet->BVH(), Standard_False);
+}
+
+//=================================================================================================
+
+Standard_Integer BRepIntCurveSurface_InstanceSet::FindInstance(
+  const Standard_Integer theTriangle) const
+{
+  if (theTriangle < 0 || theTriangle >= myNbInstanceTriangles)
+    return -1;
+
+  // Last instance starting at or before the triangle (instances of empty parts are skipped)
+  const auto anIter = std::upper_bound(myInstances.begin(),
+                                       myInstances.end(),
+                                       theTriangle,
+                                       [](const Standard_Integer              theValue,
+                                          const BRepIntCurveSurface_Instance& theInstance) {
+                                         return theValue < theInstance.FirstTriangle;
+                                       });
+  return static_cast<Standard_Integer>(anIter - myInstances.begin()) - 1;
+}
+
+//=================================================================================================
+
+Standard_Size BRepIntCurveSurface_InstanceSet::MemorySize() const
+{
+  Standard_Size aSize = myTopLevel.MemorySize()
+                        + myInstances.capacity() * sizeof(BRepIntCurveSurface_Instance)
+                        + (myFaces.capacity() + myLeafInstances.capacity())
+                            * sizeof(Standard_Integer);
+  for (const BRepIntCurveSurface_Prototype& aPrototype : myPrototypes)
+  {
+    aSize += sizeof(BRepIntCurveSurface_Prototype) + aPrototype.FlatBVH.MemorySize()
+             + aPrototype.WideBVH.MemorySize() + aPrototype.Packets.MemorySize()
+             + aPrototype.Records.capacity() * sizeof(BRepIntCurveSurface_TriangleRecord);
+  }
+  return aSize;
+}
@@ -0,0 +1,190 @@
+// Created on: 2025-03-31
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_InstanceSet_HeaderFile
+#define _BRepIntCurveSurface_InstanceSet_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+
+#include <BRepIntCurveSurface_FlatBVH.hxx>
+#include <BRepIntCurveSurface_TrianglePackets.hxx>
+#include <BRepIntCurveSurface_WideBVH.hxx>
+#include <gp_Trsf.hxx>
+
+#include <vector>
+
+//! Triangle BVH of one part in the part's own coordinates, shared by all the
+//! instances of the part (bottom level)
+struct BRepIntCurveSurface_Prototype
+{
+  BRepIntCurveSurface_FlatBVH                     FlatBVH; //!< Binary nodes (if not wide)
+  BRepIntCurveSurface_WideBVH                     WideBVH; //!< Wide nodes (if width > 2)
+  BRepIntCurveSurface_TrianglePackets             Packets; //!< SIMD packets (if enabled)
+  std::vector<BRepIntCurveSurface_TriangleRecord> Records; //!< Leaf-order records (no packets)
+  BVH_Vec3d                                       MinPoint;      //!< Box of the part
+  BVH_Vec3d                                       MaxPoint;      //!< Box of the part
+  Standard_Integer                                FirstTriangle; //!< First triangle info
+  Standard_Integer                                FirstUVFace;   //!< First face of UV origins
+  Standard_Integer                                NbTriangles;
+  Standard_Integer                                NbFaces;
+
+  BRepIntCurveSurface_Prototype()
+      : FirstTriangle(0),
+        FirstUVFace(0),
+        NbTriangles(0),
+        NbFaces(0)
+  {
+  }
+};
+
+//! Located occurrence of a part (top level)
+struct BRepIntCurveSurface_Instance
+{
+  Standard_Real    ToPart[3][4];  //!< Affine map from world to part coordinates (rows)
+  BVH_Vec3d        MinPoint;      //!< World box
+  BVH_Vec3d        MaxPoint;      //!< World box
+  Standard_Integer Prototype;     //!< Index of the part's prototype
+  Standard_Integer FirstFace;     //!< First entry of the instance in the face table
+  Standard_Integer FirstTriangle; //!< Hit index of the instance's first triangle
+
+  //! Map a ray into part coordinates. The direction is not normalized, so that ray
+  //! parameters are the same in both frames.
+  void ToPartRay(const BVH_Vec3d& theOrigin,
+                 const BVH_Vec3d& theDir,
+                 BVH_Vec3d&       thePartOrigin,
+                 BVH_Vec3d&       thePartDir) const
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      thePartOrigin[i] = ToPart[i][0] * theOrigin[0] + ToPart[i][1] * theOrigin[1]
+                         + ToPart[i][2] * theOrigin[2] + ToPart[i][3];
+      thePartDir[i] =
+        ToPart[i][0] * theDir[0] + ToPart[i][1] * theDir[1] + ToPart[i][2] * theDir[2];
+    }
+  }
+};
+
+//! Two-level acceleration structure for assemblies: one triangle BVH per distinct
+//! part (prototype) and a top-level BVH over the world boxes of the located
+//! instances of the parts. Rays are mapped into part coordinates at the instances.
+//!
+//! Triangles hit through an instance are numbered after the triangles of all
+//! previous instances, so that a single integer identifies the triangle and the
+//! instance; FindInstance() recovers the instance.
+class BRepIntCurveSurface_InstanceSet
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Empty constructor
+  BRepIntCurveSurface_InstanceSet()
+      : myNbInstanceTriangles(0)
+  {
+  }
+
+  //! Release all prototypes and instances
+  Standard_EXPORT void Clear();
+
+  //! Returns true if no instances are stored
+  Standard_Boolean IsEmpty() const { return myInstances.empty(); }
+
+  //! Append a prototype; its nodes are built by the caller
+  //! @return the prototype index
+  Standard_Integer AddPrototype()
+  {
+    myPrototypes.emplace_back();
+    return static_cast<Standard_Integer>(myPrototypes.size()) - 1;
+  }
+
+  //! Append an instance of a prototype placed by theLocation (part to world).
+  //! The world box is derived from the prototype box, which must be set.
+  //! @param thePrototype Prototype index
+  //! @param theLocation Transformation from part to world coordinates
+  //! @param theFaces Face map indices of the instance's faces, in prototype face order
+  //! @return the instance index
+  Standard_EXPORT Standard_Integer AddInstance(const Standard_Integer               thePrototype,
+                                               const gp_Trsf&                       theLocation,
+                                               const std::vector<Standard_Integer>& theFaces);
+
+  //! Build the top-level BVH over the instance boxes
+  Standard_EXPORT void Build();
+
+  //! Returns the number of prototypes
+  Standard_Integer NbPrototypes() const
+  {
+    return static_cast<Standard_Integer>(myPrototypes.size());
+  }
+
+  //! Returns prototype theIndex (0-based)
+  BRepIntCurveSurface_Prototype& ChangePrototype(const Standard_Integer theIndex)
+  {
+    return myPrototypes[theIndex];
+  }
+
+  //! Returns prototype theIndex (0-based)
+  const BRepIntCurveSurface_Prototype& Prototype(const Standard_Integer theIndex) const
+  {
+    return myPrototypes[theIndex];
+  }
+
+  //! Returns the number of instances
+  Standard_Integer NbInstances() const
+  {
+    return static_cast<Standard_Integer>(myInstances.size());
+  }
+
+  //! Returns instance theIndex (0-based)
+  const BRepIntCurveSurface_Instance& Instance(const Standard_Integer theIndex) const
+  {
+    return myInstances[theIndex];
+  }
+
+  //! Returns the number of triangles over all instances (the range of hit indices)
+  Standard_Integer NbInstanceTriangles() const { return myNbInstanceTriangles; }
+
+  //! Returns the instance whose triangles include hit index theTriangle, or -1
+  Standard_EXPORT Standard_Integer FindInstance(const Standard_Integer theTriangle) const;
+
+  //! Returns the face map index (0-based) of face theFace (0-based, in prototype face
+  //! order) of instance theInstance
+  Standard_Integer InstanceFace(const Standard_Integer theInstance,
+                                const Standard_Integer theFace) const
+  {
+    return myFaces[myInstances[theInstance].FirstFace + theFace];
+  }
+
+  //! Returns the top-level nodes (double precision, instances as primitives)
+  const BRepIntCurveSurface_FlatBVH& TopLevel() const { return myTopLevel; }
+
+  //! Returns the instance referenced by top-level primitive thePrim
+  const BRepIntCurveSurface_Instance& LeafInstance(const Standard_Integer thePrim) const
+  {
+    return myInstances[myLeafInstances[thePrim]];
+  }
+
+  //! Returns the memory held by the nodes, triangles and instances in bytes
+  Standard_EXPORT Standard_Size MemorySize() const;
+
+private:
+  std::vector<BRepIntCurveSurface_Prototype> myPrototypes;
+  std::vector<BRepIntCurveSurface_Instance>  myInstances;
+  std::vector<Standard_Integer>              myFaces;         //!< Face map index per instance face
+  std::vector<Standard_Integer>              myLeafInstances; //!< Instance per top-level primitive
+  BRepIntCurveSurface_FlatBVH                myTopLevel;
+  Standard_Integer                           myNbInstanceTriangles;
+};
+
+#endif // _BRepIntCurveSurface_InstanceSet_HeaderFile
@@ -15,22 +15,33 @@
 
 #include <BRepIntCurveSurface_InterBVH.hxx>
 
+#include <BRepIntCurveSurface_BVHCache.hxx>
+#include <BRepIntCurveSurface_VertexWelder.hxx>
+
 #include <BVH_Traverse.hxx>
 #include <BVH_Tools.hxx>
 #include <BVH_BinnedBuilder.hxx>
 #include <BVH_LinearBuilder.hxx>
+#include <BVH_SweepPlaneBuilder.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <IMeshTools_Parameters.hxx>
 #include <BRepBndLib.hxx>
 #include <Bnd_Box.hxx>
+#include <TopExp.hxx>
 #include <TopExp_Explorer.hxx>
+#include <TopoDS_Iterator.hxx>
 #include <TopoDS.hxx>
 #include <StdFail_NotDone.hxx>
+#include <Standard_DimensionMismatch.hxx>
 #include <Standard_OutOfRange.hxx>
 #include <BRep_Tool.hxx>
 #include <Poly_Triangulation.hxx>
 #include <Poly_Triangle.hxx>
+#include <Poly_PolygonOnTriangulation.hxx>
 #include <TopLoc_Location.hxx>
 #include <BRepAdaptor_Surface.hxx>
 #include <Adaptor3d_Surface.hxx>
+#include <ElCLib.hxx>
 #include <gp_Vec.hxx>
 #include <set>
 
@@ -39,14 +50,18 @@
 #include <iomanip>
 #include <chrono>
 #include <atomic>
-#include <unordered_map>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 
 #ifdef _OPENMP
   #include <omp.h>
 #endif
 
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif
+
 // Debug timing stats (thread-safe)
 namespace
 {
@@ -118,90 +133,626 @@ inline void ComputeHeightHessian(const gp_Vec&  dSdu,
   hyy = p01 * cp01 + p11 * cp11;
 }
 
+//! Evaluate the requested channels (normal, principal curvatures, height-field Hessian)
+//! of a hit at its (U, V) parameters; the normal is reversed for reversed faces. Points
+//! need no evaluation, normals the first derivatives, curvatures and the Hessian the
+//! second ones. Derivatives of elementary surfaces are evaluated from theAnalytic (if
+//! not null), those of spline surfaces from the span cache of theSpline (if defined),
+//! instead of the adaptor.
+template <BRepIntCurveSurface_HitChannels theChannels>
+inline void ComputeHitGeometry(const Adaptor3d_Surface&                   theSurface,
+                               const BRepIntCurveSurface_AnalyticSurface* theAnalytic,
+                               const BRepIntCurveSurface_SplineSurface&   theSpline,
+                               const Standard_Boolean                     theIsReversed,
+                               BRepIntCurveSurface_HitResult&             theResult)
+{
+  constexpr Standard_Boolean toNormal =
+    (theChannels & BRepIntCurveSurface_HitChannel_Normal) != 0;
+  constexpr Standard_Boolean toCurvature =
+    (theChannels & BRepIntCurveSurface_HitChannel_Curvature) != 0;
+  constexpr Standard_Boolean toHessian =
+    (theChannels & BRepIntCurveSurface_HitChannel_Hessian) != 0;
+  if constexpr (!toNormal && !toCurvature && !toHessian)
+  {
+    return;
+  }
+  else
+  {
+    gp_Pnt aPnt;
+    gp_Vec dSdu, dSdv, d2Sdu2, d2Sdv2, d2Sduv;
+    if constexpr (toCurvature || toHessian)
+    {
+      if (theAnalytic != nullptr)
+        theAnalytic->D2(theResult.U, theResult.V, aPnt, dSdu, dSdv, d2Sdu2, d2Sdv2, d2Sduv);
+      else if (theSpline.IsDefined())
+        theSpline.D2(theResult.U, theResult.V, aPnt, dSdu, dSdv, d2Sdu2, d2Sdv2, d2Sduv);
+      else
+        theSurface.D2(theResult.U, theResult.V, aPnt, dSdu, dSdv, d2Sdu2, d2Sdv2, d2Sduv);
+    }
+    else
+    {
+      if (theAnalytic != nullptr)
+        theAnalytic->D1(theResult.U, theResult.V, aPnt, dSdu, dSdv);
+      else if (theSpline.IsDefined())
+        theSpline.D1(theResult.U, theResult.V, aPnt, dSdu, dSdv);
+      else
+        theSurface.D1(theResult.U, theResult.V, aPnt, dSdu, dSdv);
+    }
+
+    if constexpr (toHessian)
+    {
+      // Analytic height-field Hessian in the world-Z projection frame
+      ComputeHeightHessian(dSdu,
+                           dSdv,
+                           d2Sdu2,
+                           d2Sdv2,
+                           d2Sduv,
+                           theResult.HeightHessXX,
+                           theResult.HeightHessYY,
+                           theResult.HeightHessXY);
+    }
+    if constexpr (!toNormal && !toCurvature)
+    {
+      return;
+    }
+
+    gp_Vec        normalVec = dSdu.Crossed(dSdv);
+    Standard_Real normalMag = normalVec.Magnitude();
+
+    if (normalMag <= 1e-10)
+    {
+      theResult.Normal = gp_Dir(0, 0, 1);
+      return;
+    }
+
+    normalVec.Normalize();
+    if (theIsReversed)
+      normalVec.Reverse();
+    theResult.Normal = gp_Dir(normalVec);
+
+    if constexpr (toCurvature)
+    {
+      Standard_Real E = dSdu.Dot(dSdu);
+      Standard_Real F = dSdu.Dot(dSdv);
+      Standard_Real G = dSdv.Dot(dSdv);
+      Standard_Real L = d2Sdu2.Dot(normalVec);
+      Standard_Real M = d2Sduv.Dot(normalVec);
+      Standard_Real N = d2Sdv2.Dot(normalVec);
+
+      Standard_Real denom = E * G - F * F;
+      if (std::abs(denom) > 1e-20)
+      {
+        theResult.GaussianCurvature = (L * N - M * M) / denom;
+        theResult.MeanCurvature     = (E * N - 2.0 * F * M + G * L) / (2.0 * denom);
+        Standard_Real disc =
+          theResult.MeanCurvature * theResult.MeanCurvature - theResult.GaussianCurvature;
+        Standard_Real sqrtDisc = std::sqrt(std::max(0.0, disc));
+        theResult.MinCurvature = theResult.MeanCurvature - sqrtDisc;
+        theResult.MaxCurvature = theResult.MeanCurvature + sqrtDisc;
+      }
+    }
+  }
+}
+
+//! Specialisation of ComputeHitGeometry() for a set of channels
+typedef void (*HitGeometryKernel)(const Adaptor3d_Surface&,
+                                  const BRepIntCurveSurface_AnalyticSurface*,
+                                  const BRepIntCurveSurface_SplineSurface&,
+                                  const Standard_Boolean,
+                                  BRepIntCurveSurface_HitResult&);
+
+//! Select the specialisation of ComputeHitGeometry() evaluating theChannels, once per
+//! batch, so that the hits of the batch skip the evaluations of unrequested channels
+HitGeometryKernel SelectHitGeometryKernel(const BRepIntCurveSurface_HitChannels theChannels)
+{
+  static const HitGeometryKernel THE_KERNELS[BRepIntCurveSurface_HitChannel_All + 1] = {
+    ComputeHitGeometry<0>,
+    ComputeHitGeometry<1>,
+    ComputeHitGeometry<2>,
+    ComputeHitGeometry<3>,
+    ComputeHitGeometry<4>,
+    ComputeHitGeometry<5>,
+    ComputeHitGeometry<6>,
+    ComputeHitGeometry<7>};
+  return THE_KERNELS[theChannels & BRepIntCurveSurface_HitChannel_All];
+}
+
 // Default vertex welding tolerance
 constexpr double DEFAULT_WELD_TOLERANCE = 1.0e-3;
 
-//! Spatial hash grid for vertex welding
-//! Uses cell size = tolerance, checks 27 neighboring cells for proper tolerance matching
-class SpatialVertexGrid
+// Newton refinement: iteration limit, and UV trust region as the hit triangle's UV box
+// grown by this multiple of its size on each side, the size being at least this fraction
+// of the face's parameter range
+constexpr int    NEWTON_MAX_ITERATIONS     = 16;
+constexpr double NEWTON_TRUST_REGION_SCALE = 2.0;
+constexpr double NEWTON_MIN_TRUST_REGION   = 1.0e-3;
+
+// Triangle splitting: at most 2^TRIANGLE_SPLIT_LEVELS references per triangle
+constexpr int TRIANGLE_SPLIT_LEVELS = 3;
+// Only triangles whose box half area exceeds this multiple of their own area are split
+constexpr double TRIANGLE_SPLIT_AREA_RATIO = 4.0;
+// A split is kept only if the two halves' boxes shrink the parent box area by this factor
+constexpr double TRIANGLE_SPLIT_GAIN = 0.75;
+
+// Face updates rebuild the BVH instead of refitting it when the edited triangles exceed
+// this fraction of the triangle slots
+constexpr double UPDATE_MAX_EDIT_RATIO = 0.25;
+// ... or when the slots taken over by other faces since the last build (which stretch
+// the leaf boxes) exceed this fraction
+constexpr double UPDATE_MAX_MOVED_RATIO = 0.125;
+
+//! Half surface area of an axis-aligned box
+inline double BoxHalfArea(const BVH_Vec3d& theMin, const BVH_Vec3d& theMax)
 {
-public:
-  SpatialVertexGrid(double tolerance, size_t reserveSize)
-      : myTol(tolerance),
-        myTolSq(tolerance * tolerance)
+  const BVH_Vec3d aSize = theMax - theMin;
+  return aSize[0] * aSize[1] + aSize[1] * aSize[2] + aSize[2] * aSize[0];
+}
+
+//! Bounding box of a convex polygon
+inline void PolygonBox(const std::vector<BVH_Vec3d>& thePoly, BVH_Vec3d& theMin, BVH_Vec3d& theMax)
+{
+  theMin = theMax = thePoly.front();
+  for (const BVH_Vec3d& aPnt : thePoly)
   {
-    myCells.reserve(reserveSize);
+    theMin = theMin.cwiseMin(aPnt);
+    theMax = theMax.cwiseMax(aPnt);
   }
+}
+
+//! Append a reference of original triangle theOrig bounded by the given box. The
+//! reference is a degenerate triangle through the box min, max and center corners:
+//! BVH_Triangulation reads only the bounds and centroid of an element.
+void AddBoxReference(std::vector<BVH_Vec3d>& theVertices,
+                     std::vector<BVH_Vec4i>& theElements,
+                     const BVH_Vec3d&        theMin,
+                     const BVH_Vec3d&        theMax,
+                     const Standard_Integer  theOrig)
+{
+  const Standard_Integer aFirst = static_cast<Standard_Integer>(theVertices.size());
+  theVertices.push_back(theMin);
+  theVertices.push_back(theMax);
+  theVertices.push_back((theMin + theMax) * 0.5);
+  theElements.push_back(BVH_Vec4i(aFirst, aFirst + 1, aFirst + 2, theOrig));
+}
 
-  //! Find existing vertex within tolerance, or add new one
-  //! Returns vertex index
-  Standard_Integer FindOrAdd(const BVH_Vec3d& v, std::vector<BVH_Vec3d>& vertices)
+//! Early split clipping: cut the polygon at the middle of the longest box axis while the
+//! two parts' boxes cover markedly less area than the parent box, then emit one
+//! reference per part. Returns the number of references added.
+Standard_Integer SplitPolygonReferences(std::vector<BVH_Vec3d>&       theVertices,
+                                        std::vector<BVH_Vec4i>&       theElements,
+                                        const std::vector<BVH_Vec3d>& thePoly,
+                                        const Standard_Integer        theOrig,
+                                        const int                     theLevel)
+{
+  BVH_Vec3d aMin, aMax;
+  PolygonBox(thePoly, aMin, aMax);
+
+  if (theLevel < TRIANGLE_SPLIT_LEVELS)
   {
-    int64_t cx = CellCoord(v[0]);
-    int64_t cy = CellCoord(v[1]);
-    int64_t cz = CellCoord(v[2]);
+    const BVH_Vec3d aSize = aMax - aMin;
+    const int       anAxis =
+      aSize[0] > aSize[1] ? (aSize[0] > aSize[2] ? 0 : 2) : (aSize[1] > aSize[2] ? 1 : 2);
+    const double aPlane = 0.5 * (aMin[anAxis] + aMax[anAxis]);
+
+    // Sutherland-Hodgman against both half-spaces; points on the plane go to both parts
+    std::vector<BVH_Vec3d> aLeft, aRight;
+    for (size_t i = 0; i < thePoly.size(); ++i)
+    {
+      const BVH_Vec3d& aP  = thePoly[i];
+      const BVH_Vec3d& aQ  = thePoly[(i + 1) % thePoly.size()];
+      const double     aDp = aP[anAxis] - aPlane;
+      const double     aDq = aQ[anAxis] - aPlane;
+      if (aDp <= 0.0)
+        aLeft.push_back(aP);
+      if (aDp >= 0.0)
+        aRight.push_back(aP);
+      if ((aDp < 0.0 && aDq > 0.0) || (aDp > 0.0 && aDq < 0.0))
+      {
+        BVH_Vec3d aCut = aP + (aQ - aP) * (aDp / (aDp - aDq));
+        aCut[anAxis]   = aPlane;
+        aLeft.push_back(aCut);
+        aRight.push_back(aCut);
+      }
+    }
 
-    // Check all 27 neighboring cells (including center)
-    for (int dx = -1; dx <= 1; ++dx)
+    if (aLeft.size() >= 3 && aRight.size() >= 3)
     {
-      for (int dy = -1; dy <= 1; ++dy)
+      BVH_Vec3d aLeftMin, aLeftMax, aRightMin, aRightMax;
+      PolygonBox(aLeft, aLeftMin, aLeftMax);
+      PolygonBox(aRight, aRightMin, aRightMax);
+      if (BoxHalfArea(aLeftMin, aLeftMax) + BoxHalfArea(aRightMin, aRightMax)
+          < TRIANGLE_SPLIT_GAIN * BoxHalfArea(aMin, aMax))
       {
-        for (int dz = -1; dz <= 1; ++dz)
-        {
-          uint64_t cellKey = MakeCellKey(cx + dx, cy + dy, cz + dz);
-          auto     it      = myCells.find(cellKey);
-          if (it != myCells.end())
-          {
-            // Check all vertices in this cell
-            for (Standard_Integer idx : it->second)
-            {
-              const BVH_Vec3d& existing = vertices[idx];
-              double           dx2      = v[0] - existing[0];
-              double           dy2      = v[1] - existing[1];
-              double           dz2      = v[2] - existing[2];
-              if (dx2 * dx2 + dy2 * dy2 + dz2 * dz2 < myTolSq)
-              {
-                return idx; // Found match
-              }
-            }
-          }
-        }
+        return SplitPolygonReferences(theVertices, theElements, aLeft, theOrig, theLevel + 1)
+               + SplitPolygonReferences(theVertices, theElements, aRight, theOrig, theLevel + 1);
       }
     }
+  }
+
+  AddBoxReference(theVertices, theElements, aMin, aMax, theOrig);
+  return 1;
+}
+
+//! Append the BVH references of a triangle: the triangle itself, or for slivers whose
+//! box is much larger than the triangle, several references with clipped boxes.
+//! All references keep the original triangle index in w and the triangle is always
+//! tested whole, so splitting only tightens the boxes.
+//! Returns the number of references added.
+Standard_Integer AddTriangleReferences(std::vector<BVH_Vec3d>& theVertices,
+                                       std::vector<BVH_Vec4i>& theElements,
+                                       const BVH_Vec4i&        theElem)
+{
+  const std::vector<BVH_Vec3d> aTri = {theVertices[theElem[0]],
+                                       theVertices[theElem[1]],
+                                       theVertices[theElem[2]]};
+
+  BVH_Vec3d aMin, aMax;
+  PolygonBox(aTri, aMin, aMax);
+  const double aTriArea = 0.5 * BVH_Vec3d::Cross(aTri[1] - aTri[0], aTri[2] - aTri[0]).Modulus();
+  if (BoxHalfArea(aMin, aMax) > TRIANGLE_SPLIT_AREA_RATIO * aTriArea)
+  {
+    const Standard_Integer aNbRefs =
+      SplitPolygonReferences(theVertices, theElements, aTri, theElem[3], 0);
+    if (aNbRefs > 1)
+      return aNbRefs;
+
+    // Not worth splitting: replace the box reference by the triangle itself
+    theElements.pop_back();
+    theVertices.resize(theVertices.size() - 3);
+  }
+
+  theElements.push_back(theElem);
+  return 1;
+}
+
+//! Sections of a triangle BVH cache file
+enum BVHCacheSection : uint32_t
+{
+  BVHCacheSection_Params = 1,
+  BVHCacheSection_FaceOffsets,
+  BVHCacheSection_Vertices,
+  BVHCacheSection_Elements,
+  BVHCacheSection_TriangleIndices,
+  BVHCacheSection_TriangleRecords,
+  BVHCacheSection_Packets,
+  BVHCacheSection_FirstPackets,
+  BVHCacheSection_FlatNodesF,
+  BVHCacheSection_FlatNodesD,
+  BVHCacheSection_WideNodes4,
+  BVHCacheSection_WideNodes8,
+  BVHCacheSection_LeafSizes
+};
+
+//! Scalar results of a triangle BVH build kept in a cache file
+struct BVHCacheParams
+{
+  Standard_Integer NbWeldedVertices;
+  Standard_Integer NbTriangleSplits;
+  Standard_Integer NodesDepth; // Depth of the flat or wide nodes
+  Standard_Integer StatNbNodes;
+  Standard_Integer StatNbLeaves;
+  Standard_Integer StatNbPrimitives;
+  Standard_Integer StatDepth;
+  Standard_Integer Padding; // Keeps the file free of uninitialized bytes
+  Standard_Real    StatSAHCost;
+  Standard_Real    StatOverlapRatio;
+};
+
+//! Load() settings that change the cached data; hashed into the cache key
+struct BVHCacheSettings
+{
+  Standard_Real    Deflection;
+  Standard_Real    WeldTolerance;
+  Standard_Integer Builder;
+  Standard_Integer LeafSize;
+  Standard_Integer MaxDepth;
+  Standard_Integer Width;
+  Standard_Integer UseCompactNodes;
+  Standard_Integer UseTrianglePackets;
+  Standard_Integer TriangleLanes;
+  Standard_Integer UseTriangleSplits;
+  Standard_Integer WeldEdgesOnly;
+  Standard_Integer Padding;
+};
+
+//! Key of the cached triangle BVH of a tessellation: the settings, the triangle
+//! count of each face and the raw nodes and corners before welding. UV nodes are
+//! not cached, so they are not part of the key.
+uint64_t BVHCacheKey(const BVHCacheSettings&              theSettings,
+                     const std::vector<Standard_Integer>& theFaceOffsets,
+                     const std::vector<BVH_Vec3d>&        theNodes,
+                     const std::vector<Standard_Integer>& theCorners,
+                     const std::vector<char>&             theWeldMask)
+{
+  uint64_t aKey = BRepIntCurveSurface_BVHCache::Hash(theSettings, 0);
+  aKey          = BRepIntCurveSurface_BVHCache::Hash(theFaceOffsets, aKey);
+  aKey          = BRepIntCurveSurface_BVHCache::Hash(theNodes, aKey);
+  aKey          = BRepIntCurveSurface_BVHCache::Hash(theCorners, aKey);
+  return BRepIntCurveSurface_BVHCache::Hash(theWeldMask, aKey);
+}
+
+//! Release the storage of a vector (clear() keeps the capacity)
+template <class T>
+void ReleaseVector(std::vector<T>& theVector)
+{
+  std::vector<T>().swap(theVector);
+}
+
+//! Tessellation of one face gathered by UpdateFaces()
+struct FaceMesh
+{
+  std::vector<BVH_Vec3d>        Nodes;     // Located nodes
+  std::vector<Standard_Integer> Triangles; // Three 0-based node indices per triangle
+  std::vector<gp_Pnt2d>         UVs;       // UV node per node (zero if absent)
+};
+
+//! Copy the triangulation of a face, applying its location
+void GatherFaceMesh(const TopoDS_Face& theFace, FaceMesh& theMesh)
+{
+  TopLoc_Location                   aLoc;
+  const Handle(Poly_Triangulation)  aTriangulation = BRep_Tool::Triangulation(theFace, aLoc);
+  if (aTriangulation.IsNull())
+    return;
+
+  const gp_Trsf&         aTrsf        = aLoc.Transformation();
+  const Standard_Boolean hasTransform = !aLoc.IsIdentity();
+  theMesh.Nodes.resize(aTriangulation->NbNodes());
+  for (Standard_Integer aNode = 1; aNode <= aTriangulation->NbNodes(); ++aNode)
+  {
+    gp_Pnt aPnt = aTriangulation->Node(aNode);
+    if (hasTransform)
+      aPnt.Transform(aTrsf);
+    theMesh.Nodes[aNode - 1] = BVH_Vec3d(aPnt.X(), aPnt.Y(), aPnt.Z());
+  }
+
+  theMesh.UVs.resize(aTriangulation->NbNodes(), gp_Pnt2d(0, 0));
+  if (aTriangulation->HasUVNodes())
+  {
+    for (Standard_Integer aNode = 1; aNode <= aTriangulation->NbNodes(); ++aNode)
+      theMesh.UVs[aNode - 1] = aTriangulation->UVNode(aNode);
+  }
+
+  theMesh.Triangles.resize(static_cast<size_t>(aTriangulation->NbTriangles()) * 3);
+  for (Standard_Integer triIdx = 1; triIdx <= aTriangulation->NbTriangles(); ++triIdx)
+  {
+    Standard_Integer aNodes[3];
+    aTriangulation->Triangle(triIdx).Get(aNodes[0], aNodes[1], aNodes[2]);
+    for (int k = 0; k < 3; ++k)
+    {
+      theMesh.Triangles[(triIdx - 1) * 3 + k] = aNodes[k] - 1;
+    }
+  }
+}
 
-    // No match found - add new vertex
-    Standard_Integer newIdx = static_cast<Standard_Integer>(vertices.size());
-    vertices.push_back(v);
+//! Store the UV nodes of a face in the UV node table, relative to the face's first
+//! node in compact mode. If the table keeps derivatives, theSurface is evaluated at
+//! every node, in the frame of the triangulation nodes.
+void StoreFaceUVs(const gp_Pnt2d*                  theUVs,
+                  const Standard_Integer           theNbNodes,
+                  const Standard_Integer           theNodeFirst,
+                  const Standard_Integer           theFace,
+                  const Adaptor3d_Surface&         theSurface,
+                  BRepIntCurveSurface_TriangleUVs& theTable)
+{
+  if (theNbNodes == 0)
+    return;
 
-    // Add to grid cell
-    uint64_t cellKey = MakeCellKey(cx, cy, cz);
-    myCells[cellKey].push_back(newIdx);
+  theTable.SetOrigin(theFace, theUVs[0]);
+  for (Standard_Integer i = 0; i < theNbNodes; ++i)
+  {
+    theTable.SetNode(theNodeFirst + i, theFace, theUVs[i]);
+  }
+  if (!theTable.HasDerivatives())
+    return;
 
-    return newIdx;
+  gp_Pnt aPnt;
+  gp_Vec aD1U, aD1V;
+  for (Standard_Integer i = 0; i < theNbNodes; ++i)
+  {
+    theSurface.D1(theUVs[i].X(), theUVs[i].Y(), aPnt, aD1U, aD1V);
+    theTable.SetDerivatives(theNodeFirst + i, aD1U, aD1V);
   }
+}
 
-private:
-  int64_t CellCoord(double val) const { return static_cast<int64_t>(std::floor(val / myTol)); }
+//! Create the builder of a triangle BVH. SAH builders split the node queue over
+//! theNbThreads threads, the linear builder sorts Morton codes and refits bounds in parallel.
+opencascade::handle<BVH_Builder<Standard_Real, 3>> NewTriangleBuilder(
+  const BRepIntCurveSurface_BVHBuilder theType,
+  const Standard_Integer               theLeafSize,
+  const Standard_Integer               theMaxDepth,
+  const Standard_Integer               theNbThreads)
+{
+  opencascade::handle<BVH_Builder<Standard_Real, 3>> aBuilder;
+  switch (theType)
+  {
+    case BRepIntCurveSurface_BVHBuilder::BinnedSAH:
+      aBuilder = new BVH_BinnedBuilder<Standard_Real, 3, 32>(theLeafSize,
+                                                             theMaxDepth,
+                                                             Standard_False,
+                                                             theNbThreads);
+      break;
+    case BRepIntCurveSurface_BVHBuilder::SweepSAH:
+      aBuilder =
+        new BVH_SweepPlaneBuilder<Standard_Real, 3>(theLeafSize, theMaxDepth, theNbThreads);
+      break;
+    default:
+      aBuilder = new BVH_LinearBuilder<Standard_Real, 3>(theLeafSize, theMaxDepth);
+      break;
+  }
+  aBuilder->SetParallel(theNbThreads > 1);
+  return aBuilder;
+}
+
+//! Collect the part instances of an assembly: compounds are traversed (composing the
+//! locations of nested compounds) and every other sub-shape is an instance
+void CollectInstanceShapes(const TopoDS_Shape& theShape, std::vector<TopoDS_Shape>& theParts)
+{
+  if (theShape.ShapeType() != TopAbs_COMPOUND)
+  {
+    theParts.push_back(theShape);
+    return;
+  }
+  for (TopoDS_Iterator anIter(theShape); anIter.More(); anIter.Next())
+  {
+    CollectInstanceShapes(anIter.Value(), theParts);
+  }
+}
 
-  uint64_t MakeCellKey(int64_t x, int64_t y, int64_t z) const
+//! Group the parts that share a face or an edge, also through different locations.
+//! Meshing writes the triangulations of the faces and the polygons of the edges, so
+//! parts of different groups can be meshed concurrently.
+void GroupMeshParts(const std::vector<TopoDS_Shape>&            theParts,
+                    std::vector<std::vector<Standard_Integer>>& theGroups)
+{
+  const Standard_Integer        nParts = static_cast<Standard_Integer>(theParts.size());
+  std::vector<Standard_Integer> aParents(nParts);
+  for (Standard_Integer i = 0; i < nParts; ++i)
   {
-    // Combine 3 coordinates into single key
-    // Use 21 bits per coordinate (covers ±1 million cells)
-    return ((static_cast<uint64_t>(x) & 0x1FFFFF)) | ((static_cast<uint64_t>(y) & 0x1FFFFF) << 21)
-           | ((static_cast<uint64_t>(z) & 0x1FFFFF) << 42);
+    aParents[i] = i;
   }
+  auto findRoot = [&aParents](Standard_Integer thePart) {
+    while (aParents[thePart] != thePart)
+    {
+      aParents[thePart] = aParents[aParents[thePart]];
+      thePart           = aParents[thePart];
+    }
+    return thePart;
+  };
 
-  double                                                      myTol;
-  double                                                      myTolSq;
-  std::unordered_map<uint64_t, std::vector<Standard_Integer>> myCells;
-};
+  // First part owning every sub-shape, keyed without location
+  TopTools_IndexedMapOfShape    aSubShapes;
+  std::vector<Standard_Integer> anOwners;
+  for (Standard_Integer i = 0; i < nParts; ++i)
+  {
+    for (const TopAbs_ShapeEnum aType : {TopAbs_FACE, TopAbs_EDGE})
+    {
+      for (TopExp_Explorer anExp(theParts[i], aType); anExp.More(); anExp.Next())
+      {
+        const Standard_Integer anIndex =
+          aSubShapes.Add(anExp.Current().Located(TopLoc_Location()));
+        if (anIndex > static_cast<Standard_Integer>(anOwners.size()))
+          anOwners.push_back(i);
+        else
+          aParents[findRoot(i)] = findRoot(anOwners[anIndex - 1]);
+      }
+    }
+  }
+
+  std::vector<Standard_Integer> aGroupOfRoot(nParts, -1);
+  for (Standard_Integer i = 0; i < nParts; ++i)
+  {
+    Standard_Integer& aGroup = aGroupOfRoot[findRoot(i)];
+    if (aGroup < 0)
+    {
+      aGroup = static_cast<Standard_Integer>(theGroups.size());
+      theGroups.emplace_back();
+    }
+    theGroups[aGroup].push_back(i);
+  }
+}
+
+//! Copy the triangulation of a face: the located nodes and their UV nodes, the corners
+//! (node indices offset by theNodeFirst) and the triangle infos, whose UV nodes are the
+//! corners. With a weld mask, the nodes lying on the face's edges are flagged.
+void GatherFaceTriangles(const TopoDS_Face&                theFace,
+                         const Handle(Poly_Triangulation)& theTriangulation,
+                         const TopLoc_Location&            theLoc,
+                         const Standard_Integer            theFaceIndex,
+                         const Standard_Integer            theNodeFirst,
+                         BVH_Vec3d*                        theNodes,
+                         gp_Pnt2d*                         theUVs,
+                         Standard_Integer*                 theCorners,
+                         char*                             theWeldMask,
+                         BRepIntCurveSurface_TriangleInfo* theInfos)
+{
+  const gp_Trsf&         aTrsf        = theLoc.Transformation();
+  const Standard_Boolean hasTransform = (theLoc.IsIdentity() == Standard_False);
+
+  // Get 3D vertices, applying the face transformation if needed
+  for (Standard_Integer aNode = 1; aNode <= theTriangulation->NbNodes(); ++aNode)
+  {
+    gp_Pnt aPnt = theTriangulation->Node(aNode);
+    if (hasTransform)
+      aPnt.Transform(aTrsf);
+    theNodes[aNode - 1] = BVH_Vec3d(aPnt.X(), aPnt.Y(), aPnt.Z());
+  }
+
+  if (theWeldMask != nullptr)
+  {
+    // Flag the nodes of the edge polygons; without them the whole face is welded. The
+    // polygons are stored under the location of the triangulation.
+    Standard_Boolean hasPolygons = Standard_True;
+    for (TopExp_Explorer anEdgeExp(theFace, TopAbs_EDGE); anEdgeExp.More(); anEdgeExp.Next())
+    {
+      const Handle(Poly_PolygonOnTriangulation) aPolygon =
+        BRep_Tool::PolygonOnTriangulation(TopoDS::Edge(anEdgeExp.Current()),
+                                          theTriangulation,
+                                          theLoc);
+      if (aPolygon.IsNull())
+      {
+        hasPolygons = Standard_False;
+        break;
+      }
+      for (Standard_Integer i = 1; i <= aPolygon->NbNodes(); ++i)
+        theWeldMask[aPolygon->Node(i) - 1] = 1;
+    }
+    if (!hasPolygons)
+      std::fill(theWeldMask, theWeldMask + theTriangulation->NbNodes(), static_cast<char>(1));
+  }
+
+  // Get the UV nodes if available; without them the Newton refinement starts from
+  // the origin of the parameter space
+  const Standard_Boolean hasUVNodes = theTriangulation->HasUVNodes();
+  for (Standard_Integer aNode = 1; aNode <= theTriangulation->NbNodes(); ++aNode)
+  {
+    theUVs[aNode - 1] = hasUVNodes ? theTriangulation->UVNode(aNode) : gp_Pnt2d(0, 0);
+  }
+
+  for (Standard_Integer triIdx = 1; triIdx <= theTriangulation->NbTriangles(); ++triIdx)
+  {
+    const Poly_Triangle& aTri = theTriangulation->Triangle(triIdx);
+    Standard_Integer     aNodes[3];
+    aTri.Get(aNodes[0], aNodes[1], aNodes[2]);
+
+    BRepIntCurveSurface_TriangleInfo& aTriInfo = theInfos[triIdx - 1];
+    aTriInfo.FaceIndex                         = theFaceIndex; // 0-based
+    for (int k = 0; k < 3; ++k)
+    {
+      theCorners[(triIdx - 1) * 3 + k] = theNodeFirst + aNodes[k] - 1;
+      aTriInfo.UVNodes[k]              = theNodeFirst + aNodes[k] - 1;
+    }
+  }
+}
 } // namespace
 
-//! Newton iteration to refine ray-surface intersection starting from approximate UV
-//! Returns NewtonResult indicating convergence status
-//! @param theSurface Surface adaptor
+//! Triangles of one face gathered by MeshAndLoad() as soon as the face is meshed,
+//! in the layout of the arrays of loadTriangles() with face-local node indices
+struct BRepIntCurveSurface_InterBVH::GatheredFace
+{
+  std::vector<BVH_Vec3d>                        Nodes;
+  std::vector<gp_Pnt2d>                         UVs;
+  std::vector<Standard_Integer>                 Corners;
+  std::vector<char>                             WeldMask; // Empty unless edge-only welding
+  std::vector<BRepIntCurveSurface_TriangleInfo> Infos;
+  Standard_Boolean                              IsGathered = Standard_False;
+};
+
+//! Newton iteration on the ray-surface intersection starting from the approximate UV of
+//! a triangle hit. Returns NewtonResult indicating convergence status.
+//!
+//! The ray is the intersection of two orthogonal planes containing it, so that the
+//! intersection solves the square system F(u,v) = (N1.S(u,v) + d1, N2.S(u,v) + d2) = 0,
+//! whose residual is the distance of S to the ray; each iteration takes a full Newton
+//! step on it. Steps are bounded by a UV trust region grown from the triangle's UV box,
+//! which scales with the parametrization of the face. Periodic parameters of faces
+//! spanning the whole period are not clamped, so that iterates cross the seam, and are
+//! wrapped into the face range at the end; other parameters (also those of trimmed
+//! periodic faces) are clamped to the face bounds.
+//! @param theSurface Surface adaptor, or spline surface evaluated through its span cache
 //! @param theRayOrigin Ray origin point
 //! @param theRayDir Ray direction (normalized)
+//! @param theUVMin Lower corner of the UV box of the hit triangle
+//! @param theUVMax Upper corner of the UV box of the hit triangle
 //! @param theU Initial U parameter (will be refined)
 //! @param theV Initial V parameter (will be refined)
 //! @param theT Output: parameter along ray
@@ -210,129 +761,126 @@ private:
 //! loop)
 //! @param theTol Convergence tolerance
 //! @param theMaxIter Maximum iterations
-static NewtonResult RefineIntersectionNewton(const Adaptor3d_Surface& theSurface,
-                                             const gp_Pnt&            theRayOrigin,
-                                             const gp_Dir&            theRayDir,
-                                             Standard_Real&           theU,
-                                             Standard_Real&           theV,
-                                             Standard_Real&           theT,
-                                             gp_Pnt&                  thePnt,
-                                             Standard_Integer&        theIterCount,
-                                             const Standard_Real      theTol     = 1e-7,
-                                             const Standard_Integer   theMaxIter = 10)
-{
-  // Newton iteration to solve: S(u,v) = O + t*D
-  // where S is surface, O is ray origin, D is ray direction
-  // We minimize |S(u,v) - (O + t*D)|^2
-  //
-  // Equivalent to solving:
-  //   (S - O - t*D) . dS/du = 0
-  //   (S - O - t*D) . dS/dv = 0
-  //   (S - O - t*D) . D = 0
-
-  Standard_Real u = theU;
-  Standard_Real v = theV;
-
-  // Get surface parameter bounds
-  Standard_Real uMin = theSurface.FirstUParameter();
-  Standard_Real uMax = theSurface.LastUParameter();
-  Standard_Real vMin = theSurface.FirstVParameter();
-  Standard_Real vMax = theSurface.LastVParameter();
-
-  gp_Pnt S;
-  gp_Vec dSu, dSv;
-  gp_Vec D(theRayDir);
-  gp_Pnt O = theRayOrigin;
+template <class SurfaceType>
+static NewtonResult RefineIntersectionNewton(const SurfaceType&     theSurface,
+                                             const gp_Pnt&          theRayOrigin,
+                                             const gp_Dir&          theRayDir,
+                                             const gp_Pnt2d&        theUVMin,
+                                             const gp_Pnt2d&        theUVMax,
+                                             Standard_Real&         theU,
+                                             Standard_Real&         theV,
+                                             Standard_Real&         theT,
+                                             gp_Pnt&                thePnt,
+                                             Standard_Integer&      theIterCount,
+                                             const Standard_Real    theTol,
+                                             const Standard_Integer theMaxIter)
+{
+  const Standard_Real    uMin       = theSurface.FirstUParameter();
+  const Standard_Real    uMax       = theSurface.LastUParameter();
+  const Standard_Real    vMin       = theSurface.FirstVParameter();
+  const Standard_Real    vMax       = theSurface.LastVParameter();
+  const Standard_Real    aPTol      = Precision::PConfusion();
+  const Standard_Boolean isUWrapped =
+    theSurface.IsUPeriodic() && uMax - uMin >= theSurface.UPeriod() - aPTol;
+  const Standard_Boolean isVWrapped =
+    theSurface.IsVPeriodic() && vMax - vMin >= theSurface.VPeriod() - aPTol;
+
+  // Trust region: the triangle's UV box grown by NEWTON_TRUST_REGION_SCALE times its size
+  // on each side (at least a small fraction of the face range for degenerate triangles)
+  const Standard_Real aSizeU =
+    std::max(theUVMax.X() - theUVMin.X(), NEWTON_MIN_TRUST_REGION * (uMax - uMin));
+  const Standard_Real aSizeV =
+    std::max(theUVMax.Y() - theUVMin.Y(), NEWTON_MIN_TRUST_REGION * (vMax - vMin));
+  Standard_Real aLowU  = theUVMin.X() - NEWTON_TRUST_REGION_SCALE * aSizeU;
+  Standard_Real aHighU = theUVMax.X() + NEWTON_TRUST_REGION_SCALE * aSizeU;
+  Standard_Real aLowV  = theUVMin.Y() - NEWTON_TRUST_REGION_SCALE * aSizeV;
+  Standard_Real aHighV = theUVMax.Y() + NEWTON_TRUST_REGION_SCALE * aSizeV;
+  if (!isUWrapped)
+  {
+    aLowU  = std::max(aLowU, uMin);
+    aHighU = std::min(aHighU, uMax);
+  }
+  if (!isVWrapped)
+  {
+    aLowV  = std::max(aLowV, vMin);
+    aHighV = std::min(aHighV, vMax);
+  }
 
+  // Two planes through the ray: N1 . P + d1 = 0 and N2 . P + d2 = 0
+  const gp_XYZ&       D    = theRayDir.XYZ();
+  const gp_XYZ        aRef = std::abs(D.X()) < 0.9 ? gp_XYZ(1.0, 0.0, 0.0) : gp_XYZ(0.0, 1.0, 0.0);
+  const gp_XYZ        N1   = D.Crossed(aRef).Normalized();
+  const gp_XYZ        N2   = D.Crossed(N1);
+  const Standard_Real d1   = -N1.Dot(theRayOrigin.XYZ());
+  const Standard_Real d2   = -N2.Dot(theRayOrigin.XYZ());
+
+  Standard_Real    u           = std::max(aLowU, std::min(aHighU, theU));
+  Standard_Real    v           = std::max(aLowV, std::min(aHighV, theV));
   Standard_Boolean hitSingular = Standard_False;
+  Standard_Boolean isConverged = Standard_False;
+  gp_Pnt           S;
+  gp_Vec           dSu, dSv;
 
   Standard_Integer localIterCount = 0;
-  for (Standard_Integer iter = 0; iter < theMaxIter; ++iter)
+  while (localIterCount < theMaxIter)
   {
     ++localIterCount;
-
-    // Evaluate surface and derivatives
     theSurface.D1(u, v, S, dSu, dSv);
 
-    // Compute t = (S - O) . D (projection of surface point onto ray)
-    gp_Vec        SO(O, S);
-    Standard_Real t = SO.Dot(D);
-
-    // Residual vector: r = S - (O + t*D)
-    gp_Pnt rayPt = O.Translated(t * D);
-    gp_Vec r(rayPt, S);
-
-    // Check convergence
-    Standard_Real residual = r.Magnitude();
-    if (residual < theTol)
+    const Standard_Real F1 = N1.Dot(S.XYZ()) + d1;
+    const Standard_Real F2 = N2.Dot(S.XYZ()) + d2;
+    if (F1 * F1 + F2 * F2 < theTol * theTol)
     {
-      theU         = u;
-      theV         = v;
-      theT         = t;
-      thePnt       = S;
-      theIterCount = localIterCount;
-      return NewtonResult::Converged;
+      isConverged = Standard_True;
+      break;
     }
 
-    // Build 2x2 Jacobian for Newton step in (u,v)
-    // J = [ dSu.dSu  dSu.dSv ]
-    //     [ dSv.dSu  dSv.dSv ]
-    //
-    // RHS = -[ r.dSu ]
-    //       [ r.dSv ]
-
-    Standard_Real j11 = dSu.Dot(dSu);
-    Standard_Real j12 = dSu.Dot(dSv);
-    Standard_Real j21 = j12; // symmetric
-    Standard_Real j22 = dSv.Dot(dSv);
-
-    Standard_Real b1 = -r.Dot(dSu);
-    Standard_Real b2 = -r.Dot(dSv);
-
-    // Solve 2x2 system: J * [du, dv]^T = [b1, b2]^T
-    Standard_Real det = j11 * j22 - j12 * j21;
-    if (std::abs(det) < 1e-15)
+    // J = [N1.Su  N1.Sv; N2.Su  N2.Sv]; det(J) = D.(Su x Sv) vanishes when the ray is
+    // tangent to the surface
+    const Standard_Real j11 = N1.Dot(dSu.XYZ());
+    const Standard_Real j12 = N1.Dot(dSv.XYZ());
+    const Standard_Real j21 = N2.Dot(dSu.XYZ());
+    const Standard_Real j22 = N2.Dot(dSv.XYZ());
+    const Standard_Real det = j11 * j22 - j12 * j21;
+    if (std::abs(det) <= 1e-12 * dSu.Magnitude() * dSv.Magnitude())
     {
-      // Singular Jacobian - can't continue
       hitSingular = Standard_True;
       break;
     }
 
-    Standard_Real du = (j22 * b1 - j12 * b2) / det;
-    Standard_Real dv = (j11 * b2 - j21 * b1) / det;
+    Standard_Real du = (j12 * F2 - j22 * F1) / det;
+    Standard_Real dv = (j21 * F1 - j11 * F2) / det;
 
-    // Update with damping if step is too large
-    Standard_Real stepSize = std::sqrt(du * du + dv * dv);
-    if (stepSize > 0.5)
+    // Scale the step down to the trust region size, keeping its direction
+    const Standard_Real aStep = std::max(std::abs(du) / aSizeU, std::abs(dv) / aSizeV);
+    if (aStep > 1.0)
     {
-      Standard_Real scale = 0.5 / stepSize;
-      du *= scale;
-      dv *= scale;
+      du /= aStep;
+      dv /= aStep;
     }
 
-    u += du;
-    v += dv;
-
-    // Clamp to parameter bounds
-    u = std::max(uMin, std::min(uMax, u));
-    v = std::max(vMin, std::min(vMax, v));
+    u = std::max(aLowU, std::min(aHighU, u + du));
+    v = std::max(aLowV, std::min(aHighV, v + dv));
   }
 
-  // Did not converge within max iterations, but return best result
-  theSurface.D0(u, v, S);
-  gp_Vec SO(O, S);
-  theT   = SO.Dot(D);
-  theU   = u;
-  theV   = v;
-  thePnt = S;
-
-  // Check if final result is acceptable
-  gp_Pnt        rayPt         = O.Translated(theT * D);
-  Standard_Real finalResidual = S.Distance(rayPt);
+  if (!isConverged)
+    theSurface.D0(u, v, S);
 
+  const gp_Vec SO(theRayOrigin, S);
+  theT         = SO.Dot(gp_Vec(theRayDir));
+  thePnt       = S;
   theIterCount = localIterCount;
 
-  if (finalResidual < theTol * 10)
+  // Bring periodic parameters that crossed the seam back into the face range
+  theU = u;
+  theV = v;
+  if (isUWrapped && (u < uMin || u > uMax))
+    theU = ElCLib::InPeriod(u, uMin, uMin + theSurface.UPeriod());
+  if (isVWrapped && (v < vMin || v > vMax))
+    theV = ElCLib::InPeriod(v, vMin, vMin + theSurface.VPeriod());
+
+  const gp_Pnt aRayPnt = theRayOrigin.Translated(theT * gp_Vec(theRayDir));
+  if (isConverged || S.Distance(aRayPnt) < theTol * 10)
   {
     // Close enough - accept as converged
     return NewtonResult::Converged;
@@ -348,24 +896,88 @@ static NewtonResult RefineIntersectionNewton(const Adaptor3d_Surface& theSurface
   }
 }
 
+//! Refine a tessellation hit on its face: in closed form on elementary surfaces
+//! (theAnalytic not null), by Newton iteration from the interpolated UV otherwise or
+//! when the exact root leaves the face bounds. Newton iteration evaluates spline
+//! surfaces through the span cache of theSpline (if defined), others through the adaptor.
+//! @param theHintT Ray parameter of the tessellation hit
+//! @param theUVMin Lower corner of the UV box of the hit triangle
+//! @param theUVMax Upper corner of the UV box of the hit triangle
+//! @param theIterCount Output: Newton iterations performed (0 in closed form)
+static NewtonResult RefineIntersection(const Adaptor3d_Surface&                   theSurface,
+                                       const BRepIntCurveSurface_AnalyticSurface* theAnalytic,
+                                       const BRepIntCurveSurface_SplineSurface&   theSpline,
+                                       const gp_Pnt&                              theRayOrigin,
+                                       const gp_Dir&                              theRayDir,
+                                       const Standard_Real                        theHintT,
+                                       const gp_Pnt2d&                            theUVMin,
+                                       const gp_Pnt2d&                            theUVMax,
+                                       Standard_Real&                             theU,
+                                       Standard_Real&                             theV,
+                                       Standard_Real&                             theT,
+                                       gp_Pnt&                                    thePnt,
+                                       Standard_Integer&                          theIterCount,
+                                       const Standard_Real                        theTol,
+                                       const Standard_Integer                     theMaxIter)
+{
+  if (theAnalytic != nullptr
+      && theAnalytic->Intersect(theRayOrigin, theRayDir, theHintT, theU, theV, theT, thePnt))
+  {
+    theIterCount = 0;
+    return NewtonResult::Converged;
+  }
+  if (theSpline.IsDefined())
+  {
+    return RefineIntersectionNewton(theSpline,
+                                    theRayOrigin,
+                                    theRayDir,
+                                    theUVMin,
+                                    theUVMax,
+                                    theU,
+                                    theV,
+                                    theT,
+                                    thePnt,
+                                    theIterCount,
+                                    theTol,
+                                    theMaxIter);
+  }
+  return RefineIntersectionNewton(theSurface,
+                                  theRayOrigin,
+                                  theRayDir,
+                                  theUVMin,
+                                  theUVMax,
+                                  theU,
+                                  theV,
+                                  theT,
+                                  thePnt,
+                                  theIterCount,
+                                  theTol,
+                                  theMaxIter);
+}
+
 namespace
 {
-//! Möller–Trumbore ray-triangle intersection
+//! Surface of one face owned by one thread of a batch query: a shallow copy of the face
+//! adaptor and a copy of its spline surface, with their own evaluation caches
+struct ThreadLocalSurface
+{
+  Handle(Adaptor3d_Surface)         Adaptor;
+  BRepIntCurveSurface_SplineSurface Spline;
+};
+
+//! Möller–Trumbore ray-triangle intersection with precomputed edges
 //! Returns true if ray hits triangle, outputs t parameter and barycentric coords (u, v)
 inline Standard_Boolean RayTriangleIntersect(const BVH_Vec3d& rayOrigin,
                                              const BVH_Vec3d& rayDir,
                                              const BVH_Vec3d& v0,
-                                             const BVH_Vec3d& v1,
-                                             const BVH_Vec3d& v2,
+                                             const BVH_Vec3d& edge1,
+                                             const BVH_Vec3d& edge2,
                                              Standard_Real&   t,
                                              Standard_Real&   u,
                                              Standard_Real&   v)
 {
   const Standard_Real EPSILON = 1e-12;
 
-  BVH_Vec3d edge1 = v1 - v0;
-  BVH_Vec3d edge2 = v2 - v0;
-
   BVH_Vec3d h;
   h[0] = rayDir[1] * edge2[2] - rayDir[2] * edge2[1];
   h[1] = rayDir[2] * edge2[0] - rayDir[0] * edge2[2];
@@ -397,29 +1009,179 @@ inline Standard_Boolean RayTriangleIntersect(const BVH_Vec3d& rayOrigin,
   return t > EPSILON; // Hit if t is positive
 }
 
+//! Ray-box intersection test using precomputed inverse direction (slab method).
+//! Bounds may be float (flattened compact nodes) or double; the test runs in double.
+template <class T>
+inline Standard_Boolean RayBoxIntersect(const T*         theBoxMin,
+                                        const T*         theBoxMax,
+                                        const BVH_Vec3d& theOrigin,
+                                        const BVH_Vec3d& theInvDir,
+                                        Standard_Real&   theNear,
+                                        Standard_Real&   theFar)
+{
+  Standard_Real t1 = (theBoxMin[0] - theOrigin[0]) * theInvDir[0];
+  Standard_Real t2 = (theBoxMax[0] - theOrigin[0]) * theInvDir[0];
+
+  theNear = std::min(t1, t2);
+  theFar  = std::max(t1, t2);
+
+  t1 = (theBoxMin[1] - theOrigin[1]) * theInvDir[1];
+  t2 = (theBoxMax[1] - theOrigin[1]) * theInvDir[1];
+
+  theNear = std::max(theNear, std::min(t1, t2));
+  theFar  = std::min(theFar, std::max(t1, t2));
+
+  t1 = (theBoxMin[2] - theOrigin[2]) * theInvDir[2];
+  t2 = (theBoxMax[2] - theOrigin[2]) * theInvDir[2];
+
+  theNear = std::max(theNear, std::min(t1, t2));
+  theFar  = std::min(theFar, std::max(t1, t2));
+
+  return theNear <= theFar;
+}
+
+//! Deferred child slot of a wide BVH node
+struct WideStackEntry
+{
+  Standard_Integer   Offset;  //!< Node index, or first primitive of a leaf
+  Standard_Integer   NbPrims; //!< 0 for inner nodes, number of primitives for leaves
+  Standard_ShortReal Near;    //!< Box entry distance
+};
+
+//! Triangle hit recorded by the count traverser
+struct TriangleHit
+{
+  Standard_Real    T;      //!< Parameter on the ray
+  Standard_Real    U;      //!< Barycentric coordinate of the second vertex
+  Standard_Real    V;      //!< Barycentric coordinate of the third vertex
+  Standard_Integer TriIdx; //!< Original triangle index (into the triangle info)
+
+  bool operator<(const TriangleHit& theOther) const { return T < theOther.T; }
+};
+
+//! Parameter intervals of the rays of a batch query, indexed like the ray array.
+//! The default interval applies when no per-ray bounds are given.
+class BatchRayRanges
+{
+public:
+  BatchRayRanges(const NCollection_Array1<gp_Lin>&        theRays,
+                 const NCollection_Array1<Standard_Real>* theMins,
+                 const NCollection_Array1<Standard_Real>* theMaxs,
+                 const Standard_Real                      theMin = 0.0,
+                 const Standard_Real                      theMax = RealLast())
+      : myMins(theMins),
+        myMaxs(theMaxs),
+        myMinShift(theMins != nullptr ? theMins->Lower() - theRays.Lower() : 0),
+        myMaxShift(theMaxs != nullptr ? theMaxs->Lower() - theRays.Lower() : 0),
+        myMin(theMin),
+        myMax(theMax)
+  {
+  }
+
+  //! Minimum parameter of ray theRays(theIdx)
+  Standard_Real Min(const Standard_Integer theIdx) const
+  {
+    return myMins != nullptr ? (*myMins)(theIdx + myMinShift) : myMin;
+  }
+
+  //! Maximum parameter of ray theRays(theIdx)
+  Standard_Real Max(const Standard_Integer theIdx) const
+  {
+    return myMaxs != nullptr ? (*myMaxs)(theIdx + myMaxShift) : myMax;
+  }
+
+private:
+  const NCollection_Array1<Standard_Real>* myMins;
+  const NCollection_Array1<Standard_Real>* myMaxs;
+  Standard_Integer                         myMinShift;
+  Standard_Integer                         myMaxShift;
+  Standard_Real                            myMin;
+  Standard_Real                            myMax;
+};
+
+//! Checks a ray parameter interval of a batch query: 0 <= theMin <= theMax.
+//! Embree requires a non-negative tnear, so both backends reject negative minimums.
+inline Standard_Boolean IsValidRayRange(const Standard_Real theMin, const Standard_Real theMax)
+{
+  return theMin >= 0.0 && theMin <= theMax; // false for NaN as well
+}
+
+//! Checks the per-ray parameter intervals of a batch query with IsValidRayRange()
+Standard_Boolean AreValidRayRanges(const NCollection_Array1<Standard_Real>& theMins,
+                                   const NCollection_Array1<Standard_Real>& theMaxs)
+{
+  for (Standard_Integer i = 0; i < theMins.Length(); ++i)
+  {
+    if (!IsValidRayRange(theMins(theMins.Lower() + i), theMaxs(theMaxs.Lower() + i)))
+      return Standard_False;
+  }
+  return Standard_True;
+}
+
+//! Convert a lower ray parameter bound to float without increasing it
+inline Standard_ShortReal ToFloatDown(const Standard_Real theValue)
+{
+  if (theValue <= -std::numeric_limits<Standard_ShortReal>::max())
+    return -std::numeric_limits<Standard_ShortReal>::infinity();
+  return BRepIntCurveSurface_FlatBVH::RoundDown(theValue);
+}
+
+//! Convert an upper ray parameter bound to float without decreasing it
+inline Standard_ShortReal ToFloatUp(const Standard_Real theValue)
+{
+  if (theValue >= std::numeric_limits<Standard_ShortReal>::max())
+    return std::numeric_limits<Standard_ShortReal>::infinity();
+  return BRepIntCurveSurface_FlatBVH::RoundUp(theValue);
+}
+
 //! Triangle BVH traverser - finds the closest triangle hit and returns the face index
 class BRepIntCurveSurface_TriangleTraverser
 {
 public:
   BRepIntCurveSurface_TriangleTraverser()
-      : myTriBVH(nullptr),
+      : myTriangles(nullptr),
+        myPackets(nullptr),
+        myFlatBVH(nullptr),
+        myWideBVH(nullptr),
         myTriangleInfo(nullptr),
+        myInstances(nullptr),
+        myTriangleShift(0),
         myClosestT(RealLast()),
         myHitTriangleIndex(-1),
-        myHitFaceIndex(-1),
         myMinParam(0.0),
         myMaxParam(RealLast()),
         myNodeTestCount(0)
   {
   }
 
-  void SetTriBVH(BRepIntCurveSurface_TriBVH* theBVH) { myTriBVH = theBVH; }
+  //! Set triangle records in BVH primitive order
+  void SetTriangles(const BRepIntCurveSurface_TriangleRecord* theTriangles)
+  {
+    myTriangles = theTriangles;
+  }
+
+  //! Set SIMD triangle packets; used instead of the records when not empty
+  void SetTrianglePackets(const BRepIntCurveSurface_TrianglePackets* thePackets)
+  {
+    myPackets = (thePackets != nullptr && !thePackets->IsEmpty()) ? thePackets : nullptr;
+  }
+
+  void SetFlatBVH(const BRepIntCurveSurface_FlatBVH* theBVH) { myFlatBVH = theBVH; }
+
+  void SetWideBVH(const BRepIntCurveSurface_WideBVH* theBVH) { myWideBVH = theBVH; }
 
   void SetTriangleInfo(const std::vector<BRepIntCurveSurface_TriangleInfo>* theInfo)
   {
     myTriangleInfo = theInfo;
   }
 
+  //! Set part instances; when not empty, the top-level BVH is traversed and the
+  //! triangle data set above is ignored
+  void SetInstances(const BRepIntCurveSurface_InstanceSet* theInstances)
+  {
+    myInstances = (theInstances != nullptr && !theInstances->IsEmpty()) ? theInstances : nullptr;
+  }
+
   void SetRay(const gp_Lin& theRay, Standard_Real theMin, Standard_Real theMax)
   {
     myRayOrigin[0] = theRay.Location().X();
@@ -428,380 +1190,1178 @@ public:
     myRayDir[0]    = theRay.Direction().X();
     myRayDir[1]    = theRay.Direction().Y();
     myRayDir[2]    = theRay.Direction().Z();
-
-    // Precompute inverse direction for fast ray-box intersection
-    // Using a small epsilon to avoid division by zero
-    const Standard_Real epsilon = 1e-12;
-    for (int i = 0; i < 3; ++i)
-    {
-      myInvRayDir[i] = (std::abs(myRayDir[i]) > epsilon)
-                         ? (1.0 / myRayDir[i])
-                         : (myRayDir[i] >= 0 ? 1.0 / epsilon : -1.0 / epsilon);
-    }
+    UpdateInverseDir();
 
     myMinParam         = theMin;
     myMaxParam         = theMax;
     myClosestT         = theMax;
     myHitTriangleIndex = -1;
-    myHitFaceIndex     = -1;
     myHitBaryU         = 0.0;
     myHitBaryV         = 0.0;
   }
 
-  //! Traverse the triangle BVH to find closest hit
+  //! Traverse the wide or flattened triangle BVH (or the top-level BVH and the parts
+  //! of the instances) to find the closest hit
   void Select()
   {
-    if (myTriBVH == nullptr || myTriBVH->BVH().IsNull())
+    if (myInstances != nullptr)
+    {
+      SelectNodes<true>(myInstances->TopLevel().NodesD());
       return;
+    }
+    SelectTriangles();
+  }
+
+  //! Get the hit face index (0-based), or -1 if no hit (without instances only)
+  Standard_Integer GetHitFaceIndex() const
+  {
+    return myHitTriangleIndex >= 0 ? (*myTriangleInfo)[myHitTriangleIndex].FaceIndex : -1;
+  }
+
+  //! Get the parameter t on the ray
+  Standard_Real GetHitT() const { return myClosestT; }
+
+  //! Get barycentric coordinates of hit
+  void GetHitBarycentric(Standard_Real& u, Standard_Real& v) const
+  {
+    u = myHitBaryU;
+    v = myHitBaryV;
+  }
+
+  //! Get the triangle index that was hit
+  Standard_Integer GetHitTriangleIndex() const { return myHitTriangleIndex; }
+
+  //! Get the number of BVH node tests performed (thread-local, no atomic overhead)
+  long long GetNodeTestCount() const { return myNodeTestCount; }
+
+  //! Get the ray origin set by SetRay()
+  const BVH_Vec3d& RayOrigin() const { return myRayOrigin; }
+
+  //! Get the clamped inverse ray direction set by SetRay()
+  const BVH_Vec3d& InvRayDir() const { return myInvRayDir; }
+
+  //! Test a node box against the ray and the current closest hit.
+  //! @param theNear Output: entry distance, clamped to the minimum ray parameter
+  template <class NodeT>
+  Standard_Boolean IntersectNode(const NodeT& theNode, Standard_Real& theNear)
+  {
+    ++myNodeTestCount; // Thread-local counter (no atomic overhead)
 
-    const opencascade::handle<BVH_Tree<Standard_Real, 3>>& aBVH = myTriBVH->BVH();
+    Standard_Real tFar;
+    if (!RayBoxIntersect(
+          theNode.MinPoint, theNode.MaxPoint, myRayOrigin, myInvRayDir, theNear, tFar))
+      return Standard_False;
 
-    // Stack-based traversal
-    std::vector<Standard_Integer> aStack;
-    aStack.reserve(64);
-    aStack.push_back(0); // Start at root
+    // Skip if box is behind ray or past current best hit
+    if (tFar < myMinParam || theNear > myClosestT)
+      return Standard_False;
 
-    while (!aStack.empty())
+    theNear = std::max(theNear, myMinParam);
+    return Standard_True;
+  }
+
+private:
+  //! Precompute the inverse direction for fast ray-box intersection, using a small
+  //! epsilon to avoid division by zero, and the single-precision copies
+  void UpdateInverseDir()
+  {
+    const Standard_Real epsilon = 1e-12;
+    for (int i = 0; i < 3; ++i)
     {
-      Standard_Integer aNodeIdx = aStack.back();
-      aStack.pop_back();
+      myInvRayDir[i] = (std::abs(myRayDir[i]) > epsilon)
+                         ? (1.0 / myRayDir[i])
+                         : (myRayDir[i] >= 0 ? 1.0 / epsilon : -1.0 / epsilon);
+      myRayOriginF[i] = static_cast<Standard_ShortReal>(myRayOrigin[i]);
+      myInvRayDirF[i] = static_cast<Standard_ShortReal>(myInvRayDir[i]);
+    }
+  }
 
-      if (aNodeIdx < 0)
-        continue;
+  //! Traverse the triangle BVH set by SetFlatBVH() / SetWideBVH() or of the current part
+  void SelectTriangles()
+  {
+    if (myTriangles == nullptr && myPackets == nullptr)
+      return;
 
-      // Get node bounds
-      const BVH_Vec3d& aMinPt = aBVH->MinPoint(aNodeIdx);
-      const BVH_Vec3d& aMaxPt = aBVH->MaxPoint(aNodeIdx);
+    if (myWideBVH != nullptr && !myWideBVH->IsEmpty())
+    {
+      if (myWideBVH->Width() == 8)
+        SelectWide(myWideBVH->Nodes8());
+      else
+        SelectWide(myWideBVH->Nodes4());
+    }
+    else if (myFlatBVH != nullptr && !myFlatBVH->IsEmpty())
+    {
+      if (myFlatBVH->IsFloat())
+        SelectNodes(myFlatBVH->NodesF());
+      else
+        SelectNodes(myFlatBVH->NodesD());
+    }
+  }
 
-      ++myNodeTestCount; // Thread-local counter (no atomic overhead)
+  //! Ordered traversal over depth-first ordered nodes.
+  //! Both children of an inner node are tested together and the nearer one is
+  //! descended first; the farther one is deferred on a fixed-size stack with its
+  //! entry distance and dropped on pop if a closer hit has been found meanwhile.
+  //! On the top level, the leaves hold part instances instead of triangles.
+  template <bool IsTopLevel = false, class NodeT>
+  void SelectNodes(const NodeT* theNodes)
+  {
+    // At most one deferred sibling per tree level (depth checked by FlatBVH::Build)
+    Standard_Integer aStack[BRepIntCurveSurface_FlatBVH::MaxStackSize];
+    Standard_Real    aStackNear[BRepIntCurveSurface_FlatBVH::MaxStackSize];
+    Standard_Integer aHead = -1;
 
-      // Test ray against box
-      Standard_Real tNear, tFar;
-      if (!RayBoxIntersect(aMinPt, aMaxPt, tNear, tFar))
-        continue;
+    Standard_Real aRootNear;
+    if (!IntersectNode(theNodes[0], aRootNear))
+      return;
 
-      // Skip if box is behind ray or past current best hit
-      if (tFar < myMinParam || tNear > myClosestT)
-        continue;
+    Standard_Integer aNodeIdx = 0; // Start at root
+    for (;;)
+    {
+      const NodeT& aNode = theNodes[aNodeIdx];
 
-      if (aBVH->IsOuter(aNodeIdx))
+      if (aNode.IsLeaf())
       {
         // Leaf node - test triangles
-        Standard_Integer aFirstTriIdx = aBVH->BegPrimitive(aNodeIdx);
-        Standard_Integer aLastTriIdx  = aBVH->EndPrimitive(aNodeIdx);
-
-        for (Standard_Integer triIdx = aFirstTriIdx; triIdx <= aLastTriIdx; ++triIdx)
-        {
-          TestTriangle(triIdx);
-        }
+        if constexpr (IsTopLevel)
+          TestInstances(aNode.Offset, aNode.NbPrims);
+        else
+          TestLeaf(aNode.Offset, aNode.NbPrims);
       }
       else
       {
-        // Inner node - push children (closer child first for efficiency)
-        Standard_Integer aLeftChild  = aBVH->Child<0>(aNodeIdx);
-        Standard_Integer aRightChild = aBVH->Child<1>(aNodeIdx);
+        // Inner node - left child follows its parent, right child is at Offset
+        Standard_Integer       aNear = aNodeIdx + 1;
+        Standard_Integer       aFar  = aNode.Offset;
+        Standard_Real          aNearT, aFarT;
+        const Standard_Boolean isNearHit = IntersectNode(theNodes[aNear], aNearT);
+        const Standard_Boolean isFarHit  = IntersectNode(theNodes[aFar], aFarT);
+
+        if (isNearHit && isFarHit)
+        {
+          if (aFarT < aNearT)
+          {
+            std::swap(aNear, aFar);
+            std::swap(aNearT, aFarT);
+          }
+          ++aHead;
+          aStack[aHead]     = aFar;
+          aStackNear[aHead] = aFarT;
+          aNodeIdx          = aNear;
+          continue;
+        }
+        if (isNearHit || isFarHit)
+        {
+          aNodeIdx = isNearHit ? aNear : aFar;
+          continue;
+        }
+      }
 
-        // Simple heuristic: push both, farther first (will be processed last)
-        aStack.push_back(aRightChild);
-        aStack.push_back(aLeftChild);
+      // Pop the next deferred node that can still contain a closer hit
+      while (aHead >= 0 && aStackNear[aHead] > myClosestT)
+      {
+        --aHead;
       }
+      if (aHead < 0)
+        return;
+      aNodeIdx = aStack[aHead--];
     }
   }
 
-  //! Get the hit face index (0-based), or -1 if no hit
-  Standard_Integer GetHitFaceIndex() const { return myHitFaceIndex; }
-
-  //! Get the parameter t on the ray
-  Standard_Real GetHitT() const { return myClosestT; }
-
-  //! Get barycentric coordinates of hit
-  void GetHitBarycentric(Standard_Real& u, Standard_Real& v) const
+  //! Ordered traversal over wide nodes.
+  //! All child boxes of a node are tested in one SIMD pass; hit children are
+  //! pushed sorted by entry distance so that the nearest one is popped first,
+  //! and popped entries are dropped if a closer hit has been found meanwhile.
+  template <int W>
+  void SelectWide(const BRepIntCurveSurface_WideNode<W>* theNodes)
   {
-    u = myHitBaryU;
-    v = myHitBaryV;
-  }
+    WideStackEntry           aStack[BRepIntCurveSurface_WideBVH::MaxStackSize];
+    Standard_Integer         aHead     = -1;
+    Standard_Integer         aNodeIdx  = 0; // Start at root
+    const Standard_ShortReal aMinParam = ToFloatDown(myMinParam);
 
-  //! Get the triangle index that was hit
-  Standard_Integer GetHitTriangleIndex() const { return myHitTriangleIndex; }
+    for (;;)
+    {
+      const BRepIntCurveSurface_WideNode<W>& aNode = theNodes[aNodeIdx];
 
-  //! Get the number of BVH node tests performed (thread-local, no atomic overhead)
-  Standard_Integer GetNodeTestCount() const { return myNodeTestCount; }
+      ++myNodeTestCount; // One SIMD test of all children
 
-private:
-  //! Ray-box intersection test using precomputed inverse direction (slab method)
-  //! This is the optimized version that avoids per-test division
-  Standard_Boolean RayBoxIntersect(const BVH_Vec3d& boxMin,
-                                   const BVH_Vec3d& boxMax,
-                                   Standard_Real&   tNear,
-                                   Standard_Real&   tFar) const
-  {
-    // Optimized slab method using precomputed inverse direction
-    Standard_Real t1 = (boxMin[0] - myRayOrigin[0]) * myInvRayDir[0];
-    Standard_Real t2 = (boxMax[0] - myRayOrigin[0]) * myInvRayDir[0];
+      Standard_ShortReal aNear[W];
+      int                aMask = BRepIntCurveSurface_WideBVH::IntersectChildren(
+        aNode, myRayOriginF, myInvRayDirF, aMinParam, ToFloatUp(myClosestT), aNear);
 
-    tNear = std::min(t1, t2);
-    tFar  = std::max(t1, t2);
+      // Insertion sort of hit children above the current head, nearest on top
+      const Standard_Integer aBase = aHead + 1;
+      for (Standard_Integer i = 0; aMask != 0; ++i, aMask >>= 1)
+      {
+        if ((aMask & 1) == 0)
+          continue;
 
-    t1 = (boxMin[1] - myRayOrigin[1]) * myInvRayDir[1];
-    t2 = (boxMax[1] - myRayOrigin[1]) * myInvRayDir[1];
+        Standard_Integer aPos = ++aHead;
+        while (aPos > aBase && aStack[aPos - 1].Near < aNear[i])
+        {
+          aStack[aPos] = aStack[aPos - 1];
+          --aPos;
+        }
+        aStack[aPos].Offset  = aNode.Offset[i];
+        aStack[aPos].NbPrims = aNode.NbPrims[i];
+        aStack[aPos].Near    = aNear[i];
+      }
 
-    tNear = std::max(tNear, std::min(t1, t2));
-    tFar  = std::min(tFar, std::max(t1, t2));
+      // Pop entries: leaves are tested in place, the first inner node is visited next
+      for (;;)
+      {
+        if (aHead < 0)
+          return;
 
-    t1 = (boxMin[2] - myRayOrigin[2]) * myInvRayDir[2];
-    t2 = (boxMax[2] - myRayOrigin[2]) * myInvRayDir[2];
+        const WideStackEntry anEntry = aStack[aHead--];
+        if (anEntry.Near > myClosestT)
+          continue;
 
-    tNear = std::max(tNear, std::min(t1, t2));
-    tFar  = std::min(tFar, std::max(t1, t2));
+        if (anEntry.NbPrims == 0)
+        {
+          aNodeIdx = anEntry.Offset;
+          break;
+        }
 
-    return tNear <= tFar;
+        TestLeaf(anEntry.Offset, anEntry.NbPrims);
+      }
+    }
   }
 
-  //! Test a single triangle (triIdx is the BVH primitive index after reordering)
-  void TestTriangle(Standard_Integer triIdx)
+public:
+  //! Test the triangles of a leaf, a whole packet per SIMD pass when packets are set
+  void TestLeaf(const Standard_Integer theFirst, const Standard_Integer theNbPrims)
   {
-    if (myTriangleInfo == nullptr)
-      return;
-
-    // Validate triIdx against Elements array
-    if (triIdx < 0 || triIdx >= static_cast<Standard_Integer>(myTriBVH->Elements.size()))
+    if (myPackets == nullptr)
+    {
+      for (Standard_Integer triIdx = theFirst; triIdx < theFirst + theNbPrims; ++triIdx)
+      {
+        TestTriangle(triIdx);
+      }
       return;
+    }
 
-    // Get triangle data from BVH - elem contains:
-    // x, y, z = vertex indices, w = ORIGINAL triangle index (preserved through Swap)
-    const BVH_Vec4i& elem = myTriBVH->Elements[triIdx];
-
-    // Validate vertex indices
-    if (elem[0] < 0 || elem[0] >= static_cast<Standard_Integer>(myTriBVH->Vertices.size())
-        || elem[1] < 0 || elem[1] >= static_cast<Standard_Integer>(myTriBVH->Vertices.size())
-        || elem[2] < 0 || elem[2] >= static_cast<Standard_Integer>(myTriBVH->Vertices.size()))
-      return;
+    const BRepIntCurveSurface_TrianglePacket* aPackets = myPackets->LeafPackets(theFirst);
+    const Standard_Integer aNbPackets =
+      BRepIntCurveSurface_TrianglePackets::NbLeafPackets(theNbPrims);
+    for (Standard_Integer aPacketIdx = 0; aPacketIdx < aNbPackets; ++aPacketIdx)
+    {
+      const BRepIntCurveSurface_TrianglePacket& aPacket = aPackets[aPacketIdx];
+
+      Standard_Real t[BRepIntCurveSurface_TrianglePackets::Lanes];
+      Standard_Real u[BRepIntCurveSurface_TrianglePackets::Lanes];
+      Standard_Real v[BRepIntCurveSurface_TrianglePackets::Lanes];
+      int           aMask = BRepIntCurveSurface_TrianglePackets::Intersect(
+        aPacket,
+        std::min(theNbPrims - aPacketIdx * BRepIntCurveSurface_TrianglePackets::Lanes,
+                 BRepIntCurveSurface_TrianglePackets::Lanes),
+        myRayOrigin,
+        myRayDir,
+        myMinParam,
+        myClosestT,
+        t,
+        u,
+        v);
+
+      // Keep the nearest lane
+      for (int aLane = 0; aMask != 0; ++aLane, aMask >>= 1)
+      {
+        if ((aMask & 1) != 0 && t[aLane] < myClosestT)
+        {
+          myClosestT         = t[aLane];
+          myHitTriangleIndex = aPacket.OriginalIndex[aLane] + myTriangleShift;
+          myHitBaryU         = u[aLane];
+          myHitBaryV         = v[aLane];
+        }
+      }
+    }
+  }
 
-    // Get original triangle index from 4th component
-    Standard_Integer originalTriIdx = elem[3];
-    if (originalTriIdx < 0
-        || originalTriIdx >= static_cast<Standard_Integer>(myTriangleInfo->size()))
-      return;
+private:
+  //! Trace the ray through the parts of the instances of a top-level leaf, in part
+  //! coordinates; hit indices are shifted to the instance's range
+  void TestInstances(const Standard_Integer theFirst, const Standard_Integer theNbPrims)
+  {
+    const BVH_Vec3d aRayOrigin = myRayOrigin;
+    const BVH_Vec3d aRayDir    = myRayDir;
+    for (Standard_Integer aPrim = theFirst; aPrim < theFirst + theNbPrims; ++aPrim)
+    {
+      const BRepIntCurveSurface_Instance&  anInstance = myInstances->LeafInstance(aPrim);
+      const BRepIntCurveSurface_Prototype& aPrototype =
+        myInstances->Prototype(anInstance.Prototype);
+      anInstance.ToPartRay(aRayOrigin, aRayDir, myRayOrigin, myRayDir);
+      UpdateInverseDir();
+
+      myTriangles     = aPrototype.Records.data();
+      myPackets       = aPrototype.Packets.IsEmpty() ? nullptr : &aPrototype.Packets;
+      myFlatBVH       = &aPrototype.FlatBVH;
+      myWideBVH       = &aPrototype.WideBVH;
+      myTriangleShift = anInstance.FirstTriangle - aPrototype.FirstTriangle;
+      SelectTriangles();
+    }
+    myRayOrigin = aRayOrigin;
+    myRayDir    = aRayDir;
+    UpdateInverseDir();
+  }
 
-    const BVH_Vec3d& v0 = myTriBVH->Vertices[elem[0]];
-    const BVH_Vec3d& v1 = myTriBVH->Vertices[elem[1]];
-    const BVH_Vec3d& v2 = myTriBVH->Vertices[elem[2]];
+  //! Test a single triangle (triIdx is the BVH primitive index after reordering)
+  void TestTriangle(Standard_Integer triIdx)
+  {
+    // Records are built at Load from welded indices, so no validation is needed here
+    const BRepIntCurveSurface_TriangleRecord& aTri = myTriangles[triIdx];
 
     Standard_Real t, u, v;
-    if (RayTriangleIntersect(myRayOrigin, myRayDir, v0, v1, v2, t, u, v))
+    if (RayTriangleIntersect(myRayOrigin, myRayDir, aTri.V0, aTri.Edge1, aTri.Edge2, t, u, v))
     {
       if (t >= myMinParam && t < myClosestT)
       {
         myClosestT         = t;
-        myHitTriangleIndex = originalTriIdx; // Use ORIGINAL index for myTriangleInfo lookup
-        myHitFaceIndex     = (*myTriangleInfo)[originalTriIdx].FaceIndex;
+        myHitTriangleIndex = aTri.OriginalIndex + myTriangleShift; // ORIGINAL index (per instance)
         myHitBaryU         = u;
         myHitBaryV         = v;
       }
     }
   }
 
-  BRepIntCurveSurface_TriBVH*                          myTriBVH;
+  const BRepIntCurveSurface_TriangleRecord*            myTriangles;
+  const BRepIntCurveSurface_TrianglePackets*           myPackets;
+  const BRepIntCurveSurface_FlatBVH*                   myFlatBVH;
+  const BRepIntCurveSurface_WideBVH*                   myWideBVH;
   const std::vector<BRepIntCurveSurface_TriangleInfo>* myTriangleInfo;
+  const BRepIntCurveSurface_InstanceSet*               myInstances;
+  Standard_Integer                                     myTriangleShift; // Instance hit offset
   BVH_Vec3d                                            myRayOrigin;
   BVH_Vec3d                                            myRayDir;
-  BVH_Vec3d        myInvRayDir; // Precomputed 1/direction for fast ray-box tests
+  BVH_Vec3d          myInvRayDir;     // Precomputed 1/direction for fast ray-box tests
+  Standard_ShortReal myRayOriginF[3]; // Single-precision copies for wide SIMD box tests
+  Standard_ShortReal myInvRayDirF[3];
   Standard_Real    myClosestT;
   Standard_Integer myHitTriangleIndex;
-  Standard_Integer myHitFaceIndex;
   Standard_Real    myMinParam;
   Standard_Real    myMaxParam;
   Standard_Real    myHitBaryU;
   Standard_Real    myHitBaryV;
-  Standard_Integer myNodeTestCount; // Thread-local counter (no atomic overhead)
+  long long        myNodeTestCount; // Thread-local counter (no atomic overhead)
 };
 
-//! Triangle BVH traverser that counts ALL intersections (not just closest)
-//! Used for PerformBatchCount with tessellation acceleration
-class BRepIntCurveSurface_TriangleCountTraverser
+//! Smallest positive spacing between the given coordinates (0 if all are equal)
+Standard_Real GridStep(std::vector<Standard_Real>& theCoords)
 {
-public:
-  BRepIntCurveSurface_TriangleCountTraverser()
-      : myTriBVH(nullptr),
-        myTriangleInfo(nullptr),
-        myHitCount(0),
-        myMinParam(0.0),
-        myMaxParam(RealLast()),
-        myNodeTestCount(0)
+  std::sort(theCoords.begin(), theCoords.end());
+  const Standard_Real anExtent = theCoords.back() - theCoords.front();
+  const Standard_Real aTol     = anExtent * 1.0e-9;
+
+  Standard_Real aStep = anExtent;
+  for (size_t i = 1; i < theCoords.size(); ++i)
   {
+    const Standard_Real aGap = theCoords[i] - theCoords[i - 1];
+    if (aGap > aTol)
+      aStep = std::min(aStep, aGap);
   }
+  return aStep;
+}
+
+//! Order ray indices along a Morton curve of the ray origins projected on the plane
+//! orthogonal to the dominant axis of the first ray, so that runs of consecutive
+//! indices cover compact square tiles of a raster grid instead of thin rows.
+//! Origins are quantized by the grid step, so 4, 16 and 64 consecutive rays of a
+//! regular grid form 2x2, 4x4 and 8x8 tiles.
+void SortRaysByTiles(const NCollection_Array1<gp_Lin>& theRays,
+                     std::vector<Standard_Integer>&    theOrder)
+{
+  const Standard_Integer aNbRays = theRays.Length();
+  theOrder.resize(aNbRays);
+  if (aNbRays == 0)
+    return;
 
-  void SetTriBVH(BRepIntCurveSurface_TriBVH* theBVH) { myTriBVH = theBVH; }
+  const gp_Dir& aDir   = theRays.First().Direction();
+  const int     aMain  = std::abs(aDir.X()) >= std::max(std::abs(aDir.Y()), std::abs(aDir.Z()))
+                           ? 0
+                           : (std::abs(aDir.Y()) >= std::abs(aDir.Z()) ? 1 : 2);
+  const int     anAxes[2] = {(aMain + 1) % 3 + 1, (aMain + 2) % 3 + 1};
 
-  void SetTriangleInfo(const std::vector<BRepIntCurveSurface_TriangleInfo>* theInfo)
+  // Cell size per axis: the grid step, but no less than 1/65535 of the extent
+  Standard_Real              aMin[2], aScale[2];
+  std::vector<Standard_Real> aCoords(aNbRays);
+  for (int k = 0; k < 2; ++k)
   {
-    myTriangleInfo = theInfo;
+    for (Standard_Integer i = 0; i < aNbRays; ++i)
+    {
+      aCoords[i] = theRays(theRays.Lower() + i).Location().Coord(anAxes[k]);
+    }
+    const Standard_Real aStep = GridStep(aCoords);
+    const Standard_Real aCell = std::max(aStep, (aCoords.back() - aCoords.front()) / 65535.0);
+    aMin[k]                   = aCoords.front();
+    aScale[k]                 = aCell > 0.0 ? 1.0 / aCell : 0.0;
   }
 
-  void SetRay(const gp_Lin& theRay, Standard_Real theMin, Standard_Real theMax)
-  {
-    myRayOrigin[0] = theRay.Location().X();
-    myRayOrigin[1] = theRay.Location().Y();
-    myRayOrigin[2] = theRay.Location().Z();
-    myRayDir[0]    = theRay.Direction().X();
-    myRayDir[1]    = theRay.Direction().Y();
-    myRayDir[2]    = theRay.Direction().Z();
+  // 16-bit cell coordinates interleaved into a 32-bit Morton key
+  auto aSpread = [](unsigned int theValue) {
+    theValue = (theValue | (theValue << 8)) & 0x00FF00FFu;
+    theValue = (theValue | (theValue << 4)) & 0x0F0F0F0Fu;
+    theValue = (theValue | (theValue << 2)) & 0x33333333u;
+    theValue = (theValue | (theValue << 1)) & 0x55555555u;
+    return theValue;
+  };
 
-    // Precompute inverse direction for fast ray-box intersection
-    const Standard_Real epsilon = 1e-12;
-    for (int i = 0; i < 3; ++i)
+  std::vector<std::pair<unsigned int, Standard_Integer>> aKeys(aNbRays);
+  for (Standard_Integer i = 0; i < aNbRays; ++i)
+  {
+    const gp_Pnt& anOrigin = theRays(theRays.Lower() + i).Location();
+    unsigned int  aCell[2];
+    for (int k = 0; k < 2; ++k)
     {
-      myInvRayDir[i] = (std::abs(myRayDir[i]) > epsilon)
-                         ? (1.0 / myRayDir[i])
-                         : (myRayDir[i] >= 0 ? 1.0 / epsilon : -1.0 / epsilon);
+      const Standard_Real aPos = (anOrigin.Coord(anAxes[k]) - aMin[k]) * aScale[k] + 0.5;
+      aCell[k]                 = static_cast<unsigned int>(std::min(aPos, 65535.0));
     }
-
-    myMinParam = theMin;
-    myMaxParam = theMax;
-    myHitCount = 0;
+    aKeys[i] = std::make_pair(aSpread(aCell[0]) | (aSpread(aCell[1]) << 1), theRays.Lower() + i);
   }
+  std::sort(aKeys.begin(), aKeys.end());
 
-  //! Traverse the triangle BVH to count ALL hits
-  void Select()
+  for (Standard_Integer i = 0; i < aNbRays; ++i)
   {
-    if (myTriBVH == nullptr || myTriBVH->BVH().IsNull())
-      return;
-
-    const opencascade::handle<BVH_Tree<Standard_Real, 3>>& aBVH = myTriBVH->BVH();
-
-    // Stack-based traversal
-    std::vector<Standard_Integer> aStack;
-    aStack.reserve(64);
-    aStack.push_back(0); // Start at root
-
-    while (!aStack.empty())
-    {
-      Standard_Integer aNodeIdx = aStack.back();
-      aStack.pop_back();
+    theOrder[i] = aKeys[i].second;
+  }
+}
 
-      if (aNodeIdx < 0)
-        continue;
+//! Closest-hit traverser for packets of coherent rays (e.g. parallel grid rays).
+//! The flattened tree is walked once per packet. A node box is classified for the
+//! whole packet by interval arithmetic over the ray origins and inverse directions
+//! (missed by all rays, hit by all rays, or undecided); an undecided packet is split
+//! into 4 groups of 16 rays, then 4 rays, and only the rays of undecided 4-ray
+//! groups are tested one by one. Active rays are tracked in a bit mask. With rays
+//! ordered by SortRaysByTiles() the groups are 8x8, 4x4 and 2x2 tiles of the grid.
+//! Rays whose direction signs differ per axis cannot share the interval test;
+//! SetRays() reports it and the caller then traverses them one by one.
+class BRepIntCurveSurface_RayPacketTraverser
+{
+public:
+  //! Maximum number of rays in a packet
+  static constexpr Standard_Integer MaxRays = 64;
 
-      // Get node bounds
-      const BVH_Vec3d& aMinPt = aBVH->MinPoint(aNodeIdx);
-      const BVH_Vec3d& aMaxPt = aBVH->MaxPoint(aNodeIdx);
+  BRepIntCurveSurface_RayPacketTraverser()
+      : myNbRays(0),
+        myMinParam(0.0),
+        myNodeTestCount(0)
+  {
+  }
 
-      ++myNodeTestCount; // Thread-local counter (no atomic overhead)
+  //! Per-ray traverser holding the scene pointers, ray and closest hit
+  BRepIntCurveSurface_TriangleTraverser& Ray(const Standard_Integer theIndex)
+  {
+    return myRays[theIndex];
+  }
 
-      // Test ray against box
-      Standard_Real tNear, tFar;
-      if (!RayBoxIntersect(aMinPt, aMaxPt, tNear, tFar))
-        continue;
+  //! Set the rays theRays(theIndices[0]) .. theRays(theIndices[theNbRays - 1]).
+  //! Boxes are culled against the smallest minimum parameter of the packet and each
+  //! ray's closest hit, initialized to its maximum parameter.
+  //! @return false if the rays cannot be traversed as a packet
+  Standard_Boolean SetRays(const NCollection_Array1<gp_Lin>& theRays,
+                           const Standard_Integer*           theIndices,
+                           const Standard_Integer            theNbRays,
+                           const BatchRayRanges&             theRanges)
+  {
+    myNbRays   = std::min(theNbRays, MaxRays);
+    myMinParam = RealLast();
+    for (Standard_Integer i = 0; i < myNbRays; ++i)
+    {
+      const Standard_Integer anIdx = theIndices[i];
+      myRays[i].SetRay(theRays(anIdx), theRanges.Min(anIdx), theRanges.Max(anIdx));
+      myMinParam = std::min(myMinParam, theRanges.Min(anIdx));
+    }
 
-      // Skip if box is entirely behind ray or past max param
-      if (tFar < myMinParam || tNear > myMaxParam)
+    // Bounds of the 4-ray groups, then of the 16-ray groups and of the packet
+    for (Standard_Integer aGroup = 0; aGroup < NbGroups; ++aGroup)
+    {
+      const Standard_Integer aSize  = GroupSize(aGroup);
+      const Standard_Integer aFirst = GroupFirstRay(aGroup);
+      if (aFirst < myNbRays && aSize == 4)
+        myGroups[aGroup].Init(myRays + aFirst, std::min(aSize, myNbRays - aFirst));
+    }
+    for (Standard_Integer aGroup = NbGroups - 1; aGroup >= 0; --aGroup)
+    {
+      const Standard_Integer aFirst = GroupFirstRay(aGroup);
+      if (aFirst >= myNbRays || GroupSize(aGroup) == 4)
         continue;
 
-      if (aBVH->IsOuter(aNodeIdx))
+      myGroups[aGroup] = myGroups[ChildGroup(aGroup, 0)];
+      for (Standard_Integer aChild = 1; aChild < 4; ++aChild)
       {
-        // Leaf node - test triangles
-        Standard_Integer aFirstTriIdx = aBVH->BegPrimitive(aNodeIdx);
-        Standard_Integer aLastTriIdx  = aBVH->EndPrimitive(aNodeIdx);
-
-        for (Standard_Integer triIdx = aFirstTriIdx; triIdx <= aLastTriIdx; ++triIdx)
-        {
-          TestTriangle(triIdx);
-        }
+        if (GroupFirstRay(ChildGroup(aGroup, aChild)) < myNbRays)
+          myGroups[aGroup].Add(myGroups[ChildGroup(aGroup, aChild)]);
       }
-      else
-      {
-        // Inner node - push children
-        Standard_Integer aLeftChild  = aBVH->Child<0>(aNodeIdx);
-        Standard_Integer aRightChild = aBVH->Child<1>(aNodeIdx);
+    }
+    UpdateClosest();
 
-        aStack.push_back(aRightChild);
-        aStack.push_back(aLeftChild);
-      }
+    for (int k = 0; k < 3; ++k)
+    {
+      myMeanDir[k] = 0.5 / myGroups[0].InvDirMin[k] + 0.5 / myGroups[0].InvDirMax[k];
     }
+    return myGroups[0].IsCoherent();
   }
 
-  //! Get the total number of hits
-  Standard_Integer GetHitCount() const { return myHitCount; }
+  //! Traverse the flattened triangle BVH for all rays of the packet
+  void Select(const BRepIntCurveSurface_FlatBVH& theBVH)
+  {
+    if (myNbRays == 0 || theBVH.IsEmpty())
+      return;
 
-  //! Get the number of BVH node tests performed (thread-local, no atomic overhead)
-  Standard_Integer GetNodeTestCount() const { return myNodeTestCount; }
+    if (theBVH.IsFloat())
+      SelectNodes(theBVH.NodesF());
+    else
+      SelectNodes(theBVH.NodesD());
+  }
 
-private:
-  //! Ray-box intersection test using precomputed inverse direction (slab method)
-  Standard_Boolean RayBoxIntersect(const BVH_Vec3d& boxMin,
-                                   const BVH_Vec3d& boxMax,
-                                   Standard_Real&   tNear,
-                                   Standard_Real&   tFar) const
+  //! Get the number of node tests: interval tests of ray groups plus per-ray box tests
+  long long GetNodeTestCount() const
   {
-    Standard_Real t1 = (boxMin[0] - myRayOrigin[0]) * myInvRayDir[0];
-    Standard_Real t2 = (boxMax[0] - myRayOrigin[0]) * myInvRayDir[0];
-
-    tNear = std::min(t1, t2);
-    tFar  = std::max(t1, t2);
+    long long aCount = myNodeTestCount;
+    for (Standard_Integer i = 0; i < MaxRays; ++i)
+    {
+      aCount += myRays[i].GetNodeTestCount();
+    }
+    return aCount;
+  }
 
-    t1 = (boxMin[1] - myRayOrigin[1]) * myInvRayDir[1];
-    t2 = (boxMax[1] - myRayOrigin[1]) * myInvRayDir[1];
+private:
+  //! Result of the interval test of a box against a group of rays
+  enum BoxHit
+  {
+    BoxHit_None, //!< No ray of the group hits the box
+    BoxHit_Some, //!< Undecided
+    BoxHit_All   //!< Every ray of the group hits the box
+  };
 
-    tNear = std::max(tNear, std::min(t1, t2));
-    tFar  = std::min(tFar, std::max(t1, t2));
+  //! Groups of rays: the packet (0), 16-ray groups (1..4) and 4-ray groups (5..20)
+  static constexpr Standard_Integer NbGroups = 21;
 
-    t1 = (boxMin[2] - myRayOrigin[2]) * myInvRayDir[2];
-    t2 = (boxMax[2] - myRayOrigin[2]) * myInvRayDir[2];
+  static Standard_Integer GroupSize(const Standard_Integer theGroup)
+  {
+    return theGroup == 0 ? 64 : (theGroup < 5 ? 16 : 4);
+  }
 
-    tNear = std::max(tNear, std::min(t1, t2));
-    tFar  = std::min(tFar, std::max(t1, t2));
+  static Standard_Integer GroupFirstRay(const Standard_Integer theGroup)
+  {
+    return theGroup == 0 ? 0 : (theGroup < 5 ? (theGroup - 1) * 16 : (theGroup - 5) * 4);
+  }
 
-    return tNear <= tFar;
+  static Standard_Integer ChildGroup(const Standard_Integer theGroup,
+                                     const Standard_Integer theChild)
+  {
+    return 4 * theGroup + 1 + theChild;
   }
 
-  //! Test a single triangle and count if hit
-  void TestTriangle(Standard_Integer triIdx)
+  //! Bounds of the origins and inverse directions of a group of rays
+  struct RayBounds
   {
-    if (myTriangleInfo == nullptr)
-      return;
+    BVH_Vec3d OriginMin;
+    BVH_Vec3d OriginMax;
+    BVH_Vec3d InvDirMin;
+    BVH_Vec3d InvDirMax;
 
-    if (triIdx < 0 || triIdx >= static_cast<Standard_Integer>(myTriBVH->Elements.size()))
-      return;
+    void Init(const BRepIntCurveSurface_TriangleTraverser* theRays, const Standard_Integer theNb)
+    {
+      OriginMin = OriginMax = theRays[0].RayOrigin();
+      InvDirMin = InvDirMax = theRays[0].InvRayDir();
+      for (Standard_Integer i = 1; i < theNb; ++i)
+      {
+        OriginMin = OriginMin.cwiseMin(theRays[i].RayOrigin());
+        OriginMax = OriginMax.cwiseMax(theRays[i].RayOrigin());
+        InvDirMin = InvDirMin.cwiseMin(theRays[i].InvRayDir());
+        InvDirMax = InvDirMax.cwiseMax(theRays[i].InvRayDir());
+      }
+    }
 
-    const BVH_Vec4i& elem = myTriBVH->Elements[triIdx];
+    void Add(const RayBounds& theOther)
+    {
+      OriginMin = OriginMin.cwiseMin(theOther.OriginMin);
+      OriginMax = OriginMax.cwiseMax(theOther.OriginMax);
+      InvDirMin = InvDirMin.cwiseMin(theOther.InvDirMin);
+      InvDirMax = InvDirMax.cwiseMax(theOther.InvDirMax);
+    }
 
-    if (elem[0] < 0 || elem[0] >= static_cast<Standard_Integer>(myTriBVH->Vertices.size())
-        || elem[1] < 0 || elem[1] >= static_cast<Standard_Integer>(myTriBVH->Vertices.size())
-        || elem[2] < 0 || elem[2] >= static_cast<Standard_Integer>(myTriBVH->Vertices.size()))
-      return;
+    //! Returns true if the direction signs agree on every axis
+    Standard_Boolean IsCoherent() const
+    {
+      return (InvDirMin[0] < 0.0) == (InvDirMax[0] < 0.0)
+             && (InvDirMin[1] < 0.0) == (InvDirMax[1] < 0.0)
+             && (InvDirMin[2] < 0.0) == (InvDirMax[2] < 0.0);
+    }
+  };
 
-    const BVH_Vec3d& v0 = myTriBVH->Vertices[elem[0]];
-    const BVH_Vec3d& v1 = myTriBVH->Vertices[elem[1]];
-    const BVH_Vec3d& v2 = myTriBVH->Vertices[elem[2]];
+  //! Slab test of a node box against a group of rays with interval arithmetic.
+  //! theMaxClosestT is the largest closest hit of the group (for culling).
+  template <class NodeT>
+  BoxHit IntersectBounds(const NodeT&        theNode,
+                         const RayBounds&    theBounds,
+                         const Standard_Real theMaxClosestT)
+  {
+    ++myNodeTestCount;
 
-    Standard_Real t, u, v;
-    if (RayTriangleIntersect(myRayOrigin, myRayDir, v0, v1, v2, t, u, v))
+    Standard_Real aNearLo = myMinParam, aNearHi = myMinParam;
+    Standard_Real aFarLo = RealLast(), aFarHi = theMaxClosestT;
+    for (int k = 0; k < 3; ++k)
     {
-      if (t >= myMinParam && t <= myMaxParam)
+      // Direction signs agree on the axis, so all rays enter through the same slab plane
+      const Standard_Boolean isNeg  = theBounds.InvDirMin[k] < 0.0;
+      const Standard_Real    aEntry = isNeg ? theNode.MaxPoint[k] : theNode.MinPoint[k];
+      const Standard_Real    aExit  = isNeg ? theNode.MinPoint[k] : theNode.MaxPoint[k];
+
+      // Bounds of the products of the intervals (plane - origin) and inverse direction
+      const Standard_Real aNear[4] = {(aEntry - theBounds.OriginMin[k]) * theBounds.InvDirMin[k],
+                                      (aEntry - theBounds.OriginMin[k]) * theBounds.InvDirMax[k],
+                                      (aEntry - theBounds.OriginMax[k]) * theBounds.InvDirMin[k],
+                                      (aEntry - theBounds.OriginMax[k]) * theBounds.InvDirMax[k]};
+      const Standard_Real aFar[4]  = {(aExit - theBounds.OriginMin[k]) * theBounds.InvDirMin[k],
+                                      (aExit - theBounds.OriginMin[k]) * theBounds.InvDirMax[k],
+                                      (aExit - theBounds.OriginMax[k]) * theBounds.InvDirMin[k],
+                                      (aExit - theBounds.OriginMax[k]) * theBounds.InvDirMax[k]};
+      aNearLo = std::max(aNearLo, std::min({aNear[0], aNear[1], aNear[2], aNear[3]}));
+      aNearHi = std::max(aNearHi, std::max({aNear[0], aNear[1], aNear[2], aNear[3]}));
+      aFarLo  = std::min(aFarLo, std::min({aFar[0], aFar[1], aFar[2], aFar[3]}));
+      aFarHi  = std::min(aFarHi, std::max({aFar[0], aFar[1], aFar[2], aFar[3]}));
+    }
+
+    if (aNearLo > aFarHi)
+      return BoxHit_None;
+    return aNearHi <= aFarLo ? BoxHit_All : BoxHit_Some;
+  }
+
+  //! Recompute the largest closest hit parameter of every group
+  void UpdateClosest()
+  {
+    for (Standard_Integer aGroup = NbGroups - 1; aGroup >= 0; --aGroup)
+    {
+      Standard_Real aMax = myMinParam;
+      if (GroupSize(aGroup) == 4)
+      {
+        const Standard_Integer aFirst = GroupFirstRay(aGroup);
+        for (Standard_Integer i = aFirst; i < std::min(aFirst + 4, myNbRays); ++i)
+        {
+          aMax = std::max(aMax, myRays[i].GetHitT());
+        }
+      }
+      else
       {
-        ++myHitCount;
+        for (Standard_Integer aChild = 0; aChild < 4; ++aChild)
+        {
+          aMax = std::max(aMax, myMaxClosestT[ChildGroup(aGroup, aChild)]);
+        }
       }
+      myMaxClosestT[aGroup] = aMax;
     }
   }
 
-  BRepIntCurveSurface_TriBVH*                          myTriBVH;
-  const std::vector<BRepIntCurveSurface_TriangleInfo>* myTriangleInfo;
-  BVH_Vec3d                                            myRayOrigin;
-  BVH_Vec3d                                            myRayDir;
-  BVH_Vec3d                                            myInvRayDir;
-  Standard_Integer                                     myHitCount;
-  Standard_Real                                        myMinParam;
-  Standard_Real                                        myMaxParam;
-  Standard_Integer myNodeTestCount; // Thread-local counter (no atomic overhead)
-};
-} // namespace
-
-//=================================================================================================
+  //! Narrow the mask of active rays of a group to the rays that may hit the node box.
+  //! Child groups are tested only when the group is undecided, and single rays
+  //! only within undecided 4-ray groups.
+  template <class NodeT>
+  uint64_t IntersectGroup(const NodeT&           theNode,
+                          const Standard_Integer theGroup,
+                          const uint64_t         theMask)
+  {
+    const Standard_Integer aSize      = GroupSize(theGroup);
+    const uint64_t         aGroupBits = aSize == 64 ? ~uint64_t(0) : (uint64_t(1) << aSize) - 1;
+    const uint64_t         aMask      = theMask & (aGroupBits << GroupFirstRay(theGroup));
+    if (aMask == 0)
+      return 0;
+
+    const BoxHit aHit = IntersectBounds(theNode, myGroups[theGroup], myMaxClosestT[theGroup]);
+    if (aHit != BoxHit_Some)
+      return aHit == BoxHit_All ? aMask : 0;
+
+    uint64_t aResult = 0;
+    if (aSize == 4)
+    {
+      for (uint64_t aBits = aMask; aBits != 0; aBits &= aBits - 1)
+      {
+        const Standard_Integer aRay = LowestBit(aBits);
+        Standard_Real          aNear;
+        if (myRays[aRay].IntersectNode(theNode, aNear))
+          aResult |= uint64_t(1) << aRay;
+      }
+      return aResult;
+    }
+
+    for (Standard_Integer aChild = 0; aChild < 4; ++aChild)
+    {
+      aResult |= IntersectGroup(theNode, ChildGroup(theGroup, aChild), aMask);
+    }
+    return aResult;
+  }
+
+  //! Traversal over depth-first ordered nodes with a mask of active rays.
+  //! Children are visited in the order of their centers along the mean ray direction.
+  template <class NodeT>
+  void SelectNodes(const NodeT* theNodes)
+  {
+    // At most one deferred sibling per tree level (depth checked by FlatBVH::Build)
+    Standard_Integer aStack[BRepIntCurveSurface_FlatBVH::MaxStackSize];
+    uint64_t         aStackMask[BRepIntCurveSurface_FlatBVH::MaxStackSize];
+    Standard_Integer aHead = -1;
+
+    Standard_Integer aNodeIdx = 0; // Start at root
+    uint64_t aMask = myNbRays == MaxRays ? ~uint64_t(0) : (uint64_t(1) << myNbRays) - 1;
+    for (;;)
+    {
+      const NodeT& aNode = theNodes[aNodeIdx];
+
+      aMask = IntersectGroup(aNode, 0, aMask);
+      if (aMask != 0)
+      {
+        if (!aNode.IsLeaf())
+        {
+          // Inner node - left child follows its parent, right child is at Offset
+          Standard_Integer aNear = aNodeIdx + 1;
+          Standard_Integer aFar  = aNode.Offset;
+          if (CenterAlongRays(theNodes[aFar]) < CenterAlongRays(theNodes[aNear]))
+            std::swap(aNear, aFar);
+
+          ++aHead;
+          aStack[aHead]     = aFar;
+          aStackMask[aHead] = aMask;
+          aNodeIdx          = aNear;
+          continue;
+        }
+
+        // Leaf node - test triangles for every active ray
+        for (uint64_t aBits = aMask; aBits != 0; aBits &= aBits - 1)
+        {
+          myRays[LowestBit(aBits)].TestLeaf(aNode.Offset, aNode.NbPrims);
+        }
+
+        UpdateClosest();
+      }
+
+      if (aHead < 0)
+        return;
+      aNodeIdx = aStack[aHead];
+      aMask    = aStackMask[aHead];
+      --aHead;
+    }
+  }
+
+  //! Position of the node center along the mean ray direction (scaled by 2)
+  template <class NodeT>
+  Standard_Real CenterAlongRays(const NodeT& theNode) const
+  {
+    Standard_Real aPos = 0.0;
+    for (int k = 0; k < 3; ++k)
+    {
+      const Standard_Real aMin = theNode.MinPoint[k];
+      aPos += (aMin + theNode.MaxPoint[k]) * myMeanDir[k];
+    }
+    return aPos;
+  }
+
+  //! Index of the lowest set bit of a non-zero mask
+  static Standard_Integer LowestBit(const uint64_t theMask)
+  {
+#if defined(_MSC_VER)
+    unsigned long anIndex;
+    _BitScanForward64(&anIndex, theMask);
+    return static_cast<Standard_Integer>(anIndex);
+#else
+    return __builtin_ctzll(theMask);
+#endif
+  }
+
+  BRepIntCurveSurface_TriangleTraverser myRays[MaxRays];
+  RayBounds                             myGroups[NbGroups];
+  Standard_Real                         myMaxClosestT[NbGroups]; // Largest closest hit per group
+  Standard_Integer                      myNbRays;
+  BVH_Vec3d                             myMeanDir;
+  Standard_Real                         myMinParam;
+  long long                             myNodeTestCount;
+};
+
+//! Triangle BVH traverser that counts ALL intersections (not just closest)
+//! Used for PerformBatchCount with tessellation acceleration
+class BRepIntCurveSurface_TriangleCountTraverser
+{
+public:
+  BRepIntCurveSurface_TriangleCountTraverser()
+      : myTriangles(nullptr),
+        myPackets(nullptr),
+        myFlatBVH(nullptr),
+        myWideBVH(nullptr),
+        myInstances(nullptr),
+        myTriangleShift(0),
+        myHitList(nullptr),
+        myUniqueHits(Standard_False),
+        myHitCount(0),
+        myMaxHitCount(IntegerLast()),
+        myMinParam(0.0),
+        myMaxParam(RealLast()),
+        myNodeTestCount(0)
+  {
+  }
+
+  //! Set triangle records in BVH primitive order
+  void SetTriangles(const BRepIntCurveSurface_TriangleRecord* theTriangles)
+  {
+    myTriangles = theTriangles;
+  }
+
+  //! Set SIMD triangle packets; used instead of the records when not empty
+  void SetTrianglePackets(const BRepIntCurveSurface_TrianglePackets* thePackets)
+  {
+    myPackets = (thePackets != nullptr && !thePackets->IsEmpty()) ? thePackets : nullptr;
+  }
+
+  void SetFlatBVH(const BRepIntCurveSurface_FlatBVH* theBVH) { myFlatBVH = theBVH; }
+
+  void SetWideBVH(const BRepIntCurveSurface_WideBVH* theBVH) { myWideBVH = theBVH; }
+
+  //! Set part instances; when not empty, the top-level BVH is traversed and the
+  //! triangle data set above is ignored
+  void SetInstances(const BRepIntCurveSurface_InstanceSet* theInstances)
+  {
+    myInstances = (theInstances != nullptr && !theInstances->IsEmpty()) ? theInstances : nullptr;
+  }
+
+  //! Stop the traversal as soon as theCount hits are found (1 for any-hit queries)
+  void SetMaxHitCount(const Standard_Integer theCount) { myMaxHitCount = theCount; }
+
+  //! Append every counted hit to theHits (not cleared by SetRay); nullptr to only count
+  void SetHitList(std::vector<TriangleHit>* theHits) { myHitList = theHits; }
+
+  //! Count every triangle once per ray; needed when split triangles have several
+  //! BVH references that the ray may all reach
+  void SetUniqueHits(const Standard_Boolean theUnique) { myUniqueHits = theUnique; }
+
+  void SetRay(const gp_Lin& theRay, Standard_Real theMin, Standard_Real theMax)
+  {
+    myRayOrigin[0] = theRay.Location().X();
+    myRayOrigin[1] = theRay.Location().Y();
+    myRayOrigin[2] = theRay.Location().Z();
+    myRayDir[0]    = theRay.Direction().X();
+    myRayDir[1]    = theRay.Direction().Y();
+    myRayDir[2]    = theRay.Direction().Z();
+    UpdateInverseDir();
+
+    myMinParam = theMin;
+    myMaxParam = theMax;
+    myHitCount = 0;
+    myHitTriangles.clear();
+  }
+
+  //! Traverse the wide or flattened triangle BVH (or the top-level BVH and the parts
+  //! of the instances) to count ALL hits
+  void Select()
+  {
+    if (myInstances != nullptr)
+    {
+      SelectNodes<true>(myInstances->TopLevel().NodesD());
+      return;
+    }
+    SelectTriangles();
+  }
+
+  //! Get the total number of hits (at most the maximum hit count)
+  Standard_Integer GetHitCount() const { return myHitCount; }
+
+  //! Get the number of BVH node tests performed (thread-local, no atomic overhead)
+  long long GetNodeTestCount() const { return myNodeTestCount; }
+
+private:
+  //! Precompute the inverse direction for fast ray-box intersection and the
+  //! single-precision copies
+  void UpdateInverseDir()
+  {
+    const Standard_Real epsilon = 1e-12;
+    for (int i = 0; i < 3; ++i)
+    {
+      myInvRayDir[i] = (std::abs(myRayDir[i]) > epsilon)
+                         ? (1.0 / myRayDir[i])
+                         : (myRayDir[i] >= 0 ? 1.0 / epsilon : -1.0 / epsilon);
+      myRayOriginF[i] = static_cast<Standard_ShortReal>(myRayOrigin[i]);
+      myInvRayDirF[i] = static_cast<Standard_ShortReal>(myInvRayDir[i]);
+    }
+  }
+
+  //! Traverse the triangle BVH set by SetFlatBVH() / SetWideBVH() or of the current part
+  void SelectTriangles()
+  {
+    if (myTriangles == nullptr && myPackets == nullptr)
+      return;
+
+    if (myWideBVH != nullptr && !myWideBVH->IsEmpty())
+    {
+      if (myWideBVH->Width() == 8)
+        SelectWide(myWideBVH->Nodes8());
+      else
+        SelectWide(myWideBVH->Nodes4());
+    }
+    else if (myFlatBVH != nullptr && !myFlatBVH->IsEmpty())
+    {
+      if (myFlatBVH->IsFloat())
+        SelectNodes(myFlatBVH->NodesF());
+      else
+        SelectNodes(myFlatBVH->NodesD());
+    }
+  }
+
+  //! Traversal over depth-first ordered nodes with a fixed-size stack.
+  //! Order does not matter when counting, so the left child is always descended
+  //! first and the right child deferred. On the top level, the leaves hold part
+  //! instances instead of triangles.
+  template <bool IsTopLevel = false, class NodeT>
+  void SelectNodes(const NodeT* theNodes)
+  {
+    // At most one deferred sibling per tree level (depth checked by FlatBVH::Build)
+    Standard_Integer aStack[BRepIntCurveSurface_FlatBVH::MaxStackSize];
+    Standard_Integer aHead    = -1;
+    Standard_Integer aNodeIdx = 0; // Start at root
+
+    for (;;)
+    {
+      const NodeT& aNode = theNodes[aNodeIdx];
+
+      ++myNodeTestCount; // Thread-local counter (no atomic overhead)
+
+      // Test ray against box, skip if entirely behind ray or past max param
+      Standard_Real tNear, tFar;
+      if (RayBoxIntersect(aNode.MinPoint, aNode.MaxPoint, myRayOrigin, myInvRayDir, tNear, tFar)
+          && tFar >= myMinParam && tNear <= myMaxParam)
+      {
+        if (!aNode.IsLeaf())
+        {
+          // Inner node - descend left child, defer right child
+          aStack[++aHead] = aNode.Offset;
+          aNodeIdx        = aNodeIdx + 1;
+          continue;
+        }
+
+        // Leaf node - test triangles
+        if constexpr (IsTopLevel)
+        {
+          if (TestInstances(aNode.Offset, aNode.NbPrims))
+            return;
+        }
+        else if (TestLeaf(aNode.Offset, aNode.NbPrims))
+          return;
+      }
+
+      if (aHead < 0)
+        return;
+      aNodeIdx = aStack[aHead--];
+    }
+  }
+
+  //! Traversal over wide nodes; all hit children are deferred in slot order
+  template <int W>
+  void SelectWide(const BRepIntCurveSurface_WideNode<W>* theNodes)
+  {
+    WideStackEntry           aStack[BRepIntCurveSurface_WideBVH::MaxStackSize];
+    Standard_Integer         aHead     = -1;
+    Standard_Integer         aNodeIdx  = 0; // Start at root
+    const Standard_ShortReal aMinParam = ToFloatDown(myMinParam);
+    const Standard_ShortReal aMaxParam = ToFloatUp(myMaxParam);
+
+    for (;;)
+    {
+      const BRepIntCurveSurface_WideNode<W>& aNode = theNodes[aNodeIdx];
+
+      ++myNodeTestCount; // One SIMD test of all children
+
+      Standard_ShortReal aNear[W];
+      int                aMask = BRepIntCurveSurface_WideBVH::IntersectChildren(
+        aNode, myRayOriginF, myInvRayDirF, aMinParam, aMaxParam, aNear);
+
+      for (Standard_Integer i = 0; aMask != 0; ++i, aMask >>= 1)
+      {
+        if ((aMask & 1) == 0)
+          continue;
+
+        ++aHead;
+        aStack[aHead].Offset  = aNode.Offset[i];
+        aStack[aHead].NbPrims = aNode.NbPrims[i];
+        aStack[aHead].Near    = aNear[i];
+      }
+
+      // Pop entries: leaves are tested in place, the first inner node is visited next
+      for (;;)
+      {
+        if (aHead < 0)
+          return;
+
+        const WideStackEntry anEntry = aStack[aHead--];
+        if (anEntry.NbPrims == 0)
+        {
+          aNodeIdx = anEntry.Offset;
+          break;
+        }
+
+        if (TestLeaf(anEntry.Offset, anEntry.NbPrims))
+          return;
+      }
+    }
+  }
+
+  //! Count the hits in the parts of the instances of a top-level leaf, in part
+  //! coordinates. Returns true once the maximum hit count is reached.
+  Standard_Boolean TestInstances(const Standard_Integer theFirst, const Standard_Integer theNbPrims)
+  {
+    const BVH_Vec3d  aRayOrigin = myRayOrigin;
+    const BVH_Vec3d  aRayDir    = myRayDir;
+    Standard_Boolean isFull     = Standard_False;
+    for (Standard_Integer aPrim = theFirst; aPrim < theFirst + theNbPrims && !isFull; ++aPrim)
+    {
+      const BRepIntCurveSurface_Instance&  anInstance = myInstances->LeafInstance(aPrim);
+      const BRepIntCurveSurface_Prototype& aPrototype =
+        myInstances->Prototype(anInstance.Prototype);
+      anInstance.ToPartRay(aRayOrigin, aRayDir, myRayOrigin, myRayDir);
+      UpdateInverseDir();
+
+      myTriangles     = aPrototype.Records.data();
+      myPackets       = aPrototype.Packets.IsEmpty() ? nullptr : &aPrototype.Packets;
+      myFlatBVH       = &aPrototype.FlatBVH;
+      myWideBVH       = &aPrototype.WideBVH;
+      myTriangleShift = anInstance.FirstTriangle - aPrototype.FirstTriangle;
+      SelectTriangles();
+      isFull = myHitCount >= myMaxHitCount;
+    }
+    myRayOrigin = aRayOrigin;
+    myRayDir    = aRayDir;
+    UpdateInverseDir();
+    return isFull;
+  }
+
+  //! Count the hits in the triangles of a leaf, a packet per SIMD pass when packets are set.
+  //! Returns true once the maximum hit count is reached.
+  Standard_Boolean TestLeaf(const Standard_Integer theFirst, const Standard_Integer theNbPrims)
+  {
+    if (myPackets == nullptr)
+    {
+      for (Standard_Integer triIdx = theFirst; triIdx < theFirst + theNbPrims; ++triIdx)
+      {
+        TestTriangle(triIdx);
+        if (myHitCount >= myMaxHitCount)
+          return Standard_True;
+      }
+      return Standard_False;
+    }
+
+    const BRepIntCurveSurface_TrianglePacket* aPackets = myPackets->LeafPackets(theFirst);
+    const Standard_Integer aNbPackets =
+      BRepIntCurveSurface_TrianglePackets::NbLeafPackets(theNbPrims);
+    for (Standard_Integer aPacketIdx = 0; aPacketIdx < aNbPackets; ++aPacketIdx)
+    {
+      Standard_Real t[BRepIntCurveSurface_TrianglePackets::Lanes];
+      Standard_Real u[BRepIntCurveSurface_TrianglePackets::Lanes];
+      Standard_Real v[BRepIntCurveSurface_TrianglePackets::Lanes];
+      int           aMask = BRepIntCurveSurface_TrianglePackets::Intersect(
+        aPackets[aPacketIdx],
+        std::min(theNbPrims - aPacketIdx * BRepIntCurveSurface_TrianglePackets::Lanes,
+                 BRepIntCurveSurface_TrianglePackets::Lanes),
+        myRayOrigin,
+        myRayDir,
+        myMinParam,
+        myMaxParam,
+        t,
+        u,
+        v);
+      for (int aLane = 0; aMask != 0; ++aLane, aMask >>= 1)
+      {
+        if ((aMask & 1) == 0)
+          continue;
+
+        AddHit(t[aLane], u[aLane], v[aLane], aPackets[aPacketIdx].OriginalIndex[aLane]);
+      }
+      if (myHitCount >= myMaxHitCount)
+      {
+        myHitCount = myMaxHitCount;
+        return Standard_True;
+      }
+    }
+    return Standard_False;
+  }
+
+  //! Test a single triangle and count if hit
+  void TestTriangle(Standard_Integer triIdx)
+  {
+    const BRepIntCurveSurface_TriangleRecord& aTri = myTriangles[triIdx];
+
+    Standard_Real t, u, v;
+    if (RayTriangleIntersect(myRayOrigin, myRayDir, aTri.V0, aTri.Edge1, aTri.Edge2, t, u, v))
+    {
+      if (t >= myMinParam && t <= myMaxParam)
+      {
+        AddHit(t, u, v, aTri.OriginalIndex);
+      }
+    }
+  }
+
+  //! Count a hit and append it to the hit list; with unique hits, a triangle already
+  //! hit through another of its BVH references is skipped
+  void AddHit(const Standard_Real    theT,
+              const Standard_Real    theU,
+              const Standard_Real    theV,
+              const Standard_Integer theTriIdx)
+  {
+    const Standard_Integer aTriIdx = theTriIdx + myTriangleShift;
+    if (myUniqueHits)
+    {
+      if (std::find(myHitTriangles.begin(), myHitTriangles.end(), aTriIdx)
+          != myHitTriangles.end())
+        return;
+      myHitTriangles.push_back(aTriIdx);
+    }
+
+    ++myHitCount;
+    if (myHitList != nullptr)
+    {
+      myHitList->push_back({theT, theU, theV, aTriIdx});
+    }
+  }
+
+  const BRepIntCurveSurface_TriangleRecord*            myTriangles;
+  const BRepIntCurveSurface_TrianglePackets*           myPackets;
+  const BRepIntCurveSurface_FlatBVH*                   myFlatBVH;
+  const BRepIntCurveSurface_WideBVH*                   myWideBVH;
+  const BRepIntCurveSurface_InstanceSet*               myInstances;
+  Standard_Integer                                     myTriangleShift; // Instance hit offset
+  std::vector<TriangleHit>*                            myHitList;
+  std::vector<Standard_Integer>                        myHitTriangles; // Hit triangles of the ray
+  Standard_Boolean                                     myUniqueHits;
+  BVH_Vec3d                                            myRayOrigin;
+  BVH_Vec3d                                            myRayDir;
+  BVH_Vec3d                                            myInvRayDir;
+  Standard_ShortReal                                   myRayOriginF[3];
+  Standard_ShortReal                                   myInvRayDirF[3];
+  Standard_Integer                                     myHitCount;
+  Standard_Integer                                     myMaxHitCount;
+  Standard_Real                                        myMinParam;
+  Standard_Real                                        myMaxParam;
+  long long myNodeTestCount; // Thread-local counter (no atomic overhead)
+};
+} // namespace
+
+//=================================================================================================
 
 BRepIntCurveSurface_InterBVH::BRepIntCurveSurface_InterBVH()
     : myTolerance(Precision::Confusion()),
       myDeflection(0.0),
       myUseTessellation(Standard_False),
+      myUseCompactUVs(Standard_False),
+      myUseCurvedUVs(Standard_False),
+      myUseTrianglePackets(BRepIntCurveSurface_TrianglePackets::IsVectorized()),
+      myUseCompactNodes(Standard_True),
+      myBVHWidth(2),
+      myUseRayPackets(Standard_False),
+      myBVHBuilder(BRepIntCurveSurface_BVHBuilder::Linear),
+      myBVHLeafSize(4),
+      myBVHMaxDepth(32),
+      myUseTriangleSplits(Standard_False),
+      myNbTriangleSplits(0),
+      myWeldEdgesOnly(Standard_False),
+      myNbMovedTriangles(0),
+      myNbUpdatedTriangles(0),
+      myIsBVHFromCache(Standard_False),
+      myUseInstancing(Standard_False),
+      myUseAnalyticSurfaces(Standard_True),
       myIsLoaded(Standard_False),
       myIsDone(Standard_False),
       myNbPnt(0),
@@ -810,7 +2370,8 @@ BRepIntCurveSurface_InterBVH::BRepIntCurveSurface_InterBVH()
 #ifdef OCCT_USE_EMBREE
       ,
       myEmbreeDevice(nullptr),
-      myEmbreeScene(nullptr)
+      myEmbreeScene(nullptr),
+      myEmbreeNbVertices(0)
 #endif
 {
 }
@@ -833,6 +2394,44 @@ BRepIntCurveSurface_InterBVH::~BRepIntCurveSurface_InterBVH()
 #endif
 }
 
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::SetBVHWidth(const Standard_Integer theWidth)
+{
+  if (theWidth != 2 && theWidth != 4 && theWidth != 8)
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::SetBVHWidth - width must be 2, 4 or 8");
+  if (theWidth > 2 && myBVHMaxDepth > BRepIntCurveSurface_WideBVH::MaxDepth(theWidth))
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::SetBVHWidth - maximum depth exceeds wide traversal stack");
+  myBVHWidth = theWidth;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::SetBVHLeafSize(const Standard_Integer theSize)
+{
+  if (theSize < 1)
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::SetBVHLeafSize - leaf size must be positive");
+  myBVHLeafSize = theSize;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::SetBVHMaxDepth(const Standard_Integer theDepth)
+{
+  // Traversal stacks of the flattened tree hold one entry per level; those of the wide
+  // tree hold up to W - 1 deferred siblings per level
+  if (theDepth < 1 || theDepth >= BRepIntCurveSurface_FlatBVH::MaxStackSize)
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::SetBVHMaxDepth - depth exceeds traversal stack size");
+  if (myBVHWidth > 2 && theDepth > BRepIntCurveSurface_WideBVH::MaxDepth(myBVHWidth))
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::SetBVHMaxDepth - depth exceeds wide traversal stack size");
+  myBVHMaxDepth = theDepth;
+}
+
 //=================================================================================================
 // SIMD helpers for Embree batch intersection
 //=================================================================================================
@@ -840,19 +2439,36 @@ BRepIntCurveSurface_InterBVH::~BRepIntCurveSurface_InterBVH()
 #ifdef OCCT_USE_EMBREE
 namespace
 {
+//! Near ray parameter in Embree precision, rounded down like the native traversal so
+//! that both backends keep hits at the caller's minimum; Embree requires tnear >= 0
+inline float EmbreeNear(const Standard_Real theMin)
+{
+  return std::max(ToFloatDown(theMin), 0.0f);
+}
+
+//! Far ray parameter in Embree precision, rounded up (RealLast() maps to infinity)
+inline float EmbreeFar(const Standard_Real theMax)
+{
+  return ToFloatUp(theMax);
+}
+
 //! Process 4 rays at once using SSE (rtcIntersect4)
 //! @param theScene Embree scene
 //! @param theRays Array of 4 rays (input)
+//! @param theMins Minimum parameters of the rays
+//! @param theMaxs Maximum parameters of the rays
 //! @param theTriIdx Output: triangle indices (-1 if miss)
 //! @param theHitT Output: hit distances
 //! @param theBaryU Output: barycentric U coordinates
 //! @param theBaryV Output: barycentric V coordinates
-void IntersectEmbree4(RTCScene          theScene,
-                      const gp_Lin*     theRays,
-                      Standard_Integer* theTriIdx,
-                      Standard_Real*    theHitT,
-                      Standard_Real*    theBaryU,
-                      Standard_Real*    theBaryV)
+void IntersectEmbree4(RTCScene             theScene,
+                      const gp_Lin*        theRays,
+                      const Standard_Real* theMins,
+                      const Standard_Real* theMaxs,
+                      Standard_Integer*    theTriIdx,
+                      Standard_Real*       theHitT,
+                      Standard_Real*       theBaryU,
+                      Standard_Real*       theBaryV)
 {
   alignas(16) RTCRayHit4 rayhit4;
   alignas(16) int        valid[4] = {-1, -1, -1, -1};
@@ -866,8 +2482,8 @@ void IntersectEmbree4(RTCScene          theScene,
     rayhit4.ray.dir_x[i]  = static_cast<float>(theRays[i].Direction().X());
     rayhit4.ray.dir_y[i]  = static_cast<float>(theRays[i].Direction().Y());
     rayhit4.ray.dir_z[i]  = static_cast<float>(theRays[i].Direction().Z());
-    rayhit4.ray.tnear[i]  = 0.0f;
-    rayhit4.ray.tfar[i]   = std::numeric_limits<float>::infinity();
+    rayhit4.ray.tnear[i]  = EmbreeNear(theMins[i]);
+    rayhit4.ray.tfar[i]   = EmbreeFar(theMaxs[i]);
     rayhit4.ray.mask[i]   = static_cast<unsigned int>(-1);
     rayhit4.ray.flags[i]  = 0;
     rayhit4.hit.geomID[i] = RTC_INVALID_GEOMETRY_ID;
@@ -900,16 +2516,20 @@ void IntersectEmbree4(RTCScene          theScene,
 //! Process 8 rays at once using AVX (rtcIntersect8)
 //! @param theScene Embree scene
 //! @param theRays Array of 8 rays (input)
+//! @param theMins Minimum parameters of the rays
+//! @param theMaxs Maximum parameters of the rays
 //! @param theTriIdx Output: triangle indices (-1 if miss)
 //! @param theHitT Output: hit distances
 //! @param theBaryU Output: barycentric U coordinates
 //! @param theBaryV Output: barycentric V coordinates
-void IntersectEmbree8(RTCScene          theScene,
-                      const gp_Lin*     theRays,
-                      Standard_Integer* theTriIdx,
-                      Standard_Real*    theHitT,
-                      Standard_Real*    theBaryU,
-                      Standard_Real*    theBaryV)
+void IntersectEmbree8(RTCScene             theScene,
+                      const gp_Lin*        theRays,
+                      const Standard_Real* theMins,
+                      const Standard_Real* theMaxs,
+                      Standard_Integer*    theTriIdx,
+                      Standard_Real*       theHitT,
+                      Standard_Real*       theBaryU,
+                      Standard_Real*       theBaryV)
 {
   alignas(32) RTCRayHit8 rayhit8;
   alignas(32) int        valid[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
@@ -923,8 +2543,8 @@ void IntersectEmbree8(RTCScene          theScene,
     rayhit8.ray.dir_x[i]  = static_cast<float>(theRays[i].Direction().X());
     rayhit8.ray.dir_y[i]  = static_cast<float>(theRays[i].Direction().Y());
     rayhit8.ray.dir_z[i]  = static_cast<float>(theRays[i].Direction().Z());
-    rayhit8.ray.tnear[i]  = 0.0f;
-    rayhit8.ray.tfar[i]   = std::numeric_limits<float>::infinity();
+    rayhit8.ray.tnear[i]  = EmbreeNear(theMins[i]);
+    rayhit8.ray.tfar[i]   = EmbreeFar(theMaxs[i]);
     rayhit8.ray.mask[i]   = static_cast<unsigned int>(-1);
     rayhit8.ray.flags[i]  = 0;
     rayhit8.hit.geomID[i] = RTC_INVALID_GEOMETRY_ID;
@@ -954,13 +2574,15 @@ void IntersectEmbree8(RTCScene          theScene,
   }
 }
 
-//! Single ray intersection using Embree (rtcIntersect1)
-void IntersectEmbree1(RTCScene          theScene,
-                      const gp_Lin&     theRay,
-                      Standard_Integer& theTriIdx,
-                      Standard_Real&    theHitT,
-                      Standard_Real&    theBaryU,
-                      Standard_Real&    theBaryV)
+//! Single ray intersection using Embree (rtcIntersect1) within [theMin, theMax]
+void IntersectEmbree1(RTCScene            theScene,
+                      const gp_Lin&       theRay,
+                      const Standard_Real theMin,
+                      const Standard_Real theMax,
+                      Standard_Integer&   theTriIdx,
+                      Standard_Real&      theHitT,
+                      Standard_Real&      theBaryU,
+                      Standard_Real&      theBaryV)
 {
   RTCRayHit rayhit;
   rayhit.ray.org_x  = static_cast<float>(theRay.Location().X());
@@ -969,8 +2591,8 @@ void IntersectEmbree1(RTCScene          theScene,
   rayhit.ray.dir_x  = static_cast<float>(theRay.Direction().X());
   rayhit.ray.dir_y  = static_cast<float>(theRay.Direction().Y());
   rayhit.ray.dir_z  = static_cast<float>(theRay.Direction().Z());
-  rayhit.ray.tnear  = 0.0f;
-  rayhit.ray.tfar   = std::numeric_limits<float>::infinity();
+  rayhit.ray.tnear  = EmbreeNear(theMin);
+  rayhit.ray.tfar   = EmbreeFar(theMax);
   rayhit.ray.mask   = static_cast<unsigned int>(-1);
   rayhit.ray.flags  = 0;
   rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
@@ -994,290 +2616,1656 @@ void IntersectEmbree1(RTCScene          theScene,
     theBaryV  = 0.0;
   }
 }
-} // namespace
-#endif
-
-//=================================================================================================
 
-void BRepIntCurveSurface_InterBVH::Load(const TopoDS_Shape& theShape,
-                                        const Standard_Real theTol,
-                                        const Standard_Real theDeflection)
+//! Occlusion test of up to 4 rays at once using SSE (rtcOccluded4)
+//! @param theScene Embree scene
+//! @param theRays Array of theNbRays rays (input)
+//! @param theNbRays Number of valid rays (1..4)
+//! @param theMins Minimum parameters of the rays
+//! @param theMaxs Maximum parameters of the rays
+//! @param theOccluded Output: true if the ray hits any triangle within its interval
+void OccludedEmbree4(RTCScene               theScene,
+                     const gp_Lin*          theRays,
+                     const Standard_Integer theNbRays,
+                     const Standard_Real*   theMins,
+                     const Standard_Real*   theMaxs,
+                     Standard_Boolean*      theOccluded)
 {
-  myIsLoaded = Standard_False;
-  myIsDone   = Standard_False;
-  myNbPnt    = 0;
-  myResults.clear();
-  myFaces.Clear();
-  mySurfaceAdaptors.clear();
-  myTriBVH.Nullify();
-  myTriangleInfo.clear();
-  myUseTessellation = Standard_False;
+  alignas(16) RTCRay4 ray4;
+  alignas(16) int     valid[4] = {0, 0, 0, 0};
 
-  myTolerance = theTol;
-  // Always use tessellation - default to 0.1 if not specified
-  myDeflection = (theDeflection > 0.0) ? theDeflection : 0.1;
+  for (int i = 0; i < theNbRays; ++i)
+  {
+    valid[i]      = -1;
+    ray4.org_x[i] = static_cast<float>(theRays[i].Location().X());
+    ray4.org_y[i] = static_cast<float>(theRays[i].Location().Y());
+    ray4.org_z[i] = static_cast<float>(theRays[i].Location().Z());
+    ray4.dir_x[i] = static_cast<float>(theRays[i].Direction().X());
+    ray4.dir_y[i] = static_cast<float>(theRays[i].Direction().Y());
+    ray4.dir_z[i] = static_cast<float>(theRays[i].Direction().Z());
+    ray4.tnear[i] = EmbreeNear(theMins[i]);
+    ray4.tfar[i]  = EmbreeFar(theMaxs[i]);
+    ray4.mask[i]  = static_cast<unsigned int>(-1);
+    ray4.flags[i] = 0;
+  }
 
-  // Collect all faces from the shape
-  TopExp_Explorer anExp(theShape, TopAbs_FACE);
-  for (; anExp.More(); anExp.Next())
+  rtcOccluded4(valid, theScene, &ray4, NULL);
+
+  // Embree sets tfar to -inf for occluded rays
+  for (int i = 0; i < theNbRays; ++i)
   {
-    myFaces.Add(anExp.Current());
+    theOccluded[i] = ray4.tfar[i] < 0.0f;
   }
+}
 
-  if (myFaces.IsEmpty())
-    return;
+//! Occlusion test of up to 8 rays at once using AVX (rtcOccluded8)
+//! @param theScene Embree scene
+//! @param theRays Array of theNbRays rays (input)
+//! @param theNbRays Number of valid rays (1..8)
+//! @param theMins Minimum parameters of the rays
+//! @param theMaxs Maximum parameters of the rays
+//! @param theOccluded Output: true if the ray hits any triangle within its interval
+void OccludedEmbree8(RTCScene               theScene,
+                     const gp_Lin*          theRays,
+                     const Standard_Integer theNbRays,
+                     const Standard_Real*   theMins,
+                     const Standard_Real*   theMaxs,
+                     Standard_Boolean*      theOccluded)
+{
+  alignas(32) RTCRay8 ray8;
+  alignas(32) int     valid[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 
-  // Create surface adaptors for all faces (needed for Newton refinement)
-  mySurfaceAdaptors.resize(myFaces.Extent());
-  for (Standard_Integer i = 1; i <= myFaces.Extent(); ++i)
+  for (int i = 0; i < theNbRays; ++i)
   {
-    const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(i));
-    mySurfaceAdaptors[i - 1] = new BRepAdaptor_Surface(aFace, Standard_True);
+    valid[i]      = -1;
+    ray8.org_x[i] = static_cast<float>(theRays[i].Location().X());
+    ray8.org_y[i] = static_cast<float>(theRays[i].Location().Y());
+    ray8.org_z[i] = static_cast<float>(theRays[i].Location().Z());
+    ray8.dir_x[i] = static_cast<float>(theRays[i].Direction().X());
+    ray8.dir_y[i] = static_cast<float>(theRays[i].Direction().Y());
+    ray8.dir_z[i] = static_cast<float>(theRays[i].Direction().Z());
+    ray8.tnear[i] = EmbreeNear(theMins[i]);
+    ray8.tfar[i]  = EmbreeFar(theMaxs[i]);
+    ray8.mask[i]  = static_cast<unsigned int>(-1);
+    ray8.flags[i] = 0;
   }
 
-  // Build triangle BVH for tessellation-accelerated intersection
-  // NOTE: The shape must already be tessellated before calling Load().
-  // Call BRepMesh_IncrementalMesh on the shape before Load() if needed.
+  rtcOccluded8(valid, theScene, &ray8, NULL);
+
+  // Embree sets tfar to -inf for occluded rays
+  for (int i = 0; i < theNbRays; ++i)
+  {
+    theOccluded[i] = ray8.tfar[i] < 0.0f;
+  }
+}
+
+//! Single ray occlusion test using Embree (rtcOccluded1)
+Standard_Boolean OccludedEmbree1(RTCScene            theScene,
+                                 const gp_Lin&       theRay,
+                                 const Standard_Real theMin,
+                                 const Standard_Real theMax)
+{
+  RTCRay ray;
+  ray.org_x = static_cast<float>(theRay.Location().X());
+  ray.org_y = static_cast<float>(theRay.Location().Y());
+  ray.org_z = static_cast<float>(theRay.Location().Z());
+  ray.dir_x = static_cast<float>(theRay.Direction().X());
+  ray.dir_y = static_cast<float>(theRay.Direction().Y());
+  ray.dir_z = static_cast<float>(theRay.Direction().Z());
+  ray.tnear = EmbreeNear(theMin);
+  ray.tfar  = EmbreeFar(theMax);
+  ray.mask  = static_cast<unsigned int>(-1);
+  ray.flags = 0;
+
+  rtcOccluded1(theScene, &ray, NULL);
+
+  // Embree sets tfar to -inf for occluded rays
+  return ray.tfar < 0.0f;
+}
+
+//! Ray query context collecting the triangles crossed by a ray
+struct EmbreeHitListContext
+{
+  RTCRayQueryContext     Context; //!< Embree context, must stay the first member
+  std::vector<unsigned>* PrimIds; //!< Triangles reported to the filter
+};
+
+//! Intersection filter recording each hit and rejecting it, so that traversal goes on
+//! until every triangle along the ray has been reported
+void CollectHitsFilter(const RTCFilterFunctionNArguments* theArgs)
+{
+  EmbreeHitListContext* aContext = reinterpret_cast<EmbreeHitListContext*>(theArgs->context);
+  for (unsigned int i = 0; i < theArgs->N; ++i)
+  {
+    if (theArgs->valid[i] == 0)
+      continue;
+
+    aContext->PrimIds->push_back(RTCHitN_primID(theArgs->hit, theArgs->N, i));
+    theArgs->valid[i] = 0;
+  }
+}
+
+//! Count all triangles hit by a ray within [theMin, theMax] using Embree
+//! (rtcIntersect1 with a collecting filter)
+//! @param thePrimIds Scratch buffer for the hit triangles (cleared)
+Standard_Integer CountHitsEmbree1(RTCScene               theScene,
+                                  const gp_Lin&          theRay,
+                                  const Standard_Real    theMin,
+                                  const Standard_Real    theMax,
+                                  std::vector<unsigned>& thePrimIds)
+{
+  thePrimIds.clear();
+
+  EmbreeHitListContext aContext;
+  rtcInitRayQueryContext(&aContext.Context);
+  aContext.PrimIds = &thePrimIds;
+
+  RTCIntersectArguments anArgs;
+  rtcInitIntersectArguments(&anArgs);
+  anArgs.context = &aContext.Context;
+  anArgs.filter  = CollectHitsFilter;
+  anArgs.flags   = RTC_RAY_QUERY_FLAG_INVOKE_ARGUMENT_FILTER;
+
+  RTCRayHit rayhit;
+  rayhit.ray.org_x  = static_cast<float>(theRay.Location().X());
+  rayhit.ray.org_y  = static_cast<float>(theRay.Location().Y());
+  rayhit.ray.org_z  = static_cast<float>(theRay.Location().Z());
+  rayhit.ray.dir_x  = static_cast<float>(theRay.Direction().X());
+  rayhit.ray.dir_y  = static_cast<float>(theRay.Direction().Y());
+  rayhit.ray.dir_z  = static_cast<float>(theRay.Direction().Z());
+  rayhit.ray.tnear  = EmbreeNear(theMin);
+  rayhit.ray.tfar   = EmbreeFar(theMax);
+  rayhit.ray.mask   = static_cast<unsigned int>(-1);
+  rayhit.ray.flags  = 0;
+  rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+  rayhit.hit.primID = RTC_INVALID_GEOMETRY_ID;
+
+  rtcIntersect1(theScene, &rayhit, &anArgs);
+
+  // A triangle referenced from several BVH leaves may be reported more than once
+  std::sort(thePrimIds.begin(), thePrimIds.end());
+  return static_cast<Standard_Integer>(
+    std::unique(thePrimIds.begin(), thePrimIds.end()) - thePrimIds.begin());
+}
+} // namespace
+#endif
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::Load(const TopoDS_Shape& theShape,
+                                        const Standard_Real theTol,
+                                        const Standard_Real theDeflection)
+{
+  myFaces.Clear();
+  mySurfaceAdaptors.clear();
+  myAnalyticSurfaces.clear();
+  mySplineSurfaces.clear();
+  myPendingFaces.clear();
+
+  myTolerance = theTol;
+  // Always use tessellation - default to 0.1 if not specified
+  myDeflection = (theDeflection > 0.0) ? theDeflection : 0.1;
+
+  if (myUseInstancing)
+  {
+    loadInstances(theShape);
+    return;
+  }
+
+  // Collect all faces from the shape
+  TopExp_Explorer anExp(theShape, TopAbs_FACE);
+  for (; anExp.More(); anExp.Next())
+  {
+    myFaces.Add(anExp.Current());
+  }
+  myIsFaceRemoved.assign(myFaces.Extent(), Standard_False);
+
+  loadTriangles();
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::MeshAndLoad(const TopoDS_Shape& theShape,
+                                               const Standard_Real theTol,
+                                               const Standard_Real theDeflection,
+                                               const Standard_Real theAngle)
+{
+  myFaces.Clear();
+  mySurfaceAdaptors.clear();
+  myAnalyticSurfaces.clear();
+  mySplineSurfaces.clear();
+  myPendingFaces.clear();
+
+  myTolerance  = theTol;
+  myDeflection = (theDeflection > 0.0) ? theDeflection : 0.1;
+
+  TopExp_Explorer anExp(theShape, TopAbs_FACE);
+  for (; anExp.More(); anExp.Next())
+  {
+    myFaces.Add(anExp.Current());
+  }
+  const Standard_Integer nFaces = myFaces.Extent();
+  myIsFaceRemoved.assign(nFaces, Standard_False);
+  mySurfaceAdaptors.resize(nFaces);
+  myAnalyticSurfaces.resize(nFaces);
+  mySplineSurfaces.resize(nFaces);
+
+  // Parts meshed by one task, and the loaded faces of every group
+  std::vector<TopoDS_Shape> aParts;
+  CollectInstanceShapes(theShape, aParts);
+  std::vector<std::vector<Standard_Integer>> aGroups;
+  GroupMeshParts(aParts, aGroups);
+  const Standard_Integer nGroups = static_cast<Standard_Integer>(aGroups.size());
+
+  std::vector<std::vector<Standard_Integer>> aGroupFaces(nGroups);
+  std::vector<char>                          isGroupFace(nFaces, 0);
+  for (Standard_Integer g = 0; g < nGroups; ++g)
+  {
+    for (const Standard_Integer aPart : aGroups[g])
+    {
+      for (anExp.Init(aParts[aPart], TopAbs_FACE); anExp.More(); anExp.Next())
+      {
+        const Standard_Integer aFaceIdx = myFaces.FindIndex(anExp.Current());
+        if (aFaceIdx > 0 && !isGroupFace[aFaceIdx - 1])
+        {
+          isGroupFace[aFaceIdx - 1] = 1;
+          aGroupFaces[g].push_back(aFaceIdx);
+        }
+      }
+    }
+  }
+
+  // A single group is meshed by BRepMesh's own face-parallel loop, several groups one
+  // per thread. Instanced parts are gathered from their prototype by loadInstances().
+  IMeshTools_Parameters aMeshParams;
+  aMeshParams.Deflection          = myDeflection;
+  aMeshParams.Angle               = theAngle;
+  aMeshParams.InParallel          = myUseOpenMP && nGroups == 1;
+  const Standard_Boolean toGather = !myUseInstancing;
+
+  std::cout << "  Meshing " << nFaces << " faces in " << nGroups << " independent parts..."
+            << std::endl;
+  std::vector<GatheredFace> aGathered(toGather ? nFaces : 0);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 1) if (myUseOpenMP && nGroups > 1)
+#endif
+  for (Standard_Integer g = 0; g < nGroups; ++g)
+  {
+    for (const Standard_Integer aPart : aGroups[g])
+    {
+      BRepMesh_IncrementalMesh aMesher(aParts[aPart], aMeshParams);
+    }
+    if (!toGather)
+      continue;
+
+    // The part is meshed: gather its triangles while other parts are being meshed
+    for (const Standard_Integer aFaceIdx : aGroupFaces[g])
+    {
+      const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(aFaceIdx));
+      initSurface(aFaceIdx - 1, aFace);
+
+      TopLoc_Location                  aLoc;
+      const Handle(Poly_Triangulation) aTriangulation = BRep_Tool::Triangulation(aFace, aLoc);
+      GatheredFace&                    aFaceData      = aGathered[aFaceIdx - 1];
+      aFaceData.IsGathered                            = Standard_True;
+      if (aTriangulation.IsNull())
+        continue;
+
+      aFaceData.Nodes.resize(aTriangulation->NbNodes());
+      aFaceData.UVs.resize(aTriangulation->NbNodes());
+      aFaceData.Corners.resize(static_cast<size_t>(aTriangulation->NbTriangles()) * 3);
+      aFaceData.WeldMask.resize(myWeldEdgesOnly ? aTriangulation->NbNodes() : 0, 0);
+      aFaceData.Infos.resize(aTriangulation->NbTriangles());
+      GatherFaceTriangles(aFace,
+                          aTriangulation,
+                          aLoc,
+                          aFaceIdx - 1,
+                          0,
+                          aFaceData.Nodes.data(),
+                          aFaceData.UVs.data(),
+                          aFaceData.Corners.data(),
+                          myWeldEdgesOnly ? aFaceData.WeldMask.data() : nullptr,
+                          aFaceData.Infos.data());
+    }
+  }
+
+  if (myUseInstancing)
+  {
+    loadInstances(theShape);
+    return;
+  }
+  loadTriangles(&aGathered);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::loadTriangles(const std::vector<GatheredFace>* theGathered)
+{
+  myIsLoaded = Standard_False;
+  myIsDone   = Standard_False;
+  myNbPnt    = 0;
+  myResults.clear();
+  myTriBVH.Nullify();
+  myFlatBVH.Clear();
+  myWideBVH.Clear();
+  myBVHStatistics = BRepIntCurveSurface_BVHStatistics();
+  myTriangleInfo.clear();
+  myTriangleUVs.Init(myUseCompactUVs, myUseCurvedUVs);
+  myNbTriangleSplits = 0;
+  myIsBVHFromCache   = Standard_False;
+  myTriangleRecords.clear();
+  myTrianglePackets.Clear();
+  myUseTessellation = Standard_False;
+  myFaceTriangles.clear();
+  myFreeTriangles.clear();
+  myTriangleRefOffsets.clear();
+  myTriangleRefs.clear();
+  myNbMovedTriangles   = 0;
+  myNbUpdatedTriangles = 0;
+  myInstances.Clear();
+#ifdef OCCT_USE_EMBREE
+  // The scene reads the shared vertex and index buffers, so it is released first
+  if (myEmbreeScene)
+  {
+    rtcReleaseScene(myEmbreeScene);
+    myEmbreeScene = nullptr;
+  }
+  ReleaseVector(myEmbreeVertices);
+  ReleaseVector(myEmbreeIndices);
+  myEmbreeNbVertices = 0;
+#endif
+
+  if (myFaces.IsEmpty())
+    return;
+
+  const Standard_Integer nFaces = myFaces.Extent();
+#ifdef _OPENMP
+  const Standard_Boolean isParallel = myUseOpenMP && nFaces > 1;
+#endif
+
+  // Fetch the triangulation of every face once (unless gathered while meshing); the
+  // prefix sums of the triangle and node counts give the first triangle and node of
+  // each face, so faces can be gathered independently
+  std::vector<Handle(Poly_Triangulation)> aFaceTriangulations(nFaces);
+  std::vector<TopLoc_Location>            aFaceLocations(nFaces);
+  std::vector<Standard_Integer>           aFaceOffsets(nFaces + 1, 0);
+  std::vector<Standard_Integer>           aNodeOffsets(nFaces + 1, 0);
+  for (Standard_Integer i = 0; i < nFaces; ++i)
+  {
+    if (theGathered != nullptr && (*theGathered)[i].IsGathered)
+    {
+      const GatheredFace& aGathered = (*theGathered)[i];
+      aFaceOffsets[i + 1] = aFaceOffsets[i] + static_cast<Standard_Integer>(aGathered.Infos.size());
+      aNodeOffsets[i + 1] = aNodeOffsets[i] + static_cast<Standard_Integer>(aGathered.Nodes.size());
+      continue;
+    }
+
+    const TopoDS_Face&          aFace          = TopoDS::Face(myFaces.FindKey(i + 1));
+    Handle(Poly_Triangulation)& aTriangulation = aFaceTriangulations[i];
+    if (!myIsFaceRemoved[i])
+      aTriangulation = BRep_Tool::Triangulation(aFace, aFaceLocations[i]);
+    aFaceOffsets[i + 1] =
+      aFaceOffsets[i] + (aTriangulation.IsNull() ? 0 : aTriangulation->NbTriangles());
+    aNodeOffsets[i + 1] =
+      aNodeOffsets[i] + (aTriangulation.IsNull() ? 0 : aTriangulation->NbNodes());
+  }
+  const Standard_Integer totalTriangles = aFaceOffsets[nFaces];
+  const Standard_Integer totalNodes     = aNodeOffsets[nFaces];
+
+  // Triangulation nodes, their UV nodes and triangle corners (global node indices) in face
+  // order before welding, and triangle infos, filled per face. With edge-only welding,
+  // aWeldMask flags the nodes lying on the face's edges. The UV node table keeps the
+  // unwelded numbering, since nodes shared by two faces have a UV on each.
+  std::vector<BVH_Vec3d>        aRawVertices(totalNodes);
+  std::vector<gp_Pnt2d>         aRawUVs(totalNodes);
+  std::vector<Standard_Integer> aCorners(static_cast<size_t>(totalTriangles) * 3);
+  std::vector<char>             aWeldMask(myWeldEdgesOnly ? totalNodes : 0, 0);
+  myTriangleInfo.resize(totalTriangles);
+  myTriangleUVs.Resize(totalNodes, nFaces);
+  mySurfaceAdaptors.resize(nFaces);
+  myAnalyticSurfaces.resize(nFaces);
+  mySplineSurfaces.resize(nFaces);
+
+  // Create the surface adaptor (needed for Newton refinement) unless an update kept it,
+  // and gather the triangles of one face into its slice of the arrays, copying them
+  // if they were gathered while meshing
+  auto gatherFace = [&](const Standard_Integer faceIdx) {
+    const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(faceIdx));
+    if (mySurfaceAdaptors[faceIdx - 1].IsNull())
+      initSurface(faceIdx - 1, aFace);
+
+    const Standard_Integer aNodeFirst = aNodeOffsets[faceIdx - 1];
+    const Standard_Integer aNbNodes   = aNodeOffsets[faceIdx] - aNodeFirst;
+    const Standard_Integer aTriFirst  = aFaceOffsets[faceIdx - 1];
+    if (theGathered != nullptr && (*theGathered)[faceIdx - 1].IsGathered)
+    {
+      const GatheredFace& aGathered = (*theGathered)[faceIdx - 1];
+      const std::vector<char>& aMask = aGathered.WeldMask;
+      std::copy(aGathered.Nodes.begin(), aGathered.Nodes.end(), aRawVertices.data() + aNodeFirst);
+      std::copy(aMask.begin(), aMask.end(), aWeldMask.data() + aNodeFirst);
+      for (size_t k = 0; k < aGathered.Corners.size(); ++k)
+      {
+        aCorners[aTriFirst * 3 + k] = aNodeFirst + aGathered.Corners[k];
+      }
+      for (size_t t = 0; t < aGathered.Infos.size(); ++t)
+      {
+        BRepIntCurveSurface_TriangleInfo& aTriInfo = myTriangleInfo[aTriFirst + t];
+        aTriInfo.FaceIndex                         = aGathered.Infos[t].FaceIndex;
+        for (int k = 0; k < 3; ++k)
+          aTriInfo.UVNodes[k] = aNodeFirst + aGathered.Infos[t].UVNodes[k];
+      }
+      StoreFaceUVs(aGathered.UVs.data(),
+                   aNbNodes,
+                   aNodeFirst,
+                   faceIdx - 1,
+                   *mySurfaceAdaptors[faceIdx - 1],
+                   myTriangleUVs);
+      return;
+    }
+
+    const Handle(Poly_Triangulation)& aTriangulation = aFaceTriangulations[faceIdx - 1];
+    if (aTriangulation.IsNull())
+      return;
+
+    GatherFaceTriangles(aFace,
+                        aTriangulation,
+                        aFaceLocations[faceIdx - 1],
+                        faceIdx - 1,
+                        aNodeFirst,
+                        aRawVertices.data() + aNodeFirst,
+                        aRawUVs.data() + aNodeFirst,
+                        aCorners.data() + static_cast<size_t>(aTriFirst) * 3,
+                        myWeldEdgesOnly ? aWeldMask.data() + aNodeFirst : nullptr,
+                        myTriangleInfo.data() + aTriFirst);
+    StoreFaceUVs(aRawUVs.data() + aNodeFirst,
+                 aNbNodes,
+                 aNodeFirst,
+                 faceIdx - 1,
+                 *mySurfaceAdaptors[faceIdx - 1],
+                 myTriangleUVs);
+  };
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 16) if (isParallel)
+#endif
+  for (Standard_Integer faceIdx = 1; faceIdx <= nFaces; ++faceIdx)
+  {
+    gatherFace(faceIdx);
+  }
+  ReleaseVector(aRawUVs);
+
+  // Build triangle BVH for tessellation-accelerated intersection
+  // NOTE: The shape must already be tessellated before calling Load().
+  // Call BRepMesh_IncrementalMesh on the shape before Load() if needed.
+  {
+    std::cout << "  Building tessellation BVH (using existing triangulation)..." << std::endl;
+
+    if (totalTriangles > 0)
+    {
+      // Create triangle BVH with the selected builder
+      Standard_Integer aBuildThreads = 1;
+#ifdef _OPENMP
+      if (myUseOpenMP)
+        aBuildThreads = omp_get_max_threads();
+#endif
+      myTriBVH = new BRepIntCurveSurface_TriBVH(
+        NewTriangleBuilder(myBVHBuilder, myBVHLeafSize, myBVHMaxDepth, aBuildThreads));
+
+      // Weld duplicate nodes at face boundaries (all nodes, or the edge nodes only)
+      // Weld tolerance: use deflection or default 1e-3
+      const double weldTol = std::max(myDeflection * 0.1, DEFAULT_WELD_TOLERANCE);
+
+      // Welded vertex indices of the triangle corners and the number of welded vertices,
+      // which come first in myTriBVH->Vertices (split references append their own)
+      std::vector<Standard_Integer> triangleIndices;
+      Standard_Integer              nVertices  = 0;
+      const Standard_Integer        nTriangles =
+        static_cast<Standard_Integer>(myTriangleInfo.size());
+
+      // Look for the data built earlier from the same triangulation with the same settings;
+      // the mapping is released once the sections are copied
+      uint64_t                aCacheKey = 0;
+      TCollection_AsciiString aCachePath;
+      if (!myBVHCacheDirectory.IsEmpty())
+      {
+        BVHCacheSettings aSettings   = {};
+        aSettings.Deflection         = myDeflection;
+        aSettings.WeldTolerance      = weldTol;
+        aSettings.Builder            = static_cast<Standard_Integer>(myBVHBuilder);
+        aSettings.LeafSize           = myBVHLeafSize;
+        aSettings.MaxDepth           = myBVHMaxDepth;
+        aSettings.Width              = myBVHWidth;
+        aSettings.UseCompactNodes    = myUseCompactNodes;
+        aSettings.UseTrianglePackets = myUseTrianglePackets;
+        aSettings.TriangleLanes      = BRepIntCurveSurface_TrianglePackets::Lanes;
+        aSettings.UseTriangleSplits  = myUseTriangleSplits;
+        aSettings.WeldEdgesOnly      = myWeldEdgesOnly;
+
+        aCacheKey  = BVHCacheKey(aSettings, aFaceOffsets, aRawVertices, aCorners, aWeldMask);
+        aCachePath = BRepIntCurveSurface_BVHCache::FilePath(myBVHCacheDirectory, aCacheKey);
+
+        BRepIntCurveSurface_BVHCache aCache;
+        myIsBVHFromCache = aCache.Open(aCachePath, aCacheKey)
+                           && readBVHCache(aCache, aFaceOffsets, triangleIndices, nVertices);
+        if (myIsBVHFromCache)
+        {
+          std::cout << "  BVH cache hit: " << aCachePath << std::endl;
+          ReleaseVector(aRawVertices);
+          ReleaseVector(aCorners);
+          ReleaseVector(aWeldMask);
+        }
+      }
+
+      if (!myIsBVHFromCache)
+      {
+        std::cout << "  Weld tolerance: " << weldTol
+                  << (myWeldEdgesOnly ? " (edge nodes only)" : "") << std::endl;
+
+        std::vector<Standard_Integer> aWeldRoots;
+        BRepIntCurveSurface_VertexWelder::Perform(aRawVertices,
+                                                  myWeldEdgesOnly ? &aWeldMask : nullptr,
+                                                  weldTol,
+                                                  myUseOpenMP,
+                                                  aWeldRoots);
+
+        // Number the welded vertices in order of first use by a triangle corner; nodes
+        // not used by any triangle are dropped
+        triangleIndices.resize(aCorners.size());
+        std::vector<Standard_Integer> aVertexIds(totalNodes, -1);
+        for (size_t i = 0; i < aCorners.size(); ++i)
+        {
+          const Standard_Integer aRoot = aWeldRoots[aCorners[i]];
+          if (aVertexIds[aRoot] < 0)
+            aVertexIds[aRoot] = nVertices++;
+          triangleIndices[i] = aVertexIds[aRoot];
+        }
+        ReleaseVector(aCorners);
+        ReleaseVector(aWeldMask);
+        ReleaseVector(aWeldRoots);
+
+        // Move the welded vertices straight into the BVH, which is their only copy;
+        // BVH_Triangulation expects vertices as array and elements as triangle indices
+        myTriBVH->Vertices.resize(nVertices);
+        for (Standard_Integer i = 0; i < totalNodes; ++i)
+        {
+          if (aVertexIds[i] >= 0)
+            myTriBVH->Vertices[aVertexIds[i]] = aRawVertices[i];
+        }
+        ReleaseVector(aVertexIds);
+        ReleaseVector(aRawVertices);
+
+        // Report vertex welding stats
+        std::cout << "  Vertex welding: " << totalNodes << " -> " << nVertices << " ("
+                  << std::fixed << std::setprecision(1) << (100.0 * nVertices / totalNodes)
+                  << "% unique)" << std::endl;
+
+        // Set triangle indices using welded vertex indices
+        // IMPORTANT: Store original triangle index in 4th component (w) because
+        // BVH building reorders Elements via Swap(), but myTriangleInfo stays in original
+        // order. Split triangles get several references (tighter boxes), all with the same w
+        myTriBVH->Elements.reserve(nTriangles);
+        for (Standard_Integer i = 0; i < nTriangles; ++i)
+        {
+          const BVH_Vec4i anElem(triangleIndices[i * 3 + 0],
+                                 triangleIndices[i * 3 + 1],
+                                 triangleIndices[i * 3 + 2],
+                                 i); // w = original triangle index
+          if (myUseTriangleSplits)
+            myNbTriangleSplits +=
+              AddTriangleReferences(myTriBVH->Vertices, myTriBVH->Elements, anElem) - 1;
+          else
+            myTriBVH->Elements.push_back(anElem);
+        }
+        const Standard_Integer nReferences =
+          static_cast<Standard_Integer>(myTriBVH->Elements.size());
+        if (myNbTriangleSplits > 0)
+        {
+          std::cout << "  Triangle splitting: " << nTriangles << " -> " << nReferences
+                    << " BVH references" << std::endl;
+        }
+
+        // CRITICAL: Mark as dirty so BVH() will actually build the tree
+        myTriBVH->MarkDirty();
+
+        // Build the BVH
+        myTriBVH->BVH();
+
+        // Emit precomputed triangle records in BVH leaf order (Elements were reordered by
+        // the build), so that leaf tests stream contiguous memory with no indirection.
+        // Records always hold the original (unsplit) triangle, whose UVs the barycentrics index
+        myTriangleRecords.resize(nReferences);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if (isParallel)
+#endif
+        for (Standard_Integer i = 0; i < nReferences; ++i)
+        {
+          const Standard_Integer              anOrig = myTriBVH->Elements[i][3];
+          const Standard_Integer*             aTri   = &triangleIndices[anOrig * 3];
+          const BVH_Vec3d&                    aV0    = myTriBVH->Vertices[aTri[0]];
+          BRepIntCurveSurface_TriangleRecord& aRec   = myTriangleRecords[i];
+
+          aRec.V0            = aV0;
+          aRec.Edge1         = myTriBVH->Vertices[aTri[1]] - aV0;
+          aRec.Edge2         = myTriBVH->Vertices[aTri[2]] - aV0;
+          aRec.OriginalIndex = anOrig;
+        }
+
+        // Collapse the tree into wide nodes, or flatten it into a compact
+        // depth-first binary node array for traversal
+        if (!myTriBVH->BVH().IsNull())
+        {
+          myBVHStatistics.Perform(*myTriBVH->BVH());
+
+          if (myBVHWidth > 2)
+            myWideBVH.Build(*myTriBVH->BVH(), myBVHWidth);
+          else
+            myFlatBVH.Build(*myTriBVH->BVH(), myUseCompactNodes);
+
+          // Regroup leaf triangles into SIMD packets; the records are then no longer read
+          if (myUseTrianglePackets)
+          {
+            myTrianglePackets.Build(*myTriBVH->BVH(), myTriangleRecords);
+            myTriangleRecords.clear();
+            myTriangleRecords.shrink_to_fit();
+          }
+        }
+
+        if (!aCachePath.IsEmpty())
+        {
+          if (writeBVHCache(aCachePath, aCacheKey, aFaceOffsets, triangleIndices, nVertices))
+            std::cout << "  BVH cache written: " << aCachePath << std::endl;
+          else
+            std::cerr << "  WARNING: Failed to write BVH cache " << aCachePath << std::endl;
+        }
+      }
+
+      myUseTessellation = Standard_True;
+
+      std::cout << "  Triangle BVH built: " << nTriangles << " triangles from " << myFaces.Extent()
+                << " faces" << std::endl;
+
+      // Debug: verify BVH structure (the tree itself is not rebuilt from the cache)
+      if (myBVHStatistics.NbNodes > 0)
+      {
+        std::cout << "  [DEBUG] BVH tree depth: " << myBVHStatistics.Depth << std::endl;
+        std::cout << "  [DEBUG] BVH tree nodes: " << myBVHStatistics.NbNodes << std::endl;
+        std::cout << "  [DEBUG] BVH quality: SAH cost " << myBVHStatistics.SAHCost << ", overlap "
+                  << myBVHStatistics.OverlapRatio << ", " << myBVHStatistics.NbLeaves
+                  << " leaves (avg " << myBVHStatistics.AverageLeafSize() << " triangles)"
+                  << std::endl;
+        if (!myWideBVH.IsEmpty())
+        {
+          std::cout << "  [DEBUG] Wide BVH nodes: " << myWideBVH.NbNodes() << " ("
+                    << myWideBVH.Width() << "-wide, depth " << myWideBVH.Depth() << ", "
+                    << myWideBVH.MemorySize() / 1024 << " KB)" << std::endl;
+        }
+        else
+        {
+          std::cout << "  [DEBUG] Flat BVH nodes: " << myFlatBVH.NbNodes() << " ("
+                    << (myFlatBVH.IsFloat() ? "float32" : "float64") << ", "
+                    << myFlatBVH.MemorySize() / 1024 << " KB)" << std::endl;
+        }
+        if (!myTrianglePackets.IsEmpty())
+        {
+          std::cout << "  [DEBUG] Triangle packets: " << myTrianglePackets.NbPackets() << " ("
+                    << BRepIntCurveSurface_TrianglePackets::Lanes << " lanes, "
+                    << myTrianglePackets.MemorySize() / 1024 << " KB)" << std::endl;
+        }
+        std::cout << "  [DEBUG] Vertices array size: " << myTriBVH->Vertices.size() << std::endl;
+        std::cout << "  [DEBUG] Elements array size: " << myTriBVH->Elements.size() << std::endl;
+        std::cout << "  [DEBUG] TriangleInfo array size: " << myTriangleInfo.size() << std::endl;
+        // Sample a few elements to verify w component
+        if (nTriangles > 0)
+        {
+          std::cout << "  [DEBUG] Elements[0]: v=(" << myTriBVH->Elements[0][0] << ","
+                    << myTriBVH->Elements[0][1] << "," << myTriBVH->Elements[0][2]
+                    << ") origIdx=" << myTriBVH->Elements[0][3] << std::endl;
+          if (nTriangles > 100)
+          {
+            std::cout << "  [DEBUG] Elements[100]: v=(" << myTriBVH->Elements[100][0] << ","
+                      << myTriBVH->Elements[100][1] << "," << myTriBVH->Elements[100][2]
+                      << ") origIdx=" << myTriBVH->Elements[100][3] << std::endl;
+          }
+        }
+      }
+
+#ifdef OCCT_USE_EMBREE
+      // Build Embree scene for hardware-accelerated BVH traversal
+      std::cout << "  Building Embree scene..." << std::endl;
+
+      // Create Embree device if not already created
+      if (!myEmbreeDevice)
+      {
+        myEmbreeDevice = rtcNewDevice(nullptr);
+        if (!myEmbreeDevice)
+        {
+          std::cerr << "  ERROR: Failed to create Embree device!" << std::endl;
+        }
+      }
+
+      if (myEmbreeDevice)
+      {
+        myEmbreeScene = rtcNewScene(myEmbreeDevice);
+        // Multi-hit counting passes its filter through the intersection arguments
+        rtcSetSceneFlags(myEmbreeScene, RTC_SCENE_FLAG_FILTER_FUNCTION_IN_ARGUMENTS);
+
+        // Create triangle geometry
+        RTCGeometry geom = rtcNewGeometry(myEmbreeDevice, RTC_GEOMETRY_TYPE_TRIANGLE);
+
+        // Vertex buffer shared with Embree (which expects float, not double), padded so
+        // that the last vertex can be read with one 16-byte load
+        myEmbreeVertices.resize(static_cast<size_t>(nVertices) * 3 + 1, 0.0f);
+        for (Standard_Integer i = 0; i < nVertices; ++i)
+        {
+          const BVH_Vec3d& aVertex    = myTriBVH->Vertices[i];
+          myEmbreeVertices[3 * i + 0] = static_cast<float>(aVertex[0]);
+          myEmbreeVertices[3 * i + 1] = static_cast<float>(aVertex[1]);
+          myEmbreeVertices[3 * i + 2] = static_cast<float>(aVertex[2]);
+        }
+        rtcSetSharedGeometryBuffer(geom,
+                                   RTC_BUFFER_TYPE_VERTEX,
+                                   0,
+                                   RTC_FORMAT_FLOAT3,
+                                   myEmbreeVertices.data(),
+                                   0,
+                                   3 * sizeof(float),
+                                   nVertices);
+
+        // Index buffer shared with Embree: the welded corner indices are taken over
+        // rather than copied (non-negative integers read as unsigned)
+        myEmbreeIndices = std::move(triangleIndices);
+        rtcSetSharedGeometryBuffer(geom,
+                                   RTC_BUFFER_TYPE_INDEX,
+                                   0,
+                                   RTC_FORMAT_UINT3,
+                                   myEmbreeIndices.data(),
+                                   0,
+                                   3 * sizeof(unsigned),
+                                   nTriangles);
+
+        rtcCommitGeometry(geom);
+        rtcAttachGeometry(myEmbreeScene, geom);
+        rtcReleaseGeometry(geom);
+        rtcCommitScene(myEmbreeScene);
+        myEmbreeNbVertices = static_cast<size_t>(nVertices);
+
+        std::cout << "  Embree scene built: " << nTriangles << " triangles, "
+                  << nVertices << " vertices" << std::endl;
+      }
+#endif
+    }
+  }
+
+  myIsLoaded = Standard_True;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::loadInstances(const TopoDS_Shape& theShape)
+{
+  // No faces are loaded yet, so this only releases the data of the previous shape,
+  // including the Embree scene: rays are traced in part coordinates by the OCCT_BVH
+  // backend only
+  myIsFaceRemoved.clear();
+  loadTriangles();
+
+  // Parts differing by their location only share a prototype
+  std::vector<TopoDS_Shape> aParts;
+  CollectInstanceShapes(theShape, aParts);
+  TopTools_IndexedMapOfShape    aPrototypeShapes;
+  std::vector<Standard_Integer> aPartPrototypes(aParts.size());
+  for (size_t i = 0; i < aParts.size(); ++i)
+  {
+    aPartPrototypes[i] = aPrototypeShapes.Add(aParts[i].Located(TopLoc_Location())) - 1;
+  }
+  const Standard_Integer nPrototypes = aPrototypeShapes.Extent();
+
+  // Faces and triangulations of the faces of every prototype, in part coordinates; the
+  // triangle infos, UV nodes and UV origins of the prototypes follow each other
+  std::vector<std::vector<TopoDS_Face>> aPrototypeFaces(nPrototypes);
+  std::vector<std::vector<FaceMesh>>    aPrototypeMeshes(nPrototypes);
+  std::vector<Standard_Integer>         aFirstUVNodes(nPrototypes, 0);
+  Standard_Integer                      aNbTriangles = 0;
+  Standard_Integer                      aNbUVNodes   = 0;
+  Standard_Integer                      aNbUVFaces   = 0;
+  for (Standard_Integer p = 0; p < nPrototypes; ++p)
+  {
+    TopTools_IndexedMapOfShape aFaces;
+    TopExp::MapShapes(aPrototypeShapes.FindKey(p + 1), TopAbs_FACE, aFaces);
+
+    BRepIntCurveSurface_Prototype& aPrototype = myInstances.ChangePrototype(
+      myInstances.AddPrototype());
+    aPrototype.FirstTriangle = aNbTriangles;
+    aPrototype.FirstUVFace   = aNbUVFaces;
+    aPrototype.NbFaces       = aFaces.Extent();
+    aFirstUVNodes[p]         = aNbUVNodes;
+    aPrototypeFaces[p].resize(aFaces.Extent());
+    aPrototypeMeshes[p].resize(aFaces.Extent());
+    for (Standard_Integer k = 1; k <= aFaces.Extent(); ++k)
+    {
+      FaceMesh& aMesh           = aPrototypeMeshes[p][k - 1];
+      aPrototypeFaces[p][k - 1] = TopoDS::Face(aFaces.FindKey(k));
+      GatherFaceMesh(aPrototypeFaces[p][k - 1], aMesh);
+      aPrototype.NbTriangles += static_cast<Standard_Integer>(aMesh.Triangles.size() / 3);
+      aNbUVNodes += static_cast<Standard_Integer>(aMesh.Nodes.size());
+    }
+    aNbTriangles += aPrototype.NbTriangles;
+    aNbUVFaces += aPrototype.NbFaces;
+  }
+  myTriangleInfo.resize(aNbTriangles);
+  myTriangleUVs.Resize(aNbUVNodes, aNbUVFaces);
+
+  // Build the triangle BVH of every prototype; large assemblies have many parts, so the
+  // parts are distributed over threads and each BVH is built on one thread
+  std::vector<Standard_Integer> aNbSplits(nPrototypes, 0);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 1) if (myUseOpenMP && nPrototypes > 1)
+#endif
+  for (Standard_Integer p = 0; p < nPrototypes; ++p)
+  {
+    BRepIntCurveSurface_Prototype& aPrototype = myInstances.ChangePrototype(p);
+    if (aPrototype.NbTriangles == 0)
+      continue;
+
+    opencascade::handle<BRepIntCurveSurface_TriBVH> aBVH = new BRepIntCurveSurface_TriBVH(
+      NewTriangleBuilder(myBVHBuilder, myBVHLeafSize, myBVHMaxDepth, 1));
+
+    // Part nodes are not welded: the BVH only reads the corners of its own triangles.
+    // w holds the index of the triangle info, as in the BVH of a single shape.
+    // Derivatives at the UV nodes are evaluated in part coordinates, as the nodes.
+    std::vector<Standard_Integer> aCorners;
+    aCorners.reserve(static_cast<size_t>(aPrototype.NbTriangles) * 3);
+    Standard_Integer    aTriangle = aPrototype.FirstTriangle;
+    BRepAdaptor_Surface aPartSurface;
+    for (size_t k = 0; k < aPrototypeMeshes[p].size(); ++k)
+    {
+      const FaceMesh&        aMesh      = aPrototypeMeshes[p][k];
+      const Standard_Integer aNodeFirst = static_cast<Standard_Integer>(aBVH->Vertices.size());
+      const Standard_Integer aUVFirst   = aFirstUVNodes[p] + aNodeFirst;
+      aBVH->Vertices.insert(aBVH->Vertices.end(), aMesh.Nodes.begin(), aMesh.Nodes.end());
+      if (myTriangleUVs.HasDerivatives() && !aMesh.UVs.empty())
+        aPartSurface.Initialize(aPrototypeFaces[p][k]);
+      StoreFaceUVs(aMesh.UVs.data(),
+                   static_cast<Standard_Integer>(aMesh.UVs.size()),
+                   aUVFirst,
+                   aPrototype.FirstUVFace + static_cast<Standard_Integer>(k),
+                   aPartSurface,
+                   myTriangleUVs);
+      for (size_t t = 0; t < aMesh.Triangles.size() / 3; ++t, ++aTriangle)
+      {
+        BRepIntCurveSurface_TriangleInfo& aTriInfo = myTriangleInfo[aTriangle];
+        aTriInfo.FaceIndex                         = static_cast<Standard_Integer>(k);
+        for (int c = 0; c < 3; ++c)
+        {
+          aCorners.push_back(aNodeFirst + aMesh.Triangles[t * 3 + c]);
+          aTriInfo.UVNodes[c] = aUVFirst + aMesh.Triangles[t * 3 + c];
+        }
+      }
+    }
+    aPrototypeMeshes[p].clear();
+    aPrototypeFaces[p].clear();
+
+    const Standard_Integer* aTriCorners = aCorners.data();
+    for (Standard_Integer i = 0; i < aPrototype.NbTriangles; ++i, aTriCorners += 3)
+    {
+      const BVH_Vec4i anElem(aTriCorners[0],
+                             aTriCorners[1],
+                             aTriCorners[2],
+                             aPrototype.FirstTriangle + i);
+      if (myUseTriangleSplits)
+        aNbSplits[p] += AddTriangleReferences(aBVH->Vertices, aBVH->Elements, anElem) - 1;
+      else
+        aBVH->Elements.push_back(anElem);
+    }
+    aBVH->MarkDirty();
+    if (aBVH->BVH().IsNull())
+      continue;
+
+    // Leaf-order records, nodes and packets as for a single shape, in part coordinates
+    const Standard_Integer nReferences = static_cast<Standard_Integer>(aBVH->Elements.size());
+    aPrototype.Records.resize(nReferences);
+    for (Standard_Integer i = 0; i < nReferences; ++i)
+    {
+      const Standard_Integer              anOrig = aBVH->Elements[i][3];
+      const Standard_Integer              aLocal = anOrig - aPrototype.FirstTriangle;
+      const Standard_Integer*             aTri   = &aCorners[aLocal * 3];
+      const BVH_Vec3d&                    aV0    = aBVH->Vertices[aTri[0]];
+      BRepIntCurveSurface_TriangleRecord& aRec   = aPrototype.Records[i];
+
+      aRec.V0            = aV0;
+      aRec.Edge1         = aBVH->Vertices[aTri[1]] - aV0;
+      aRec.Edge2         = aBVH->Vertices[aTri[2]] - aV0;
+      aRec.OriginalIndex = anOrig;
+    }
+
+    if (myBVHWidth > 2)
+      aPrototype.WideBVH.Build(*aBVH->BVH(), myBVHWidth);
+    else
+      aPrototype.FlatBVH.Build(*aBVH->BVH(), myUseCompactNodes);
+    if (myUseTrianglePackets)
+    {
+      aPrototype.Packets.Build(*aBVH->BVH(), aPrototype.Records);
+      aPrototype.Records.clear();
+      aPrototype.Records.shrink_to_fit();
+    }
+    aPrototype.MinPoint = aBVH->BVH()->MinPoint(0);
+    aPrototype.MaxPoint = aBVH->BVH()->MaxPoint(0);
+  }
+  for (Standard_Integer p = 0; p < nPrototypes; ++p)
+  {
+    myNbTriangleSplits += aNbSplits[p];
+  }
+
+  // Every instance keeps its own faces (with their location), numbered in the order
+  // of the prototype faces, so hits report the face of the instance
+  for (size_t i = 0; i < aParts.size(); ++i)
+  {
+    TopTools_IndexedMapOfShape aFaces;
+    TopExp::MapShapes(aParts[i], TopAbs_FACE, aFaces);
+    std::vector<Standard_Integer> aFaceIndices(aFaces.Extent());
+    for (Standard_Integer k = 1; k <= aFaces.Extent(); ++k)
+    {
+      aFaceIndices[k - 1] = myFaces.Add(aFaces.FindKey(k)) - 1;
+    }
+    myInstances.AddInstance(aPartPrototypes[i],
+                            aParts[i].Location().Transformation(),
+                            aFaceIndices);
+  }
+  myInstances.Build();
+
+  const Standard_Integer nFaces = myFaces.Extent();
+  myIsFaceRemoved.assign(nFaces, Standard_False);
+  mySurfaceAdaptors.resize(nFaces);
+  myAnalyticSurfaces.resize(nFaces);
+  mySplineSurfaces.resize(nFaces);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 16) if (myUseOpenMP && nFaces > 1)
+#endif
+  for (Standard_Integer faceIdx = 1; faceIdx <= nFaces; ++faceIdx)
+  {
+    initSurface(faceIdx - 1, TopoDS::Face(myFaces.FindKey(faceIdx)));
+  }
+
+  myUseTessellation = myInstances.NbInstanceTriangles() > 0;
+  myIsLoaded        = Standard_True;
+
+  std::cout << "  Part instances: " << myInstances.NbInstances() << " instances of "
+            << nPrototypes << " parts, " << aNbTriangles << " part triangles for "
+            << myInstances.NbInstanceTriangles() << " instanced triangles" << std::endl;
+  if (myNbTriangleSplits > 0)
+  {
+    std::cout << "  Triangle splitting: " << myNbTriangleSplits << " extra BVH references"
+              << std::endl;
+  }
+  std::cout << "  Two-level BVH: " << myInstances.TopLevel().NbNodes() << " top-level nodes, "
+            << myInstances.MemorySize() / 1024 << " KB" << std::endl;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::ReplaceFace(const Standard_Integer theIndex,
+                                               const TopoDS_Face&     theFace)
+{
+  if (theIndex < 1 || theIndex > nbFacesAfterUpdate())
+    throw Standard_OutOfRange("BRepIntCurveSurface_InterBVH::ReplaceFace - index out of range");
+  if (isFaceLoadedOrPending(theFace))
+    throw Standard_ProgramError(
+      "BRepIntCurveSurface_InterBVH::ReplaceFace - face already loaded or pending");
+
+  myPendingFaces.emplace_back(theIndex, theFace);
+}
+
+//=================================================================================================
+
+Standard_Integer BRepIntCurveSurface_InterBVH::AddFace(const TopoDS_Face& theFace)
+{
+  if (isFaceLoadedOrPending(theFace))
+    throw Standard_ProgramError(
+      "BRepIntCurveSurface_InterBVH::AddFace - face already loaded or pending");
+
+  const Standard_Integer anIndex = nbFacesAfterUpdate() + 1;
+  myPendingFaces.emplace_back(anIndex, theFace);
+  return anIndex;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::RemoveFace(const Standard_Integer theIndex)
+{
+  if (theIndex < 1 || theIndex > nbFacesAfterUpdate())
+    throw Standard_OutOfRange("BRepIntCurveSurface_InterBVH::RemoveFace - index out of range");
+
+  myPendingFaces.emplace_back(theIndex, TopoDS_Face());
+}
+
+//=================================================================================================
+
+Standard_Integer BRepIntCurveSurface_InterBVH::nbFacesAfterUpdate() const
+{
+  // Added faces take consecutive indices after the loaded ones
+  Standard_Integer aNbFaces = myFaces.Extent();
+  for (const std::pair<Standard_Integer, TopoDS_Face>& anEdit : myPendingFaces)
+    aNbFaces = std::max(aNbFaces, anEdit.first);
+  return aNbFaces;
+}
+
+//=================================================================================================
+
+Standard_Boolean BRepIntCurveSurface_InterBVH::isFaceLoadedOrPending(
+  const TopoDS_Face& theFace) const
+{
+  if (myFaces.Contains(theFace))
+    return Standard_True;
+
+  // Added faces enter myFaces only in UpdateFaces(); a second edit with the same face
+  // would reuse its index there
+  for (const std::pair<Standard_Integer, TopoDS_Face>& anEdit : myPendingFaces)
+  {
+    if (anEdit.second.IsSame(theFace))
+      return Standard_True;
+  }
+  return Standard_False;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::initSurface(const Standard_Integer theIndex,
+                                               const TopoDS_Face&     theFace)
+{
+  mySurfaceAdaptors[theIndex] = new BRepAdaptor_Surface(theFace, Standard_True);
+  myAnalyticSurfaces[theIndex].Init(*mySurfaceAdaptors[theIndex]);
+  mySplineSurfaces[theIndex].Init(*mySurfaceAdaptors[theIndex]);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::prepareFaceUpdate()
+{
+  const Standard_Integer nSlots = static_cast<Standard_Integer>(myTriangleInfo.size());
+  const Standard_Integer nRefs  = static_cast<Standard_Integer>(myTriBVH->Elements.size());
+
+  // Slots of every face, in increasing order
+  myFaceTriangles.assign(myFaces.Extent(), std::vector<Standard_Integer>());
+  myFreeTriangles.clear();
+  for (Standard_Integer aSlot = 0; aSlot < nSlots; ++aSlot)
+    myFaceTriangles[myTriangleInfo[aSlot].FaceIndex].push_back(aSlot);
+
+  // BVH primitives (leaf-order Elements) referencing every slot, bucketed by the
+  // original triangle index kept in the 4th component
+  myTriangleRefOffsets.assign(nSlots + 1, 0);
+  for (Standard_Integer p = 0; p < nRefs; ++p)
+    ++myTriangleRefOffsets[myTriBVH->Elements[p][3] + 1];
+  for (Standard_Integer aSlot = 0; aSlot < nSlots; ++aSlot)
+    myTriangleRefOffsets[aSlot + 1] += myTriangleRefOffsets[aSlot];
+
+  std::vector<Standard_Integer> aCursors(myTriangleRefOffsets.begin(),
+                                         myTriangleRefOffsets.end() - 1);
+  myTriangleRefs.resize(nRefs);
+  for (Standard_Integer p = 0; p < nRefs; ++p)
+    myTriangleRefs[aCursors[myTriBVH->Elements[p][3]]++] = p;
+
+  if (!myWideBVH.IsEmpty())
+    myWideBVH.InitRefit(nRefs);
+  else
+    myFlatBVH.InitRefit(nRefs);
+}
+
+//=================================================================================================
+
+Standard_Boolean BRepIntCurveSurface_InterBVH::UpdateFaces()
+{
+  if (!myInstances.IsEmpty())
+    throw Standard_ProgramError(
+      "BRepIntCurveSurface_InterBVH::UpdateFaces - faces of part instances cannot be updated");
+
+  myIsDone = Standard_False;
+  myNbPnt  = 0;
+  myResults.clear();
+
+  // Apply the edits to the face map; an edit of a face added by an earlier edit comes
+  // after it, so an index past the loaded faces is always the next one
+  std::vector<Standard_Integer> aChangedFaces;
+  for (const std::pair<Standard_Integer, TopoDS_Face>& anEdit : myPendingFaces)
+  {
+    const Standard_Integer anIndex = anEdit.first;
+    if (anIndex > myFaces.Extent())
+    {
+      myFaces.Add(anEdit.second);
+      mySurfaceAdaptors.push_back(Handle(BRepAdaptor_Surface)());
+      myAnalyticSurfaces.emplace_back();
+      mySplineSurfaces.emplace_back();
+      myIsFaceRemoved.push_back(Standard_False);
+    }
+    else if (anEdit.second.IsNull())
+    {
+      myIsFaceRemoved[anIndex - 1] = Standard_True;
+    }
+    else
+    {
+      myFaces.Substitute(anIndex, anEdit.second);
+      mySurfaceAdaptors[anIndex - 1].Nullify();
+      myAnalyticSurfaces[anIndex - 1] = BRepIntCurveSurface_AnalyticSurface();
+      mySplineSurfaces[anIndex - 1]   = BRepIntCurveSurface_SplineSurface();
+      myIsFaceRemoved[anIndex - 1]    = Standard_False;
+    }
+    aChangedFaces.push_back(anIndex - 1);
+  }
+  myPendingFaces.clear();
+  std::sort(aChangedFaces.begin(), aChangedFaces.end());
+  aChangedFaces.erase(std::unique(aChangedFaces.begin(), aChangedFaces.end()),
+                      aChangedFaces.end());
+  const Standard_Integer nChanged = static_cast<Standard_Integer>(aChangedFaces.size());
+
+  // Only the flat and wide nodes can be refitted
+  if (!myUseTessellation || (myFlatBVH.IsEmpty() && myWideBVH.IsEmpty()))
+  {
+    loadTriangles();
+    return Standard_False;
+  }
+
+  if (myFaceTriangles.empty())
+    prepareFaceUpdate();
+  myFaceTriangles.resize(myFaces.Extent());
+
+  // Slots needed by the changed faces against the slots they hold and the free ones
+  const Standard_Integer nSlots = static_cast<Standard_Integer>(myTriangleInfo.size());
+  std::vector<Standard_Integer> aNbNeeded(nChanged, 0);
+  Standard_Integer              aNbEdited = 0;
+  Standard_Integer              aNbMoved  = 0;
+  Standard_Integer              aNbSpare  = static_cast<Standard_Integer>(myFreeTriangles.size());
+  for (Standard_Integer i = 0; i < nChanged; ++i)
+  {
+    const Standard_Integer aFaceIdx = aChangedFaces[i];
+    if (!myIsFaceRemoved[aFaceIdx])
+    {
+      TopLoc_Location                  aLoc;
+      const Handle(Poly_Triangulation) aTriangulation =
+        BRep_Tool::Triangulation(TopoDS::Face(myFaces.FindKey(aFaceIdx + 1)), aLoc);
+      aNbNeeded[i] = aTriangulation.IsNull() ? 0 : aTriangulation->NbTriangles();
+    }
+    const Standard_Integer aNbHeld =
+      static_cast<Standard_Integer>(myFaceTriangles[aFaceIdx].size());
+    aNbEdited += std::max(aNbNeeded[i], aNbHeld);
+    aNbSpare += aNbHeld - aNbNeeded[i];
+    aNbMoved += std::max(aNbNeeded[i] - aNbHeld, 0);
+  }
+
+  if (aNbSpare < 0 || aNbEdited > nSlots * UPDATE_MAX_EDIT_RATIO
+      || myNbMovedTriangles + aNbMoved > nSlots * UPDATE_MAX_MOVED_RATIO
+      || myNbUpdatedTriangles + aNbEdited > nSlots)
+  {
+    std::cout << "  Face update: rebuilding the triangle BVH (" << aNbEdited << " of " << nSlots
+              << " triangles edited)" << std::endl;
+    loadTriangles();
+    return Standard_False;
+  }
+
+  // Gather the new tessellations and create the surface adaptors of the changed faces
+  std::vector<FaceMesh> aMeshes(nChanged);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 1) if (myUseOpenMP && nChanged > 1)
+#endif
+  for (Standard_Integer i = 0; i < nChanged; ++i)
+  {
+    const Standard_Integer aFaceIdx = aChangedFaces[i];
+    if (myIsFaceRemoved[aFaceIdx])
+      continue;
+
+    const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(aFaceIdx + 1));
+    if (mySurfaceAdaptors[aFaceIdx].IsNull())
+      initSurface(aFaceIdx, aFace);
+    GatherFaceMesh(aFace, aMeshes[i]);
+  }
+
+  // Release the surplus slots first, then hand free slots to the faces that grew
+  std::vector<Standard_Integer> aDeadSlots;
+  for (Standard_Integer i = 0; i < nChanged; ++i)
+  {
+    std::vector<Standard_Integer>& aSlots = myFaceTriangles[aChangedFaces[i]];
+    const Standard_Integer         aNbNew =
+      static_cast<Standard_Integer>(aMeshes[i].Triangles.size() / 3);
+    while (static_cast<Standard_Integer>(aSlots.size()) > aNbNew)
+    {
+      aDeadSlots.push_back(aSlots.back());
+      myFreeTriangles.push_back(aSlots.back());
+      aSlots.pop_back();
+    }
+  }
+  for (Standard_Integer i = 0; i < nChanged; ++i)
+  {
+    std::vector<Standard_Integer>& aSlots = myFaceTriangles[aChangedFaces[i]];
+    const Standard_Integer         aNbNew =
+      static_cast<Standard_Integer>(aMeshes[i].Triangles.size() / 3);
+    while (static_cast<Standard_Integer>(aSlots.size()) < aNbNew)
+    {
+      aSlots.push_back(myFreeTriangles.back());
+      myFreeTriangles.pop_back();
+    }
+  }
+  myNbMovedTriangles += aNbMoved;
+  myNbUpdatedTriangles += aNbEdited;
+
+  // Leaf holding a primitive, the primitive range of a leaf, and the records read by the
+  // traversal (packets or leaf-order records)
+  const Standard_Boolean isWide     = !myWideBVH.IsEmpty();
+  const Standard_Boolean hasPackets = !myTrianglePackets.IsEmpty();
+  auto leafOf = [&](const Standard_Integer thePrim) {
+    return isWide ? myWideBVH.PrimitiveLeaf(thePrim) : myFlatBVH.PrimitiveLeaf(thePrim);
+  };
+  auto leafRange = [&](const Standard_Integer theLeaf,
+                       Standard_Integer&      theFirst,
+                       Standard_Integer&      theNbPrims) {
+    if (isWide)
+      myWideBVH.LeafRange(theLeaf, theFirst, theNbPrims);
+    else
+      myFlatBVH.LeafRange(theLeaf, theFirst, theNbPrims);
+  };
+  auto setRecord = [&](const Standard_Integer                    thePrim,
+                       const BRepIntCurveSurface_TriangleRecord& theRec) {
+    if (hasPackets)
+    {
+      Standard_Integer aFirst = 0, aNbPrims = 0;
+      leafRange(leafOf(thePrim), aFirst, aNbPrims);
+      myTrianglePackets.SetTriangle(aFirst, thePrim, theRec);
+    }
+    else
+    {
+      myTriangleRecords[thePrim] = theRec;
+    }
+  };
+  auto getRecord = [&](const Standard_Integer theFirst, const Standard_Integer thePrim) {
+    return hasPackets ? myTrianglePackets.Triangle(theFirst, thePrim)
+                      : myTriangleRecords[thePrim];
+  };
+
+  // Slots whose primitives change; removed triangles become degenerate records that
+  // never produce a hit
+  const BRepIntCurveSurface_TriangleRecord aDead = {BVH_Vec3d(), BVH_Vec3d(), BVH_Vec3d(), -1};
+  std::vector<Standard_Integer>            aChangedSlots(aDeadSlots);
+  for (const Standard_Integer aSlot : aDeadSlots)
+  {
+    myTriangleInfo[aSlot].FaceIndex = -1;
+    for (Standard_Integer r = myTriangleRefOffsets[aSlot]; r < myTriangleRefOffsets[aSlot + 1];
+         ++r)
+    {
+      myTriBVH->Elements[myTriangleRefs[r]] = BVH_Vec4i(0, 0, 0, aSlot);
+      setRecord(myTriangleRefs[r], aDead);
+    }
+  }
+
+  // Write the new triangles; their nodes are appended to the vertices without welding
+  // and their UV nodes to the UV node table, under a new origin of the face
+  const size_t aFirstNewVertex = myTriBVH->Vertices.size();
+  for (Standard_Integer i = 0; i < nChanged; ++i)
   {
-    std::cout << "  Building tessellation BVH (using existing triangulation)..." << std::endl;
+    const Standard_Integer               aFaceIdx = aChangedFaces[i];
+    const FaceMesh&                      aMesh    = aMeshes[i];
+    const std::vector<Standard_Integer>& aSlots   = myFaceTriangles[aFaceIdx];
+    const Standard_Integer               aNodeBase =
+      static_cast<Standard_Integer>(myTriBVH->Vertices.size());
+    const Standard_Integer aUVBase  = myTriangleUVs.NbNodes();
+    const Standard_Integer aNbNodes = static_cast<Standard_Integer>(aMesh.UVs.size());
+    myTriBVH->Vertices.insert(myTriBVH->Vertices.end(), aMesh.Nodes.begin(), aMesh.Nodes.end());
+    myTriangleUVs.Resize(aUVBase + aNbNodes, std::max(myTriangleUVs.NbFaces(), aFaceIdx + 1));
+    if (!myIsFaceRemoved[aFaceIdx])
+    {
+      StoreFaceUVs(aMesh.UVs.data(),
+                   aNbNodes,
+                   aUVBase,
+                   aFaceIdx,
+                   *mySurfaceAdaptors[aFaceIdx],
+                   myTriangleUVs);
+    }
 
-    // Count total triangles first
-    Standard_Integer totalTriangles = 0;
-    for (Standard_Integer faceIdx = 1; faceIdx <= myFaces.Extent(); ++faceIdx)
+    for (size_t t = 0; t < aSlots.size(); ++t)
     {
-      const TopoDS_Face&         aFace = TopoDS::Face(myFaces.FindKey(faceIdx));
-      TopLoc_Location            aLoc;
-      Handle(Poly_Triangulation) aTriangulation = BRep_Tool::Triangulation(aFace, aLoc);
-      if (!aTriangulation.IsNull())
+      const Standard_Integer  aSlot = aSlots[t];
+      const Standard_Integer* aTri  = &aMesh.Triangles[t * 3];
+
+      BRepIntCurveSurface_TriangleInfo& aTriInfo = myTriangleInfo[aSlot];
+      aTriInfo.FaceIndex                         = aFaceIdx;
+      for (int k = 0; k < 3; ++k)
+        aTriInfo.UVNodes[k] = aUVBase + aTri[k];
+
+      BRepIntCurveSurface_TriangleRecord aRec;
+      aRec.V0            = aMesh.Nodes[aTri[0]];
+      aRec.Edge1         = aMesh.Nodes[aTri[1]] - aRec.V0;
+      aRec.Edge2         = aMesh.Nodes[aTri[2]] - aRec.V0;
+      aRec.OriginalIndex = aSlot;
+      const BVH_Vec4i anElem(aNodeBase + aTri[0], aNodeBase + aTri[1], aNodeBase + aTri[2], aSlot);
+      for (Standard_Integer r = myTriangleRefOffsets[aSlot];
+           r < myTriangleRefOffsets[aSlot + 1];
+           ++r)
       {
-        totalTriangles += aTriangulation->NbTriangles();
+        myTriBVH->Elements[myTriangleRefs[r]] = anElem;
+        setRecord(myTriangleRefs[r], aRec);
       }
+      aChangedSlots.push_back(aSlot);
     }
+  }
 
-    if (totalTriangles > 0)
+  // Refit the leaves holding the changed primitives to their live triangles; a leaf
+  // left with removed triangles only shrinks to a point
+  std::vector<Standard_Integer> aLeaves;
+  for (const Standard_Integer aSlot : aChangedSlots)
+  {
+    for (Standard_Integer r = myTriangleRefOffsets[aSlot]; r < myTriangleRefOffsets[aSlot + 1];
+         ++r)
     {
-      // Create triangle BVH
-      opencascade::handle<BVH_LinearBuilder<Standard_Real, 3>> aTriBuilder =
-        new BVH_LinearBuilder<Standard_Real, 3>(4, 32);
-      myTriBVH = new BRepIntCurveSurface_TriBVH(aTriBuilder);
-
-      // Reserve space for vertices and triangles
-      myTriangleInfo.reserve(totalTriangles);
-
-      // Collect all triangles from all faces with vertex welding
-      // Use spatial grid to merge duplicate vertices at face boundaries
-      // Weld tolerance: use deflection or default 1e-3
-      const double weldTol = std::max(myDeflection * 0.1, DEFAULT_WELD_TOLERANCE);
-      std::cout << "  Weld tolerance: " << weldTol << std::endl;
-
-      std::vector<BVH_Vec3d> uniqueVertices;
-      uniqueVertices.reserve(totalTriangles * 2);
-      std::vector<Standard_Integer> triangleIndices;
-      triangleIndices.reserve(totalTriangles * 3);
-
-      // Spatial grid for vertex welding (checks 27 neighboring cells for proper tolerance matching)
-      SpatialVertexGrid vertexGrid(weldTol, totalTriangles * 2);
-
-      // Helper lambda to get or create vertex index (welds duplicates)
-      auto getVertexIndex = [&](const gp_Pnt& p) -> Standard_Integer {
-        BVH_Vec3d v(p.X(), p.Y(), p.Z());
-        return vertexGrid.FindOrAdd(v, uniqueVertices);
-      };
-
-      for (Standard_Integer faceIdx = 1; faceIdx <= myFaces.Extent(); ++faceIdx)
-      {
-        const TopoDS_Face&         aFace = TopoDS::Face(myFaces.FindKey(faceIdx));
-        TopLoc_Location            aLoc;
-        Handle(Poly_Triangulation) aTriangulation = BRep_Tool::Triangulation(aFace, aLoc);
-
-        if (aTriangulation.IsNull())
-          continue;
-
-        const gp_Trsf&   aTrsf        = aLoc.Transformation();
-        Standard_Boolean hasTransform = (aLoc.IsIdentity() == Standard_False);
-
-        // Get the UV nodes if available
-        Standard_Boolean hasUVNodes = aTriangulation->HasUVNodes();
-
-        for (Standard_Integer triIdx = 1; triIdx <= aTriangulation->NbTriangles(); ++triIdx)
-        {
-          const Poly_Triangle& aTri = aTriangulation->Triangle(triIdx);
-          Standard_Integer     n1, n2, n3;
-          aTri.Get(n1, n2, n3);
-
-          // Get 3D vertices
-          gp_Pnt p1 = aTriangulation->Node(n1);
-          gp_Pnt p2 = aTriangulation->Node(n2);
-          gp_Pnt p3 = aTriangulation->Node(n3);
-
-          // Apply face transformation if needed
-          if (hasTransform)
-          {
-            p1.Transform(aTrsf);
-            p2.Transform(aTrsf);
-            p3.Transform(aTrsf);
-          }
-
-          // Get welded vertex indices for this triangle
-          triangleIndices.push_back(getVertexIndex(p1));
-          triangleIndices.push_back(getVertexIndex(p2));
-          triangleIndices.push_back(getVertexIndex(p3));
-
-          // Store triangle info with UV coordinates
-          BRepIntCurveSurface_TriangleInfo aTriInfo;
-          aTriInfo.FaceIndex = faceIdx - 1; // 0-based
+      aLeaves.push_back(leafOf(myTriangleRefs[r]));
+    }
+  }
+  std::sort(aLeaves.begin(), aLeaves.end());
+  aLeaves.erase(std::unique(aLeaves.begin(), aLeaves.end()), aLeaves.end());
 
-          if (hasUVNodes)
-          {
-            aTriInfo.UV0 = aTriangulation->UVNode(n1);
-            aTriInfo.UV1 = aTriangulation->UVNode(n2);
-            aTriInfo.UV2 = aTriangulation->UVNode(n3);
-          }
-          else
-          {
-            // No UV nodes - will need to use Face intersector anyway
-            aTriInfo.UV0 = gp_Pnt2d(0, 0);
-            aTriInfo.UV1 = gp_Pnt2d(0, 0);
-            aTriInfo.UV2 = gp_Pnt2d(0, 0);
-          }
+  std::vector<BVH_Vec3d> aMins(aLeaves.size());
+  std::vector<BVH_Vec3d> aMaxs(aLeaves.size());
+  for (size_t i = 0; i < aLeaves.size(); ++i)
+  {
+    Standard_Integer aFirst = 0, aNbPrims = 0;
+    leafRange(aLeaves[i], aFirst, aNbPrims);
 
-          myTriangleInfo.push_back(aTriInfo);
-        }
-      }
+    Standard_Boolean isLive = Standard_False;
+    for (Standard_Integer p = aFirst; p < aFirst + aNbPrims; ++p)
+    {
+      const BRepIntCurveSurface_TriangleRecord aRec = getRecord(aFirst, p);
+      if (aRec.OriginalIndex < 0)
+        continue;
 
-      // Build the triangle BVH
-      // BVH_Triangulation expects vertices as array and elements as triangle indices
-      Standard_Integer nVertices    = static_cast<Standard_Integer>(uniqueVertices.size());
-      Standard_Integer nTriangles   = static_cast<Standard_Integer>(myTriangleInfo.size());
-      Standard_Integer nRawVertices = totalTriangles * 3;
+      const BVH_Vec3d aV1  = aRec.V0 + aRec.Edge1;
+      const BVH_Vec3d aV2  = aRec.V0 + aRec.Edge2;
+      const BVH_Vec3d aMin = aRec.V0.cwiseMin(aV1).cwiseMin(aV2);
+      const BVH_Vec3d aMax = aRec.V0.cwiseMax(aV1).cwiseMax(aV2);
 
-      // Report vertex welding stats
-      std::cout << "  Vertex welding: " << nRawVertices << " -> " << nVertices << " (" << std::fixed
-                << std::setprecision(1) << (100.0 * nVertices / nRawVertices) << "% unique)"
-                << std::endl;
+      aMins[i] = isLive ? aMins[i].cwiseMin(aMin) : aMin;
+      aMaxs[i] = isLive ? aMaxs[i].cwiseMax(aMax) : aMax;
+      isLive   = Standard_True;
+    }
+    if (!isLive)
+    {
+      if (isWide)
+        myWideBVH.LeafBox(aLeaves[i], aMins[i], aMaxs[i]);
+      else
+        myFlatBVH.LeafBox(aLeaves[i], aMins[i], aMaxs[i]);
+      aMaxs[i] = aMins[i];
+    }
+  }
+  if (isWide)
+    myWideBVH.Refit(aLeaves, aMins, aMaxs);
+  else
+    myFlatBVH.Refit(aLeaves, aMins, aMaxs);
 
-      // Set welded vertices
-      myTriBVH->Vertices.resize(nVertices);
-      for (Standard_Integer i = 0; i < nVertices; ++i)
-      {
-        myTriBVH->Vertices[i] = uniqueVertices[i];
-      }
+#ifdef OCCT_USE_EMBREE
+  // Update the shared buffers of the Embree geometry in place (growing the vertex buffer
+  // with some slack when needed, which moves it); Embree rebuilds its own BVH on commit
+  if (myEmbreeScene)
+  {
+    RTCGeometry  aGeom       = rtcGetGeometry(myEmbreeScene, 0);
+    const size_t aNbVertices = myTriBVH->Vertices.size();
+    if (aNbVertices > myEmbreeNbVertices)
+    {
+      myEmbreeNbVertices = aNbVertices + aNbVertices / 4;
+      myEmbreeVertices.resize(myEmbreeNbVertices * 3 + 1, 0.0f);
+      rtcSetSharedGeometryBuffer(aGeom,
+                                 RTC_BUFFER_TYPE_VERTEX,
+                                 0,
+                                 RTC_FORMAT_FLOAT3,
+                                 myEmbreeVertices.data(),
+                                 0,
+                                 3 * sizeof(float),
+                                 myEmbreeNbVertices);
+    }
+    for (size_t i = aFirstNewVertex; i < aNbVertices; ++i)
+    {
+      const BVH_Vec3d& aVertex    = myTriBVH->Vertices[i];
+      myEmbreeVertices[3 * i + 0] = static_cast<float>(aVertex[0]);
+      myEmbreeVertices[3 * i + 1] = static_cast<float>(aVertex[1]);
+      myEmbreeVertices[3 * i + 2] = static_cast<float>(aVertex[2]);
+    }
 
-      // Set triangle indices using welded vertex indices
-      // IMPORTANT: Store original triangle index in 4th component (w) because
-      // BVH building reorders Elements via Swap(), but myTriangleInfo stays in original order
-      myTriBVH->Elements.resize(nTriangles);
-      for (Standard_Integer i = 0; i < nTriangles; ++i)
-      {
-        myTriBVH->Elements[i] = BVH_Vec4i(triangleIndices[i * 3 + 0],
-                                          triangleIndices[i * 3 + 1],
-                                          triangleIndices[i * 3 + 2],
-                                          i); // w = original triangle index
-      }
+    for (const Standard_Integer aSlot : aChangedSlots)
+    {
+      // Elements of a slot's references all hold its corners, or zeros once removed
+      const BVH_Vec4i& anElem = myTriBVH->Elements[myTriangleRefs[myTriangleRefOffsets[aSlot]]];
+      myEmbreeIndices[3 * aSlot + 0] = anElem[0];
+      myEmbreeIndices[3 * aSlot + 1] = anElem[1];
+      myEmbreeIndices[3 * aSlot + 2] = anElem[2];
+    }
 
-      // CRITICAL: Mark as dirty so BVH() will actually build the tree
-      myTriBVH->MarkDirty();
+    rtcUpdateGeometryBuffer(aGeom, RTC_BUFFER_TYPE_VERTEX, 0);
+    rtcUpdateGeometryBuffer(aGeom, RTC_BUFFER_TYPE_INDEX, 0);
+    rtcCommitGeometry(aGeom);
+    rtcCommitScene(myEmbreeScene);
+  }
+#else
+  (void)aFirstNewVertex;
+#endif
 
-      // Build the BVH
-      myTriBVH->BVH();
+  std::cout << "  Face update: " << nChanged << " faces, " << aChangedSlots.size()
+            << " triangles, " << aLeaves.size() << " leaves refitted" << std::endl;
+  return Standard_True;
+}
 
-      myUseTessellation = Standard_True;
+//=================================================================================================
 
-      std::cout << "  Triangle BVH built: " << nTriangles << " triangles from " << myFaces.Extent()
-                << " faces" << std::endl;
+Standard_Boolean BRepIntCurveSurface_InterBVH::readBVHCache(
+  const BRepIntCurveSurface_BVHCache&  theCache,
+  const std::vector<Standard_Integer>& theFaceOffsets,
+  std::vector<Standard_Integer>&       theTriangleIndices,
+  Standard_Integer&                    theNbVertices)
+{
+  BVHCacheParams                aParams;
+  std::vector<Standard_Integer> aFaceOffsets;
+  std::vector<BVH_Vec3d>        aVertices;
+  std::vector<BVH_Vec4i>        anElements;
+  std::vector<Standard_Integer> aTriangleIndices;
+  std::vector<Standard_Integer> aLeafSizes;
+  if (!theCache.Read(BVHCacheSection_Params, aParams)
+      || !theCache.Read(BVHCacheSection_FaceOffsets, aFaceOffsets)
+      || !theCache.Read(BVHCacheSection_Vertices, aVertices)
+      || !theCache.Read(BVHCacheSection_Elements, anElements)
+      || !theCache.Read(BVHCacheSection_TriangleIndices, aTriangleIndices)
+      || !theCache.Read(BVHCacheSection_LeafSizes, aLeafSizes))
+  {
+    return Standard_False;
+  }
 
-      // Debug: verify BVH structure
-      if (!myTriBVH->BVH().IsNull())
-      {
-        std::cout << "  [DEBUG] BVH tree depth: " << myTriBVH->BVH()->Depth() << std::endl;
-        std::cout << "  [DEBUG] BVH tree nodes: " << myTriBVH->BVH()->Length() << std::endl;
-        std::cout << "  [DEBUG] Vertices array size: " << myTriBVH->Vertices.size() << std::endl;
-        std::cout << "  [DEBUG] Elements array size: " << myTriBVH->Elements.size() << std::endl;
-        std::cout << "  [DEBUG] TriangleInfo array size: " << myTriangleInfo.size() << std::endl;
-        // Sample a few elements to verify w component
-        if (nTriangles > 0)
-        {
-          std::cout << "  [DEBUG] Elements[0]: v=(" << myTriBVH->Elements[0][0] << ","
-                    << myTriBVH->Elements[0][1] << "," << myTriBVH->Elements[0][2]
-                    << ") origIdx=" << myTriBVH->Elements[0][3] << std::endl;
-          if (nTriangles > 100)
-          {
-            std::cout << "  [DEBUG] Elements[100]: v=(" << myTriBVH->Elements[100][0] << ","
-                      << myTriBVH->Elements[100][1] << "," << myTriBVH->Elements[100][2]
-                      << ") origIdx=" << myTriBVH->Elements[100][3] << std::endl;
-          }
-        }
-      }
+  // The key already covers the triangulation; these checks guard against key collisions
+  const size_t aNbTriangles = myTriangleInfo.size();
+  if (aFaceOffsets != theFaceOffsets || aTriangleIndices.size() != aNbTriangles * 3
+      || anElements.size() < aNbTriangles || aParams.NbWeldedVertices < 0
+      || static_cast<size_t>(aParams.NbWeldedVertices) > aVertices.size())
+  {
+    return Standard_False;
+  }
 
-#ifdef OCCT_USE_EMBREE
-      // Build Embree scene for hardware-accelerated BVH traversal
-      std::cout << "  Building Embree scene..." << std::endl;
+  // Triangle records in leaf order, or the packets regrouping them
+  std::vector<BRepIntCurveSurface_TriangleRecord> aRecords;
+  std::vector<BRepIntCurveSurface_TrianglePacket> aPackets;
+  std::vector<Standard_Integer>                   aFirstPackets;
+  const Standard_Boolean                          hasTriangles =
+    myUseTrianglePackets ? theCache.Read(BVHCacheSection_Packets, aPackets)
+                             && theCache.Read(BVHCacheSection_FirstPackets, aFirstPackets)
+                             && aFirstPackets.size() == anElements.size()
+                         : theCache.Read(BVHCacheSection_TriangleRecords, aRecords)
+                             && aRecords.size() == anElements.size();
+  if (!hasTriangles)
+    return Standard_False;
 
-      // Create Embree device if not already created
-      if (!myEmbreeDevice)
-      {
-        myEmbreeDevice = rtcNewDevice(nullptr);
-        if (!myEmbreeDevice)
-        {
-          std::cerr << "  ERROR: Failed to create Embree device!" << std::endl;
-        }
-      }
+  // Traversal nodes of the configured layout
+  std::vector<BRepIntCurveSurface_FlatNodeF> aFlatNodesF;
+  std::vector<BRepIntCurveSurface_FlatNodeD> aFlatNodesD;
+  std::vector<BRepIntCurveSurface_WideNode4> aWideNodes4;
+  std::vector<BRepIntCurveSurface_WideNode8> aWideNodes8;
+  Standard_Boolean                           hasNodes = Standard_False;
+  if (myBVHWidth == 8)
+    hasNodes = theCache.Read(BVHCacheSection_WideNodes8, aWideNodes8) && !aWideNodes8.empty();
+  else if (myBVHWidth == 4)
+    hasNodes = theCache.Read(BVHCacheSection_WideNodes4, aWideNodes4) && !aWideNodes4.empty();
+  else if (myUseCompactNodes)
+    hasNodes = theCache.Read(BVHCacheSection_FlatNodesF, aFlatNodesF) && !aFlatNodesF.empty();
+  else
+    hasNodes = theCache.Read(BVHCacheSection_FlatNodesD, aFlatNodesD) && !aFlatNodesD.empty();
+  if (!hasNodes)
+    return Standard_False;
 
-      // Release old scene if exists
-      if (myEmbreeScene)
-      {
-        rtcReleaseScene(myEmbreeScene);
-        myEmbreeScene = nullptr;
-      }
+  // The tree itself is not rebuilt: traversal only reads the flat or wide nodes
+  myTriBVH->Vertices = std::move(aVertices);
+  myTriBVH->Elements = std::move(anElements);
+  myTriangleRecords  = std::move(aRecords);
+  if (myUseTrianglePackets)
+    myTrianglePackets.Assign(std::move(aPackets), std::move(aFirstPackets));
+
+  if (myBVHWidth == 8)
+    myWideBVH.Assign(std::move(aWideNodes8), aParams.NodesDepth);
+  else if (myBVHWidth == 4)
+    myWideBVH.Assign(std::move(aWideNodes4), aParams.NodesDepth);
+  else if (myUseCompactNodes)
+    myFlatBVH.Assign(std::move(aFlatNodesF), aParams.NodesDepth);
+  else
+    myFlatBVH.Assign(std::move(aFlatNodesD), aParams.NodesDepth);
+
+  myNbTriangleSplits           = aParams.NbTriangleSplits;
+  myBVHStatistics.SAHCost      = aParams.StatSAHCost;
+  myBVHStatistics.OverlapRatio = aParams.StatOverlapRatio;
+  myBVHStatistics.NbNodes      = aParams.StatNbNodes;
+  myBVHStatistics.NbLeaves     = aParams.StatNbLeaves;
+  myBVHStatistics.NbPrimitives = aParams.StatNbPrimitives;
+  myBVHStatistics.Depth        = aParams.StatDepth;
+  myBVHStatistics.LeafSizes    = std::move(aLeafSizes);
+
+  theTriangleIndices = std::move(aTriangleIndices);
+  theNbVertices      = aParams.NbWeldedVertices;
+  return Standard_True;
+}
 
-      if (myEmbreeDevice)
-      {
-        myEmbreeScene = rtcNewScene(myEmbreeDevice);
+//=================================================================================================
 
-        // Create triangle geometry
-        RTCGeometry geom = rtcNewGeometry(myEmbreeDevice, RTC_GEOMETRY_TYPE_TRIANGLE);
+Standard_Boolean BRepIntCurveSurface_InterBVH::writeBVHCache(
+  const TCollection_AsciiString&       thePath,
+  const uint64_t                       theKey,
+  const std::vector<Standard_Integer>& theFaceOffsets,
+  const std::vector<Standard_Integer>& theTriangleIndices,
+  const Standard_Integer               theNbVertices) const
+{
+  BVHCacheParams aParams   = {};
+  aParams.NbWeldedVertices = theNbVertices;
+  aParams.NbTriangleSplits = myNbTriangleSplits;
+  aParams.NodesDepth       = myWideBVH.IsEmpty() ? myFlatBVH.Depth() : myWideBVH.Depth();
+  aParams.StatNbNodes      = myBVHStatistics.NbNodes;
+  aParams.StatNbLeaves     = myBVHStatistics.NbLeaves;
+  aParams.StatNbPrimitives = myBVHStatistics.NbPrimitives;
+  aParams.StatDepth        = myBVHStatistics.Depth;
+  aParams.StatSAHCost      = myBVHStatistics.SAHCost;
+  aParams.StatOverlapRatio = myBVHStatistics.OverlapRatio;
+
+  BRepIntCurveSurface_BVHCache aCache;
+  aCache.AddSection(BVHCacheSection_Params, aParams);
+  aCache.AddSection(BVHCacheSection_FaceOffsets, theFaceOffsets);
+  aCache.AddSection(BVHCacheSection_Vertices, myTriBVH->Vertices);
+  aCache.AddSection(BVHCacheSection_Elements, myTriBVH->Elements);
+  aCache.AddSection(BVHCacheSection_TriangleIndices, theTriangleIndices);
+  aCache.AddSection(BVHCacheSection_LeafSizes, myBVHStatistics.LeafSizes);
+  if (myTrianglePackets.IsEmpty())
+  {
+    aCache.AddSection(BVHCacheSection_TriangleRecords, myTriangleRecords);
+  }
+  else
+  {
+    aCache.AddSection(BVHCacheSection_Packets, myTrianglePackets.Packets());
+    aCache.AddSection(BVHCacheSection_FirstPackets, myTrianglePackets.FirstPackets());
+  }
 
-        // Set vertex buffer (Embree expects float, not double)
-        float* verts = (float*)rtcSetNewGeometryBuffer(geom,
-                                                       RTC_BUFFER_TYPE_VERTEX,
-                                                       0,
-                                                       RTC_FORMAT_FLOAT3,
-                                                       3 * sizeof(float),
-                                                       uniqueVertices.size());
-        for (size_t i = 0; i < uniqueVertices.size(); ++i)
-        {
-          verts[3 * i + 0] = static_cast<float>(uniqueVertices[i][0]);
-          verts[3 * i + 1] = static_cast<float>(uniqueVertices[i][1]);
-          verts[3 * i + 2] = static_cast<float>(uniqueVertices[i][2]);
-        }
+  if (!myWideBVH.IsEmpty())
+  {
+    if (myWideBVH.Width() == 8)
+      aCache.AddSection(BVHCacheSection_WideNodes8,
+                        myWideBVH.Nodes8(),
+                        sizeof(BRepIntCurveSurface_WideNode8),
+                        myWideBVH.NbNodes());
+    else
+      aCache.AddSection(BVHCacheSection_WideNodes4,
+                        myWideBVH.Nodes4(),
+                        sizeof(BRepIntCurveSurface_WideNode4),
+                        myWideBVH.NbNodes());
+  }
+  else if (myFlatBVH.IsFloat())
+  {
+    aCache.AddSection(BVHCacheSection_FlatNodesF,
+                      myFlatBVH.NodesF(),
+                      sizeof(BRepIntCurveSurface_FlatNodeF),
+                      myFlatBVH.NbNodes());
+  }
+  else
+  {
+    aCache.AddSection(BVHCacheSection_FlatNodesD,
+                      myFlatBVH.NodesD(),
+                      sizeof(BRepIntCurveSurface_FlatNodeD),
+                      myFlatBVH.NbNodes());
+  }
+  return aCache.Write(thePath, theKey);
+}
 
-        // Set index buffer
-        unsigned* idxs = (unsigned*)rtcSetNewGeometryBuffer(geom,
-                                                            RTC_BUFFER_TYPE_INDEX,
-                                                            0,
-                                                            RTC_FORMAT_UINT3,
-                                                            3 * sizeof(unsigned),
-                                                            nTriangles);
-        for (Standard_Integer i = 0; i < nTriangles; ++i)
-        {
-          idxs[3 * i + 0] = static_cast<unsigned>(triangleIndices[i * 3 + 0]);
-          idxs[3 * i + 1] = static_cast<unsigned>(triangleIndices[i * 3 + 1]);
-          idxs[3 * i + 2] = static_cast<unsigned>(triangleIndices[i * 3 + 2]);
-        }
+//=================================================================================================
 
-        rtcCommitGeometry(geom);
-        rtcAttachGeometry(myEmbreeScene, geom);
-        rtcReleaseGeometry(geom);
-        rtcCommitScene(myEmbreeScene);
+Standard_Boolean BRepIntCurveSurface_InterBVH::hitTriangle(const Standard_Integer theTriangle,
+                                                           const Standard_Real    theU,
+                                                           const Standard_Real    theV,
+                                                           const gp_Dir&          theDir,
+                                                           Standard_Integer&      theFace,
+                                                           Standard_Integer&      theInstance,
+                                                           gp_Pnt2d&              theUV,
+                                                           gp_Pnt2d&              theUVMin,
+                                                           gp_Pnt2d&              theUVMax) const
+{
+  theFace     = -1;
+  theInstance = -1;
+  if (myInstances.IsEmpty())
+  {
+    if (theTriangle < 0 || theTriangle >= static_cast<Standard_Integer>(myTriangleInfo.size()))
+      return Standard_False;
 
-        std::cout << "  Embree scene built: " << nTriangles << " triangles, "
-                  << uniqueVertices.size() << " vertices" << std::endl;
-      }
-#endif
+    const BRepIntCurveSurface_TriangleInfo& aTriInfo = myTriangleInfo[theTriangle];
+    theFace                                          = aTriInfo.FaceIndex;
+    if (theFace >= 0)
+    {
+      theUV = myTriangleUVs.InterpolateCurved(aTriInfo.UVNodes, theFace, theU, theV, theDir.XYZ());
+      myTriangleUVs.Bounds(aTriInfo.UVNodes, theFace, theUVMin, theUVMax);
     }
+    return Standard_True;
   }
 
-  myIsLoaded = Standard_True;
+  // Hit indices number the triangles of the instances one after the other; UV origins
+  // are stored per prototype face, and derivatives in part coordinates
+  theInstance = myInstances.FindInstance(theTriangle);
+  if (theInstance < 0)
+    return Standard_False;
+
+  const BRepIntCurveSurface_Instance&  anInstance = myInstances.Instance(theInstance);
+  const BRepIntCurveSurface_Prototype& aPrototype = myInstances.Prototype(anInstance.Prototype);
+  const BRepIntCurveSurface_TriangleInfo& aTriInfo =
+    myTriangleInfo[aPrototype.FirstTriangle + theTriangle - anInstance.FirstTriangle];
+  const Standard_Integer aUVFace = aPrototype.FirstUVFace + aTriInfo.FaceIndex;
+  theFace = myInstances.InstanceFace(theInstance, aTriInfo.FaceIndex);
+  if (myTriangleUVs.HasDerivatives())
+  {
+    BVH_Vec3d aPartOrigin, aPartDir;
+    anInstance.ToPartRay(BVH_Vec3d(0.0, 0.0, 0.0),
+                         BVH_Vec3d(theDir.X(), theDir.Y(), theDir.Z()),
+                         aPartOrigin,
+                         aPartDir);
+    theUV = myTriangleUVs.InterpolateCurved(aTriInfo.UVNodes,
+                                            aUVFace,
+                                            theU,
+                                            theV,
+                                            gp_XYZ(aPartDir.x(), aPartDir.y(), aPartDir.z()));
+  }
+  else
+  {
+    theUV = myTriangleUVs.Interpolate(aTriInfo.UVNodes, aUVFace, theU, theV);
+  }
+  myTriangleUVs.Bounds(aTriInfo.UVNodes, aUVFace, theUVMin, theUVMax);
+  return Standard_True;
 }
 
 //=================================================================================================
@@ -1290,55 +4278,70 @@ void BRepIntCurveSurface_InterBVH::Perform(const gp_Lin&       theLine,
   myNbPnt  = 0;
   myResults.clear();
 
-  if (!myIsLoaded || !myUseTessellation || myTriBVH.IsNull())
+  if (!myIsLoaded || !myUseTessellation)
     return;
 
   // Use tessellation-accelerated path (same as PerformBatch for single ray)
   // Step 1: Fast triangle BVH traversal to find candidate face
   BRepIntCurveSurface_TriangleTraverser aTriTraverser;
-  aTriTraverser.SetTriBVH(myTriBVH.get());
+  aTriTraverser.SetTriangles(myTriangleRecords.data());
+  aTriTraverser.SetTrianglePackets(&myTrianglePackets);
+  aTriTraverser.SetFlatBVH(&myFlatBVH);
+  aTriTraverser.SetWideBVH(&myWideBVH);
+  aTriTraverser.SetInstances(&myInstances);
   aTriTraverser.SetTriangleInfo(&myTriangleInfo);
   aTriTraverser.SetRay(theLine, theMin, theMax);
   aTriTraverser.Select();
 
-  Standard_Integer hitFaceIdx = aTriTraverser.GetHitFaceIndex();
-  Standard_Integer hitTriIdx  = aTriTraverser.GetHitTriangleIndex();
-
-  if (hitFaceIdx >= 0 && hitFaceIdx < static_cast<Standard_Integer>(mySurfaceAdaptors.size())
-      && hitTriIdx >= 0 && hitTriIdx < static_cast<Standard_Integer>(myTriangleInfo.size()))
+  Standard_Integer hitFaceIdx = -1;
+  Standard_Integer hitInstIdx = -1;
+  Standard_Real    baryU, baryV;
+  gp_Pnt2d         anInitUV, anUVMin, anUVMax;
+  aTriTraverser.GetHitBarycentric(baryU, baryV);
+
+  // Interpolate the UV of the hit from the UV nodes of the triangle
+  if (hitTriangle(aTriTraverser.GetHitTriangleIndex(),
+                  baryU,
+                  baryV,
+                  theLine.Direction(),
+                  hitFaceIdx,
+                  hitInstIdx,
+                  anInitUV,
+                  anUVMin,
+                  anUVMax)
+      && hitFaceIdx >= 0 && hitFaceIdx < static_cast<Standard_Integer>(mySurfaceAdaptors.size()))
   {
     // Step 2: UV-guided Newton refinement
-    const BRepIntCurveSurface_TriangleInfo& triInfo = myTriangleInfo[hitTriIdx];
-    Standard_Real                           baryU, baryV;
-    aTriTraverser.GetHitBarycentric(baryU, baryV);
-    Standard_Real baryW = 1.0 - baryU - baryV;
-
-    // Interpolate UV: UV = w*UV0 + u*UV1 + v*UV2
-    Standard_Real initU =
-      baryW * triInfo.UV0.X() + baryU * triInfo.UV1.X() + baryV * triInfo.UV2.X();
-    Standard_Real initV =
-      baryW * triInfo.UV0.Y() + baryU * triInfo.UV1.Y() + baryV * triInfo.UV2.Y();
-
-    // Refine using Newton iteration
-    const BRepAdaptor_Surface& aSurface = *mySurfaceAdaptors[hitFaceIdx];
-    Standard_Real              finalU   = initU;
-    Standard_Real              finalV   = initV;
-    Standard_Real              finalT   = 0.0;
-    gp_Pnt                     finalPnt;
-    Standard_Integer           iterCount = 0;
-
-    NewtonResult newtonResult = RefineIntersectionNewton(aSurface,
-                                                         theLine.Location(),
-                                                         theLine.Direction(),
-                                                         finalU,
-                                                         finalV,
-                                                         finalT,
-                                                         finalPnt,
-                                                         iterCount,
-                                                         myTolerance,
-                                                         100);
-
-    Standard_Real hitT = aTriTraverser.GetHitT();
+    Standard_Real initU = anInitUV.X();
+    Standard_Real initV = anInitUV.Y();
+
+    // Refine in closed form or using Newton iteration
+    const BRepAdaptor_Surface&                 aSurface   = *mySurfaceAdaptors[hitFaceIdx];
+    const BRepIntCurveSurface_AnalyticSurface* anAnalytic = analyticSurface(hitFaceIdx);
+    const BRepIntCurveSurface_SplineSurface    aSpline(mySplineSurfaces[hitFaceIdx]);
+    const Standard_Real                        hitT   = aTriTraverser.GetHitT();
+    Standard_Real                              finalU = initU;
+    Standard_Real                              finalV = initV;
+    Standard_Real                              finalT = 0.0;
+    gp_Pnt                                     finalPnt;
+    Standard_Integer                           iterCount = 0;
+
+    NewtonResult newtonResult = RefineIntersection(aSurface,
+                                                   anAnalytic,
+                                                   aSpline,
+                                                   theLine.Location(),
+                                                   theLine.Direction(),
+                                                   hitT,
+                                                   anUVMin,
+                                                   anUVMax,
+                                                   finalU,
+                                                   finalV,
+                                                   finalT,
+                                                   finalPnt,
+                                                   iterCount,
+                                                   myTolerance,
+                                                   NEWTON_MAX_ITERATIONS);
+
     if (hitT >= theMin && hitT <= theMax)
     {
       BRepIntCurveSurface_HitResult aResult;
@@ -1360,59 +4363,18 @@ void BRepIntCurveSurface_InterBVH::Perform(const gp_Lin&       theLine,
         aResult.W     = hitT;
       }
 
-      aResult.FaceIndex  = hitFaceIdx + 1; // 1-based
-      aResult.Transition = IntCurveSurface_In;
-      aResult.State      = TopAbs_IN;
+      aResult.FaceIndex     = hitFaceIdx + 1; // 1-based
+      aResult.InstanceIndex = hitInstIdx + 1;
+      aResult.Transition    = IntCurveSurface_In;
+      aResult.State         = TopAbs_IN;
 
       // Compute surface normal and curvatures
-      gp_Pnt normPnt;
-      gp_Vec dSdu, dSdv, d2Sdu2, d2Sdv2, d2Sduv;
-      aSurface.D2(aResult.U, aResult.V, normPnt, dSdu, dSdv, d2Sdu2, d2Sdv2, d2Sduv);
-      gp_Vec        normalVec = dSdu.Crossed(dSdv);
-      Standard_Real normalMag = normalVec.Magnitude();
-
-      if (normalMag > 1e-10)
-      {
-        normalVec.Normalize();
-        const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(hitFaceIdx + 1));
-        if (aFace.Orientation() == TopAbs_REVERSED)
-          normalVec.Reverse();
-        aResult.Normal = gp_Dir(normalVec);
-
-        // Curvature computation
-        Standard_Real E     = dSdu.Dot(dSdu);
-        Standard_Real F     = dSdu.Dot(dSdv);
-        Standard_Real G     = dSdv.Dot(dSdv);
-        Standard_Real L     = d2Sdu2.Dot(normalVec);
-        Standard_Real M     = d2Sduv.Dot(normalVec);
-        Standard_Real N     = d2Sdv2.Dot(normalVec);
-        Standard_Real denom = E * G - F * F;
-
-        if (std::abs(denom) > 1e-20)
-        {
-          aResult.GaussianCurvature = (L * N - M * M) / denom;
-          aResult.MeanCurvature     = (E * N - 2.0 * F * M + G * L) / (2.0 * denom);
-          Standard_Real disc =
-            aResult.MeanCurvature * aResult.MeanCurvature - aResult.GaussianCurvature;
-          Standard_Real sqrtDisc = std::sqrt(std::max(0.0, disc));
-          aResult.MinCurvature   = aResult.MeanCurvature - sqrtDisc;
-          aResult.MaxCurvature   = aResult.MeanCurvature + sqrtDisc;
-        }
-
-        // Analytic height-field Hessian in the world-Z projection frame
-        ComputeHeightHessian(dSdu,
-                             dSdv,
-                             d2Sdu2,
-                             d2Sdv2,
-                             d2Sduv,
-                             aResult.HeightHessXX,
-                             aResult.HeightHessYY,
-                             aResult.HeightHessXY);
-      }
-      else
-      {
-        aResult.Normal = gp_Dir(0, 0, 1);
-      }
+      const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(hitFaceIdx + 1));
+      ComputeHitGeometry<BRepIntCurveSurface_HitChannel_All>(aSurface,
+                                                             anAnalytic,
+                                                             aSpline,
+                                                             aFace.Orientation() == TopAbs_REVERSED,
+                                                             aResult);
 
       myResults.push_back(aResult);
       myNbPnt = 1;
@@ -1427,10 +4389,46 @@ void BRepIntCurveSurface_InterBVH::Perform(const gp_Lin&       theLine,
 void BRepIntCurveSurface_InterBVH::PerformBatch(
   const NCollection_Array1<gp_Lin>&                  theRays,
   NCollection_Array1<BRepIntCurveSurface_HitResult>& theResults,
-  const Standard_Integer                             theNumThreads)
+  const Standard_Integer                             theNumThreads,
+  const BRepIntCurveSurface_HitChannels              theChannels)
+{
+  (void)theNumThreads; // Will be used for manual thread control if needed
+  performBatch(theRays, nullptr, nullptr, theResults, theChannels);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::PerformBatch(
+  const NCollection_Array1<gp_Lin>&                  theRays,
+  const NCollection_Array1<Standard_Real>&           theMinParams,
+  const NCollection_Array1<Standard_Real>&           theMaxParams,
+  NCollection_Array1<BRepIntCurveSurface_HitResult>& theResults,
+  const Standard_Integer                             theNumThreads,
+  const BRepIntCurveSurface_HitChannels              theChannels)
 {
   (void)theNumThreads; // Will be used for manual thread control if needed
+  if (theMinParams.Length() != theRays.Length() || theMaxParams.Length() != theRays.Length())
+  {
+    throw Standard_DimensionMismatch(
+      "BRepIntCurveSurface_InterBVH::PerformBatch - parameter arrays must match the rays");
+  }
+  if (!AreValidRayRanges(theMinParams, theMaxParams))
+  {
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::PerformBatch - negative or empty ray interval");
+  }
+  performBatch(theRays, &theMinParams, &theMaxParams, theResults, theChannels);
+}
+
+//=================================================================================================
 
+void BRepIntCurveSurface_InterBVH::performBatch(
+  const NCollection_Array1<gp_Lin>&                  theRays,
+  const NCollection_Array1<Standard_Real>*           theMinParams,
+  const NCollection_Array1<Standard_Real>*           theMaxParams,
+  NCollection_Array1<BRepIntCurveSurface_HitResult>& theResults,
+  const BRepIntCurveSurface_HitChannels              theChannels)
+{
   if (!myIsLoaded)
   {
     theResults.Resize(theRays.Lower(), theRays.Upper(), Standard_False);
@@ -1440,6 +4438,8 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
   Standard_Integer nRays = theRays.Length();
   theResults.Resize(theRays.Lower(), theRays.Lower() + nRays - 1, Standard_False);
 
+  const BatchRayRanges aRanges(theRays, theMinParams, theMaxParams);
+
   // Initialize results
   for (Standard_Integer i = theResults.Lower(); i <= theResults.Upper(); ++i)
   {
@@ -1449,7 +4449,7 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
   auto startTime = std::chrono::high_resolution_clock::now();
 
   // Use tessellation-accelerated path
-  if (myTriBVH.IsNull())
+  if (!myUseTessellation)
   {
     std::cerr << "Error: Triangle BVH not built - shape must be tessellated." << std::endl;
     return;
@@ -1459,8 +4459,16 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
   const char* backendNames[] = {"OCCT_BVH", "Embree_Scalar", "Embree_SIMD4", "Embree_SIMD8"};
   std::cout << "  Backend requested: " << backendNames[static_cast<int>(myBackend)]
             << ", OpenMP: " << (myUseOpenMP ? "enabled" : "disabled") << std::endl;
-  std::cout << "  [DEBUG] myTriBVH Elements size: " << myTriBVH->Elements.size() << std::endl;
-  std::cout << "  [DEBUG] myTriBVH Vertices size: " << myTriBVH->Vertices.size() << std::endl;
+  if (!myTriBVH.IsNull())
+  {
+    std::cout << "  [DEBUG] myTriBVH Elements size: " << myTriBVH->Elements.size() << std::endl;
+    std::cout << "  [DEBUG] myTriBVH Vertices size: " << myTriBVH->Vertices.size() << std::endl;
+  }
+  else
+  {
+    std::cout << "  [DEBUG] Part instances: " << myInstances.NbInstances() << " of "
+              << myInstances.NbPrototypes() << " parts" << std::endl;
+  }
   std::cout << "  [DEBUG] myTriangleInfo size: " << myTriangleInfo.size() << std::endl;
 
   // Structure to hold thread-local stats (avoid atomic contention)
@@ -1473,8 +4481,11 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
     long long nodeTests        = 0; // BVH node tests (thread-local to avoid atomic contention)
   };
 
-  // Thread-local surface adaptors type (for thread-safe surface evaluation)
-  using ThreadLocalSurfaces = std::vector<Handle(Adaptor3d_Surface)>;
+  // Thread-local surface adaptors and span caches type (for thread-safe surface evaluation)
+  using ThreadLocalSurfaces = std::vector<ThreadLocalSurface>;
+
+  // Evaluation of the requested normal and curvature channels of the hits
+  const HitGeometryKernel aHitGeometry = SelectHitGeometryKernel(theChannels);
 
   // Lambda to process a single ray and refine the hit
   // Uses thread-local surface adaptors for thread safety
@@ -1486,11 +4497,19 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
                            const gp_Lin&        aRay,
                            ThreadLocalStats&    stats,
                            ThreadLocalSurfaces& localSurfaces) {
-    if (hitTriIdx < 0 || hitTriIdx >= static_cast<Standard_Integer>(myTriangleInfo.size()))
-      return;
-
-    Standard_Integer hitFaceIdx = myTriangleInfo[hitTriIdx].FaceIndex;
-    if (hitFaceIdx < 0 || hitFaceIdx >= static_cast<Standard_Integer>(mySurfaceAdaptors.size()))
+    Standard_Integer hitFaceIdx = -1;
+    Standard_Integer hitInstIdx = -1;
+    gp_Pnt2d         anInitUV, anUVMin, anUVMax;
+    if (!hitTriangle(hitTriIdx,
+                     baryU,
+                     baryV,
+                     aRay.Direction(),
+                     hitFaceIdx,
+                     hitInstIdx,
+                     anInitUV,
+                     anUVMin,
+                     anUVMax)
+        || hitFaceIdx < 0 || hitFaceIdx >= static_cast<Standard_Integer>(mySurfaceAdaptors.size()))
       return;
 
     stats.faceTests++;
@@ -1498,42 +4517,48 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
     // UV-guided Newton refinement
     auto t0 = std::chrono::high_resolution_clock::now();
 
-    const BRepIntCurveSurface_TriangleInfo& triInfo = myTriangleInfo[hitTriIdx];
-    Standard_Real                           baryW   = 1.0 - baryU - baryV;
-    Standard_Real                           initU =
-      baryW * triInfo.UV0.X() + baryU * triInfo.UV1.X() + baryV * triInfo.UV2.X();
-    Standard_Real initV =
-      baryW * triInfo.UV0.Y() + baryU * triInfo.UV1.Y() + baryV * triInfo.UV2.Y();
-
-    // Use thread-local surface adaptor for thread safety
-    const Adaptor3d_Surface& aSurface = *localSurfaces[hitFaceIdx];
-    Standard_Real            finalU   = initU;
-    Standard_Real            finalV   = initV;
-    Standard_Real            finalT   = 0.0;
-    gp_Pnt                   finalPnt;
-    Standard_Integer         iterCount = 0;
-
-    NewtonResult newtonResult = RefineIntersectionNewton(aSurface,
-                                                         aRay.Location(),
-                                                         aRay.Direction(),
-                                                         finalU,
-                                                         finalV,
-                                                         finalT,
-                                                         finalPnt,
-                                                         iterCount,
-                                                         myTolerance,
-                                                         100);
+    Standard_Real initU = anInitUV.X();
+    Standard_Real initV = anInitUV.Y();
+
+    // Use thread-local surface adaptor and span cache for thread safety (elementary
+    // surfaces are read-only and shared)
+    const ThreadLocalSurface&                  aLocal     = localSurfaces[hitFaceIdx];
+    const Adaptor3d_Surface&                   aSurface   = *aLocal.Adaptor;
+    const BRepIntCurveSurface_AnalyticSurface* anAnalytic = analyticSurface(hitFaceIdx);
+    Standard_Real                              finalU     = initU;
+    Standard_Real                              finalV     = initV;
+    Standard_Real                              finalT     = 0.0;
+    gp_Pnt                                     finalPnt;
+    Standard_Integer                           iterCount = 0;
+
+    NewtonResult newtonResult = RefineIntersection(aSurface,
+                                                   anAnalytic,
+                                                   aLocal.Spline,
+                                                   aRay.Location(),
+                                                   aRay.Direction(),
+                                                   hitT,
+                                                   anUVMin,
+                                                   anUVMax,
+                                                   finalU,
+                                                   finalV,
+                                                   finalT,
+                                                   finalPnt,
+                                                   iterCount,
+                                                   myTolerance,
+                                                   NEWTON_MAX_ITERATIONS);
 
     auto t1 = std::chrono::high_resolution_clock::now();
     stats.refinementTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
     stats.newtonIters += iterCount;
 
-    if (hitT >= 0.0)
+    const Standard_Real aMin = aRanges.Min(idx);
+    const Standard_Real aMax = aRanges.Max(idx);
+    if (hitT >= aMin && hitT <= aMax)
     {
       BRepIntCurveSurface_HitResult& aResult = theResults(idx);
       aResult.IsValid                        = Standard_True;
 
-      if (newtonResult == NewtonResult::Converged && finalT >= 0.0)
+      if (newtonResult == NewtonResult::Converged && finalT >= aMin && finalT <= aMax)
       {
         aResult.Point = finalPnt;
         aResult.U     = finalU;
@@ -1549,58 +4574,18 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
         aResult.W     = hitT;
       }
 
-      aResult.FaceIndex  = hitFaceIdx + 1;
-      aResult.Transition = IntCurveSurface_In;
-      aResult.State      = TopAbs_IN;
-
-      // Compute surface normal and curvatures
-      gp_Pnt normPnt;
-      gp_Vec dSdu, dSdv, d2Sdu2, d2Sdv2, d2Sduv;
-      aSurface.D2(aResult.U, aResult.V, normPnt, dSdu, dSdv, d2Sdu2, d2Sdv2, d2Sduv);
-      gp_Vec        normalVec = dSdu.Crossed(dSdv);
-      Standard_Real normalMag = normalVec.Magnitude();
-
-      if (normalMag > 1e-10)
-      {
-        normalVec.Normalize();
-        const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(hitFaceIdx + 1));
-        if (aFace.Orientation() == TopAbs_REVERSED)
-          normalVec.Reverse();
-        aResult.Normal = gp_Dir(normalVec);
-
-        Standard_Real E = dSdu.Dot(dSdu);
-        Standard_Real F = dSdu.Dot(dSdv);
-        Standard_Real G = dSdv.Dot(dSdv);
-        Standard_Real L = d2Sdu2.Dot(normalVec);
-        Standard_Real M = d2Sduv.Dot(normalVec);
-        Standard_Real N = d2Sdv2.Dot(normalVec);
-
-        Standard_Real denom = E * G - F * F;
-        if (std::abs(denom) > 1e-20)
-        {
-          aResult.GaussianCurvature = (L * N - M * M) / denom;
-          aResult.MeanCurvature     = (E * N - 2.0 * F * M + G * L) / (2.0 * denom);
-          Standard_Real disc =
-            aResult.MeanCurvature * aResult.MeanCurvature - aResult.GaussianCurvature;
-          Standard_Real sqrtDisc = std::sqrt(std::max(0.0, disc));
-          aResult.MinCurvature   = aResult.MeanCurvature - sqrtDisc;
-          aResult.MaxCurvature   = aResult.MeanCurvature + sqrtDisc;
-        }
-
-        // Analytic height-field Hessian in the world-Z projection frame
-        ComputeHeightHessian(dSdu,
-                             dSdv,
-                             d2Sdu2,
-                             d2Sdv2,
-                             d2Sduv,
-                             aResult.HeightHessXX,
-                             aResult.HeightHessYY,
-                             aResult.HeightHessXY);
-      }
-      else
-      {
-        aResult.Normal = gp_Dir(0, 0, 1);
-      }
+      aResult.FaceIndex     = hitFaceIdx + 1;
+      aResult.InstanceIndex = hitInstIdx + 1;
+      aResult.Transition    = IntCurveSurface_In;
+      aResult.State         = TopAbs_IN;
+
+      // Compute the requested surface normal and curvatures
+      const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(hitFaceIdx + 1));
+      aHitGeometry(aSurface,
+                   anAnalytic,
+                   aLocal.Spline,
+                   aFace.Orientation() == TopAbs_REVERSED,
+                   aResult);
     }
   };
 
@@ -1609,7 +4594,8 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
     ThreadLocalSurfaces surfaces(mySurfaceAdaptors.size());
     for (size_t i = 0; i < mySurfaceAdaptors.size(); ++i)
     {
-      surfaces[i] = mySurfaceAdaptors[i]->ShallowCopy();
+      surfaces[i].Adaptor = mySurfaceAdaptors[i]->ShallowCopy();
+      surfaces[i].Spline  = mySplineSurfaces[i];
     }
     return surfaces;
   };
@@ -1634,13 +4620,116 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
     std::cout << "  Warning: Embree not available, using OCCT_BVH" << std::endl;
     effectiveBackend = BRepIntCurveSurface_BVHBackend::OCCT_BVH;
   }
-#endif
-
-  // Aggregate stats from all threads
-  ThreadLocalStats totalStats;
-
-  // Process rays based on backend and parallelization settings
-  if (effectiveBackend == BRepIntCurveSurface_BVHBackend::OCCT_BVH)
+#endif
+
+  // Aggregate stats from all threads
+  ThreadLocalStats totalStats;
+
+  // Packet traversal walks the flattened binary tree only; packets are formed
+  // from tiles of neighbouring rays rather than from runs of the input order
+  const Standard_Boolean        useRayPackets = myUseRayPackets && !myFlatBVH.IsEmpty();
+  std::vector<Standard_Integer> aRayOrder;
+  if (effectiveBackend == BRepIntCurveSurface_BVHBackend::OCCT_BVH && useRayPackets)
+  {
+    SortRaysByTiles(theRays, aRayOrder);
+  }
+
+  // Lambda to trace a tile of rays as one packet through the flattened BVH
+  // (per-ray traversal if their directions are not coherent)
+  auto processRayPacket = [&](Standard_Integer                        first,
+                              BRepIntCurveSurface_RayPacketTraverser& aPacket,
+                              ThreadLocalStats&                       stats,
+                              ThreadLocalSurfaces&                    localSurfaces) {
+    const Standard_Integer aNbRays =
+      std::min(BRepIntCurveSurface_RayPacketTraverser::MaxRays, nRays - first);
+    const Standard_Integer* anIndices = aRayOrder.data() + first;
+    if (aPacket.SetRays(theRays, anIndices, aNbRays, aRanges))
+    {
+      aPacket.Select(myFlatBVH);
+    }
+    else
+    {
+      for (Standard_Integer j = 0; j < aNbRays; ++j)
+      {
+        aPacket.Ray(j).Select();
+      }
+    }
+
+    for (Standard_Integer j = 0; j < aNbRays; ++j)
+    {
+      const BRepIntCurveSurface_TriangleTraverser& aTriTraverser = aPacket.Ray(j);
+
+      Standard_Real baryU, baryV;
+      aTriTraverser.GetHitBarycentric(baryU, baryV);
+      processRayHit(anIndices[j],
+                    aTriTraverser.GetHitTriangleIndex(),
+                    aTriTraverser.GetHitT(),
+                    baryU,
+                    baryV,
+                    theRays(anIndices[j]),
+                    stats,
+                    localSurfaces);
+    }
+  };
+
+  // Helper to create a packet traverser bound to the native BVH data
+  auto createRayPacket = [&](BRepIntCurveSurface_RayPacketTraverser& aPacket) {
+    for (Standard_Integer j = 0; j < BRepIntCurveSurface_RayPacketTraverser::MaxRays; ++j)
+    {
+      BRepIntCurveSurface_TriangleTraverser& aTriTraverser = aPacket.Ray(j);
+      aTriTraverser.SetTriangles(myTriangleRecords.data());
+      aTriTraverser.SetTrianglePackets(&myTrianglePackets);
+      aTriTraverser.SetFlatBVH(&myFlatBVH);
+      aTriTraverser.SetTriangleInfo(&myTriangleInfo);
+    }
+  };
+
+  // Process rays based on backend and parallelization settings
+  if (effectiveBackend == BRepIntCurveSurface_BVHBackend::OCCT_BVH && useRayPackets)
+  {
+    const Standard_Integer aPacketSize = BRepIntCurveSurface_RayPacketTraverser::MaxRays;
+    const Standard_Integer nPackets    = (nRays + aPacketSize - 1) / aPacketSize;
+#ifdef _OPENMP
+    if (myUseOpenMP)
+    {
+  #pragma omp parallel
+      {
+        ThreadLocalStats                       localStats;
+        ThreadLocalSurfaces                    localSurfaces = createLocalSurfaces();
+        BRepIntCurveSurface_RayPacketTraverser aPacket;
+        createRayPacket(aPacket);
+  #pragma omp for schedule(dynamic, 1)
+        for (Standard_Integer p = 0; p < nPackets; ++p)
+        {
+          processRayPacket(p * aPacketSize, aPacket, localStats, localSurfaces);
+        }
+        localStats.nodeTests += aPacket.GetNodeTestCount();
+  #pragma omp critical
+        {
+          totalStats.faceTests += localStats.faceTests;
+          totalStats.newtonIters += localStats.newtonIters;
+          totalStats.newtonFailures += localStats.newtonFailures;
+          totalStats.refinementTimeNs += localStats.refinementTimeNs;
+          totalStats.nodeTests += localStats.nodeTests;
+        }
+      }
+    }
+    else
+#endif
+    {
+      ThreadLocalStats                       localStats;
+      ThreadLocalSurfaces                    localSurfaces = createLocalSurfaces();
+      BRepIntCurveSurface_RayPacketTraverser aPacket;
+      createRayPacket(aPacket);
+      for (Standard_Integer p = 0; p < nPackets; ++p)
+      {
+        processRayPacket(p * aPacketSize, aPacket, localStats, localSurfaces);
+      }
+      localStats.nodeTests += aPacket.GetNodeTestCount();
+      totalStats = localStats;
+    }
+  }
+  else if (effectiveBackend == BRepIntCurveSurface_BVHBackend::OCCT_BVH)
   {
 // OCCT BVH backend (no Embree dependency)
 #ifdef _OPENMP
@@ -1657,9 +4746,13 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
           const gp_Lin&    aRay = theRays(idx);
 
           BRepIntCurveSurface_TriangleTraverser aTriTraverser;
-          aTriTraverser.SetTriBVH(myTriBVH.get());
+          aTriTraverser.SetTriangles(myTriangleRecords.data());
+          aTriTraverser.SetTrianglePackets(&myTrianglePackets);
+          aTriTraverser.SetFlatBVH(&myFlatBVH);
+          aTriTraverser.SetWideBVH(&myWideBVH);
+          aTriTraverser.SetInstances(&myInstances);
           aTriTraverser.SetTriangleInfo(&myTriangleInfo);
-          aTriTraverser.SetRay(aRay, 0.0, RealLast());
+          aTriTraverser.SetRay(aRay, aRanges.Min(idx), aRanges.Max(idx));
           aTriTraverser.Select();
 
           // Accumulate thread-local node test count (no atomic overhead!)
@@ -1694,9 +4787,13 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
         const gp_Lin&    aRay = theRays(idx);
 
         BRepIntCurveSurface_TriangleTraverser aTriTraverser;
-        aTriTraverser.SetTriBVH(myTriBVH.get());
+        aTriTraverser.SetTriangles(myTriangleRecords.data());
+        aTriTraverser.SetTrianglePackets(&myTrianglePackets);
+        aTriTraverser.SetFlatBVH(&myFlatBVH);
+        aTriTraverser.SetWideBVH(&myWideBVH);
+        aTriTraverser.SetInstances(&myInstances);
         aTriTraverser.SetTriangleInfo(&myTriangleInfo);
-        aTriTraverser.SetRay(aRay, 0.0, RealLast());
+        aTriTraverser.SetRay(aRay, aRanges.Min(idx), aRanges.Max(idx));
         aTriTraverser.Select();
 
         // Accumulate thread-local node test count
@@ -1731,7 +4828,8 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
 
           Standard_Integer hitTriIdx;
           Standard_Real    hitT, baryU, baryV;
-          IntersectEmbree1(myEmbreeScene, aRay, hitTriIdx, hitT, baryU, baryV);
+          IntersectEmbree1(
+            myEmbreeScene, aRay, aRanges.Min(idx), aRanges.Max(idx), hitTriIdx, hitT, baryU, baryV);
 
           processRayHit(idx, hitTriIdx, hitT, baryU, baryV, aRay, localStats, localSurfaces);
         }
@@ -1756,7 +4854,8 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
 
         Standard_Integer hitTriIdx;
         Standard_Real    hitT, baryU, baryV;
-        IntersectEmbree1(myEmbreeScene, aRay, hitTriIdx, hitT, baryU, baryV);
+        IntersectEmbree1(
+          myEmbreeScene, aRay, aRanges.Min(idx), aRanges.Max(idx), hitTriIdx, hitT, baryU, baryV);
 
         processRayHit(idx, hitTriIdx, hitT, baryU, baryV, aRay, localStats, localSurfaces);
       }
@@ -1779,18 +4878,20 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
           Standard_Integer batchSize = std::min(4, nRays - i);
 
           // Prepare batch of rays (pad with dummy rays if needed)
-          gp_Lin rays[4];
+          gp_Lin        rays[4];
+          Standard_Real rayMins[4], rayMaxs[4];
           for (int j = 0; j < 4; ++j)
           {
-            if (j < batchSize)
-              rays[j] = theRays(theRays.Lower() + i + j);
-            else
-              rays[j] = rays[0]; // Duplicate first ray for padding
+            // Duplicate first ray for padding
+            const Standard_Integer idx = theRays.Lower() + i + (j < batchSize ? j : 0);
+            rays[j]                    = theRays(idx);
+            rayMins[j]                 = aRanges.Min(idx);
+            rayMaxs[j]                 = aRanges.Max(idx);
           }
 
           Standard_Integer triIdx[4];
           Standard_Real    hitT[4], baryU[4], baryV[4];
-          IntersectEmbree4(myEmbreeScene, rays, triIdx, hitT, baryU, baryV);
+          IntersectEmbree4(myEmbreeScene, rays, rayMins, rayMaxs, triIdx, hitT, baryU, baryV);
 
           // Process results
           for (int j = 0; j < batchSize; ++j)
@@ -1824,18 +4925,20 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
       {
         Standard_Integer batchSize = std::min(4, nRays - i);
 
-        gp_Lin rays[4];
+        gp_Lin        rays[4];
+        Standard_Real rayMins[4], rayMaxs[4];
         for (int j = 0; j < 4; ++j)
         {
-          if (j < batchSize)
-            rays[j] = theRays(theRays.Lower() + i + j);
-          else
-            rays[j] = rays[0];
+          // Duplicate first ray for padding
+          const Standard_Integer idx = theRays.Lower() + i + (j < batchSize ? j : 0);
+          rays[j]                    = theRays(idx);
+          rayMins[j]                 = aRanges.Min(idx);
+          rayMaxs[j]                 = aRanges.Max(idx);
         }
 
         Standard_Integer triIdx[4];
         Standard_Real    hitT[4], baryU[4], baryV[4];
-        IntersectEmbree4(myEmbreeScene, rays, triIdx, hitT, baryU, baryV);
+        IntersectEmbree4(myEmbreeScene, rays, rayMins, rayMaxs, triIdx, hitT, baryU, baryV);
 
         for (int j = 0; j < batchSize; ++j)
         {
@@ -1855,192 +4958,791 @@ void BRepIntCurveSurface_InterBVH::PerformBatch(
   }
   else if (effectiveBackend == BRepIntCurveSurface_BVHBackend::Embree_SIMD8)
   {
-  // Embree SIMD8 backend (rtcIntersect8) - process 8 rays at a time
-  #ifdef _OPENMP
-    if (myUseOpenMP)
-    {
-    #pragma omp parallel
-      {
-        ThreadLocalStats    localStats;
-        ThreadLocalSurfaces localSurfaces = createLocalSurfaces();
-    #pragma omp for schedule(dynamic, 8)
-        for (Standard_Integer i = 0; i < nRays; i += 8)
-        {
-          Standard_Integer batchSize = std::min(8, nRays - i);
+  // Embree SIMD8 backend (rtcIntersect8) - process 8 rays at a time
+  #ifdef _OPENMP
+    if (myUseOpenMP)
+    {
+    #pragma omp parallel
+      {
+        ThreadLocalStats    localStats;
+        ThreadLocalSurfaces localSurfaces = createLocalSurfaces();
+    #pragma omp for schedule(dynamic, 8)
+        for (Standard_Integer i = 0; i < nRays; i += 8)
+        {
+          Standard_Integer batchSize = std::min(8, nRays - i);
+
+          gp_Lin        rays[8];
+          Standard_Real rayMins[8], rayMaxs[8];
+          for (int j = 0; j < 8; ++j)
+          {
+            // Duplicate first ray for padding
+            const Standard_Integer idx = theRays.Lower() + i + (j < batchSize ? j : 0);
+            rays[j]                    = theRays(idx);
+            rayMins[j]                 = aRanges.Min(idx);
+            rayMaxs[j]                 = aRanges.Max(idx);
+          }
+
+          Standard_Integer triIdx[8];
+          Standard_Real    hitT[8], baryU[8], baryV[8];
+          IntersectEmbree8(myEmbreeScene, rays, rayMins, rayMaxs, triIdx, hitT, baryU, baryV);
+
+          for (int j = 0; j < batchSize; ++j)
+          {
+            Standard_Integer idx = theRays.Lower() + i + j;
+            processRayHit(idx,
+                          triIdx[j],
+                          hitT[j],
+                          baryU[j],
+                          baryV[j],
+                          rays[j],
+                          localStats,
+                          localSurfaces);
+          }
+        }
+    #pragma omp critical
+        {
+          totalStats.faceTests += localStats.faceTests;
+          totalStats.newtonIters += localStats.newtonIters;
+          totalStats.newtonFailures += localStats.newtonFailures;
+          totalStats.refinementTimeNs += localStats.refinementTimeNs;
+        }
+      }
+    }
+    else
+  #endif
+    {
+      ThreadLocalStats    localStats;
+      ThreadLocalSurfaces localSurfaces = createLocalSurfaces();
+      for (Standard_Integer i = 0; i < nRays; i += 8)
+      {
+        Standard_Integer batchSize = std::min(8, nRays - i);
+
+        gp_Lin        rays[8];
+        Standard_Real rayMins[8], rayMaxs[8];
+        for (int j = 0; j < 8; ++j)
+        {
+          // Duplicate first ray for padding
+          const Standard_Integer idx = theRays.Lower() + i + (j < batchSize ? j : 0);
+          rays[j]                    = theRays(idx);
+          rayMins[j]                 = aRanges.Min(idx);
+          rayMaxs[j]                 = aRanges.Max(idx);
+        }
+
+        Standard_Integer triIdx[8];
+        Standard_Real    hitT[8], baryU[8], baryV[8];
+        IntersectEmbree8(myEmbreeScene, rays, rayMins, rayMaxs, triIdx, hitT, baryU, baryV);
+
+        for (int j = 0; j < batchSize; ++j)
+        {
+          Standard_Integer idx = theRays.Lower() + i + j;
+          processRayHit(idx,
+                        triIdx[j],
+                        hitT[j],
+                        baryU[j],
+                        baryV[j],
+                        rays[j],
+                        localStats,
+                        localSurfaces);
+        }
+      }
+      totalStats = localStats;
+    }
+  }
+#endif
+
+  // Print debug stats (using thread-local accumulated stats, no atomic contention)
+  auto   endTime  = std::chrono::high_resolution_clock::now();
+  double totalSec = std::chrono::duration<double>(endTime - startTime).count();
+
+  std::cout << "  Total time: " << std::fixed << std::setprecision(2) << totalSec << "s, "
+            << std::setprecision(0) << (nRays / totalSec) << " rays/sec" << std::endl;
+  std::cout << "  [DEBUG] Triangle BVH node tests: " << totalStats.nodeTests << " ("
+            << (double)totalStats.nodeTests / nRays << " per ray)" << std::endl;
+  std::cout << "  [DEBUG] Face intersection tests: " << totalStats.faceTests << " ("
+            << (double)totalStats.faceTests / nRays << " per ray)" << std::endl;
+  if (totalStats.faceTests > 0)
+  {
+    std::cout << "  [DEBUG] Surface refinement time: " << totalStats.refinementTimeNs / 1000000.0
+              << " ms (" << (double)totalStats.refinementTimeNs / totalStats.faceTests / 1000.0
+              << " us per call)" << std::endl;
+  }
+  if (totalStats.newtonIters > 0)
+  {
+    std::cout << "  [DEBUG] Newton iterations: " << totalStats.newtonIters << " ("
+              << (double)totalStats.newtonIters / totalStats.faceTests << " per hit)" << std::endl;
+  }
+  if (totalStats.newtonFailures > 0)
+  {
+    std::cout << "  [DEBUG] Newton refinement failures: " << totalStats.newtonFailures
+              << " (used triangle fallback)" << std::endl;
+  }
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::PerformBatchCount(
+  const NCollection_Array1<gp_Lin>&     theRays,
+  NCollection_Array1<Standard_Integer>& theHitCounts,
+  const Standard_Integer                theNumThreads)
+{
+  (void)theNumThreads; // Will be used for manual thread control if needed
+  performBatchCount(theRays, nullptr, nullptr, theHitCounts);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::PerformBatchCount(
+  const NCollection_Array1<gp_Lin>&        theRays,
+  const NCollection_Array1<Standard_Real>& theMinParams,
+  const NCollection_Array1<Standard_Real>& theMaxParams,
+  NCollection_Array1<Standard_Integer>&    theHitCounts,
+  const Standard_Integer                   theNumThreads)
+{
+  (void)theNumThreads; // Will be used for manual thread control if needed
+  if (theMinParams.Length() != theRays.Length() || theMaxParams.Length() != theRays.Length())
+  {
+    throw Standard_DimensionMismatch(
+      "BRepIntCurveSurface_InterBVH::PerformBatchCount - parameter arrays must match the rays");
+  }
+  if (!AreValidRayRanges(theMinParams, theMaxParams))
+  {
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::PerformBatchCount - negative or empty ray interval");
+  }
+  performBatchCount(theRays, &theMinParams, &theMaxParams, theHitCounts);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::performBatchCount(
+  const NCollection_Array1<gp_Lin>&        theRays,
+  const NCollection_Array1<Standard_Real>* theMinParams,
+  const NCollection_Array1<Standard_Real>* theMaxParams,
+  NCollection_Array1<Standard_Integer>&    theHitCounts)
+{
+  if (!myIsLoaded)
+  {
+    theHitCounts.Resize(theRays.Lower(), theRays.Upper(), Standard_False);
+    for (Standard_Integer i = theHitCounts.Lower(); i <= theHitCounts.Upper(); ++i)
+      theHitCounts(i) = 0;
+    return;
+  }
+
+  Standard_Integer nRays = theRays.Length();
+  theHitCounts.Resize(theRays.Lower(), theRays.Lower() + nRays - 1, Standard_False);
+
+  const BatchRayRanges aRanges(theRays, theMinParams, theMaxParams);
+
+  // Initialize counts
+  for (Standard_Integer i = theHitCounts.Lower(); i <= theHitCounts.Upper(); ++i)
+  {
+    theHitCounts(i) = 0;
+  }
+
+  // Progress tracking
+  Standard_Integer lastProgress = 0;
+  auto             startTime    = std::chrono::high_resolution_clock::now();
+
+  // Use tessellation-accelerated path
+  if (!myUseTessellation)
+  {
+    std::cerr << "Error: Triangle BVH not built - shape must be tessellated." << std::endl;
+    return;
+  }
+
+  std::cout << "  Using tessellation-accelerated intersection counting..." << std::endl;
+
+  // Thread-local node test accumulator
+  long long totalNodeTests = 0;
+
+#ifdef OCCT_USE_EMBREE
+  if (myBackend != BRepIntCurveSurface_BVHBackend::OCCT_BVH && myEmbreeScene)
+  {
+    // Every Embree backend counts with rtcIntersect1: the filter rejects each hit so
+    // that the traversal continues, which packet queries would not speed up
+  #ifdef _OPENMP
+    if (myUseOpenMP)
+    {
+    #pragma omp parallel
+      {
+        std::vector<unsigned> aPrimIds;
+    #pragma omp for schedule(dynamic, 64)
+        for (Standard_Integer i = 0; i < nRays; ++i)
+        {
+          const Standard_Integer idx = theRays.Lower() + i;
+          theHitCounts(idx)          = CountHitsEmbree1(
+            myEmbreeScene, theRays(idx), aRanges.Min(idx), aRanges.Max(idx), aPrimIds);
+        }
+      }
+    }
+    else
+  #endif
+    {
+      std::vector<unsigned> aPrimIds;
+      for (Standard_Integer i = 0; i < nRays; ++i)
+      {
+        const Standard_Integer idx = theRays.Lower() + i;
+        theHitCounts(idx)          = CountHitsEmbree1(
+          myEmbreeScene, theRays(idx), aRanges.Min(idx), aRanges.Max(idx), aPrimIds);
+      }
+    }
+
+    auto   endTime  = std::chrono::high_resolution_clock::now();
+    double totalSec = std::chrono::duration<double>(endTime - startTime).count();
+    std::cout << "  Total time: " << std::fixed << std::setprecision(2) << totalSec << "s, "
+              << std::setprecision(0) << (nRays / totalSec) << " rays/sec" << std::endl;
+    return;
+  }
+#endif
+
+  // Lambda to count the hits of one ray with the native traverser
+  auto countRay = [&](BRepIntCurveSurface_TriangleCountTraverser& aTriTraverser,
+                      Standard_Integer                            idx) {
+    aTriTraverser.SetRay(theRays(idx), aRanges.Min(idx), aRanges.Max(idx));
+    aTriTraverser.Select();
+    theHitCounts(idx) = aTriTraverser.GetHitCount();
+  };
+
+  // Helper to bind a count traverser to the native BVH data
+  auto createTraverser = [&](BRepIntCurveSurface_TriangleCountTraverser& aTriTraverser) {
+    aTriTraverser.SetTriangles(myTriangleRecords.data());
+    aTriTraverser.SetTrianglePackets(&myTrianglePackets);
+    aTriTraverser.SetFlatBVH(&myFlatBVH);
+    aTriTraverser.SetWideBVH(&myWideBVH);
+    aTriTraverser.SetInstances(&myInstances);
+    aTriTraverser.SetUniqueHits(myNbTriangleSplits > 0);
+  };
+
+#ifdef _OPENMP
+  if (myUseOpenMP)
+  {
+  #pragma omp parallel reduction(+ : totalNodeTests)
+    {
+      BRepIntCurveSurface_TriangleCountTraverser aTriTraverser;
+      createTraverser(aTriTraverser);
+  #pragma omp for schedule(dynamic, 64)
+      for (Standard_Integer i = 0; i < nRays; ++i)
+      {
+        countRay(aTriTraverser, theRays.Lower() + i);
+      }
+      totalNodeTests += aTriTraverser.GetNodeTestCount();
+    }
+  }
+  else
+#endif
+  {
+    BRepIntCurveSurface_TriangleCountTraverser aTriTraverser;
+    createTraverser(aTriTraverser);
+    for (Standard_Integer i = 0; i < nRays; ++i)
+    {
+      countRay(aTriTraverser, theRays.Lower() + i);
+
+      // Print progress every 5%
+      Standard_Integer currentProgress = (i + 1) * 100 / nRays;
+      if (currentProgress >= lastProgress + 5)
+      {
+        auto   now     = std::chrono::high_resolution_clock::now();
+        double elapsed = std::chrono::duration<double>(now - startTime).count();
+        std::cout << "  Progress: " << currentProgress << "% (" << std::fixed
+                  << std::setprecision(1) << elapsed << "s)" << std::endl;
+        lastProgress = currentProgress;
+      }
+    }
+    totalNodeTests = aTriTraverser.GetNodeTestCount();
+  }
+
+  auto   endTime  = std::chrono::high_resolution_clock::now();
+  double totalSec = std::chrono::duration<double>(endTime - startTime).count();
+  std::cout << "  Total time: " << std::fixed << std::setprecision(2) << totalSec << "s, "
+            << std::setprecision(0) << (nRays / totalSec) << " rays/sec" << std::endl;
+
+  // Print debug stats
+  std::cout << "  [DEBUG] Triangle BVH node tests: " << totalNodeTests << " (" << std::fixed
+            << std::setprecision(1) << (double)totalNodeTests / nRays << " per ray)" << std::endl;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::PerformBatchAllHits(
+  const NCollection_Array1<gp_Lin>&                  theRays,
+  NCollection_Array1<Standard_Integer>&              theOffsets,
+  NCollection_Array1<BRepIntCurveSurface_HitResult>& theHits,
+  const Standard_Integer                             theNumThreads)
+{
+  (void)theNumThreads; // Will be used for manual thread control if needed
+  performBatchAllHits(theRays, nullptr, nullptr, theOffsets, theHits);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::PerformBatchAllHits(
+  const NCollection_Array1<gp_Lin>&                  theRays,
+  const NCollection_Array1<Standard_Real>&           theMinParams,
+  const NCollection_Array1<Standard_Real>&           theMaxParams,
+  NCollection_Array1<Standard_Integer>&              theOffsets,
+  NCollection_Array1<BRepIntCurveSurface_HitResult>& theHits,
+  const Standard_Integer                             theNumThreads)
+{
+  (void)theNumThreads; // Will be used for manual thread control if needed
+  if (theMinParams.Length() != theRays.Length() || theMaxParams.Length() != theRays.Length())
+  {
+    throw Standard_DimensionMismatch(
+      "BRepIntCurveSurface_InterBVH::PerformBatchAllHits - parameter arrays must match the rays");
+  }
+  if (!AreValidRayRanges(theMinParams, theMaxParams))
+  {
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::PerformBatchAllHits - negative or empty ray interval");
+  }
+  performBatchAllHits(theRays, &theMinParams, &theMaxParams, theOffsets, theHits);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_InterBVH::performBatchAllHits(
+  const NCollection_Array1<gp_Lin>&                  theRays,
+  const NCollection_Array1<Standard_Real>*           theMinParams,
+  const NCollection_Array1<Standard_Real>*           theMaxParams,
+  NCollection_Array1<Standard_Integer>&              theOffsets,
+  NCollection_Array1<BRepIntCurveSurface_HitResult>& theHits)
+{
+  const Standard_Integer nRays = theRays.Length();
+  theOffsets.Resize(theRays.Lower(), theRays.Lower() + nRays, Standard_False);
+  for (Standard_Integer i = theOffsets.Lower(); i <= theOffsets.Upper(); ++i)
+  {
+    theOffsets(i) = 1;
+  }
+  theHits.Resize(1, 0, Standard_False);
+
+  const BatchRayRanges aRanges(theRays, theMinParams, theMaxParams);
+
+  if (!myIsLoaded || nRays == 0)
+    return;
+
+  if (!myUseTessellation)
+  {
+    std::cerr << "Error: Triangle BVH not built - shape must be tessellated." << std::endl;
+    return;
+  }
 
-          gp_Lin rays[8];
-          for (int j = 0; j < 8; ++j)
-          {
-            if (j < batchSize)
-              rays[j] = theRays(theRays.Lower() + i + j);
-            else
-              rays[j] = rays[0];
-          }
+  auto startTime = std::chrono::high_resolution_clock::now();
 
-          Standard_Integer triIdx[8];
-          Standard_Real    hitT[8], baryU[8], baryV[8];
-          IntersectEmbree8(myEmbreeScene, rays, triIdx, hitT, baryU, baryV);
+  // Rays are processed in blocks, each block storing the refined hits of its rays
+  // contiguously; blocks are concatenated once the offsets are known
+  const Standard_Integer aBlockSize = 256;
+  const Standard_Integer nBlocks    = (nRays + aBlockSize - 1) / aBlockSize;
+  const Standard_Real    aMergeTol  = std::max(myTolerance, Precision::Confusion());
+  std::vector<std::vector<BRepIntCurveSurface_HitResult>> aBlockHits(nBlocks);
+  std::vector<Standard_Integer>                           aNbHits(nRays, 0);
+
+  // Thread-local surface adaptors and span caches (for thread-safe surface evaluation)
+  using ThreadLocalSurfaces = std::vector<ThreadLocalSurface>;
+  auto createLocalSurfaces  = [&]() -> ThreadLocalSurfaces {
+    ThreadLocalSurfaces surfaces(mySurfaceAdaptors.size());
+    for (size_t i = 0; i < mySurfaceAdaptors.size(); ++i)
+    {
+      surfaces[i].Adaptor = mySurfaceAdaptors[i]->ShallowCopy();
+      surfaces[i].Spline  = mySplineSurfaces[i];
+    }
+    return surfaces;
+  };
 
-          for (int j = 0; j < batchSize; ++j)
-          {
-            Standard_Integer idx = theRays.Lower() + i + j;
-            processRayHit(idx,
-                          triIdx[j],
-                          hitT[j],
-                          baryU[j],
-                          baryV[j],
-                          rays[j],
-                          localStats,
-                          localSurfaces);
-          }
-        }
-    #pragma omp critical
-        {
-          totalStats.faceTests += localStats.faceTests;
-          totalStats.newtonIters += localStats.newtonIters;
-          totalStats.newtonFailures += localStats.newtonFailures;
-          totalStats.refinementTimeNs += localStats.refinementTimeNs;
-        }
-      }
+  // Refine a triangle hit on its face; returns false for hits outside the loaded faces
+  auto refineHit = [&](Standard_Integer               idx,
+                       const gp_Lin&                  aRay,
+                       const TriangleHit&             aTriHit,
+                       ThreadLocalSurfaces&           localSurfaces,
+                       BRepIntCurveSurface_HitResult& aResult) -> Standard_Boolean {
+    Standard_Integer hitFaceIdx = -1;
+    Standard_Integer hitInstIdx = -1;
+    gp_Pnt2d         anInitUV, anUVMin, anUVMax;
+    if (!hitTriangle(aTriHit.TriIdx,
+                     aTriHit.U,
+                     aTriHit.V,
+                     aRay.Direction(),
+                     hitFaceIdx,
+                     hitInstIdx,
+                     anInitUV,
+                     anUVMin,
+                     anUVMax)
+        || hitFaceIdx < 0 || hitFaceIdx >= static_cast<Standard_Integer>(localSurfaces.size()))
+      return Standard_False;
+
+    Standard_Real initU = anInitUV.X();
+    Standard_Real initV = anInitUV.Y();
+
+    const ThreadLocalSurface&                  aLocal     = localSurfaces[hitFaceIdx];
+    const Adaptor3d_Surface&                   aSurface   = *aLocal.Adaptor;
+    const BRepIntCurveSurface_AnalyticSurface* anAnalytic = analyticSurface(hitFaceIdx);
+    Standard_Real                              finalU     = initU;
+    Standard_Real                              finalV     = initV;
+    Standard_Real                              finalT     = 0.0;
+    gp_Pnt                                     finalPnt;
+    Standard_Integer                           iterCount = 0;
+
+    NewtonResult newtonResult = RefineIntersection(aSurface,
+                                                   anAnalytic,
+                                                   aLocal.Spline,
+                                                   aRay.Location(),
+                                                   aRay.Direction(),
+                                                   aTriHit.T,
+                                                   anUVMin,
+                                                   anUVMax,
+                                                   finalU,
+                                                   finalV,
+                                                   finalT,
+                                                   finalPnt,
+                                                   iterCount,
+                                                   myTolerance,
+                                                   NEWTON_MAX_ITERATIONS);
+
+    aResult.IsValid = Standard_True;
+    if (newtonResult == NewtonResult::Converged && finalT >= aRanges.Min(idx)
+        && finalT <= aRanges.Max(idx))
+    {
+      aResult.Point = finalPnt;
+      aResult.U     = finalU;
+      aResult.V     = finalV;
+      aResult.W     = finalT;
     }
     else
-  #endif
     {
-      ThreadLocalStats    localStats;
-      ThreadLocalSurfaces localSurfaces = createLocalSurfaces();
-      for (Standard_Integer i = 0; i < nRays; i += 8)
-      {
-        Standard_Integer batchSize = std::min(8, nRays - i);
+      // Newton failed - use triangle intersection point directly
+      aResult.Point = aRay.Location().Translated(aTriHit.T * gp_Vec(aRay.Direction()));
+      aResult.U     = initU;
+      aResult.V     = initV;
+      aResult.W     = aTriHit.T;
+    }
 
-        gp_Lin rays[8];
-        for (int j = 0; j < 8; ++j)
-        {
-          if (j < batchSize)
-            rays[j] = theRays(theRays.Lower() + i + j);
-          else
-            rays[j] = rays[0];
-        }
+    aResult.FaceIndex     = hitFaceIdx + 1;
+    aResult.InstanceIndex = hitInstIdx + 1;
+    aResult.State         = TopAbs_IN;
+
+    // The transition needs the normal
+    const TopoDS_Face& aFace = TopoDS::Face(myFaces.FindKey(hitFaceIdx + 1));
+    ComputeHitGeometry<BRepIntCurveSurface_HitChannel_All>(aSurface,
+                                                           anAnalytic,
+                                                           aLocal.Spline,
+                                                           aFace.Orientation() == TopAbs_REVERSED,
+                                                           aResult);
+
+    // Entering along the normal direction of the face is an exit from the material
+    const Standard_Real aCos = aResult.Normal.Dot(aRay.Direction());
+    aResult.Transition       = aCos < -Precision::Angular()
+                                 ? IntCurveSurface_In
+                                 : (aCos > Precision::Angular() ? IntCurveSurface_Out
+                                                                : IntCurveSurface_Tangent);
+    return Standard_True;
+  };
 
-        Standard_Integer triIdx[8];
-        Standard_Real    hitT[8], baryU[8], baryV[8];
-        IntersectEmbree8(myEmbreeScene, rays, triIdx, hitT, baryU, baryV);
+  auto processBlock = [&](Standard_Integer          theBlock,
+                          ThreadLocalSurfaces&      localSurfaces,
+                          std::vector<TriangleHit>& aTriHits,
+                          long long&                theNodeTests) {
+    BRepIntCurveSurface_TriangleCountTraverser aTriTraverser;
+    aTriTraverser.SetTriangles(myTriangleRecords.data());
+    aTriTraverser.SetTrianglePackets(&myTrianglePackets);
+    aTriTraverser.SetFlatBVH(&myFlatBVH);
+    aTriTraverser.SetWideBVH(&myWideBVH);
+    aTriTraverser.SetInstances(&myInstances);
+    aTriTraverser.SetHitList(&aTriHits);
+    aTriTraverser.SetUniqueHits(myNbTriangleSplits > 0);
+
+    std::vector<BRepIntCurveSurface_HitResult>& aHits  = aBlockHits[theBlock];
+    const Standard_Integer                      aFirst = theBlock * aBlockSize;
+    const Standard_Integer                      aLast  = std::min(nRays, aFirst + aBlockSize);
+    for (Standard_Integer i = aFirst; i < aLast; ++i)
+    {
+      const Standard_Integer idx  = theRays.Lower() + i;
+      const gp_Lin&          aRay = theRays(idx);
 
-        for (int j = 0; j < batchSize; ++j)
-        {
-          Standard_Integer idx = theRays.Lower() + i + j;
-          processRayHit(idx,
-                        triIdx[j],
-                        hitT[j],
-                        baryU[j],
-                        baryV[j],
-                        rays[j],
-                        localStats,
-                        localSurfaces);
-        }
+      aTriHits.clear();
+      aTriTraverser.SetRay(aRay, aRanges.Min(idx), aRanges.Max(idx));
+      aTriTraverser.Select();
+
+      const size_t aRayFirstHit = aHits.size();
+      for (const TriangleHit& aTriHit : aTriHits)
+      {
+        BRepIntCurveSurface_HitResult aResult;
+        if (refineHit(idx, aRay, aTriHit, localSurfaces, aResult))
+          aHits.push_back(aResult);
+      }
+
+      // Sort by the refined parameter and keep one hit per coincident group
+      std::sort(aHits.begin() + aRayFirstHit,
+                aHits.end(),
+                [](const BRepIntCurveSurface_HitResult& theA,
+                   const BRepIntCurveSurface_HitResult& theB) { return theA.W < theB.W; });
+      size_t aNbKept = aRayFirstHit;
+      for (size_t k = aRayFirstHit; k < aHits.size(); ++k)
+      {
+        if (aNbKept == aRayFirstHit || aHits[k].W - aHits[aNbKept - 1].W > aMergeTol)
+          aHits[aNbKept++] = aHits[k];
+      }
+      aHits.resize(aNbKept);
+      aNbHits[i] = static_cast<Standard_Integer>(aNbKept - aRayFirstHit);
+    }
+    theNodeTests += aTriTraverser.GetNodeTestCount();
+  };
+
+  long long totalNodeTests = 0;
+#ifdef _OPENMP
+  if (myUseOpenMP)
+  {
+  #pragma omp parallel reduction(+ : totalNodeTests)
+    {
+      ThreadLocalSurfaces      localSurfaces = createLocalSurfaces();
+      std::vector<TriangleHit> aTriHits;
+  #pragma omp for schedule(dynamic, 1)
+      for (Standard_Integer b = 0; b < nBlocks; ++b)
+      {
+        processBlock(b, localSurfaces, aTriHits, totalNodeTests);
       }
-      totalStats = localStats;
     }
   }
+  else
 #endif
+  {
+    ThreadLocalSurfaces      localSurfaces = createLocalSurfaces();
+    std::vector<TriangleHit> aTriHits;
+    for (Standard_Integer b = 0; b < nBlocks; ++b)
+    {
+      processBlock(b, localSurfaces, aTriHits, totalNodeTests);
+    }
+  }
 
-  // Print debug stats (using thread-local accumulated stats, no atomic contention)
-  auto   endTime  = std::chrono::high_resolution_clock::now();
-  double totalSec = std::chrono::duration<double>(endTime - startTime).count();
-
-  std::cout << "  Total time: " << std::fixed << std::setprecision(2) << totalSec << "s, "
-            << std::setprecision(0) << (nRays / totalSec) << " rays/sec" << std::endl;
-  std::cout << "  [DEBUG] Triangle BVH node tests: " << totalStats.nodeTests << " ("
-            << (double)totalStats.nodeTests / nRays << " per ray)" << std::endl;
-  std::cout << "  [DEBUG] Face intersection tests: " << totalStats.faceTests << " ("
-            << (double)totalStats.faceTests / nRays << " per ray)" << std::endl;
-  if (totalStats.faceTests > 0)
+  // Offsets from the per-ray hit counts, then concatenate the block hits
+  for (Standard_Integer i = 0; i < nRays; ++i)
   {
-    std::cout << "  [DEBUG] Surface refinement time: " << totalStats.refinementTimeNs / 1000000.0
-              << " ms (" << (double)totalStats.refinementTimeNs / totalStats.faceTests / 1000.0
-              << " us per call)" << std::endl;
+    theOffsets(theRays.Lower() + i + 1) = theOffsets(theRays.Lower() + i) + aNbHits[i];
   }
-  if (totalStats.newtonIters > 0)
+  const Standard_Integer nHits = theOffsets(theOffsets.Upper()) - 1;
+  theHits.Resize(1, nHits, Standard_False);
+  for (Standard_Integer b = 0; b < nBlocks; ++b)
   {
-    std::cout << "  [DEBUG] Newton iterations: " << totalStats.newtonIters << " ("
-              << (double)totalStats.newtonIters / totalStats.faceTests << " per hit)" << std::endl;
+    Standard_Integer aHitIdx = theOffsets(theRays.Lower() + b * aBlockSize);
+    for (const BRepIntCurveSurface_HitResult& aHit : aBlockHits[b])
+    {
+      theHits(aHitIdx++) = aHit;
+    }
+    std::vector<BRepIntCurveSurface_HitResult>().swap(aBlockHits[b]);
   }
-  if (totalStats.newtonFailures > 0)
+
+  auto   endTime  = std::chrono::high_resolution_clock::now();
+  double totalSec = std::chrono::duration<double>(endTime - startTime).count();
+  std::cout << "  All-hits time: " << std::fixed << std::setprecision(2) << totalSec << "s, "
+            << std::setprecision(0) << (nRays / totalSec) << " rays/sec" << std::endl;
+  std::cout << "  [DEBUG] Triangle BVH node tests: " << totalNodeTests << " ("
+            << std::setprecision(1) << (double)totalNodeTests / nRays << " per ray)" << std::endl;
+  std::cout << "  [DEBUG] Hits: " << nHits << " (" << std::setprecision(2)
+            << (double)nHits / nRays << " per ray)" << std::endl;
+}
+
+//=================================================================================================
+
+Standard_Boolean BRepIntCurveSurface_InterBVH::PerformOcclusion(const gp_Lin&       theLine,
+                                                                const Standard_Real theMin,
+                                                                const Standard_Real theMax) const
+{
+  if (!myIsLoaded || !myUseTessellation)
+    return Standard_False;
+
+#ifdef OCCT_USE_EMBREE
+  if (myBackend != BRepIntCurveSurface_BVHBackend::OCCT_BVH && myEmbreeScene)
   {
-    std::cout << "  [DEBUG] Newton refinement failures: " << totalStats.newtonFailures
-              << " (used triangle fallback)" << std::endl;
+    return OccludedEmbree1(myEmbreeScene, theLine, theMin, theMax);
   }
+#endif
+
+  BRepIntCurveSurface_TriangleCountTraverser aTriTraverser;
+  aTriTraverser.SetTriangles(myTriangleRecords.data());
+  aTriTraverser.SetTrianglePackets(&myTrianglePackets);
+  aTriTraverser.SetFlatBVH(&myFlatBVH);
+  aTriTraverser.SetWideBVH(&myWideBVH);
+  aTriTraverser.SetInstances(&myInstances);
+  aTriTraverser.SetMaxHitCount(1);
+  aTriTraverser.SetRay(theLine, theMin, theMax);
+  aTriTraverser.Select();
+  return aTriTraverser.GetHitCount() > 0;
 }
 
 //=================================================================================================
 
-void BRepIntCurveSurface_InterBVH::PerformBatchCount(
+void BRepIntCurveSurface_InterBVH::PerformBatchOcclusion(
   const NCollection_Array1<gp_Lin>&     theRays,
-  NCollection_Array1<Standard_Integer>& theHitCounts,
-  const Standard_Integer                theNumThreads)
+  NCollection_Array1<Standard_Boolean>& theOccluded,
+  const Standard_Real                   theMin,
+  const Standard_Real                   theMax,
+  const Standard_Integer                theNumThreads) const
 {
-  if (!myIsLoaded)
+  (void)theNumThreads; // Will be used for manual thread control if needed
+  if (!IsValidRayRange(theMin, theMax))
   {
-    theHitCounts.Resize(theRays.Lower(), theRays.Upper(), Standard_False);
-    for (Standard_Integer i = theHitCounts.Lower(); i <= theHitCounts.Upper(); ++i)
-      theHitCounts(i) = 0;
-    return;
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::PerformBatchOcclusion - negative or empty ray interval");
   }
+  performBatchOcclusion(theRays, nullptr, nullptr, theMin, theMax, theOccluded);
+}
 
-  Standard_Integer nRays = theRays.Length();
-  theHitCounts.Resize(theRays.Lower(), theRays.Lower() + nRays - 1, Standard_False);
+//=================================================================================================
 
-  // Initialize counts
-  for (Standard_Integer i = theHitCounts.Lower(); i <= theHitCounts.Upper(); ++i)
+void BRepIntCurveSurface_InterBVH::PerformBatchOcclusion(
+  const NCollection_Array1<gp_Lin>&        theRays,
+  const NCollection_Array1<Standard_Real>& theMinParams,
+  const NCollection_Array1<Standard_Real>& theMaxParams,
+  NCollection_Array1<Standard_Boolean>&    theOccluded,
+  const Standard_Integer                   theNumThreads) const
+{
+  (void)theNumThreads; // Will be used for manual thread control if needed
+  if (theMinParams.Length() != theRays.Length() || theMaxParams.Length() != theRays.Length())
   {
-    theHitCounts(i) = 0;
+    throw Standard_DimensionMismatch(
+      "BRepIntCurveSurface_InterBVH::PerformBatchOcclusion - parameter arrays must match the rays");
+  }
+  if (!AreValidRayRanges(theMinParams, theMaxParams))
+  {
+    throw Standard_OutOfRange(
+      "BRepIntCurveSurface_InterBVH::PerformBatchOcclusion - negative or empty ray interval");
   }
+  performBatchOcclusion(theRays, &theMinParams, &theMaxParams, 0.0, RealLast(), theOccluded);
+}
 
-  // Progress tracking
-  Standard_Integer lastProgress = 0;
-  auto             startTime    = std::chrono::high_resolution_clock::now();
+//=================================================================================================
 
-  // Use tessellation-accelerated path
-  if (myTriBVH.IsNull())
+void BRepIntCurveSurface_InterBVH::performBatchOcclusion(
+  const NCollection_Array1<gp_Lin>&        theRays,
+  const NCollection_Array1<Standard_Real>* theMinParams,
+  const NCollection_Array1<Standard_Real>* theMaxParams,
+  const Standard_Real                      theMin,
+  const Standard_Real                      theMax,
+  NCollection_Array1<Standard_Boolean>&    theOccluded) const
+{
+
+  const Standard_Integer nRays = theRays.Length();
+  theOccluded.Resize(theRays.Lower(), theRays.Lower() + nRays - 1, Standard_False);
+
+  const BatchRayRanges aRanges(theRays, theMinParams, theMaxParams, theMin, theMax);
+  for (Standard_Integer i = theOccluded.Lower(); i <= theOccluded.Upper(); ++i)
+  {
+    theOccluded(i) = Standard_False;
+  }
+
+  if (!myIsLoaded || nRays == 0)
+    return;
+
+  if (!myUseTessellation)
   {
     std::cerr << "Error: Triangle BVH not built - shape must be tessellated." << std::endl;
     return;
   }
 
-  std::cout << "  Using tessellation-accelerated intersection counting..." << std::endl;
-
-  // Thread-local node test accumulator
-  long long totalNodeTests = 0;
+  auto startTime = std::chrono::high_resolution_clock::now();
 
-  // Single-threaded triangle BVH traversal (can be parallelized later)
-  for (Standard_Integer i = 0; i < nRays; ++i)
+#ifdef OCCT_USE_EMBREE
+  if (myBackend != BRepIntCurveSurface_BVHBackend::OCCT_BVH && myEmbreeScene)
   {
-    Standard_Integer idx  = theRays.Lower() + i;
-    const gp_Lin&    aRay = theRays(idx);
+    // Rays are tested in groups of 1, 4 or 8 depending on the Embree backend
+    const Standard_Integer aGroupSize =
+      myBackend == BRepIntCurveSurface_BVHBackend::Embree_SIMD8
+        ? 8
+        : (myBackend == BRepIntCurveSurface_BVHBackend::Embree_SIMD4 ? 4 : 1);
+    const Standard_Integer nGroups = (nRays + aGroupSize - 1) / aGroupSize;
+
+    auto processGroup = [&](Standard_Integer theGroup) {
+      const Standard_Integer aFirst    = theRays.Lower() + theGroup * aGroupSize;
+      const Standard_Integer aNbRays   = std::min(aGroupSize, theRays.Upper() - aFirst + 1);
+      Standard_Boolean       anOccl[8] = {};
+      Standard_Real          aMins[8], aMaxs[8];
+      for (Standard_Integer j = 0; j < aNbRays; ++j)
+      {
+        aMins[j] = aRanges.Min(aFirst + j);
+        aMaxs[j] = aRanges.Max(aFirst + j);
+      }
+      if (aGroupSize == 8)
+      {
+        OccludedEmbree8(myEmbreeScene, &theRays(aFirst), aNbRays, aMins, aMaxs, anOccl);
+      }
+      else if (aGroupSize == 4)
+      {
+        OccludedEmbree4(myEmbreeScene, &theRays(aFirst), aNbRays, aMins, aMaxs, anOccl);
+      }
+      else
+      {
+        anOccl[0] = OccludedEmbree1(myEmbreeScene, theRays(aFirst), aMins[0], aMaxs[0]);
+      }
+      for (Standard_Integer j = 0; j < aNbRays; ++j)
+      {
+        theOccluded(aFirst + j) = anOccl[j];
+      }
+    };
+
+  #ifdef _OPENMP
+    if (myUseOpenMP)
+    {
+    #pragma omp parallel for schedule(dynamic, 64)
+      for (Standard_Integer g = 0; g < nGroups; ++g)
+      {
+        processGroup(g);
+      }
+    }
+    else
+  #endif
+    {
+      for (Standard_Integer g = 0; g < nGroups; ++g)
+      {
+        processGroup(g);
+      }
+    }
+
+    auto   endTime  = std::chrono::high_resolution_clock::now();
+    double totalSec = std::chrono::duration<double>(endTime - startTime).count();
+    std::cout << "  Occlusion time: " << std::fixed << std::setprecision(2) << totalSec << "s, "
+              << std::setprecision(0) << (nRays / totalSec) << " rays/sec" << std::endl;
+    return;
+  }
+#endif
+
+  // OCCT BVH backend: traversal stops at the first triangle hit
+  long long totalNodeTests = 0;
 
-    // Use the triangle count traverser (counts ALL triangle hits)
+  auto processRay = [&](Standard_Integer theIdx, long long& theNodeTests) {
     BRepIntCurveSurface_TriangleCountTraverser aTriTraverser;
-    aTriTraverser.SetTriBVH(myTriBVH.get());
-    aTriTraverser.SetTriangleInfo(&myTriangleInfo);
-    aTriTraverser.SetRay(aRay, 0.0, RealLast());
+    aTriTraverser.SetTriangles(myTriangleRecords.data());
+    aTriTraverser.SetTrianglePackets(&myTrianglePackets);
+    aTriTraverser.SetFlatBVH(&myFlatBVH);
+    aTriTraverser.SetWideBVH(&myWideBVH);
+    aTriTraverser.SetInstances(&myInstances);
+    aTriTraverser.SetMaxHitCount(1);
+    aTriTraverser.SetRay(theRays(theIdx), aRanges.Min(theIdx), aRanges.Max(theIdx));
     aTriTraverser.Select();
 
-    theHitCounts(idx) = aTriTraverser.GetHitCount();
-    totalNodeTests += aTriTraverser.GetNodeTestCount();
+    theOccluded(theIdx) = aTriTraverser.GetHitCount() > 0;
+    theNodeTests += aTriTraverser.GetNodeTestCount();
+  };
 
-    // Print progress every 5%
-    Standard_Integer currentProgress = (i + 1) * 100 / nRays;
-    if (currentProgress >= lastProgress + 5)
+#ifdef _OPENMP
+  if (myUseOpenMP)
+  {
+  #pragma omp parallel for schedule(dynamic, 64) reduction(+ : totalNodeTests)
+    for (Standard_Integer i = 0; i < nRays; ++i)
     {
-      auto   now     = std::chrono::high_resolution_clock::now();
-      double elapsed = std::chrono::duration<double>(now - startTime).count();
-      std::cout << "  Progress: " << currentProgress << "% (" << std::fixed << std::setprecision(1)
-                << elapsed << "s)" << std::endl;
-      lastProgress = currentProgress;
+      processRay(theRays.Lower() + i, totalNodeTests);
+    }
+  }
+  else
+#endif
+  {
+    for (Standard_Integer i = 0; i < nRays; ++i)
+    {
+      processRay(theRays.Lower() + i, totalNodeTests);
     }
   }
 
-  // Print debug stats
-  std::cout << "  [DEBUG] Triangle BVH node tests: " << totalNodeTests << " (" << std::fixed
+  auto   endTime  = std::chrono::high_resolution_clock::now();
+  double totalSec = std::chrono::duration<double>(endTime - startTime).count();
+  std::cout << "  Occlusion time: " << std::fixed << std::setprecision(2) << totalSec << "s, "
+            << std::setprecision(0) << (nRays / totalSec) << " rays/sec" << std::endl;
+  std::cout << "  [DEBUG] Triangle BVH node tests: " << totalNodeTests << " ("
             << std::setprecision(1) << (double)totalNodeTests / nRays << " per ray)" << std::endl;
 }
 
@@ -2189,3 +5891,70 @@ Standard_Integer BRepIntCurveSurface_InterBVH::FaceIndex(const Standard_Integer
     throw Standard_OutOfRange("BRepIntCurveSurface_InterBVH::FaceIndex - index out of range");
   return myResults[theIndex - 1].FaceIndex;
 }
+
+//=================================================================================================
+
+Standard_Integer BRepIntCurveSurface_InterBVH::InstanceIndex(const Standard_Integer theIndex) const
+{
+  if (theIndex < 1 || theIndex > myNbPnt)
+    throw Standard_OutOfRange("BRepIntCurveSurface_InterBVH::InstanceIndex - index out of range");
+  return myResults[theIndex - 1].InstanceIndex;
+}
+
+//=================================================================================================
+
+BRepIntCurveSurface_MemoryUsage BRepIntCurveSurface_InterBVH::MemoryUsage() const
+{
+  BRepIntCurveSurface_MemoryUsage aUsage;
+  if (!myTriBVH.IsNull())
+  {
+    aUsage.Vertices = myTriBVH->Vertices.capacity() * sizeof(BVH_Vec3d);
+    aUsage.Elements = myTriBVH->Elements.capacity() * sizeof(BVH_Vec4i);
+
+    // The tree is not built when the nodes were read from the BVH cache
+    if (!myTriBVH->IsDirty() && !myTriBVH->BVH().IsNull())
+    {
+      aUsage.Nodes = static_cast<Standard_Size>(myTriBVH->BVH()->Length())
+                     * (2 * sizeof(BVH_Vec3d) + sizeof(BVH_Vec4i));
+    }
+  }
+  aUsage.Nodes += myFlatBVH.MemorySize() + myWideBVH.MemorySize();
+  aUsage.Triangles = myTriangleRecords.capacity() * sizeof(BRepIntCurveSurface_TriangleRecord)
+                     + myTrianglePackets.MemorySize();
+  aUsage.TriangleInfo = myTriangleInfo.capacity() * sizeof(BRepIntCurveSurface_TriangleInfo);
+  aUsage.UVNodes      = myTriangleUVs.MemorySize();
+
+  aUsage.SurfaceAdaptors = mySurfaceAdaptors.capacity() * sizeof(Handle(BRepAdaptor_Surface));
+  for (const Handle(BRepAdaptor_Surface)& anAdaptor : mySurfaceAdaptors)
+  {
+    if (!anAdaptor.IsNull())
+      aUsage.SurfaceAdaptors += sizeof(BRepAdaptor_Surface);
+  }
+  aUsage.SurfaceAdaptors +=
+    myAnalyticSurfaces.capacity() * sizeof(BRepIntCurveSurface_AnalyticSurface)
+    + mySplineSurfaces.capacity() * sizeof(BRepIntCurveSurface_SplineSurface);
+  for (const BRepIntCurveSurface_SplineSurface& aSpline : mySplineSurfaces)
+  {
+    aUsage.SurfaceAdaptors += aSpline.MemorySize();
+  }
+
+  aUsage.UpdateTables = myFaceTriangles.capacity() * sizeof(std::vector<Standard_Integer>)
+                        + (myFreeTriangles.capacity() + myTriangleRefOffsets.capacity()
+                           + myTriangleRefs.capacity())
+                            * sizeof(Standard_Integer);
+  for (const std::vector<Standard_Integer>& aSlots : myFaceTriangles)
+  {
+    aUsage.UpdateTables += aSlots.capacity() * sizeof(Standard_Integer);
+  }
+  aUsage.Instances = myInstances.MemorySize();
+
+#ifdef OCCT_USE_EMBREE
+  // Buffers shared with Embree; its own BVH is not reported by the device
+  if (myEmbreeScene)
+  {
+    aUsage.Embree = myEmbreeVertices.capacity() * sizeof(float)
+                    + myEmbreeIndices.capacity() * sizeof(Standard_Integer);
+  }
+#endif
+  return aUsage;
+}
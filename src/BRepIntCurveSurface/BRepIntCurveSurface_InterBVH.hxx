@@ -29,11 +29,23 @@
 #include <TopoDS_Shape.hxx>
 #include <TopoDS_Face.hxx>
 #include <TopTools_IndexedMapOfShape.hxx>
+#include <TCollection_AsciiString.hxx>
 #include <IntCurveSurface_TransitionOnCurve.hxx>
 #include <TopAbs_State.hxx>
 #include <NCollection_Array1.hxx>
 #include <BRepAdaptor_Surface.hxx>
 
+#include <BRepIntCurveSurface_AnalyticSurface.hxx>
+#include <BRepIntCurveSurface_BVHStatistics.hxx>
+#include <BRepIntCurveSurface_FlatBVH.hxx>
+#include <BRepIntCurveSurface_InstanceSet.hxx>
+#include <BRepIntCurveSurface_SplineSurface.hxx>
+#include <BRepIntCurveSurface_TrianglePackets.hxx>
+#include <BRepIntCurveSurface_TriangleUVs.hxx>
+#include <BRepIntCurveSurface_WideBVH.hxx>
+
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 #ifdef OCCT_USE_EMBREE
@@ -47,6 +59,7 @@
 #endif
 
 class BRepIntCurveSurface_InterBVH;
+class BRepIntCurveSurface_BVHCache;
 
 //! Backend selection for ray-triangle intersection
 enum class BRepIntCurveSurface_BVHBackend
@@ -57,28 +70,89 @@ enum class BRepIntCurveSurface_BVHBackend
   Embree_SIMD8   //!< Embree rtcIntersect8 (AVX, 8 rays at once)
 };
 
+//! Construction algorithm of the triangle BVH (OCCT_BVH backend)
+enum class BRepIntCurveSurface_BVHBuilder
+{
+  Linear,    //!< BVH_LinearBuilder: Morton-code LBVH, fastest build
+  BinnedSAH, //!< BVH_BinnedBuilder: SAH evaluated over 32 bins per axis
+  SweepSAH   //!< BVH_SweepPlaneBuilder: exact SAH over all sorted split planes, slowest build
+};
+
+//! Optional fields of BRepIntCurveSurface_HitResult computed by PerformBatch(). Point,
+//! UV, ray parameter and face of a hit are always computed; the point needs no surface
+//! evaluation, the normal the first derivatives, curvatures and the Hessian the second
+//! ones. Curvatures also set the normal.
+enum BRepIntCurveSurface_HitChannel
+{
+  BRepIntCurveSurface_HitChannel_Point     = 0x00, //!< Point, UV, ray parameter and face only
+  BRepIntCurveSurface_HitChannel_Normal    = 0x01, //!< Surface normal
+  BRepIntCurveSurface_HitChannel_Curvature = 0x02, //!< Gaussian, mean and principal curvatures
+  BRepIntCurveSurface_HitChannel_Hessian   = 0x04, //!< Height-field Hessian
+  BRepIntCurveSurface_HitChannel_All       = 0x07  //!< All fields
+};
+
+//! Bit mask of BRepIntCurveSurface_HitChannel values
+typedef Standard_Integer BRepIntCurveSurface_HitChannels;
+
 //! Typedef for triangle BVH
 typedef BVH_Triangulation<Standard_Real, 3> BRepIntCurveSurface_TriBVH;
 
-//! Structure mapping a triangle to its source face and UV coordinates
+//! Structure mapping a triangle to its source face and the UV nodes of its corners
 struct BRepIntCurveSurface_TriangleInfo
 {
-  Standard_Integer FaceIndex;     //!< 0-based index into myFaces
-  gp_Pnt2d         UV0, UV1, UV2; //!< UV coordinates of triangle vertices on the face
+  Standard_Integer FaceIndex;  //!< 0-based index into myFaces
+  Standard_Integer UVNodes[3]; //!< Corner nodes in the UV node table
+};
+
+//! Memory held by a loaded shape in bytes, per data structure
+struct BRepIntCurveSurface_MemoryUsage
+{
+  Standard_Size Vertices;        //!< Welded vertices of the triangle BVH
+  Standard_Size Elements;        //!< Triangle corners of the BVH primitives
+  Standard_Size Nodes;           //!< BVH tree, flattened and wide nodes
+  Standard_Size Triangles;       //!< Leaf-order triangle records and SIMD packets
+  Standard_Size TriangleInfo;    //!< Face and UV node indices per triangle
+  Standard_Size UVNodes;         //!< UV node table
+  Standard_Size SurfaceAdaptors; //!< Surface adaptors, elementary and spline surfaces
+  Standard_Size UpdateTables;    //!< Face slots and primitive references of UpdateFaces()
+  Standard_Size Instances;       //!< Prototypes and top-level BVH of instancing
+  Standard_Size Embree;          //!< Vertex and index buffers of the Embree geometry
+
+  BRepIntCurveSurface_MemoryUsage()
+      : Vertices(0),
+        Elements(0),
+        Nodes(0),
+        Triangles(0),
+        TriangleInfo(0),
+        UVNodes(0),
+        SurfaceAdaptors(0),
+        UpdateTables(0),
+        Instances(0),
+        Embree(0)
+  {
+  }
+
+  //! Returns the sum of all entries
+  Standard_Size Total() const
+  {
+    return Vertices + Elements + Nodes + Triangles + TriangleInfo + UVNodes + SurfaceAdaptors
+           + UpdateTables + Instances + Embree;
+  }
 };
 
 //! Structure to hold a single ray-surface hit result
 struct BRepIntCurveSurface_HitResult
 {
-  Standard_Boolean                  IsValid;    //!< True if hit is valid
-  gp_Pnt                            Point;      //!< Hit point in 3D
-  Standard_Real                     U;          //!< U parameter on surface
-  Standard_Real                     V;          //!< V parameter on surface
-  Standard_Real                     W;          //!< Parameter on ray (distance from origin)
-  Standard_Integer                  FaceIndex;  //!< Index of hit face (1-based)
-  gp_Dir                            Normal;     //!< Surface normal at hit point
-  IntCurveSurface_TransitionOnCurve Transition; //!< Transition type
-  TopAbs_State                      State;      //!< State (IN or ON)
+  Standard_Boolean                  IsValid;       //!< True if hit is valid
+  gp_Pnt                            Point;         //!< Hit point in 3D
+  Standard_Real                     U;             //!< U parameter on surface
+  Standard_Real                     V;             //!< V parameter on surface
+  Standard_Real                     W;             //!< Parameter on ray (distance from origin)
+  Standard_Integer                  FaceIndex;     //!< Index of hit face (1-based)
+  Standard_Integer                  InstanceIndex; //!< Hit part instance (1-based, 0 if none)
+  gp_Dir                            Normal;        //!< Surface normal at hit point
+  IntCurveSurface_TransitionOnCurve Transition;    //!< Transition type
+  TopAbs_State                      State;         //!< State (IN or ON)
 
   // Curvature fields (computed when requested)
   Standard_Real GaussianCurvature; //!< Gaussian curvature K = κ1 × κ2
@@ -98,6 +172,7 @@ struct BRepIntCurveSurface_HitResult
         V(0.0),
         W(RealLast()),
         FaceIndex(0),
+        InstanceIndex(0),
         Transition(IntCurveSurface_Tangent),
         State(TopAbs_UNKNOWN),
         GaussianCurvature(0.0),
@@ -156,6 +231,52 @@ public:
                             const Standard_Real theTol,
                             const Standard_Real theDeflection = 0.0);
 
+  //! Tessellate a shape and load it, overlapping meshing with the BVH build.
+  //! Parts of the shape that share no face or edge are meshed concurrently (the faces
+  //! of a single part in parallel by BRepMesh), and the triangles of every part are
+  //! gathered as soon as the part is meshed, while other parts are still meshed.
+  //! Existing triangulations meeting the deflection are kept.
+  //! @param theShape Shape to intersect with (must contain faces)
+  //! @param theTol Tolerance for intersection calculations
+  //! @param theDeflection Linear deflection of the tessellation (defaults to 0.1 if <= 0)
+  //! @param theAngle Angular deflection of the tessellation in radians
+  Standard_EXPORT void MeshAndLoad(const TopoDS_Shape& theShape,
+                                   const Standard_Real theTol,
+                                   const Standard_Real theDeflection = 0.0,
+                                   const Standard_Real theAngle      = 0.5);
+
+  //! Replace loaded face theIndex (1-based) by theFace on the next UpdateFaces();
+  //! hits on the new face report the same index. The face must be tessellated.
+  //! @throw Standard_OutOfRange if theIndex is not a loaded or added face
+  //! @throw Standard_ProgramError if theFace is already loaded or pending
+  Standard_EXPORT void ReplaceFace(const Standard_Integer theIndex, const TopoDS_Face& theFace);
+
+  //! Append a tessellated face on the next UpdateFaces().
+  //! @return the index the face will have
+  //! @throw Standard_ProgramError if theFace is already loaded or pending
+  Standard_EXPORT Standard_Integer AddFace(const TopoDS_Face& theFace);
+
+  //! Remove face theIndex on the next UpdateFaces(); the index stays reserved
+  //! and is never reported by a hit.
+  //! @throw Standard_OutOfRange if theIndex is not a loaded or added face
+  Standard_EXPORT void RemoveFace(const Standard_Integer theIndex);
+
+  //! Apply the face edits made since the last Load() or UpdateFaces().
+  //! Triangles of the edited faces are written into the slots their faces held (or
+  //! slots freed by removed faces) and the BVH boxes above them are refitted, so
+  //! the cost is proportional to the edit. The triangle BVH is rebuilt instead,
+  //! reusing the tessellation and surface adaptors of unchanged faces, when there
+  //! are not enough free slots or when refitted slots would degrade the tree.
+  //! Other faces keep their indices; GetBVHStatistics() describes the last build.
+  //! @return true if the BVH was refitted, false if it was rebuilt
+  Standard_EXPORT Standard_Boolean UpdateFaces();
+
+  //! Check if face theIndex (1-based) was removed by UpdateFaces()
+  Standard_Boolean IsFaceRemoved(const Standard_Integer theIndex) const
+  {
+    return myIsFaceRemoved[theIndex - 1];
+  }
+
   //! Perform intersection with a single ray (line).
   //! Results can be accessed via IsDone(), NbPnt(), Pnt(), etc.
   //! @param theLine Ray to intersect
@@ -169,9 +290,33 @@ public:
   //! @param theRays Array of rays to intersect
   //! @param theResults Output array of hit results (resized automatically)
   //! @param theNumThreads Number of threads (0 = auto)
+  //! @param theChannels Optional result fields to compute (BRepIntCurveSurface_HitChannel
+  //!        mask); the others keep their default values
   Standard_EXPORT void PerformBatch(const NCollection_Array1<gp_Lin>&                  theRays,
                                     NCollection_Array1<BRepIntCurveSurface_HitResult>& theResults,
-                                    const Standard_Integer theNumThreads = 0);
+                                    const Standard_Integer theNumThreads = 0,
+                                    const BRepIntCurveSurface_HitChannels theChannels =
+                                      BRepIntCurveSurface_HitChannel_All);
+
+  //! Perform batch intersection of ray segments (parallelized): ray i only reports a hit
+  //! within [theMinParams(i), theMaxParams(i)], and BVH nodes outside of that interval
+  //! are not traversed. The parameter arrays are indexed like theRays (same length).
+  //! @param theRays Array of rays to intersect
+  //! @param theMinParams Minimum parameter on each ray
+  //! @param theMaxParams Maximum parameter on each ray
+  //! @param theResults Output array of hit results (resized automatically)
+  //! @param theNumThreads Number of threads (0 = auto)
+  //! @param theChannels Optional result fields to compute (BRepIntCurveSurface_HitChannel
+  //!        mask); the others keep their default values
+  //! @throw Standard_DimensionMismatch if the parameter arrays do not match theRays
+  //! @throw Standard_OutOfRange if a minimum is negative or greater than its maximum
+  Standard_EXPORT void PerformBatch(const NCollection_Array1<gp_Lin>&                  theRays,
+                                    const NCollection_Array1<Standard_Real>&           theMinParams,
+                                    const NCollection_Array1<Standard_Real>&           theMaxParams,
+                                    NCollection_Array1<BRepIntCurveSurface_HitResult>& theResults,
+                                    const Standard_Integer theNumThreads = 0,
+                                    const BRepIntCurveSurface_HitChannels theChannels =
+                                      BRepIntCurveSurface_HitChannel_All);
 
   //! Perform batch intersection counting all hits per ray (not just closest).
   //! @param theRays Array of rays to intersect
@@ -181,6 +326,82 @@ public:
                                          NCollection_Array1<Standard_Integer>& theHitCounts,
                                          const Standard_Integer                theNumThreads = 0);
 
+  //! Perform batch hit counting of ray segments: only the hits of ray i within
+  //! [theMinParams(i), theMaxParams(i)] are counted (see PerformBatch()).
+  //! @throw Standard_DimensionMismatch if the parameter arrays do not match theRays
+  //! @throw Standard_OutOfRange if a minimum is negative or greater than its maximum
+  Standard_EXPORT void PerformBatchCount(const NCollection_Array1<gp_Lin>&        theRays,
+                                         const NCollection_Array1<Standard_Real>& theMinParams,
+                                         const NCollection_Array1<Standard_Real>& theMaxParams,
+                                         NCollection_Array1<Standard_Integer>&    theHitCounts,
+                                         const Standard_Integer theNumThreads = 0);
+
+  //! Perform batch intersection returning every hit along each ray (not just the closest).
+  //! Each triangle hit is Newton-refined on its face like in PerformBatch(). The hits of a
+  //! ray are sorted by W and coincident hits (closer than the tolerance, e.g. on an edge
+  //! shared by two triangles or faces) are reported once. Transition is In or Out by the
+  //! sign of the ray direction along the face normal (Tangent when orthogonal).
+  //! The output is in compressed sparse row form: the hits of ray i are
+  //! theHits(theOffsets(i)) .. theHits(theOffsets(i + 1) - 1).
+  //! @param theRays Array of rays to intersect
+  //! @param theOffsets Output array of offsets into theHits, bounds [Lower(), Upper() + 1]
+  //!        of theRays
+  //! @param theHits Output array of the hits of all rays, 1-based
+  //! @param theNumThreads Number of threads (0 = auto)
+  Standard_EXPORT void PerformBatchAllHits(
+    const NCollection_Array1<gp_Lin>&                  theRays,
+    NCollection_Array1<Standard_Integer>&              theOffsets,
+    NCollection_Array1<BRepIntCurveSurface_HitResult>& theHits,
+    const Standard_Integer                             theNumThreads = 0);
+
+  //! Perform the all-hits query on ray segments: only the hits of ray i within
+  //! [theMinParams(i), theMaxParams(i)] are reported (see PerformBatch()).
+  //! @throw Standard_DimensionMismatch if the parameter arrays do not match theRays
+  //! @throw Standard_OutOfRange if a minimum is negative or greater than its maximum
+  Standard_EXPORT void PerformBatchAllHits(
+    const NCollection_Array1<gp_Lin>&                  theRays,
+    const NCollection_Array1<Standard_Real>&           theMinParams,
+    const NCollection_Array1<Standard_Real>&           theMaxParams,
+    NCollection_Array1<Standard_Integer>&              theOffsets,
+    NCollection_Array1<BRepIntCurveSurface_HitResult>& theHits,
+    const Standard_Integer                             theNumThreads = 0);
+
+  //! Test a single ray for occlusion (any-hit query).
+  //! The traversal stops at the first triangle hit within [theMin, theMax]; no surface
+  //! refinement, normal or curvature is computed and the single-ray results are untouched.
+  //! @param theLine Ray to test
+  //! @param theMin Minimum parameter on ray (default 0)
+  //! @param theMax Maximum parameter on ray (default infinite)
+  //! @return true if the ray hits the tessellation within [theMin, theMax]
+  Standard_EXPORT Standard_Boolean PerformOcclusion(const gp_Lin&       theLine,
+                                                    const Standard_Real theMin = 0.0,
+                                                    const Standard_Real theMax = RealLast()) const;
+
+  //! Perform batch occlusion tests (any-hit queries, parallelized).
+  //! Uses rtcOccluded1/4/8 with the Embree backends and an early-terminating traversal
+  //! with the OCCT_BVH backend.
+  //! @param theRays Array of rays to test
+  //! @param theOccluded Output array, true where the ray hits within [theMin, theMax]
+  //! @param theMin Minimum parameter on the rays (default 0)
+  //! @param theMax Maximum parameter on the rays (default infinite)
+  //! @param theNumThreads Number of threads (0 = auto)
+  //! @throw Standard_OutOfRange if theMin is negative or greater than theMax
+  Standard_EXPORT void PerformBatchOcclusion(const NCollection_Array1<gp_Lin>&     theRays,
+                                             NCollection_Array1<Standard_Boolean>& theOccluded,
+                                             const Standard_Real    theMin        = 0.0,
+                                             const Standard_Real    theMax        = RealLast(),
+                                             const Standard_Integer theNumThreads = 0) const;
+
+  //! Perform batch occlusion tests of ray segments: ray i is tested within
+  //! [theMinParams(i), theMaxParams(i)] (see PerformBatch()).
+  //! @throw Standard_DimensionMismatch if the parameter arrays do not match theRays
+  //! @throw Standard_OutOfRange if a minimum is negative or greater than its maximum
+  Standard_EXPORT void PerformBatchOcclusion(const NCollection_Array1<gp_Lin>&        theRays,
+                                             const NCollection_Array1<Standard_Real>& theMinParams,
+                                             const NCollection_Array1<Standard_Real>& theMaxParams,
+                                             NCollection_Array1<Standard_Boolean>&    theOccluded,
+                                             const Standard_Integer theNumThreads = 0) const;
+
   //! Returns true if intersection was performed successfully
   Standard_Boolean IsDone() const { return myIsDone; }
 
@@ -239,7 +460,8 @@ public:
   //! Returns true if the shape has been loaded and BVH built
   Standard_Boolean IsLoaded() const { return myIsLoaded; }
 
-  //! Returns the number of faces in the loaded shape
+  //! Returns the number of faces in the loaded shape, including faces added and
+  //! removed by UpdateFaces()
   Standard_Integer NbFaces() const { return myFaces.Extent(); }
 
   //! Set the BVH backend for ray-triangle intersection
@@ -255,6 +477,248 @@ public:
   //! Check if OpenMP parallelization is enabled
   Standard_Boolean GetUseOpenMP() const { return myUseOpenMP; }
 
+  //! Store flattened BVH node bounds as float32 (rounded outwards) instead of float64.
+  //! Halves the node size for the OCCT_BVH backend; takes effect on the next Load().
+  void SetUseCompactNodes(Standard_Boolean theUse) { myUseCompactNodes = theUse; }
+
+  //! Check if flattened BVH nodes use float32 bounds
+  Standard_Boolean GetUseCompactNodes() const { return myUseCompactNodes; }
+
+  //! Store the UV nodes seeding the Newton refinement as float32 offsets from an origin
+  //! per face instead of float64; takes effect on the next Load(). Halves the UV node
+  //! table; the refined hits keep full precision.
+  void SetUseCompactUVs(Standard_Boolean theUse) { myUseCompactUVs = theUse; }
+
+  //! Check if UV nodes are stored as float32 offsets
+  Standard_Boolean GetUseCompactUVs() const { return myUseCompactUVs; }
+
+  //! Store the first surface derivatives at the UV nodes (float32, 24 bytes per node)
+  //! and correct the interpolated UV seeding the Newton refinement for the curvature
+  //! of the face; takes effect on the next Load(). Saves iterations on coarse meshes
+  //! of curved faces at the cost of one surface evaluation per node while loading.
+  void SetUseCurvedUVs(Standard_Boolean theUse) { myUseCurvedUVs = theUse; }
+
+  //! Check if interpolated UVs are corrected for the curvature of the faces
+  Standard_Boolean GetUseCurvedUVs() const { return myUseCurvedUVs; }
+
+  //! Enable/disable the closed-form refinement of hits on planes, cylinders, cones,
+  //! spheres and tori (enabled by default). Other surfaces, and hits whose exact root
+  //! falls outside the UV bounds of the face, are refined by Newton iteration.
+  void SetUseAnalyticSurfaces(Standard_Boolean theUse) { myUseAnalyticSurfaces = theUse; }
+
+  //! Check if hits on elementary surfaces are refined in closed form
+  Standard_Boolean GetUseAnalyticSurfaces() const { return myUseAnalyticSurfaces; }
+
+  //! Set the node arity traversed by the OCCT_BVH backend; takes effect on the next Load().
+  //! 2 keeps the flattened binary tree, 4 or 8 collapse it into wide nodes whose child
+  //! boxes are tested with one SSE/AVX pass (float32 bounds, SetUseCompactNodes() ignored).
+  //! @throw Standard_OutOfRange if theWidth is not 2, 4 or 8, or if the maximum depth
+  //!        exceeds WideBVH::MaxDepth(theWidth) (lower it first with SetBVHMaxDepth())
+  Standard_EXPORT void SetBVHWidth(const Standard_Integer theWidth);
+
+  //! Get the node arity of the OCCT_BVH backend
+  Standard_Integer GetBVHWidth() const { return myBVHWidth; }
+
+  //! Store leaf triangles of the OCCT_BVH backend in SoA packets of
+  //! BRepIntCurveSurface_TrianglePackets::Lanes triangles, each leaf tested in one SIMD
+  //! pass instead of one triangle at a time; takes effect on the next Load().
+  //! On by default only when BRepIntCurveSurface_TrianglePackets::IsVectorized().
+  void SetUseTrianglePackets(Standard_Boolean theUse) { myUseTrianglePackets = theUse; }
+
+  //! Check if leaf triangles are stored in SIMD packets
+  Standard_Boolean GetUseTrianglePackets() const { return myUseTrianglePackets; }
+
+  //! Trace PerformBatch() rays of the OCCT_BVH backend in packets of consecutive rays
+  //! that walk the flattened binary tree together. Intended for coherent rays such as
+  //! parallel rays on a raster grid; requires a BVH width of 2.
+  void SetUseRayPackets(Standard_Boolean theUse) { myUseRayPackets = theUse; }
+
+  //! Check if batch rays are traced in packets
+  Standard_Boolean GetUseRayPackets() const { return myUseRayPackets; }
+
+  //! Set the algorithm building the triangle BVH; takes effect on the next Load().
+  //! SAH builders take longer to build but produce trees needing fewer node visits.
+  void SetBVHBuilder(BRepIntCurveSurface_BVHBuilder theBuilder) { myBVHBuilder = theBuilder; }
+
+  //! Get the algorithm building the triangle BVH
+  BRepIntCurveSurface_BVHBuilder GetBVHBuilder() const { return myBVHBuilder; }
+
+  //! Set the maximum number of triangles per BVH leaf; takes effect on the next Load().
+  //! @throw Standard_OutOfRange if theSize is not positive
+  Standard_EXPORT void SetBVHLeafSize(const Standard_Integer theSize);
+
+  //! Get the maximum number of triangles per BVH leaf
+  Standard_Integer GetBVHLeafSize() const { return myBVHLeafSize; }
+
+  //! Set the maximum depth of the triangle BVH; takes effect on the next Load().
+  //! Deeper nodes become leaves regardless of the leaf size.
+  //! @throw Standard_OutOfRange if theDepth is not in [1, FlatBVH::MaxStackSize - 1], or
+  //!        exceeds WideBVH::MaxDepth() of the current width when it is 4 or 8
+  Standard_EXPORT void SetBVHMaxDepth(const Standard_Integer theDepth);
+
+  //! Get the maximum depth of the triangle BVH
+  Standard_Integer GetBVHMaxDepth() const { return myBVHMaxDepth; }
+
+  //! Give sliver triangles (long and thin, typical of cylinders and fillets) several BVH
+  //! references with tighter boxes; takes effect on the next Load(). Each reference still
+  //! tests the whole triangle, so results are unchanged, but rays no longer visit every
+  //! node overlapped by the sliver's large diagonal box.
+  void SetUseTriangleSplits(Standard_Boolean theUse) { myUseTriangleSplits = theUse; }
+
+  //! Check if sliver triangles are split into several BVH references
+  Standard_Boolean GetUseTriangleSplits() const { return myUseTriangleSplits; }
+
+  //! Weld only triangulation nodes lying on B-Rep edges (from the edges' polygons on
+  //! triangulation); takes effect on the next Load(). Nodes inside a face are never merged,
+  //! which is faster and keeps close but unconnected faces (thin walls) apart.
+  void SetWeldEdgesOnly(Standard_Boolean theEdgesOnly) { myWeldEdgesOnly = theEdgesOnly; }
+
+  //! Check if only edge nodes are welded
+  Standard_Boolean GetWeldEdgesOnly() const { return myWeldEdgesOnly; }
+
+  //! Returns the quality metrics (SAH cost, leaf sizes, overlap) of the triangle BVH
+  //! computed by the last Load()
+  const BRepIntCurveSurface_BVHStatistics& GetBVHStatistics() const { return myBVHStatistics; }
+
+  //! Set a directory where Load() keeps the triangle BVH of every tessellation it builds,
+  //! in files keyed by a hash of the triangulation and of the BVH settings; an empty
+  //! path (default) disables the cache. When the same shape is loaded again, welding
+  //! and BVH construction are skipped and the data is read from the memory-mapped file.
+  void SetBVHCacheDirectory(const TCollection_AsciiString& theDirectory)
+  {
+    myBVHCacheDirectory = theDirectory;
+  }
+
+  //! Get the directory of the triangle BVH cache
+  const TCollection_AsciiString& GetBVHCacheDirectory() const { return myBVHCacheDirectory; }
+
+  //! Check if the last Load() read the triangle BVH from the cache
+  Standard_Boolean IsBVHFromCache() const { return myIsBVHFromCache; }
+
+  //! Load assemblies as instances of their parts; takes effect on the next Load().
+  //! Every sub-shape of the compounds of the loaded shape is an instance, and instances
+  //! of the same part (same TShape and orientation, any location) share one triangle BVH
+  //! in part coordinates. A top-level BVH over the instance boxes maps the rays into the
+  //! parts. Faces are still indexed per instance. Requires the OCCT_BVH backend; the BVH
+  //! cache and UpdateFaces() are not available with instancing.
+  void SetUseInstancing(Standard_Boolean theUse) { myUseInstancing = theUse; }
+
+  //! Check if assemblies are loaded as part instances
+  Standard_Boolean GetUseInstancing() const { return myUseInstancing; }
+
+  //! Returns the number of part instances of the last Load() (0 without instancing)
+  Standard_Integer NbInstances() const { return myInstances.NbInstances(); }
+
+  //! Returns the part instance (1-based, 0 without instancing) at i-th intersection
+  Standard_EXPORT Standard_Integer InstanceIndex(const Standard_Integer theIndex) const;
+
+  //! Returns the memory held by the loaded shape, per data structure. Containers count
+  //! their capacity; OCCT geometry shared with the shape is not included.
+  Standard_EXPORT BRepIntCurveSurface_MemoryUsage MemoryUsage() const;
+
+private:
+  struct GatheredFace;
+
+  //! Gather the triangulations of the loaded faces (skipping removed faces) and build
+  //! the triangle BVH, the traversal nodes and the Embree scene. Surface adaptors
+  //! that already exist are kept.
+  //! @param theGathered Triangles of the faces gathered while meshing, or null
+  void loadTriangles(const std::vector<GatheredFace>* theGathered = nullptr);
+
+  //! Load the parts of an assembly once and place them by the instances' locations
+  //! (see SetUseInstancing())
+  void loadInstances(const TopoDS_Shape& theShape);
+
+  //! Find the source triangle of hit index theTriangle and interpolate the UV of the hit
+  //! on its face, corrected for the curvature of the face if the UV nodes keep the
+  //! surface derivatives.
+  //! @param theU Barycentric U of the hit
+  //! @param theV Barycentric V of the hit
+  //! @param theDir World direction of the ray
+  //! @param theFace Output: 0-based face index of the hit
+  //! @param theInstance Output: 0-based instance index of the hit, -1 without instancing
+  //! @param theUV Output: UV of the hit interpolated from the triangle's UV nodes
+  //! @param theUVMin Output: lower corner of the triangle's UV box
+  //! @param theUVMax Output: upper corner of the triangle's UV box
+  //! @return false if theTriangle is out of range
+  Standard_Boolean hitTriangle(const Standard_Integer theTriangle,
+                               const Standard_Real    theU,
+                               const Standard_Real    theV,
+                               const gp_Dir&          theDir,
+                               Standard_Integer&      theFace,
+                               Standard_Integer&      theInstance,
+                               gp_Pnt2d&              theUV,
+                               gp_Pnt2d&              theUVMin,
+                               gp_Pnt2d&              theUVMax) const;
+
+  //! Create the surface adaptor of face theIndex (0-based), classify its surface and
+  //! keep the world copy of B-spline and Bezier surfaces
+  void initSurface(const Standard_Integer theIndex, const TopoDS_Face& theFace);
+
+  //! Returns the cached elementary surface of face theIndex (0-based), or null if the
+  //! surface is not elementary or closed-form refinement is disabled
+  const BRepIntCurveSurface_AnalyticSurface* analyticSurface(
+    const Standard_Integer theIndex) const
+  {
+    return myUseAnalyticSurfaces && myAnalyticSurfaces[theIndex].IsElementary()
+             ? &myAnalyticSurfaces[theIndex]
+             : nullptr;
+  }
+
+  //! Index the triangle slots of every face, the BVH primitives referencing every
+  //! slot and the tree nodes, for the first UpdateFaces() after a build
+  void prepareFaceUpdate();
+
+  //! Returns the number of faces once the pending face edits are applied
+  Standard_Integer nbFacesAfterUpdate() const;
+
+  //! Returns true if theFace is loaded or added by a pending face edit
+  Standard_Boolean isFaceLoadedOrPending(const TopoDS_Face& theFace) const;
+
+  //! Batch queries with optional per-ray parameter intervals; null arrays select
+  //! [0, RealLast()] (or [theMin, theMax]) for every ray
+  void performBatch(const NCollection_Array1<gp_Lin>&                  theRays,
+                    const NCollection_Array1<Standard_Real>*           theMinParams,
+                    const NCollection_Array1<Standard_Real>*           theMaxParams,
+                    NCollection_Array1<BRepIntCurveSurface_HitResult>& theResults,
+                    const BRepIntCurveSurface_HitChannels              theChannels);
+
+  void performBatchCount(const NCollection_Array1<gp_Lin>&        theRays,
+                         const NCollection_Array1<Standard_Real>* theMinParams,
+                         const NCollection_Array1<Standard_Real>* theMaxParams,
+                         NCollection_Array1<Standard_Integer>&    theHitCounts);
+
+  void performBatchAllHits(const NCollection_Array1<gp_Lin>&                  theRays,
+                           const NCollection_Array1<Standard_Real>*           theMinParams,
+                           const NCollection_Array1<Standard_Real>*           theMaxParams,
+                           NCollection_Array1<Standard_Integer>&              theOffsets,
+                           NCollection_Array1<BRepIntCurveSurface_HitResult>& theHits);
+
+  void performBatchOcclusion(const NCollection_Array1<gp_Lin>&        theRays,
+                             const NCollection_Array1<Standard_Real>* theMinParams,
+                             const NCollection_Array1<Standard_Real>* theMaxParams,
+                             const Standard_Real                      theMin,
+                             const Standard_Real                      theMax,
+                             NCollection_Array1<Standard_Boolean>&    theOccluded) const;
+
+  //! Restore the triangle BVH data of Load() from a cache file; nothing is changed
+  //! unless every section is present and consistent with the gathered triangulation.
+  //! @param theCache Mapped cache file
+  //! @param theFaceOffsets First triangle of each face, must match the cached one
+  //! @param theTriangleIndices Output: welded vertex indices of the triangle corners
+  //! @param theNbVertices Output: number of welded vertices
+  Standard_Boolean readBVHCache(const BRepIntCurveSurface_BVHCache&  theCache,
+                                const std::vector<Standard_Integer>& theFaceOffsets,
+                                std::vector<Standard_Integer>&       theTriangleIndices,
+                                Standard_Integer&                    theNbVertices);
+
+  //! Store the triangle BVH data built by Load() in a cache file
+  Standard_Boolean writeBVHCache(const TCollection_AsciiString&       thePath,
+                                 const uint64_t                       theKey,
+                                 const std::vector<Standard_Integer>& theFaceOffsets,
+                                 const std::vector<Standard_Integer>& theTriangleIndices,
+                                 const Standard_Integer               theNbVertices) const;
+
 private:
   // Face data
   TopTools_IndexedMapOfShape myFaces;
@@ -264,9 +728,69 @@ private:
   std::vector<BRepIntCurveSurface_TriangleInfo> myTriangleInfo; // Maps triangle index to face + UV
   Standard_Boolean                              myUseTessellation;
 
+  // UV nodes of the triangle corners, one per triangulation node. Nodes are numbered as
+  // the unwelded vertices, and origins are indexed by face (see hitTriangle()).
+  BRepIntCurveSurface_TriangleUVs myTriangleUVs;
+  Standard_Boolean                myUseCompactUVs;
+  Standard_Boolean                myUseCurvedUVs;
+
+  // Triangles with precomputed edges in BVH leaf order, read by the native traversers
+  // (released after Load when packets are built from them)
+  std::vector<BRepIntCurveSurface_TriangleRecord> myTriangleRecords;
+  BRepIntCurveSurface_TrianglePackets             myTrianglePackets;
+  Standard_Boolean                                myUseTrianglePackets;
+
+  // Depth-first flattened copy of the triangle BVH traversed by the OCCT_BVH backend
+  BRepIntCurveSurface_FlatBVH myFlatBVH;
+  Standard_Boolean            myUseCompactNodes;
+
+  // 4- or 8-wide copy of the triangle BVH, used instead of myFlatBVH when myBVHWidth > 2
+  BRepIntCurveSurface_WideBVH myWideBVH;
+  Standard_Integer            myBVHWidth;
+  Standard_Boolean            myUseRayPackets; // Coherent packet traversal in PerformBatch
+
+  // Triangle BVH construction parameters and the metrics of the last build
+  BRepIntCurveSurface_BVHBuilder    myBVHBuilder;
+  Standard_Integer                  myBVHLeafSize;
+  Standard_Integer                  myBVHMaxDepth;
+  BRepIntCurveSurface_BVHStatistics myBVHStatistics;
+  Standard_Boolean                  myUseTriangleSplits;
+  Standard_Integer                  myNbTriangleSplits; // Extra references of the last Load
+  Standard_Boolean                  myWeldEdgesOnly;
+
+  // Incremental face updates. Triangle indices are slots owned by one face, or free
+  // after a removal; every slot keeps its BVH primitives, which are rewritten in place.
+  std::vector<std::pair<Standard_Integer, TopoDS_Face>> myPendingFaces; // Null face: removal
+  std::vector<Standard_Boolean>                         myIsFaceRemoved;
+  std::vector<std::vector<Standard_Integer>>            myFaceTriangles; // Slots of each face
+  std::vector<Standard_Integer>                         myFreeTriangles;
+  std::vector<Standard_Integer> myTriangleRefOffsets; // BVH primitives of slot i are
+  std::vector<Standard_Integer> myTriangleRefs;       // myTriangleRefs[offsets[i], offsets[i+1])
+  Standard_Integer              myNbMovedTriangles;   // Slots taken from other faces since build
+  Standard_Integer              myNbUpdatedTriangles; // Slots rewritten since the last build
+
+  // On-disk cache of the triangle BVH (disabled if the directory is empty)
+  TCollection_AsciiString myBVHCacheDirectory;
+  Standard_Boolean        myIsBVHFromCache; // The last Load() read the cache
+
+  // Two-level BVH of part instances (empty unless myUseInstancing). Triangle info of
+  // prototype p is myTriangleInfo[FirstTriangle, FirstTriangle + NbTriangles) with
+  // face indices local to the part; its UV origins start at FirstUVFace.
+  BRepIntCurveSurface_InstanceSet myInstances;
+  Standard_Boolean                myUseInstancing;
+
   // Surface adaptors for fast UV-guided Newton refinement (used with tessellation BVH)
   std::vector<Handle(BRepAdaptor_Surface)> mySurfaceAdaptors;
 
+  // Elementary surfaces of the faces (same indexing as mySurfaceAdaptors), refined in
+  // closed form without adaptor calls
+  std::vector<BRepIntCurveSurface_AnalyticSurface> myAnalyticSurfaces;
+  Standard_Boolean                                 myUseAnalyticSurfaces;
+
+  // B-spline and Bezier surfaces of the faces (same indexing), evaluated through span
+  // caches; batch queries copy them so that every thread has its own caches
+  std::vector<BRepIntCurveSurface_SplineSurface> mySplineSurfaces;
+
   // Tolerance
   Standard_Real myTolerance;
   Standard_Real myDeflection;
@@ -287,6 +811,12 @@ private:
   // Embree BVH acceleration
   RTCDevice myEmbreeDevice;
   RTCScene  myEmbreeScene;
+  size_t    myEmbreeNbVertices; // Capacity of the vertex buffer, grown by UpdateFaces()
+
+  // Vertex (float XYZ, one padding float) and index buffers read in place by the Embree
+  // geometry; they must outlive the scene
+  std::vector<float>            myEmbreeVertices;
+  std::vector<Standard_Integer> myEmbreeIndices;
 #endif
 };
 
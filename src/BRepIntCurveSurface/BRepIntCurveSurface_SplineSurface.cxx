@@ -0,0 +1,84 @@
+// Created on: 2025-04-14
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_SplineSurface.hxx>
+
+#include <Adaptor3d_Surface.hxx>
+#include <Geom_BezierSurface.hxx>
+#include <GeomConvert.hxx>
+
+//=================================================================================================
+
+void BRepIntCurveSurface_SplineSurface::Init(const Adaptor3d_Surface& theSurface)
+{
+  myCache.Nullify();
+  switch (theSurface.GetType())
+  {
+    case GeomAbs_BSplineSurface:
+      mySurface = theSurface.BSpline();
+      break;
+    case GeomAbs_BezierSurface:
+      mySurface = GeomConvert::SurfaceToBSplineSurface(theSurface.Bezier());
+      break;
+    default:
+      mySurface.Nullify();
+      return;
+  }
+
+  myUMin = theSurface.FirstUParameter();
+  myUMax = theSurface.LastUParameter();
+  myVMin = theSurface.FirstVParameter();
+  myVMax = theSurface.LastVParameter();
+}
+
+//=================================================================================================
+
+Standard_Size BRepIntCurveSurface_SplineSurface::MemorySize() const
+{
+  if (mySurface.IsNull())
+    return 0;
+
+  const Standard_Boolean isRational = mySurface->IsURational() || mySurface->IsVRational();
+  const Standard_Size    aNbPoles =
+    static_cast<Standard_Size>(mySurface->NbUPoles()) * mySurface->NbVPoles();
+  const Standard_Size aNbKnots =
+    mySurface->UKnotSequence().Length() + mySurface->VKnotSequence().Length();
+  return sizeof(Geom_BSplineSurface)
+         + aNbPoles * (sizeof(gp_Pnt) + (isRational ? sizeof(Standard_Real) : 0))
+         + aNbKnots * sizeof(Standard_Real);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_SplineSurface::buildCache(const Standard_Real theU,
+                                                   const Standard_Real theV) const
+{
+  if (myCache.IsNull())
+  {
+    myCache = new BSplSLib_Cache(mySurface->UDegree(),
+                                 mySurface->IsUPeriodic(),
+                                 mySurface->UKnotSequence(),
+                                 mySurface->VDegree(),
+                                 mySurface->IsVPeriodic(),
+                                 mySurface->VKnotSequence(),
+                                 mySurface->Weights());
+  }
+  myCache->BuildCache(theU,
+                      theV,
+                      mySurface->UKnotSequence(),
+                      mySurface->VKnotSequence(),
+                      mySurface->Poles(),
+                      mySurface->Weights());
+}
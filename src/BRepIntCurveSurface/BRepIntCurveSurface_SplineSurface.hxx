@@ -0,0 +1,149 @@
+// Created on: 2025-04-14
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_SplineSurface_HeaderFile
+#define _BRepIntCurveSurface_SplineSurface_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+#include <Standard_Handle.hxx>
+
+#include <BSplSLib_Cache.hxx>
+#include <Geom_BSplineSurface.hxx>
+#include <gp_Pnt.hxx>
+#include <gp_Vec.hxx>
+
+class Adaptor3d_Surface;
+
+//! Evaluator of a B-spline or Bezier face surface through a span cache.
+//!
+//! The polynomial coefficients of the knot span of the last evaluation are kept
+//! (BSplSLib_Cache), so that the Newton iterations of a hit and the hits of nearby
+//! rays on the same span skip the span search and the basis functions. The surface
+//! is held in world coordinates (Bezier surfaces are converted to B-splines).
+//!
+//! The cache is mutable state: copies share the surface but not the cache, so that
+//! each thread evaluates through its own copy.
+class BRepIntCurveSurface_SplineSurface
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Empty constructor; the surface is not defined until Init()
+  BRepIntCurveSurface_SplineSurface()
+      : myUMin(0.0),
+        myUMax(0.0),
+        myVMin(0.0),
+        myVMax(0.0)
+  {
+  }
+
+  //! Copy the surface and its bounds, without the span cache
+  BRepIntCurveSurface_SplineSurface(const BRepIntCurveSurface_SplineSurface& theOther)
+      : mySurface(theOther.mySurface),
+        myUMin(theOther.myUMin),
+        myUMax(theOther.myUMax),
+        myVMin(theOther.myVMin),
+        myVMax(theOther.myVMax)
+  {
+  }
+
+  //! Copy the surface and its bounds, releasing the span cache
+  BRepIntCurveSurface_SplineSurface& operator=(const BRepIntCurveSurface_SplineSurface& theOther)
+  {
+    mySurface = theOther.mySurface;
+    myCache.Nullify();
+    myUMin = theOther.myUMin;
+    myUMax = theOther.myUMax;
+    myVMin = theOther.myVMin;
+    myVMax = theOther.myVMax;
+    return *this;
+  }
+
+  //! Keep the surface of a face in world coordinates if it is a B-spline or Bezier
+  //! surface, and release it otherwise
+  Standard_EXPORT void Init(const Adaptor3d_Surface& theSurface);
+
+  //! Returns true if the face surface is a B-spline or Bezier surface
+  Standard_Boolean IsDefined() const { return !mySurface.IsNull(); }
+
+  //! UV bounds of the face
+  Standard_Real FirstUParameter() const { return myUMin; }
+  Standard_Real LastUParameter() const { return myUMax; }
+  Standard_Real FirstVParameter() const { return myVMin; }
+  Standard_Real LastVParameter() const { return myVMax; }
+
+  //! Periodicity of the surface
+  Standard_Boolean IsUPeriodic() const { return mySurface->IsUPeriodic(); }
+  Standard_Boolean IsVPeriodic() const { return mySurface->IsVPeriodic(); }
+  Standard_Real    UPeriod() const { return mySurface->UPeriod(); }
+  Standard_Real    VPeriod() const { return mySurface->VPeriod(); }
+
+  //! Point at (theU, theV)
+  void D0(const Standard_Real theU, const Standard_Real theV, gp_Pnt& thePnt) const
+  {
+    validateCache(theU, theV);
+    myCache->D0(theU, theV, thePnt);
+  }
+
+  //! Point and first derivatives at (theU, theV)
+  void D1(const Standard_Real theU,
+          const Standard_Real theV,
+          gp_Pnt&             thePnt,
+          gp_Vec&             theD1U,
+          gp_Vec&             theD1V) const
+  {
+    validateCache(theU, theV);
+    myCache->D1(theU, theV, thePnt, theD1U, theD1V);
+  }
+
+  //! Point and derivatives up to the second order at (theU, theV)
+  void D2(const Standard_Real theU,
+          const Standard_Real theV,
+          gp_Pnt&             thePnt,
+          gp_Vec&             theD1U,
+          gp_Vec&             theD1V,
+          gp_Vec&             theD2U,
+          gp_Vec&             theD2V,
+          gp_Vec&             theD2UV) const
+  {
+    validateCache(theU, theV);
+    myCache->D2(theU, theV, thePnt, theD1U, theD1V, theD2U, theD2V, theD2UV);
+  }
+
+  //! Returns the size of the world copy of the surface in bytes (the cache excluded)
+  Standard_EXPORT Standard_Size MemorySize() const;
+
+private:
+  //! Rebuild the cache on the span of (theU, theV) unless it already covers it
+  void validateCache(const Standard_Real theU, const Standard_Real theV) const
+  {
+    if (myCache.IsNull() || !myCache->IsCacheValid(theU, theV))
+      buildCache(theU, theV);
+  }
+
+  //! Compute the coefficients of the span of (theU, theV)
+  Standard_EXPORT void buildCache(const Standard_Real theU, const Standard_Real theV) const;
+
+private:
+  Handle(Geom_BSplineSurface)    mySurface; //!< World surface (null if not a spline)
+  mutable Handle(BSplSLib_Cache) myCache;   //!< Coefficients of the last span
+  Standard_Real                  myUMin;    //!< UV bounds of the face
+  Standard_Real                  myUMax;
+  Standard_Real                  myVMin;
+  Standard_Real                  myVMax;
+};
+
+#endif // _BRepIntCurveSurface_SplineSurface_HeaderFile
@@ -0,0 +1,292 @@
+// Created on: 2025-02-03
+// Created by: Andrea Pozzetti (with Claude Code assistance)
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_TrianglePackets.hxx>
+
+#include <cmath>
+
+#if defined(__AVX512F__) || defined(__AVX__)
+  #include <immintrin.h>
+#endif
+
+namespace
+{
+//! Determinant below which a triangle is treated as parallel to the ray
+const Standard_Real THE_PACKET_EPSILON = 1e-12;
+
+#if defined(__AVX512F__)
+__m512d Dot(const __m512d theA[3], const __m512d theB[3])
+{
+  return _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(theA[0], theB[0]),
+                                     _mm512_mul_pd(theA[1], theB[1])),
+                       _mm512_mul_pd(theA[2], theB[2]));
+}
+
+void Cross(const __m512d theA[3], const __m512d theB[3], __m512d theRes[3])
+{
+  theRes[0] = _mm512_sub_pd(_mm512_mul_pd(theA[1], theB[2]), _mm512_mul_pd(theA[2], theB[1]));
+  theRes[1] = _mm512_sub_pd(_mm512_mul_pd(theA[2], theB[0]), _mm512_mul_pd(theA[0], theB[2]));
+  theRes[2] = _mm512_sub_pd(_mm512_mul_pd(theA[0], theB[1]), _mm512_mul_pd(theA[1], theB[0]));
+}
+#elif defined(__AVX__)
+__m256d Dot(const __m256d theA[3], const __m256d theB[3])
+{
+  return _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(theA[0], theB[0]),
+                                     _mm256_mul_pd(theA[1], theB[1])),
+                       _mm256_mul_pd(theA[2], theB[2]));
+}
+
+void Cross(const __m256d theA[3], const __m256d theB[3], __m256d theRes[3])
+{
+  theRes[0] = _mm256_sub_pd(_mm256_mul_pd(theA[1], theB[2]), _mm256_mul_pd(theA[2], theB[1]));
+  theRes[1] = _mm256_sub_pd(_mm256_mul_pd(theA[2], theB[0]), _mm256_mul_pd(theA[0], theB[2]));
+  theRes[2] = _mm256_sub_pd(_mm256_mul_pd(theA[0], theB[1]), _mm256_mul_pd(theA[1], theB[0]));
+}
+
+//! Tests the four lanes of thePacket starting at theFirst (0 or 4); rows of a packet
+//! are 64-byte aligned, so both halves are 32-byte aligned
+int IntersectQuad(const BRepIntCurveSurface_TrianglePacket& thePacket,
+                  const int                                 theFirst,
+                  const BVH_Vec3d&                          theOrigin,
+                  const BVH_Vec3d&                          theDir,
+                  const Standard_Real                       theMin,
+                  const Standard_Real                       theMax,
+                  Standard_Real*                            theT,
+                  Standard_Real*                            theU,
+                  Standard_Real*                            theV)
+{
+  const __m256d aD[3]  = {_mm256_set1_pd(theDir[0]),
+                          _mm256_set1_pd(theDir[1]),
+                          _mm256_set1_pd(theDir[2])};
+  const __m256d aE1[3] = {_mm256_load_pd(thePacket.Edge1[0] + theFirst),
+                          _mm256_load_pd(thePacket.Edge1[1] + theFirst),
+                          _mm256_load_pd(thePacket.Edge1[2] + theFirst)};
+  const __m256d aE2[3] = {_mm256_load_pd(thePacket.Edge2[0] + theFirst),
+                          _mm256_load_pd(thePacket.Edge2[1] + theFirst),
+                          _mm256_load_pd(thePacket.Edge2[2] + theFirst)};
+  const __m256d aS[3]  = {
+    _mm256_sub_pd(_mm256_set1_pd(theOrigin[0]), _mm256_load_pd(thePacket.V0[0] + theFirst)),
+    _mm256_sub_pd(_mm256_set1_pd(theOrigin[1]), _mm256_load_pd(thePacket.V0[1] + theFirst)),
+    _mm256_sub_pd(_mm256_set1_pd(theOrigin[2]), _mm256_load_pd(thePacket.V0[2] + theFirst))};
+
+  // h = dir x edge2, q = s x edge1
+  __m256d aH[3], aQ[3];
+  Cross(aD, aE2, aH);
+  Cross(aS, aE1, aQ);
+
+  const __m256d a = Dot(aE1, aH);
+  const __m256d f = _mm256_div_pd(_mm256_set1_pd(1.0), a);
+  const __m256d u = _mm256_mul_pd(f, Dot(aS, aH));
+  const __m256d v = _mm256_mul_pd(f, Dot(aD, aQ));
+  const __m256d t = _mm256_mul_pd(f, Dot(aE2, aQ));
+
+  // |a| by clearing the sign bit
+  const __m256d aZero = _mm256_setzero_pd();
+  const __m256d anAbs = _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+  __m256d       aHit  = _mm256_cmp_pd(anAbs, _mm256_set1_pd(THE_PACKET_EPSILON), _CMP_GE_OQ);
+  aHit = _mm256_and_pd(aHit, _mm256_cmp_pd(u, aZero, _CMP_GE_OQ));
+  aHit = _mm256_and_pd(aHit, _mm256_cmp_pd(v, aZero, _CMP_GE_OQ));
+  aHit = _mm256_and_pd(aHit, _mm256_cmp_pd(_mm256_add_pd(u, v), _mm256_set1_pd(1.0), _CMP_LE_OQ));
+  aHit = _mm256_and_pd(aHit, _mm256_cmp_pd(t, _mm256_set1_pd(THE_PACKET_EPSILON), _CMP_GT_OQ));
+  aHit = _mm256_and_pd(aHit, _mm256_cmp_pd(t, _mm256_set1_pd(theMin), _CMP_GE_OQ));
+  aHit = _mm256_and_pd(aHit, _mm256_cmp_pd(t, _mm256_set1_pd(theMax), _CMP_LE_OQ));
+
+  _mm256_storeu_pd(theT, t);
+  _mm256_storeu_pd(theU, u);
+  _mm256_storeu_pd(theV, v);
+  return _mm256_movemask_pd(aHit);
+}
+#endif
+} // namespace
+
+//=================================================================================================
+
+void BRepIntCurveSurface_TrianglePackets::Build(
+  const BVH_Tree<Standard_Real, 3>&                      theTree,
+  const std::vector<BRepIntCurveSurface_TriangleRecord>& theTriangles)
+{
+  Clear();
+  if (theTree.Length() == 0 || theTriangles.empty())
+    return;
+
+  myFirstPacket.assign(theTriangles.size(), -1);
+  myPackets.reserve(theTriangles.size() / Lanes + theTree.Length() / 2 + 1);
+
+  for (Standard_Integer aNode = 0; aNode < theTree.Length(); ++aNode)
+  {
+    if (!theTree.IsOuter(aNode))
+      continue;
+
+    const Standard_Integer aBeg = theTree.BegPrimitive(aNode);
+    const Standard_Integer aEnd = theTree.EndPrimitive(aNode);
+    myFirstPacket[aBeg]         = static_cast<Standard_Integer>(myPackets.size());
+
+    for (Standard_Integer aFirst = aBeg; aFirst <= aEnd; aFirst += Lanes)
+    {
+      myPackets.emplace_back();
+      BRepIntCurveSurface_TrianglePacket& aPacket = myPackets.back();
+      for (int aLane = 0; aLane < Lanes; ++aLane)
+      {
+        const Standard_Integer aPrim = aFirst + aLane;
+        if (aPrim > aEnd)
+        {
+          // Degenerate padding triangle: zero determinant, never reported as a hit
+          for (int k = 0; k < 3; ++k)
+          {
+            aPacket.V0[k][aLane]    = 0.0;
+            aPacket.Edge1[k][aLane] = 0.0;
+            aPacket.Edge2[k][aLane] = 0.0;
+          }
+          aPacket.OriginalIndex[aLane] = -1;
+          continue;
+        }
+
+        const BRepIntCurveSurface_TriangleRecord& aTri = theTriangles[aPrim];
+        for (int k = 0; k < 3; ++k)
+        {
+          aPacket.V0[k][aLane]    = aTri.V0[k];
+          aPacket.Edge1[k][aLane] = aTri.Edge1[k];
+          aPacket.Edge2[k][aLane] = aTri.Edge2[k];
+        }
+        aPacket.OriginalIndex[aLane] = aTri.OriginalIndex;
+      }
+    }
+  }
+}
+
+//=================================================================================================
+
+Standard_Boolean BRepIntCurveSurface_TrianglePackets::IsVectorized()
+{
+#if defined(__AVX512F__) || defined(__AVX__)
+  return Standard_True;
+#else
+  return Standard_False;
+#endif
+}
+
+//=================================================================================================
+
+int BRepIntCurveSurface_TrianglePackets::Intersect(
+  const BRepIntCurveSurface_TrianglePacket& thePacket,
+  const Standard_Integer                    theNbTriangles,
+  const BVH_Vec3d&                          theOrigin,
+  const BVH_Vec3d&                          theDir,
+  const Standard_Real                       theMin,
+  const Standard_Real                       theMax,
+  Standard_Real                             theT[Lanes],
+  Standard_Real                             theU[Lanes],
+  Standard_Real                             theV[Lanes])
+{
+  static_assert(Lanes == 8, "Packet kernels are written for 8 lanes");
+#if defined(__AVX512F__)
+  const __m512d aD[3]  = {_mm512_set1_pd(theDir[0]),
+                          _mm512_set1_pd(theDir[1]),
+                          _mm512_set1_pd(theDir[2])};
+  const __m512d aE1[3] = {_mm512_load_pd(thePacket.Edge1[0]),
+                          _mm512_load_pd(thePacket.Edge1[1]),
+                          _mm512_load_pd(thePacket.Edge1[2])};
+  const __m512d aE2[3] = {_mm512_load_pd(thePacket.Edge2[0]),
+                          _mm512_load_pd(thePacket.Edge2[1]),
+                          _mm512_load_pd(thePacket.Edge2[2])};
+  const __m512d aS[3]  = {
+    _mm512_sub_pd(_mm512_set1_pd(theOrigin[0]), _mm512_load_pd(thePacket.V0[0])),
+    _mm512_sub_pd(_mm512_set1_pd(theOrigin[1]), _mm512_load_pd(thePacket.V0[1])),
+    _mm512_sub_pd(_mm512_set1_pd(theOrigin[2]), _mm512_load_pd(thePacket.V0[2]))};
+
+  // h = dir x edge2, q = s x edge1
+  __m512d aH[3], aQ[3];
+  Cross(aD, aE2, aH);
+  Cross(aS, aE1, aQ);
+
+  const __m512d a = Dot(aE1, aH);
+  const __m512d f = _mm512_div_pd(_mm512_set1_pd(1.0), a);
+  const __m512d u = _mm512_mul_pd(f, Dot(aS, aH));
+  const __m512d v = _mm512_mul_pd(f, Dot(aD, aQ));
+  const __m512d t = _mm512_mul_pd(f, Dot(aE2, aQ));
+
+  // Start from the lanes holding triangles
+  const __m512d aZero = _mm512_setzero_pd();
+  __mmask8      aMask = static_cast<__mmask8>((1u << theNbTriangles) - 1u);
+  aMask = _mm512_mask_cmp_pd_mask(aMask,
+                                  _mm512_abs_pd(a),
+                                  _mm512_set1_pd(THE_PACKET_EPSILON),
+                                  _CMP_GE_OQ);
+  aMask = _mm512_mask_cmp_pd_mask(aMask, u, aZero, _CMP_GE_OQ);
+  aMask = _mm512_mask_cmp_pd_mask(aMask, v, aZero, _CMP_GE_OQ);
+  aMask = _mm512_mask_cmp_pd_mask(aMask, _mm512_add_pd(u, v), _mm512_set1_pd(1.0), _CMP_LE_OQ);
+  aMask = _mm512_mask_cmp_pd_mask(aMask, t, _mm512_set1_pd(THE_PACKET_EPSILON), _CMP_GT_OQ);
+  aMask = _mm512_mask_cmp_pd_mask(aMask, t, _mm512_set1_pd(theMin), _CMP_GE_OQ);
+  aMask = _mm512_mask_cmp_pd_mask(aMask, t, _mm512_set1_pd(theMax), _CMP_LE_OQ);
+
+  _mm512_storeu_pd(theT, t);
+  _mm512_storeu_pd(theU, u);
+  _mm512_storeu_pd(theV, v);
+  return static_cast<int>(aMask);
+#elif defined(__AVX__)
+  // The upper quad is padding for leaves of up to four triangles
+  int aMask = IntersectQuad(thePacket, 0, theOrigin, theDir, theMin, theMax, theT, theU, theV);
+  if (theNbTriangles > 4)
+  {
+    aMask |= IntersectQuad(thePacket,
+                           4,
+                           theOrigin,
+                           theDir,
+                           theMin,
+                           theMax,
+                           theT + 4,
+                           theU + 4,
+                           theV + 4)
+             << 4;
+  }
+  return aMask & ((1 << theNbTriangles) - 1);
+#else
+  int aMask = 0;
+  for (int i = 0; i < theNbTriangles; ++i)
+  {
+    const Standard_Real e1x = thePacket.Edge1[0][i], e1y = thePacket.Edge1[1][i];
+    const Standard_Real e1z = thePacket.Edge1[2][i];
+    const Standard_Real e2x = thePacket.Edge2[0][i], e2y = thePacket.Edge2[1][i];
+    const Standard_Real e2z = thePacket.Edge2[2][i];
+
+    const Standard_Real hx = theDir[1] * e2z - theDir[2] * e2y;
+    const Standard_Real hy = theDir[2] * e2x - theDir[0] * e2z;
+    const Standard_Real hz = theDir[0] * e2y - theDir[1] * e2x;
+    const Standard_Real a  = e1x * hx + e1y * hy + e1z * hz;
+    const Standard_Real f  = 1.0 / a;
+
+    const Standard_Real sx = theOrigin[0] - thePacket.V0[0][i];
+    const Standard_Real sy = theOrigin[1] - thePacket.V0[1][i];
+    const Standard_Real sz = theOrigin[2] - thePacket.V0[2][i];
+    const Standard_Real u  = f * (sx * hx + sy * hy + sz * hz);
+
+    const Standard_Real qx = sy * e1z - sz * e1y;
+    const Standard_Real qy = sz * e1x - sx * e1z;
+    const Standard_Real qz = sx * e1y - sy * e1x;
+    const Standard_Real v  = f * (theDir[0] * qx + theDir[1] * qy + theDir[2] * qz);
+    const Standard_Real t  = f * (e2x * qx + e2y * qy + e2z * qz);
+
+    theT[i] = t;
+    theU[i] = u;
+    theV[i] = v;
+    if (std::abs(a) >= THE_PACKET_EPSILON && u >= 0.0 && v >= 0.0 && u + v <= 1.0
+        && t > THE_PACKET_EPSILON && t >= theMin && t <= theMax)
+    {
+      aMask |= 1 << i;
+    }
+  }
+  return aMask;
+#endif
+}
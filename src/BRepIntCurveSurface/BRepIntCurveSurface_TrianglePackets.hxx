@@ -0,0 +1,191 @@
+// Created on: 2025-02-03
+// Created by: Andrea Pozzetti (with Claude Code assistance)
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_TrianglePackets_HeaderFile
+#define _BRepIntCurveSurface_TrianglePackets_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+
+#include <BVH_Tree.hxx>
+
+#include <vector>
+
+//! Triangle precomputed for ray tests, stored in BVH primitive (leaf) order
+struct BRepIntCurveSurface_TriangleRecord
+{
+  BVH_Vec3d        V0;            //!< First vertex
+  BVH_Vec3d        Edge1;         //!< Second vertex minus first vertex
+  BVH_Vec3d        Edge2;         //!< Third vertex minus first vertex
+  Standard_Integer OriginalIndex; //!< Index into the triangle info array
+};
+
+//! Number of triangles in a packet. Fixed regardless of the instruction set, so the
+//! packet layout is the same for the library, its clients and the cache files;
+//! only the kernel in Intersect() is selected when the library is compiled.
+constexpr int BRepIntCurveSurface_TriangleLanes = 8;
+
+//! Group of leaf triangles stored as structure-of-arrays (double precision).
+//! Unused lanes hold degenerate triangles, which the kernel always rejects.
+struct alignas(64) BRepIntCurveSurface_TrianglePacket
+{
+  Standard_Real    V0[3][BRepIntCurveSurface_TriangleLanes];    //!< First vertices (X, Y, Z rows)
+  Standard_Real    Edge1[3][BRepIntCurveSurface_TriangleLanes]; //!< First edges
+  Standard_Real    Edge2[3][BRepIntCurveSurface_TriangleLanes]; //!< Second edges
+  Standard_Integer OriginalIndex[BRepIntCurveSurface_TriangleLanes]; //!< -1 for unused lanes
+};
+
+//! Leaf triangles of a BVH regrouped into SIMD packets.
+//!
+//! Every leaf is split into ceil(NbPrims / Lanes) packets, so all triangles of a
+//! typical leaf of BVH_LinearBuilder(4, 32) are tested with a single kernel call.
+//! Packets of a leaf are contiguous and located by the leaf's first primitive.
+class BRepIntCurveSurface_TrianglePackets
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  static constexpr int Lanes = BRepIntCurveSurface_TriangleLanes;
+
+  //! Empty constructor
+  BRepIntCurveSurface_TrianglePackets() {}
+
+  //! Group the triangles of every leaf of theTree into packets.
+  //! @param theTree Binary BVH tree whose leaves define the groups
+  //! @param theTriangles Triangle records in BVH primitive order
+  Standard_EXPORT void Build(const BVH_Tree<Standard_Real, 3>&                      theTree,
+                             const std::vector<BRepIntCurveSurface_TriangleRecord>& theTriangles);
+
+  //! Take over packets built earlier, e.g. read back from a cache file.
+  //! @param thePackets Packets of all leaves
+  //! @param theFirstPackets First packet of each leaf, indexed by the leaf's first primitive
+  void Assign(std::vector<BRepIntCurveSurface_TrianglePacket>&& thePackets,
+              std::vector<Standard_Integer>&&                   theFirstPackets)
+  {
+    myPackets     = std::move(thePackets);
+    myFirstPacket = std::move(theFirstPackets);
+  }
+
+  //! Returns all packets in leaf order
+  const std::vector<BRepIntCurveSurface_TrianglePacket>& Packets() const { return myPackets; }
+
+  //! Returns the first packet of each leaf, indexed by the leaf's first primitive
+  const std::vector<Standard_Integer>& FirstPackets() const { return myFirstPacket; }
+
+  //! Release all packets
+  void Clear()
+  {
+    myPackets.clear();
+    myPackets.shrink_to_fit();
+    myFirstPacket.clear();
+    myFirstPacket.shrink_to_fit();
+  }
+
+  //! Returns true if no packets are stored
+  Standard_Boolean IsEmpty() const { return myPackets.empty(); }
+
+  //! Returns the number of packets
+  Standard_Integer NbPackets() const { return static_cast<Standard_Integer>(myPackets.size()); }
+
+  //! Returns the first packet of the leaf starting at primitive theFirstPrim
+  const BRepIntCurveSurface_TrianglePacket* LeafPackets(const Standard_Integer theFirstPrim) const
+  {
+    return myPackets.data() + myFirstPacket[theFirstPrim];
+  }
+
+  //! Returns primitive thePrim of the leaf starting at primitive theFirstPrim
+  //! (OriginalIndex is -1 for a removed triangle)
+  BRepIntCurveSurface_TriangleRecord Triangle(const Standard_Integer theFirstPrim,
+                                              const Standard_Integer thePrim) const
+  {
+    const BRepIntCurveSurface_TrianglePacket& aPacket =
+      LeafPackets(theFirstPrim)[(thePrim - theFirstPrim) / Lanes];
+    const int                          aLane = (thePrim - theFirstPrim) % Lanes;
+    BRepIntCurveSurface_TriangleRecord aTri;
+    for (int k = 0; k < 3; ++k)
+    {
+      aTri.V0[k]    = aPacket.V0[k][aLane];
+      aTri.Edge1[k] = aPacket.Edge1[k][aLane];
+      aTri.Edge2[k] = aPacket.Edge2[k][aLane];
+    }
+    aTri.OriginalIndex = aPacket.OriginalIndex[aLane];
+    return aTri;
+  }
+
+  //! Replace primitive thePrim of the leaf starting at primitive theFirstPrim; a
+  //! triangle with zero edges and OriginalIndex -1 is never reported as a hit
+  void SetTriangle(const Standard_Integer                    theFirstPrim,
+                   const Standard_Integer                    thePrim,
+                   const BRepIntCurveSurface_TriangleRecord& theTriangle)
+  {
+    BRepIntCurveSurface_TrianglePacket& aPacket =
+      myPackets[myFirstPacket[theFirstPrim] + (thePrim - theFirstPrim) / Lanes];
+    const int aLane = (thePrim - theFirstPrim) % Lanes;
+    for (int k = 0; k < 3; ++k)
+    {
+      aPacket.V0[k][aLane]    = theTriangle.V0[k];
+      aPacket.Edge1[k][aLane] = theTriangle.Edge1[k];
+      aPacket.Edge2[k][aLane] = theTriangle.Edge2[k];
+    }
+    aPacket.OriginalIndex[aLane] = theTriangle.OriginalIndex;
+  }
+
+  //! Returns the number of packets of a leaf with theNbPrims primitives
+  static Standard_Integer NbLeafPackets(const Standard_Integer theNbPrims)
+  {
+    return (theNbPrims + Lanes - 1) / Lanes;
+  }
+
+  //! Returns the size of the packet storage in bytes
+  Standard_Size MemorySize() const
+  {
+    return myPackets.capacity() * sizeof(BRepIntCurveSurface_TrianglePacket)
+           + myFirstPacket.capacity() * sizeof(Standard_Integer);
+  }
+
+  //! Returns true if Intersect() was compiled with an AVX or AVX-512 kernel; without
+  //! one, packets are slower than testing the triangle records one by one.
+  Standard_EXPORT static Standard_Boolean IsVectorized();
+
+  //! Möller–Trumbore test of a ray against the used lanes of a packet: one 8-wide pass
+  //! with AVX-512, one 4-wide pass per quad holding triangles with AVX, a scalar loop
+  //! over the triangles otherwise. Padding lanes are never reported.
+  //! @param thePacket Triangles to test
+  //! @param theNbTriangles Number of leading lanes holding triangles, in [1, Lanes]
+  //! @param theOrigin Ray origin
+  //! @param theDir Ray direction
+  //! @param theMin Minimum parameter on ray
+  //! @param theMax Maximum parameter on ray (inclusive)
+  //! @param theT Output: parameter on ray of every lane
+  //! @param theU Output: barycentric U of every lane
+  //! @param theV Output: barycentric V of every lane
+  //! @return bit mask of lanes hit within [theMin, theMax]; outputs of other lanes
+  //!         may be left unset
+  Standard_EXPORT static int Intersect(const BRepIntCurveSurface_TrianglePacket& thePacket,
+                                       const Standard_Integer                    theNbTriangles,
+                                       const BVH_Vec3d&                          theOrigin,
+                                       const BVH_Vec3d&                          theDir,
+                                       const Standard_Real                       theMin,
+                                       const Standard_Real                       theMax,
+                                       Standard_Real                             theT[Lanes],
+                                       Standard_Real                             theU[Lanes],
+                                       Standard_Real                             theV[Lanes]);
+
+private:
+  std::vector<BRepIntCurveSurface_TrianglePacket> myPackets;
+  std::vector<Standard_Integer> myFirstPacket; //!< First packet of a leaf, by its first primitive
+};
+
+#endif // _BRepIntCurveSurface_TrianglePackets_HeaderFile
@@ -0,0 +1,126 @@
+// Created on: 2025-04-14
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_TriangleUVs.hxx>
+
+#include <cmath>
+
+namespace
+{
+//! Relative threshold on the determinant of the correction step
+const Standard_Real CURVED_UV_SINGULARITY = 1.0e-12;
+
+//! Convert a stored derivative to double precision
+NCollection_Vec3<Standard_Real> toReal(const NCollection_Vec3<Standard_ShortReal>& theVec)
+{
+  return NCollection_Vec3<Standard_Real>(theVec.x(), theVec.y(), theVec.z());
+}
+} // namespace
+
+//=================================================================================================
+
+void BRepIntCurveSurface_TriangleUVs::Init(const Standard_Boolean theIsCompact,
+                                           const Standard_Boolean theHasDerivatives)
+{
+  myNodes.clear();
+  myNodes.shrink_to_fit();
+  myCompactNodes.clear();
+  myCompactNodes.shrink_to_fit();
+  myDerivatives.clear();
+  myDerivatives.shrink_to_fit();
+  myOrigins.clear();
+  myOrigins.shrink_to_fit();
+  myIsCompact      = theIsCompact;
+  myHasDerivatives = theHasDerivatives;
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_TriangleUVs::Resize(const Standard_Integer theNbNodes,
+                                             const Standard_Integer theNbFaces)
+{
+  if (myIsCompact)
+    myCompactNodes.resize(theNbNodes, NCollection_Vec2<Standard_ShortReal>(0.0f, 0.0f));
+  else
+    myNodes.resize(theNbNodes, gp_Pnt2d(0.0, 0.0));
+  if (myHasDerivatives)
+    myDerivatives.resize(static_cast<size_t>(theNbNodes) * 2,
+                         NCollection_Vec3<Standard_ShortReal>(0.0f, 0.0f, 0.0f));
+  myOrigins.resize(theNbFaces, gp_Pnt2d(0.0, 0.0));
+}
+
+//=================================================================================================
+
+gp_Pnt2d BRepIntCurveSurface_TriangleUVs::InterpolateCurved(const Standard_Integer theNodes[3],
+                                                            const Standard_Integer theFace,
+                                                            const Standard_Real    theU,
+                                                            const Standard_Real    theV,
+                                                            const gp_XYZ&          theDir) const
+{
+  const gp_Pnt2d aUV = Interpolate(theNodes, theFace, theU, theV);
+  if (!myHasDerivatives)
+    return aUV;
+
+  // Blend the derivatives at the hit, and the corners' tangent-plane predictions of the
+  // face point at aUV relative to the chord: aBulge = sum w_i * (D1U_i du_i + D1V_i dv_i)
+  const Standard_Real             aWeights[3] = {1.0 - theU - theV, theU, theV};
+  NCollection_Vec3<Standard_Real> aD1U(0.0, 0.0, 0.0);
+  NCollection_Vec3<Standard_Real> aD1V(0.0, 0.0, 0.0);
+  NCollection_Vec3<Standard_Real> aBulge(0.0, 0.0, 0.0);
+  gp_Pnt2d                        aMin(aUV), aMax(aUV);
+  for (int k = 0; k < 3; ++k)
+  {
+    const gp_Pnt2d                        aNode   = Node(theNodes[k], theFace);
+    const NCollection_Vec3<Standard_Real> aNodeDU = toReal(myDerivatives[2 * theNodes[k]]);
+    const NCollection_Vec3<Standard_Real> aNodeDV = toReal(myDerivatives[2 * theNodes[k] + 1]);
+    aD1U += aNodeDU * aWeights[k];
+    aD1V += aNodeDV * aWeights[k];
+    aBulge += (aNodeDU * (aUV.X() - aNode.X()) + aNodeDV * (aUV.Y() - aNode.Y())) * aWeights[k];
+    aMin.SetCoord(std::min(aMin.X(), aNode.X()), std::min(aMin.Y(), aNode.Y()));
+    aMax.SetCoord(std::max(aMax.X(), aNode.X()), std::max(aMax.Y(), aNode.Y()));
+  }
+
+  // The hit lies on the ray, the face point is estimated at hit + aBulge / 2. Solve
+  // for the step bringing the estimate onto the ray, on the plane normal to the ray.
+  const NCollection_Vec3<Standard_Real> aDir(theDir.X(), theDir.Y(), theDir.Z());
+  const Standard_Real                   aDirSq = aDir.Dot(aDir);
+  if (aDirSq <= 0.0)
+    return aUV;
+  auto toNormalPlane = [&](const NCollection_Vec3<Standard_Real>& theVec) {
+    return theVec - aDir * (theVec.Dot(aDir) / aDirSq);
+  };
+  const NCollection_Vec3<Standard_Real> aTU    = toNormalPlane(aD1U);
+  const NCollection_Vec3<Standard_Real> aTV    = toNormalPlane(aD1V);
+  const NCollection_Vec3<Standard_Real> aGap   = toNormalPlane(aBulge) * 0.5;
+  const Standard_Real                   aGramU = aTU.Dot(aTU);
+  const Standard_Real                   aGramX = aTU.Dot(aTV);
+  const Standard_Real                   aGramV = aTV.Dot(aTV);
+  const Standard_Real                   aDet   = aGramU * aGramV - aGramX * aGramX;
+  if (aDet <= 0.0 || aDet <= CURVED_UV_SINGULARITY * aGramU * aGramV)
+    return aUV;
+
+  const Standard_Real aRhsU = -aTU.Dot(aGap);
+  const Standard_Real aRhsV = -aTV.Dot(aGap);
+  const gp_Pnt2d      aCurved(aUV.X() + (aGramV * aRhsU - aGramX * aRhsV) / aDet,
+                              aUV.Y() + (aGramU * aRhsV - aGramX * aRhsU) / aDet);
+
+  // Keep the linear UV if the step leaves the neighbourhood of the triangle
+  const Standard_Real aSizeU = aMax.X() - aMin.X();
+  const Standard_Real aSizeV = aMax.Y() - aMin.Y();
+  if (aCurved.X() < aMin.X() - aSizeU || aCurved.X() > aMax.X() + aSizeU
+      || aCurved.Y() < aMin.Y() - aSizeV || aCurved.Y() > aMax.Y() + aSizeV)
+    return aUV;
+  return aCurved;
+}
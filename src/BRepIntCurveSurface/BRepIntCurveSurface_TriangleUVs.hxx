@@ -0,0 +1,207 @@
+// Created on: 2025-04-14
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_TriangleUVs_HeaderFile
+#define _BRepIntCurveSurface_TriangleUVs_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+
+#include <gp_Pnt2d.hxx>
+#include <gp_Vec.hxx>
+#include <gp_XYZ.hxx>
+#include <NCollection_Vec2.hxx>
+#include <NCollection_Vec3.hxx>
+
+#include <algorithm>
+#include <vector>
+
+//! UV nodes of the triangulations, shared by the triangles referencing them.
+//!
+//! Nodes are stored once per triangulation node instead of three times per
+//! triangle. In compact mode they are single precision offsets from an origin
+//! per face (usually the face's first node), so the float mantissa covers the
+//! parameter range of the face rather than the absolute parameter values. The
+//! nodes only seed the Newton refinement, which restores full precision.
+//!
+//! Optionally, the first derivatives of the face surface are kept at every node
+//! (single precision), so that the UV of a hit can be corrected for the curvature
+//! of the face between the corners of its triangle (see InterpolateCurved()).
+class BRepIntCurveSurface_TriangleUVs
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Empty constructor
+  BRepIntCurveSurface_TriangleUVs()
+      : myIsCompact(Standard_False),
+        myHasDerivatives(Standard_False)
+  {
+  }
+
+  //! Release all nodes and faces, select the storage precision and whether the surface
+  //! derivatives are kept at the nodes
+  Standard_EXPORT void Init(const Standard_Boolean theIsCompact,
+                            const Standard_Boolean theHasDerivatives = Standard_False);
+
+  //! Resize the node and face tables; added nodes, derivatives and origins are zero
+  Standard_EXPORT void Resize(const Standard_Integer theNbNodes, const Standard_Integer theNbFaces);
+
+  //! Returns true if the nodes are single precision offsets
+  Standard_Boolean IsCompact() const { return myIsCompact; }
+
+  //! Returns true if the surface derivatives are kept at the nodes
+  Standard_Boolean HasDerivatives() const { return myHasDerivatives; }
+
+  //! Returns the number of nodes
+  Standard_Integer NbNodes() const
+  {
+    return static_cast<Standard_Integer>(myIsCompact ? myCompactNodes.size() : myNodes.size());
+  }
+
+  //! Returns the number of faces
+  Standard_Integer NbFaces() const { return static_cast<Standard_Integer>(myOrigins.size()); }
+
+  //! Set the origin of the nodes of face theFace; must precede SetNode() on the face
+  void SetOrigin(const Standard_Integer theFace, const gp_Pnt2d& theOrigin)
+  {
+    myOrigins[theFace] = theOrigin;
+  }
+
+  //! Set node theNode, belonging to face theFace
+  void SetNode(const Standard_Integer theNode,
+               const Standard_Integer theFace,
+               const gp_Pnt2d&        theUV)
+  {
+    if (myIsCompact)
+    {
+      const gp_Pnt2d& anOrigin    = myOrigins[theFace];
+      myCompactNodes[theNode].x() = static_cast<Standard_ShortReal>(theUV.X() - anOrigin.X());
+      myCompactNodes[theNode].y() = static_cast<Standard_ShortReal>(theUV.Y() - anOrigin.Y());
+    }
+    else
+    {
+      myNodes[theNode] = theUV;
+    }
+  }
+
+  //! Set the first derivatives of the face surface at node theNode; the table must
+  //! keep derivatives
+  void SetDerivatives(const Standard_Integer theNode, const gp_Vec& theD1U, const gp_Vec& theD1V)
+  {
+    myDerivatives[2 * theNode]     = NCollection_Vec3<Standard_ShortReal>(
+      static_cast<Standard_ShortReal>(theD1U.X()),
+      static_cast<Standard_ShortReal>(theD1U.Y()),
+      static_cast<Standard_ShortReal>(theD1U.Z()));
+    myDerivatives[2 * theNode + 1] = NCollection_Vec3<Standard_ShortReal>(
+      static_cast<Standard_ShortReal>(theD1V.X()),
+      static_cast<Standard_ShortReal>(theD1V.Y()),
+      static_cast<Standard_ShortReal>(theD1V.Z()));
+  }
+
+  //! Returns node theNode of face theFace
+  gp_Pnt2d Node(const Standard_Integer theNode, const Standard_Integer theFace) const
+  {
+    if (!myIsCompact)
+      return myNodes[theNode];
+
+    const NCollection_Vec2<Standard_ShortReal>& aNode = myCompactNodes[theNode];
+    return gp_Pnt2d(myOrigins[theFace].X() + aNode.x(), myOrigins[theFace].Y() + aNode.y());
+  }
+
+  //! Interpolate the UV of a point of a triangle: w * UV0 + u * UV1 + v * UV2.
+  //! @param theNodes Nodes of the triangle's corners
+  //! @param theFace Face of the triangle
+  //! @param theU Barycentric U of the point
+  //! @param theV Barycentric V of the point
+  gp_Pnt2d Interpolate(const Standard_Integer theNodes[3],
+                       const Standard_Integer theFace,
+                       const Standard_Real    theU,
+                       const Standard_Real    theV) const
+  {
+    const Standard_Real aW = 1.0 - theU - theV;
+    if (!myIsCompact)
+    {
+      const gp_Pnt2d& aUV0 = myNodes[theNodes[0]];
+      const gp_Pnt2d& aUV1 = myNodes[theNodes[1]];
+      const gp_Pnt2d& aUV2 = myNodes[theNodes[2]];
+      return gp_Pnt2d(aW * aUV0.X() + theU * aUV1.X() + theV * aUV2.X(),
+                      aW * aUV0.Y() + theU * aUV1.Y() + theV * aUV2.Y());
+    }
+
+    // Interpolate the offsets; the weights sum to one, so the origin is added once
+    const NCollection_Vec2<Standard_ShortReal>& aUV0 = myCompactNodes[theNodes[0]];
+    const NCollection_Vec2<Standard_ShortReal>& aUV1 = myCompactNodes[theNodes[1]];
+    const NCollection_Vec2<Standard_ShortReal>& aUV2 = myCompactNodes[theNodes[2]];
+    return gp_Pnt2d(myOrigins[theFace].X() + aW * aUV0.x() + theU * aUV1.x() + theV * aUV2.x(),
+                    myOrigins[theFace].Y() + aW * aUV0.y() + theU * aUV1.y() + theV * aUV2.y());
+  }
+
+  //! Interpolate the UV of a ray hit on a triangle, corrected for the curvature of the
+  //! face from the surface derivatives at the corners.
+  //!
+  //! The face point at the interpolated UV is estimated as the mean of the hit (on the
+  //! chord) and of the corners' tangent-plane predictions, exact for quadratic patches;
+  //! one Newton step of the derivatives, blended at the hit, then moves the UV so that
+  //! the estimate reaches the ray. Falls back to Interpolate() without derivatives,
+  //! for singular derivatives, or if the step leaves the triangle's UV box grown by
+  //! its own size.
+  //! @param theNodes Nodes of the triangle's corners
+  //! @param theFace Face of the triangle
+  //! @param theU Barycentric U of the hit
+  //! @param theV Barycentric V of the hit
+  //! @param theDir Ray direction, in the frame of the derivatives
+  Standard_EXPORT gp_Pnt2d InterpolateCurved(const Standard_Integer theNodes[3],
+                                             const Standard_Integer theFace,
+                                             const Standard_Real    theU,
+                                             const Standard_Real    theV,
+                                             const gp_XYZ&          theDir) const;
+
+  //! Compute the UV box of a triangle
+  //! @param theNodes Nodes of the triangle's corners
+  //! @param theFace Face of the triangle
+  void Bounds(const Standard_Integer theNodes[3],
+              const Standard_Integer theFace,
+              gp_Pnt2d&              theMin,
+              gp_Pnt2d&              theMax) const
+  {
+    const gp_Pnt2d aUV0 = Node(theNodes[0], theFace);
+    const gp_Pnt2d aUV1 = Node(theNodes[1], theFace);
+    const gp_Pnt2d aUV2 = Node(theNodes[2], theFace);
+    theMin.SetCoord(std::min(aUV0.X(), std::min(aUV1.X(), aUV2.X())),
+                    std::min(aUV0.Y(), std::min(aUV1.Y(), aUV2.Y())));
+    theMax.SetCoord(std::max(aUV0.X(), std::max(aUV1.X(), aUV2.X())),
+                    std::max(aUV0.Y(), std::max(aUV1.Y(), aUV2.Y())));
+  }
+
+  //! Returns the size of the node, derivative and origin storage in bytes
+  Standard_Size MemorySize() const
+  {
+    return myNodes.capacity() * sizeof(gp_Pnt2d)
+           + myCompactNodes.capacity() * sizeof(NCollection_Vec2<Standard_ShortReal>)
+           + myDerivatives.capacity() * sizeof(NCollection_Vec3<Standard_ShortReal>)
+           + myOrigins.capacity() * sizeof(gp_Pnt2d);
+  }
+
+private:
+  std::vector<gp_Pnt2d>                             myNodes;        //!< Nodes (full precision)
+  std::vector<NCollection_Vec2<Standard_ShortReal>> myCompactNodes; //!< Offsets (compact mode)
+  std::vector<NCollection_Vec3<Standard_ShortReal>> myDerivatives;  //!< D1U and D1V per node
+  std::vector<gp_Pnt2d>                             myOrigins;      //!< Origin per face
+  Standard_Boolean                                  myIsCompact;
+  Standard_Boolean                                  myHasDerivatives;
+};
+
+#endif // _BRepIntCurveSurface_TriangleUVs_HeaderFile
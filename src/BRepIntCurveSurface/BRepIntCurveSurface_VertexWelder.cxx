@@ -0,0 +1,284 @@
+// Created on: 2025-03-17
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_VertexWelder.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace
+{
+// Cell coordinates take at most this many bits per axis, so that keys never alias
+constexpr int CELL_BITS = 21;
+
+//! Sorted cell key of a welded vertex
+struct CellKey
+{
+  uint64_t         Key;
+  Standard_Integer Index;
+};
+
+//! Packs cell coordinates into a key; x varies fastest, so the three cells
+//! (x - 1 .. x + 1, y, z) form one contiguous key range
+class CellGrid
+{
+public:
+  CellGrid(const BVH_Vec3d& theMin, const BVH_Vec3d& theMax, const Standard_Real theTolerance)
+      : myMin(theMin)
+  {
+    // Cells are at least the tolerance wide, and wide enough for CELL_BITS bits per axis
+    // (coordinates are shifted by one so that neighbour cells are never negative)
+    const BVH_Vec3d     aSize    = theMax - theMin;
+    const Standard_Real anExtent = std::max(aSize[0], std::max(aSize[1], aSize[2]));
+    myCellSize =
+      std::max(theTolerance, anExtent / static_cast<Standard_Real>((1 << CELL_BITS) - 4));
+    if (!(myCellSize > 0.0))
+      myCellSize = 1.0; // single point, zero tolerance
+
+    myBits[0] = myBits[1] = myBits[2] = 1;
+    for (int k = 0; k < 3; ++k)
+    {
+      const int64_t aMaxCoord = Coord(theMax[k], k) + 1;
+      while ((int64_t(1) << myBits[k]) <= aMaxCoord)
+        ++myBits[k];
+    }
+  }
+
+  //! Total number of key bits
+  int NbBits() const { return myBits[0] + myBits[1] + myBits[2]; }
+
+  //! Cell coordinate along axis theAxis (at least 1)
+  int64_t Coord(const Standard_Real theValue, const int theAxis) const
+  {
+    return static_cast<int64_t>(std::floor((theValue - myMin[theAxis]) / myCellSize)) + 1;
+  }
+
+  //! Key of the cell with the given coordinates
+  uint64_t Key(const int64_t theX, const int64_t theY, const int64_t theZ) const
+  {
+    return static_cast<uint64_t>(theX) | (static_cast<uint64_t>(theY) << myBits[0])
+           | (static_cast<uint64_t>(theZ) << (myBits[0] + myBits[1]));
+  }
+
+private:
+  BVH_Vec3d     myMin;
+  Standard_Real myCellSize;
+  int           myBits[3];
+};
+
+//! Stable LSD radix sort of the keys, 8 bits per pass. Every thread histograms and
+//! scatters its own contiguous chunk; chunk offsets follow the digit-major prefix sum.
+void RadixSort(std::vector<CellKey>&  theKeys,
+               const int              theNbBits,
+               const Standard_Boolean theIsParallel)
+{
+  int aNbChunks = 1;
+#ifdef _OPENMP
+  if (theIsParallel)
+    aNbChunks = omp_get_max_threads();
+#else
+  (void)theIsParallel;
+#endif
+
+  const size_t         aNbKeys = theKeys.size();
+  std::vector<CellKey> aTemp(aNbKeys);
+  std::vector<size_t>  aHist(static_cast<size_t>(aNbChunks) * 256);
+
+  for (int aShift = 0; aShift < theNbBits; aShift += 8)
+  {
+    std::fill(aHist.begin(), aHist.end(), 0);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static, 1) if (aNbChunks > 1)
+#endif
+    for (int aChunk = 0; aChunk < aNbChunks; ++aChunk)
+    {
+      size_t*      aChunkHist = &aHist[static_cast<size_t>(aChunk) * 256];
+      const size_t aBeg       = aNbKeys * aChunk / aNbChunks;
+      const size_t aEnd       = aNbKeys * (aChunk + 1) / aNbChunks;
+      for (size_t i = aBeg; i < aEnd; ++i)
+        ++aChunkHist[(theKeys[i].Key >> aShift) & 0xFF];
+    }
+
+    size_t aSum = 0;
+    for (int aDigit = 0; aDigit < 256; ++aDigit)
+    {
+      for (int aChunk = 0; aChunk < aNbChunks; ++aChunk)
+      {
+        size_t&      aCount = aHist[static_cast<size_t>(aChunk) * 256 + aDigit];
+        const size_t aNext  = aSum + aCount;
+        aCount              = aSum;
+        aSum                = aNext;
+      }
+    }
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static, 1) if (aNbChunks > 1)
+#endif
+    for (int aChunk = 0; aChunk < aNbChunks; ++aChunk)
+    {
+      size_t*      aChunkHist = &aHist[static_cast<size_t>(aChunk) * 256];
+      const size_t aBeg       = aNbKeys * aChunk / aNbChunks;
+      const size_t aEnd       = aNbKeys * (aChunk + 1) / aNbChunks;
+      for (size_t i = aBeg; i < aEnd; ++i)
+        aTemp[aChunkHist[(theKeys[i].Key >> aShift) & 0xFF]++] = theKeys[i];
+    }
+
+    theKeys.swap(aTemp);
+  }
+}
+} // namespace
+
+//=================================================================================================
+
+void BRepIntCurveSurface_VertexWelder::Perform(const std::vector<BVH_Vec3d>&  theVertices,
+                                               const std::vector<char>*       theMask,
+                                               const Standard_Real            theTolerance,
+                                               const Standard_Boolean         theIsParallel,
+                                               std::vector<Standard_Integer>& theRoots)
+{
+  const Standard_Integer aNbVertices = static_cast<Standard_Integer>(theVertices.size());
+  theRoots.resize(aNbVertices);
+  for (Standard_Integer i = 0; i < aNbVertices; ++i)
+    theRoots[i] = i;
+
+  // Bounding box of the welded vertices
+  Standard_Integer aNbWelded = 0;
+  BVH_Vec3d        aMin(RealLast()), aMax(-RealLast());
+  for (Standard_Integer i = 0; i < aNbVertices; ++i)
+  {
+    if (theMask != nullptr && (*theMask)[i] == 0)
+      continue;
+    aMin = aMin.cwiseMin(theVertices[i]);
+    aMax = aMax.cwiseMax(theVertices[i]);
+    ++aNbWelded;
+  }
+  if (aNbWelded < 2)
+    return;
+
+  const CellGrid aGrid(aMin, aMax, theTolerance);
+
+  std::vector<CellKey> aKeys;
+  aKeys.reserve(aNbWelded);
+  for (Standard_Integer i = 0; i < aNbVertices; ++i)
+  {
+    if (theMask != nullptr && (*theMask)[i] == 0)
+      continue;
+    const BVH_Vec3d& aPnt = theVertices[i];
+    aKeys.push_back(
+      {aGrid.Key(aGrid.Coord(aPnt[0], 0), aGrid.Coord(aPnt[1], 1), aGrid.Coord(aPnt[2], 2)), i});
+  }
+  RadixSort(aKeys, aGrid.NbBits(), theIsParallel);
+
+  // First key of every occupied cell
+  std::vector<Standard_Integer> aCellStarts;
+  for (Standard_Integer k = 0; k < aNbWelded; ++k)
+  {
+    if (k == 0 || aKeys[k].Key != aKeys[k - 1].Key)
+      aCellStarts.push_back(k);
+  }
+  aCellStarts.push_back(aNbWelded);
+  const Standard_Integer aNbCells = static_cast<Standard_Integer>(aCellStarts.size()) - 1;
+
+  auto aLess = [](const CellKey& theKey, const uint64_t theValue) { return theKey.Key < theValue; };
+  const Standard_Real aTolSq = theTolerance * theTolerance;
+
+  // Smallest-index vertex within the tolerance (possibly the vertex itself).
+  // The first key of a neighbour row (x - 1, y + dy, z + dz) is the cell key plus a
+  // constant, so while the cells of a chunk are visited in key order each of the 9 row
+  // cursors only moves forward: one binary search per chunk, then a linear merge.
+  int aNbChunks = 1;
+#ifdef _OPENMP
+  if (theIsParallel)
+    aNbChunks = std::min(aNbCells, 4 * omp_get_max_threads());
+  #pragma omp parallel for schedule(dynamic, 1) if (aNbChunks > 1)
+#endif
+  for (int aChunk = 0; aChunk < aNbChunks; ++aChunk)
+  {
+    const Standard_Integer aChunkBeg = static_cast<Standard_Integer>(
+      static_cast<int64_t>(aNbCells) * aChunk / aNbChunks);
+    const Standard_Integer aChunkEnd = static_cast<Standard_Integer>(
+      static_cast<int64_t>(aNbCells) * (aChunk + 1) / aNbChunks);
+
+    Standard_Integer aRowBeg[9];
+    Standard_Integer aRowEnd[9];
+    for (Standard_Integer aCell = aChunkBeg; aCell < aChunkEnd; ++aCell)
+    {
+      const Standard_Integer aCellBeg = aCellStarts[aCell];
+      const Standard_Integer aCellEnd = aCellStarts[aCell + 1];
+      const BVH_Vec3d&       aCorner  = theVertices[aKeys[aCellBeg].Index];
+      const int64_t          aX       = aGrid.Coord(aCorner[0], 0);
+      const int64_t          aY       = aGrid.Coord(aCorner[1], 1);
+      const int64_t          aZ       = aGrid.Coord(aCorner[2], 2);
+
+      for (int aRow = 0; aRow < 9; ++aRow)
+      {
+        const uint64_t aFirst = aGrid.Key(aX - 1, aY + aRow % 3 - 1, aZ + aRow / 3 - 1);
+        const uint64_t aLast  = aGrid.Key(aX + 1, aY + aRow % 3 - 1, aZ + aRow / 3 - 1);
+        if (aCell == aChunkBeg)
+        {
+          aRowBeg[aRow] = static_cast<Standard_Integer>(
+            std::lower_bound(aKeys.begin(), aKeys.end(), aFirst, aLess) - aKeys.begin());
+          aRowEnd[aRow] = aRowBeg[aRow];
+        }
+        while (aRowBeg[aRow] < aNbWelded && aKeys[aRowBeg[aRow]].Key < aFirst)
+          ++aRowBeg[aRow];
+        aRowEnd[aRow] = std::max(aRowEnd[aRow], aRowBeg[aRow]);
+        while (aRowEnd[aRow] < aNbWelded && aKeys[aRowEnd[aRow]].Key <= aLast)
+          ++aRowEnd[aRow];
+      }
+
+      for (Standard_Integer k = aCellBeg; k < aCellEnd; ++k)
+      {
+        const Standard_Integer i     = aKeys[k].Index;
+        const BVH_Vec3d&       aPnt  = theVertices[i];
+        Standard_Integer       aRoot = i;
+        for (int aRow = 0; aRow < 9; ++aRow)
+        {
+          for (Standard_Integer j = aRowBeg[aRow]; j < aRowEnd[aRow]; ++j)
+          {
+            const Standard_Integer anOther = aKeys[j].Index;
+            if (anOther >= aRoot)
+              continue;
+            const BVH_Vec3d aDelta = theVertices[anOther] - aPnt;
+            if (aDelta[0] * aDelta[0] + aDelta[1] * aDelta[1] + aDelta[2] * aDelta[2] < aTolSq)
+              aRoot = anOther;
+          }
+        }
+        theRoots[i] = aRoot;
+      }
+    }
+  }
+
+  // Resolve chains in index order: the root of a smaller index is already final. A
+  // vertex joins the root of its neighbour only within the tolerance of that root, so
+  // that runs of nodes spaced just under the tolerance do not collapse into one vertex;
+  // otherwise it stays a root of its own.
+  for (Standard_Integer i = 0; i < aNbVertices; ++i)
+  {
+    const Standard_Integer aRoot = theRoots[theRoots[i]];
+    if (aRoot == theRoots[i])
+      continue;
+
+    const BVH_Vec3d aDelta = theVertices[aRoot] - theVertices[i];
+    theRoots[i] =
+      aDelta[0] * aDelta[0] + aDelta[1] * aDelta[1] + aDelta[2] * aDelta[2] < aTolSq ? aRoot : i;
+  }
+}
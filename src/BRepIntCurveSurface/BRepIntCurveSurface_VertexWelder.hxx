@@ -0,0 +1,60 @@
+// Created on: 2025-03-17
+// Created by: Andrea Pozzetti
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_VertexWelder_HeaderFile
+#define _BRepIntCurveSurface_VertexWelder_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+
+#include <BVH_Types.hxx>
+
+#include <vector>
+
+//! Merges vertices closer than a tolerance.
+//!
+//! Vertices are quantized to cells of at least the tolerance, and the packed cell
+//! keys are radix sorted so that each cell is a contiguous range. The neighbours of
+//! a vertex lie in the 3x3x3 surrounding cells, i.e. in 9 key ranges that are walked
+//! forward as the cells are visited in key order; there is no hash map and no per-cell
+//! allocation. Sorting and the neighbour search run on all OpenMP threads. Memory is
+//! two key arrays of 16 bytes per welded vertex plus one index per occupied cell.
+//!
+//! Every vertex is mapped to the smallest-index vertex within the tolerance, and
+//! chains are resolved to their first vertex as long as it lies within the tolerance
+//! (a vertex farther from it stays a representative), so merged vertices are never
+//! farther than the tolerance from their representative and the result does not
+//! depend on the number of threads.
+class BRepIntCurveSurface_VertexWelder
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Compute the representative of every vertex.
+  //! @param theVertices Vertex positions
+  //! @param theMask If not null, only vertices with a non-zero entry are welded;
+  //!        the others are their own representative
+  //! @param theTolerance Vertices closer than this distance are merged
+  //! @param theIsParallel Use OpenMP threads
+  //! @param theRoots Output: index of the representative of each vertex, never
+  //!        greater than the vertex index
+  Standard_EXPORT static void Perform(const std::vector<BVH_Vec3d>&  theVertices,
+                                      const std::vector<char>*       theMask,
+                                      const Standard_Real            theTolerance,
+                                      const Standard_Boolean         theIsParallel,
+                                      std::vector<Standard_Integer>& theRoots);
+};
+
+#endif // _BRepIntCurveSurface_VertexWelder_HeaderFile
@@ -0,0 +1,302 @@
+// Created on: 2025-01-27
+// Created by: Andrea Pozzetti (with Claude Code assistance)
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#include <BRepIntCurveSurface_WideBVH.hxx>
+
+#include <BRepIntCurveSurface_FlatBVH.hxx>
+#include <Standard_ProgramError.hxx>
+
+#include <functional>
+
+namespace
+{
+//! Half surface area of a node box (used to pick the child to open)
+inline Standard_Real HalfArea(const BVH_Tree<Standard_Real, 3>& theTree,
+                              const Standard_Integer            theNode)
+{
+  const BVH_Vec3d aSize = theTree.MaxPoint(theNode) - theTree.MinPoint(theNode);
+  return aSize[0] * aSize[1] + aSize[1] * aSize[2] + aSize[2] * aSize[0];
+}
+
+//! Store the box and link of binary node theNode in child slot theSlot
+template <int W>
+void SetSlot(BRepIntCurveSurface_WideNode<W>&  theWide,
+             const Standard_Integer            theSlot,
+             const BVH_Tree<Standard_Real, 3>& theTree,
+             const Standard_Integer            theNode)
+{
+  const BVH_Vec3d& aMin = theTree.MinPoint(theNode);
+  const BVH_Vec3d& aMax = theTree.MaxPoint(theNode);
+
+  theWide.MinX[theSlot]    = BRepIntCurveSurface_FlatBVH::RoundDown(aMin[0]);
+  theWide.MinY[theSlot]    = BRepIntCurveSurface_FlatBVH::RoundDown(aMin[1]);
+  theWide.MinZ[theSlot]    = BRepIntCurveSurface_FlatBVH::RoundDown(aMin[2]);
+  theWide.MaxX[theSlot]    = BRepIntCurveSurface_FlatBVH::RoundUp(aMax[0]);
+  theWide.MaxY[theSlot]    = BRepIntCurveSurface_FlatBVH::RoundUp(aMax[1]);
+  theWide.MaxZ[theSlot]    = BRepIntCurveSurface_FlatBVH::RoundUp(aMax[2]);
+  theWide.Offset[theSlot]  = 0;
+  theWide.NbPrims[theSlot] = 0;
+  if (theTree.IsOuter(theNode))
+  {
+    theWide.Offset[theSlot]  = theTree.BegPrimitive(theNode);
+    theWide.NbPrims[theSlot] = theTree.EndPrimitive(theNode) - theTree.BegPrimitive(theNode) + 1;
+  }
+}
+
+//! Emit a wide node for the children of inner binary node theNode, then its
+//! inner children in depth-first order. Returns the index of the emitted node.
+template <int W>
+Standard_Integer EmitWideNode(const BVH_Tree<Standard_Real, 3>&             theTree,
+                              const Standard_Integer                        theNode,
+                              const Standard_Integer                        theLevel,
+                              std::vector<BRepIntCurveSurface_WideNode<W>>& theNodes,
+                              Standard_Integer&                             theDepth)
+{
+  theDepth = std::max(theDepth, theLevel);
+
+  // Open the largest inner child until all W slots are used
+  Standard_Integer aChildren[W];
+  Standard_Integer aNbChildren = 0;
+  aChildren[aNbChildren++]     = theTree.template Child<0>(theNode);
+  aChildren[aNbChildren++]     = theTree.template Child<1>(theNode);
+  while (aNbChildren < W)
+  {
+    Standard_Integer aBest     = -1;
+    Standard_Real    aBestArea = -1.0;
+    for (Standard_Integer i = 0; i < aNbChildren; ++i)
+    {
+      if (theTree.IsOuter(aChildren[i]))
+        continue;
+      const Standard_Real anArea = HalfArea(theTree, aChildren[i]);
+      if (anArea > aBestArea)
+      {
+        aBest     = i;
+        aBestArea = anArea;
+      }
+    }
+    if (aBest < 0)
+      break;
+
+    const Standard_Integer anOpened = aChildren[aBest];
+    aChildren[aBest]                = theTree.template Child<0>(anOpened);
+    aChildren[aNbChildren++]        = theTree.template Child<1>(anOpened);
+  }
+
+  const Standard_Integer aWideIdx = static_cast<Standard_Integer>(theNodes.size());
+  theNodes.emplace_back();
+  BRepIntCurveSurface_WideNode<W>& aWide = theNodes[aWideIdx];
+  aWide.NbChildren                       = aNbChildren;
+  for (Standard_Integer i = 0; i < aNbChildren; ++i)
+  {
+    SetSlot(aWide, i, theTree, aChildren[i]);
+  }
+
+  // Node references are re-fetched by index as emplace_back may reallocate
+  for (Standard_Integer i = 0; i < aNbChildren; ++i)
+  {
+    if (theTree.IsOuter(aChildren[i]))
+      continue;
+    const Standard_Integer aChildIdx =
+      EmitWideNode(theTree, aChildren[i], theLevel + 1, theNodes, theDepth);
+    theNodes[aWideIdx].Offset[i] = aChildIdx;
+  }
+  return aWideIdx;
+}
+
+template <int W>
+void BuildWide(const BVH_Tree<Standard_Real, 3>&             theTree,
+               std::vector<BRepIntCurveSurface_WideNode<W>>& theNodes,
+               Standard_Integer&                             theDepth)
+{
+  // Every wide node replaces at least one binary inner node
+  theNodes.reserve(theTree.Length() / 2 + 1);
+
+  if (theTree.IsOuter(0))
+  {
+    // Single-leaf tree: root holds the leaf in its only slot
+    theNodes.emplace_back();
+    theNodes[0].NbChildren = 1;
+    SetSlot(theNodes[0], 0, theTree, 0);
+    return;
+  }
+
+  // Recursion depth is bounded by the builder's maximum tree depth
+  EmitWideNode(theTree, 0, 0, theNodes, theDepth);
+}
+
+//! Record the parent slot of every node and the leaf slot of every primitive
+template <int W>
+void IndexNodes(const std::vector<BRepIntCurveSurface_WideNode<W>>& theNodes,
+                std::vector<Standard_Integer>&                      theParents,
+                std::vector<Standard_Integer>&                      thePrimLeaves)
+{
+  const Standard_Integer aNbNodes = static_cast<Standard_Integer>(theNodes.size());
+  theParents.assign(aNbNodes, -1);
+  for (Standard_Integer aNode = 0; aNode < aNbNodes; ++aNode)
+  {
+    const BRepIntCurveSurface_WideNode<W>& aWide = theNodes[aNode];
+    for (Standard_Integer aSlot = 0; aSlot < aWide.NbChildren; ++aSlot)
+    {
+      if (aWide.NbPrims[aSlot] > 0)
+      {
+        std::fill(thePrimLeaves.begin() + aWide.Offset[aSlot],
+                  thePrimLeaves.begin() + aWide.Offset[aSlot] + aWide.NbPrims[aSlot],
+                  aNode * W + aSlot);
+      }
+      else
+      {
+        theParents[aWide.Offset[aSlot]] = aNode * W + aSlot;
+      }
+    }
+  }
+}
+
+//! Set the leaf slot boxes, then store the merged slot boxes of every changed node in
+//! its parent slot. Children follow their parent in emission order, so nodes are
+//! processed in decreasing index order.
+template <int W>
+void RefitNodes(std::vector<BRepIntCurveSurface_WideNode<W>>& theNodes,
+                const std::vector<Standard_Integer>&          theParents,
+                const std::vector<Standard_Integer>&          theLeaves,
+                const std::vector<BVH_Vec3d>&                 theMins,
+                const std::vector<BVH_Vec3d>&                 theMaxs)
+{
+  std::vector<Standard_Integer> aChanged;
+  for (size_t i = 0; i < theLeaves.size(); ++i)
+  {
+    BRepIntCurveSurface_WideNode<W>& aWide = theNodes[theLeaves[i] / W];
+    const Standard_Integer           aSlot = theLeaves[i] % W;
+
+    aWide.MinX[aSlot] = BRepIntCurveSurface_FlatBVH::RoundDown(theMins[i][0]);
+    aWide.MinY[aSlot] = BRepIntCurveSurface_FlatBVH::RoundDown(theMins[i][1]);
+    aWide.MinZ[aSlot] = BRepIntCurveSurface_FlatBVH::RoundDown(theMins[i][2]);
+    aWide.MaxX[aSlot] = BRepIntCurveSurface_FlatBVH::RoundUp(theMaxs[i][0]);
+    aWide.MaxY[aSlot] = BRepIntCurveSurface_FlatBVH::RoundUp(theMaxs[i][1]);
+    aWide.MaxZ[aSlot] = BRepIntCurveSurface_FlatBVH::RoundUp(theMaxs[i][2]);
+    for (Standard_Integer aNode = theLeaves[i] / W; aNode >= 0;)
+    {
+      aChanged.push_back(aNode);
+      aNode = theParents[aNode] < 0 ? -1 : theParents[aNode] / W;
+    }
+  }
+  std::sort(aChanged.begin(), aChanged.end(), std::greater<Standard_Integer>());
+  aChanged.erase(std::unique(aChanged.begin(), aChanged.end()), aChanged.end());
+
+  // The root box is not stored; slot boxes are already rounded outwards
+  for (const Standard_Integer aNode : aChanged)
+  {
+    if (theParents[aNode] < 0)
+      continue;
+
+    const BRepIntCurveSurface_WideNode<W>& aWide   = theNodes[aNode];
+    BRepIntCurveSurface_WideNode<W>&       aParent = theNodes[theParents[aNode] / W];
+    const Standard_Integer                 aSlot   = theParents[aNode] % W;
+
+    aParent.MinX[aSlot] = *std::min_element(aWide.MinX, aWide.MinX + aWide.NbChildren);
+    aParent.MinY[aSlot] = *std::min_element(aWide.MinY, aWide.MinY + aWide.NbChildren);
+    aParent.MinZ[aSlot] = *std::min_element(aWide.MinZ, aWide.MinZ + aWide.NbChildren);
+    aParent.MaxX[aSlot] = *std::max_element(aWide.MaxX, aWide.MaxX + aWide.NbChildren);
+    aParent.MaxY[aSlot] = *std::max_element(aWide.MaxY, aWide.MaxY + aWide.NbChildren);
+    aParent.MaxZ[aSlot] = *std::max_element(aWide.MaxZ, aWide.MaxZ + aWide.NbChildren);
+  }
+}
+} // namespace
+
+//=================================================================================================
+
+void BRepIntCurveSurface_WideBVH::Build(const BVH_Tree<Standard_Real, 3>& theTree,
+                                        const Standard_Integer            theWidth)
+{
+  if (theWidth != 4 && theWidth != 8)
+  {
+    throw Standard_ProgramError("BRepIntCurveSurface_WideBVH::Build - width must be 4 or 8");
+  }
+
+  Clear();
+  myWidth = theWidth;
+
+  if (theTree.Length() == 0)
+    return;
+
+  if (myWidth == 8)
+    BuildWide(theTree, myNodes8, myDepth);
+  else
+    BuildWide(theTree, myNodes4, myDepth);
+
+  if (myDepth > MaxDepth(myWidth))
+  {
+    Clear();
+    throw Standard_ProgramError(
+      "BRepIntCurveSurface_WideBVH::Build - tree is too deep for traversal stack");
+  }
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_WideBVH::InitRefit(const Standard_Integer theNbPrims)
+{
+  myPrimLeaves.assign(theNbPrims, -1);
+  if (myWidth == 8)
+    IndexNodes(myNodes8, myParents, myPrimLeaves);
+  else
+    IndexNodes(myNodes4, myParents, myPrimLeaves);
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_WideBVH::LeafRange(const Standard_Integer theLeaf,
+                                            Standard_Integer&      theFirst,
+                                            Standard_Integer&      theNbPrims) const
+{
+  const Standard_Integer aNode = theLeaf / myWidth;
+  const Standard_Integer aSlot = theLeaf % myWidth;
+
+  theFirst   = myWidth == 8 ? myNodes8[aNode].Offset[aSlot] : myNodes4[aNode].Offset[aSlot];
+  theNbPrims = myWidth == 8 ? myNodes8[aNode].NbPrims[aSlot] : myNodes4[aNode].NbPrims[aSlot];
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_WideBVH::LeafBox(const Standard_Integer theLeaf,
+                                          BVH_Vec3d&             theMin,
+                                          BVH_Vec3d&             theMax) const
+{
+  const Standard_Integer aNode = theLeaf / myWidth;
+  const Standard_Integer aSlot = theLeaf % myWidth;
+  if (myWidth == 8)
+  {
+    const BRepIntCurveSurface_WideNode8& aWide = myNodes8[aNode];
+    theMin = BVH_Vec3d(aWide.MinX[aSlot], aWide.MinY[aSlot], aWide.MinZ[aSlot]);
+    theMax = BVH_Vec3d(aWide.MaxX[aSlot], aWide.MaxY[aSlot], aWide.MaxZ[aSlot]);
+  }
+  else
+  {
+    const BRepIntCurveSurface_WideNode4& aWide = myNodes4[aNode];
+    theMin = BVH_Vec3d(aWide.MinX[aSlot], aWide.MinY[aSlot], aWide.MinZ[aSlot]);
+    theMax = BVH_Vec3d(aWide.MaxX[aSlot], aWide.MaxY[aSlot], aWide.MaxZ[aSlot]);
+  }
+}
+
+//=================================================================================================
+
+void BRepIntCurveSurface_WideBVH::Refit(const std::vector<Standard_Integer>& theLeaves,
+                                        const std::vector<BVH_Vec3d>&        theMins,
+                                        const std::vector<BVH_Vec3d>&        theMaxs)
+{
+  if (myWidth == 8)
+    RefitNodes(myNodes8, myParents, theLeaves, theMins, theMaxs);
+  else
+    RefitNodes(myNodes4, myParents, theLeaves, theMins, theMaxs);
+}
@@ -0,0 +1,315 @@
+// Created on: 2025-01-27
+// Created by: Andrea Pozzetti (with Claude Code assistance)
+// Copyright (c) 2025 OPEN CASCADE SAS
+//
+// This file is part of Open CASCADE Technology software library.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License version 2.1 as published
+// by the Free Software Foundation, with special exception defined in the file
+// OCCT_LGPL_EXCEPTION.txt. Consult the file LICENSE_LGPL_21.txt included in OCCT
+// distribution for complete text of the license and disclaimer of any warranty.
+//
+// Alternatively, this file may be used under the terms of Open CASCADE
+// commercial license or contractual agreement.
+
+#ifndef _BRepIntCurveSurface_WideBVH_HeaderFile
+#define _BRepIntCurveSurface_WideBVH_HeaderFile
+
+#include <Standard.hxx>
+#include <Standard_DefineAlloc.hxx>
+
+#include <BVH_Tree.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <immintrin.h>
+  #define OCCT_RT_WIDE_SSE
+  #if defined(__AVX__)
+    #define OCCT_RT_WIDE_AVX
+  #endif
+#endif
+
+//! Node of the wide (4- or 8-ary) triangle BVH.
+//! Child boxes are stored as structure-of-arrays in single precision (rounded
+//! outwards) so that all of them are tested against a ray with one SIMD pass.
+//! Leaf children are stored inline as a primitive range of the parent slot.
+template <int W>
+struct alignas(32) BRepIntCurveSurface_WideNode
+{
+  Standard_ShortReal MinX[W], MinY[W], MinZ[W]; //!< Child box minimum corners
+  Standard_ShortReal MaxX[W], MaxY[W], MaxZ[W]; //!< Child box maximum corners
+  Standard_Integer   Offset[W];  //!< Inner child: index of its node; leaf child: first primitive
+  Standard_Integer   NbPrims[W]; //!< 0 for inner children, number of primitives for leaves
+  Standard_Integer   NbChildren; //!< Number of occupied slots (the rest are never reported)
+};
+
+//! 4-wide node (SSE)
+typedef BRepIntCurveSurface_WideNode<4> BRepIntCurveSurface_WideNode4;
+
+//! 8-wide node (AVX, or two SSE passes)
+typedef BRepIntCurveSurface_WideNode<8> BRepIntCurveSurface_WideNode8;
+
+//! Wide copy of a binary BVH_Tree.
+//!
+//! Each node is collapsed with its descendants by repeatedly opening the inner
+//! child with the largest surface area until the node has W children, which
+//! divides the number of traversal steps by roughly log2(W). Primitive indices
+//! are the same as in the source tree.
+class BRepIntCurveSurface_WideBVH
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Capacity of the fixed traversal stack; a visited node defers at most W children
+  static constexpr Standard_Integer MaxStackSize = 256;
+
+  //! Returns the deepest tree level whose traversal fits in MaxStackSize at width theWidth:
+  //! W - 1 deferred siblings per ancestor level plus the W children of a deepest node
+  static constexpr Standard_Integer MaxDepth(const Standard_Integer theWidth)
+  {
+    return (MaxStackSize - theWidth) / (theWidth - 1);
+  }
+
+  //! Empty constructor
+  BRepIntCurveSurface_WideBVH()
+      : myWidth(4),
+        myDepth(0)
+  {
+  }
+
+  //! Collapse the given tree.
+  //! @param theTree Binary BVH tree to collapse
+  //! @param theWidth Node arity, 4 or 8
+  //! @throw Standard_ProgramError if the width is not supported or the tree is too
+  //!        deep for the traversal stack
+  Standard_EXPORT void Build(const BVH_Tree<Standard_Real, 3>& theTree,
+                             const Standard_Integer            theWidth);
+
+  //! Take over 4-wide nodes built earlier, e.g. read back from a cache file
+  void Assign(std::vector<BRepIntCurveSurface_WideNode4>&& theNodes,
+              const Standard_Integer                       theDepth)
+  {
+    Clear();
+    myNodes4 = std::move(theNodes);
+    myWidth  = 4;
+    myDepth  = theDepth;
+  }
+
+  //! Take over 8-wide nodes built earlier, e.g. read back from a cache file
+  void Assign(std::vector<BRepIntCurveSurface_WideNode8>&& theNodes,
+              const Standard_Integer                       theDepth)
+  {
+    Clear();
+    myNodes8 = std::move(theNodes);
+    myWidth  = 8;
+    myDepth  = theDepth;
+  }
+
+  //! Release all nodes
+  void Clear()
+  {
+    myDepth = 0;
+    myNodes4.clear();
+    myNodes4.shrink_to_fit();
+    myNodes8.clear();
+    myNodes8.shrink_to_fit();
+    myParents.clear();
+    myParents.shrink_to_fit();
+    myPrimLeaves.clear();
+    myPrimLeaves.shrink_to_fit();
+  }
+
+  //! Returns true if no nodes are stored
+  Standard_Boolean IsEmpty() const { return NbNodes() == 0; }
+
+  //! Returns the node arity (4 or 8)
+  Standard_Integer Width() const { return myWidth; }
+
+  //! Returns the number of nodes
+  Standard_Integer NbNodes() const
+  {
+    return static_cast<Standard_Integer>(myWidth == 8 ? myNodes8.size() : myNodes4.size());
+  }
+
+  //! Returns the depth of the deepest node (root is level 0)
+  Standard_Integer Depth() const { return myDepth; }
+
+  //! Returns 4-wide nodes (empty unless Width() == 4)
+  const BRepIntCurveSurface_WideNode4* Nodes4() const { return myNodes4.data(); }
+
+  //! Returns 8-wide nodes (empty unless Width() == 8)
+  const BRepIntCurveSurface_WideNode8* Nodes8() const { return myNodes8.data(); }
+
+  //! Index the leaf of every primitive and the parent slot of every node for
+  //! PrimitiveLeaf() and Refit(). Leaves are child slots, identified by
+  //! node * Width() + slot. Linear in the number of nodes; the index is released
+  //! with the nodes.
+  //! @param theNbPrims Number of primitives referenced by the leaves
+  Standard_EXPORT void InitRefit(const Standard_Integer theNbPrims);
+
+  //! Returns true if InitRefit() was called since the nodes were last replaced
+  Standard_Boolean IsRefitReady() const { return !myParents.empty(); }
+
+  //! Returns the leaf slot holding primitive thePrim (requires InitRefit())
+  Standard_Integer PrimitiveLeaf(const Standard_Integer thePrim) const
+  {
+    return myPrimLeaves[thePrim];
+  }
+
+  //! Returns the first primitive and the number of primitives of leaf slot theLeaf
+  Standard_EXPORT void LeafRange(const Standard_Integer theLeaf,
+                                 Standard_Integer&      theFirst,
+                                 Standard_Integer&      theNbPrims) const;
+
+  //! Returns the box of leaf slot theLeaf
+  Standard_EXPORT void LeafBox(const Standard_Integer theLeaf,
+                               BVH_Vec3d&             theMin,
+                               BVH_Vec3d&             theMax) const;
+
+  //! Set new boxes of leaf slots and recompute the slot boxes of their ancestors; the
+  //! work is proportional to the number of leaves times the tree depth (requires
+  //! InitRefit()).
+  //! @param theLeaves Leaf slots
+  //! @param theMins New box minimum of each leaf
+  //! @param theMaxs New box maximum of each leaf
+  Standard_EXPORT void Refit(const std::vector<Standard_Integer>& theLeaves,
+                             const std::vector<BVH_Vec3d>&        theMins,
+                             const std::vector<BVH_Vec3d>&        theMaxs);
+
+  //! Returns the size of the node array (and of the refit index) in bytes
+  Standard_Size MemorySize() const
+  {
+    return myNodes4.capacity() * sizeof(BRepIntCurveSurface_WideNode4)
+           + myNodes8.capacity() * sizeof(BRepIntCurveSurface_WideNode8)
+           + (myParents.capacity() + myPrimLeaves.capacity()) * sizeof(Standard_Integer);
+  }
+
+  //! Test a ray against all child boxes of a node (slab method).
+  //! The far distance is moved toward +infinity by 2*gamma(3) of its magnitude, also
+  //! when it is negative, so that float rounding never culls a box the ray actually enters.
+  //! @param theNode Node whose children are tested
+  //! @param theOrigin Ray origin
+  //! @param theInvDir Inverse ray direction (finite)
+  //! @param theMin Minimum parameter on ray
+  //! @param theMax Maximum parameter on ray
+  //! @param theNear Output: entry distance of every child, clamped to theMin
+  //! @return bit mask of children whose box is entered within [theMin, theMax]
+  template <int W>
+  static int IntersectChildren(const BRepIntCurveSurface_WideNode<W>& theNode,
+                               const Standard_ShortReal               theOrigin[3],
+                               const Standard_ShortReal               theInvDir[3],
+                               const Standard_ShortReal               theMin,
+                               const Standard_ShortReal               theMax,
+                               Standard_ShortReal                     theNear[W])
+  {
+    const Standard_ShortReal aFarPad = 6.0f * std::numeric_limits<Standard_ShortReal>::epsilon();
+    int aMask = 0;
+#if defined(OCCT_RT_WIDE_AVX)
+    if constexpr (W == 8)
+    {
+      const __m256 aOrgX = _mm256_set1_ps(theOrigin[0]);
+      const __m256 aOrgY = _mm256_set1_ps(theOrigin[1]);
+      const __m256 aOrgZ = _mm256_set1_ps(theOrigin[2]);
+      const __m256 aInvX = _mm256_set1_ps(theInvDir[0]);
+      const __m256 aInvY = _mm256_set1_ps(theInvDir[1]);
+      const __m256 aInvZ = _mm256_set1_ps(theInvDir[2]);
+
+      const __m256 t1x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(theNode.MinX), aOrgX), aInvX);
+      const __m256 t2x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(theNode.MaxX), aOrgX), aInvX);
+      const __m256 t1y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(theNode.MinY), aOrgY), aInvY);
+      const __m256 t2y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(theNode.MaxY), aOrgY), aInvY);
+      const __m256 t1z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(theNode.MinZ), aOrgZ), aInvZ);
+      const __m256 t2z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(theNode.MaxZ), aOrgZ), aInvZ);
+
+      __m256 aNear = _mm256_max_ps(_mm256_min_ps(t1x, t2x), _mm256_set1_ps(theMin));
+      __m256 aFar  = _mm256_min_ps(_mm256_max_ps(t1x, t2x), _mm256_set1_ps(theMax));
+      aNear        = _mm256_max_ps(aNear, _mm256_min_ps(t1y, t2y));
+      aFar         = _mm256_min_ps(aFar, _mm256_max_ps(t1y, t2y));
+      aNear        = _mm256_max_ps(aNear, _mm256_min_ps(t1z, t2z));
+      aFar         = _mm256_min_ps(aFar, _mm256_max_ps(t1z, t2z));
+
+      // aFar += |aFar| * aFarPad, |x| by clearing the sign bit
+      aFar = _mm256_add_ps(aFar,
+                           _mm256_mul_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), aFar),
+                                         _mm256_set1_ps(aFarPad)));
+
+      _mm256_storeu_ps(theNear, aNear);
+      aMask = _mm256_movemask_ps(_mm256_cmp_ps(aNear, aFar, _CMP_LE_OQ));
+    }
+    else
+#endif
+    {
+#if defined(OCCT_RT_WIDE_SSE)
+      const __m128 aOrgX = _mm_set1_ps(theOrigin[0]);
+      const __m128 aOrgY = _mm_set1_ps(theOrigin[1]);
+      const __m128 aOrgZ = _mm_set1_ps(theOrigin[2]);
+      const __m128 aInvX = _mm_set1_ps(theInvDir[0]);
+      const __m128 aInvY = _mm_set1_ps(theInvDir[1]);
+      const __m128 aInvZ = _mm_set1_ps(theInvDir[2]);
+
+      for (int aBase = 0; aBase < W; aBase += 4)
+      {
+        const __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(theNode.MinX + aBase), aOrgX), aInvX);
+        const __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(theNode.MaxX + aBase), aOrgX), aInvX);
+        const __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(theNode.MinY + aBase), aOrgY), aInvY);
+        const __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(theNode.MaxY + aBase), aOrgY), aInvY);
+        const __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(theNode.MinZ + aBase), aOrgZ), aInvZ);
+        const __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(theNode.MaxZ + aBase), aOrgZ), aInvZ);
+
+        __m128 aNear = _mm_max_ps(_mm_min_ps(t1x, t2x), _mm_set1_ps(theMin));
+        __m128 aFar  = _mm_min_ps(_mm_max_ps(t1x, t2x), _mm_set1_ps(theMax));
+        aNear        = _mm_max_ps(aNear, _mm_min_ps(t1y, t2y));
+        aFar         = _mm_min_ps(aFar, _mm_max_ps(t1y, t2y));
+        aNear        = _mm_max_ps(aNear, _mm_min_ps(t1z, t2z));
+        aFar         = _mm_min_ps(aFar, _mm_max_ps(t1z, t2z));
+
+        // aFar += |aFar| * aFarPad, |x| by clearing the sign bit
+        aFar = _mm_add_ps(
+          aFar,
+          _mm_mul_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), aFar), _mm_set1_ps(aFarPad)));
+
+        _mm_storeu_ps(theNear + aBase, aNear);
+        aMask |= _mm_movemask_ps(_mm_cmple_ps(aNear, aFar)) << aBase;
+      }
+#else
+      for (int i = 0; i < W; ++i)
+      {
+        const Standard_ShortReal t1x = (theNode.MinX[i] - theOrigin[0]) * theInvDir[0];
+        const Standard_ShortReal t2x = (theNode.MaxX[i] - theOrigin[0]) * theInvDir[0];
+        const Standard_ShortReal t1y = (theNode.MinY[i] - theOrigin[1]) * theInvDir[1];
+        const Standard_ShortReal t2y = (theNode.MaxY[i] - theOrigin[1]) * theInvDir[1];
+        const Standard_ShortReal t1z = (theNode.MinZ[i] - theOrigin[2]) * theInvDir[2];
+        const Standard_ShortReal t2z = (theNode.MaxZ[i] - theOrigin[2]) * theInvDir[2];
+
+        Standard_ShortReal aNear = std::max(theMin, std::min(t1x, t2x));
+        Standard_ShortReal aFar  = std::min(theMax, std::max(t1x, t2x));
+        aNear                    = std::max(aNear, std::min(t1y, t2y));
+        aFar                     = std::min(aFar, std::max(t1y, t2y));
+        aNear                    = std::max(aNear, std::min(t1z, t2z));
+        aFar                     = std::min(aFar, std::max(t1z, t2z));
+        aFar += std::abs(aFar) * aFarPad;
+
+        theNear[i] = aNear;
+        if (aNear <= aFar)
+          aMask |= 1 << i;
+      }
+#endif
+    }
+    return aMask & ((1 << theNode.NbChildren) - 1);
+  }
+
+private:
+  std::vector<BRepIntCurveSurface_WideNode4> myNodes4;
+  std::vector<BRepIntCurveSurface_WideNode8> myNodes8;
+  std::vector<Standard_Integer>              myParents;    //!< Parent slot of each node (root: -1)
+  std::vector<Standard_Integer>              myPrimLeaves; //!< Leaf slot of each primitive
+  Standard_Integer                           myWidth;
+  Standard_Integer                           myDepth;
+};
+
+#endif // _BRepIntCurveSurface_WideBVH_HeaderFile
@@ -5,7 +5,6 @@
 
 #include <BRepIntCurveSurface_InterBVH.hxx>
 #include <BRepBndLib.hxx>
-#include <BRepMesh_IncrementalMesh.hxx>
 #include <Bnd_Box.hxx>
 #include <BRep_Builder.hxx>
 #include <BRepTools.hxx>
@@ -407,7 +406,11 @@ void RenderZHeightImage(BRepIntCurveSurface_InterBVH& theRaytracer,
 
   OSD_Timer timer;
   timer.Start();
-  theRaytracer.PerformBatch(rays, results);
+  theRaytracer.PerformBatch(rays,
+                            results,
+                            0,
+                            theWithNormals ? BRepIntCurveSurface_HitChannel_Normal
+                                           : BRepIntCurveSurface_HitChannel_Point);
   timer.Stop();
 
   // Find Z range for normalization
@@ -665,11 +668,18 @@ void RenderToNumpy(BRepIntCurveSurface_InterBVH& theRaytracer,
   }
   std::cout << std::endl;
 
+  // Evaluate the surface only for the requested channels
+  BRepIntCurveSurface_HitChannels hitChannels = BRepIntCurveSurface_HitChannel_Point;
+  if (outNormals)
+    hitChannels |= BRepIntCurveSurface_HitChannel_Normal;
+  if (outCurvGauss || outCurvMean || outCurvMin || outCurvMax)
+    hitChannels |= BRepIntCurveSurface_HitChannel_Curvature;
+
   NCollection_Array1<BRepIntCurveSurface_HitResult> results;
 
   OSD_Timer timer;
   timer.Start();
-  theRaytracer.PerformBatch(rays, results);
+  theRaytracer.PerformBatch(rays, results, 0, hitChannels);
   timer.Stop();
 
   // Create output buffer (HxWxC layout for NumPy)
@@ -856,6 +866,31 @@ void PrintUsage(const char* progName)
   std::cout << "                      embree  = Embree rtcIntersect1 (scalar)" << std::endl;
   std::cout << "                      embree4 = Embree rtcIntersect4 (SSE, 4 rays)" << std::endl;
   std::cout << "                      embree8 = Embree rtcIntersect8 (AVX, 8 rays)" << std::endl;
+  std::cout << "  --bvh-width N       Node arity of the occt backend: 2, 4, 8 (default: 2)"
+            << std::endl;
+  std::cout << "                      4/8 = wide nodes with SSE/AVX box tests" << std::endl;
+  std::cout << "  --bvh-builder B     BVH construction: linear, binned, sweep (default: linear)"
+            << std::endl;
+  std::cout << "                      binned/sweep = SAH splits, slower build, faster traversal"
+            << std::endl;
+  std::cout << "  --bvh-leaf-size N   Maximum triangles per BVH leaf (default: 4)" << std::endl;
+  std::cout << "  --bvh-max-depth N   Maximum BVH depth, 1-63 (default: 32)" << std::endl;
+  std::cout << "  --split-triangles   Split sliver triangles into several BVH references"
+            << std::endl;
+  std::cout << "  --weld-edges-only   Weld only mesh nodes on B-Rep edges" << std::endl;
+  std::cout << "  --bvh-cache DIR     Keep built BVHs in DIR and reload them on the next run"
+            << std::endl;
+  std::cout << "  --instancing        Share one BVH between the placements of a repeated part"
+            << std::endl;
+  std::cout << "  --compact-uvs       Store the UV nodes of the mesh as float32 offsets"
+            << std::endl;
+  std::cout << "  --curved-uvs        Correct the UV seeding Newton iteration for curvature"
+            << std::endl;
+  std::cout << "  --no-analytic       Refine hits on elementary surfaces by Newton iteration"
+            << std::endl;
+  std::cout << "  --ray-packets       Trace coherent rays in packets of 64 (default: on)"
+            << std::endl;
+  std::cout << "  --no-ray-packets    Trace every ray on its own" << std::endl;
   std::cout << "  --openmp            Enable OpenMP parallelization (default: on)" << std::endl;
   std::cout << "  --no-openmp         Disable OpenMP parallelization" << std::endl;
   std::cout << std::endl;
@@ -915,8 +950,20 @@ int main(int argc, char* argv[])
 
   // Backend and parallelization options
   BRepIntCurveSurface_BVHBackend backend           = BRepIntCurveSurface_BVHBackend::OCCT_BVH;
+  int                            bvhWidth          = 2;     // Binary flattened BVH
+  BRepIntCurveSurface_BVHBuilder bvhBuilder        = BRepIntCurveSurface_BVHBuilder::Linear;
+  int                            bvhLeafSize       = 4;
+  int                            bvhMaxDepth       = 32;
+  bool                           splitTriangles    = false; // Sliver pre-splitting
+  bool                           weldEdgesOnly     = false; // Weld all nodes by distance
+  bool                           useRayPackets     = true;  // Packet traversal (width 2)
   bool                           useOpenMP         = true;  // Enabled by default
   bool                           allowDisconnected = false; // Allow disconnected shapes
+  std::string                    bvhCacheDir;               // Empty: no BVH cache
+  bool                           useInstancing     = false; // Share BVHs of repeated parts
+  bool                           compactUVs        = false; // Float64 UV nodes
+  bool                           curvedUVs         = false; // Linear UV interpolation
+  bool                           useAnalytic       = true;  // Closed-form elementary hits
 
   // NumPy output channel flags
   bool npyPosition  = false; // X, Y, Z position (3 channels)
@@ -1072,6 +1119,103 @@ int main(int argc, char* argv[])
         }
       }
     }
+    else if (arg == "--bvh-width")
+    {
+      if (i + 1 < argc)
+      {
+        bvhWidth = std::atoi(argv[++i]);
+        if (bvhWidth != 2 && bvhWidth != 4 && bvhWidth != 8)
+        {
+          std::cerr << "Warning: Unsupported BVH width " << bvhWidth << ", using 2" << std::endl;
+          bvhWidth = 2;
+        }
+      }
+    }
+    else if (arg == "--bvh-builder")
+    {
+      if (i + 1 < argc)
+      {
+        std::string builderArg = argv[++i];
+        if (builderArg == "linear")
+        {
+          bvhBuilder = BRepIntCurveSurface_BVHBuilder::Linear;
+        }
+        else if (builderArg == "binned")
+        {
+          bvhBuilder = BRepIntCurveSurface_BVHBuilder::BinnedSAH;
+        }
+        else if (builderArg == "sweep")
+        {
+          bvhBuilder = BRepIntCurveSurface_BVHBuilder::SweepSAH;
+        }
+        else
+        {
+          std::cerr << "Warning: Unknown BVH builder '" << builderArg << "', using linear"
+                    << std::endl;
+        }
+      }
+    }
+    else if (arg == "--bvh-leaf-size")
+    {
+      if (i + 1 < argc)
+      {
+        bvhLeafSize = std::atoi(argv[++i]);
+        if (bvhLeafSize < 1)
+        {
+          std::cerr << "Warning: Invalid BVH leaf size " << bvhLeafSize << ", using 4" << std::endl;
+          bvhLeafSize = 4;
+        }
+      }
+    }
+    else if (arg == "--bvh-max-depth")
+    {
+      if (i + 1 < argc)
+      {
+        bvhMaxDepth = std::atoi(argv[++i]);
+        if (bvhMaxDepth < 1 || bvhMaxDepth > 63)
+        {
+          std::cerr << "Warning: Invalid BVH depth " << bvhMaxDepth << ", using 32" << std::endl;
+          bvhMaxDepth = 32;
+        }
+      }
+    }
+    else if (arg == "--split-triangles")
+    {
+      splitTriangles = true;
+    }
+    else if (arg == "--weld-edges-only")
+    {
+      weldEdgesOnly = true;
+    }
+    else if (arg == "--bvh-cache")
+    {
+      if (i + 1 < argc)
+        bvhCacheDir = argv[++i];
+    }
+    else if (arg == "--instancing")
+    {
+      useInstancing = true;
+    }
+    else if (arg == "--compact-uvs")
+    {
+      compactUVs = true;
+    }
+    else if (arg == "--curved-uvs")
+    {
+      curvedUVs = true;
+    }
+    else if (arg == "--no-analytic")
+    {
+      useAnalytic = false;
+    }
+    else if (arg == "--ray-packets")
+    {
+      useRayPackets = true;
+    }
+    else if (arg == "--no-ray-packets")
+    {
+      useRayPackets = false;
+    }
     else if (arg == "--openmp")
     {
       useOpenMP = true;
@@ -1135,15 +1279,46 @@ int main(int argc, char* argv[])
 
   std::cout << "\nBuilding BVH acceleration structure..." << std::endl;
 
-  // Tessellate the shape (always done, using default or user-specified deflection)
+  BRepIntCurveSurface_InterBVH raytracer;
+
+  // Configure backend and parallelization
+  raytracer.SetBackend(backend);
+  raytracer.SetBVHWidth(bvhWidth);
+  raytracer.SetBVHBuilder(bvhBuilder);
+  raytracer.SetBVHLeafSize(bvhLeafSize);
+  raytracer.SetBVHMaxDepth(bvhMaxDepth);
+  raytracer.SetUseTriangleSplits(splitTriangles);
+  raytracer.SetWeldEdgesOnly(weldEdgesOnly);
+  raytracer.SetBVHCacheDirectory(bvhCacheDir.c_str());
+  raytracer.SetUseInstancing(useInstancing);
+  raytracer.SetUseCompactUVs(compactUVs);
+  raytracer.SetUseCurvedUVs(curvedUVs);
+  raytracer.SetUseAnalyticSurfaces(useAnalytic);
+  raytracer.SetUseRayPackets(useRayPackets && bvhWidth == 2);
+  raytracer.SetUseOpenMP(useOpenMP);
+
+  // Tessellate the shape (always done, using default or user-specified deflection) and
+  // build the BVH, gathering the triangles of every meshed part while others are meshed
   std::cout << "Tessellating shape with deflection: " << deflection
             << ", angle: " << angularDeflection << " rad" << std::endl;
-  OSD_Timer meshTimer;
-  meshTimer.Start();
-  BRepMesh_IncrementalMesh mesher(shape, deflection, Standard_False, angularDeflection);
-  meshTimer.Stop();
-  std::cout << "Tessellation completed in " << std::fixed << std::setprecision(2)
-            << meshTimer.ElapsedTime() * 1000.0 << " ms" << std::endl;
+  OSD_Timer loadTimer;
+  loadTimer.Start();
+  raytracer.MeshAndLoad(shape, 0.001, deflection, angularDeflection);
+  loadTimer.Stop();
+
+  std::cout << (raytracer.IsBVHFromCache() ? "Tessellated and BVH loaded from cache in "
+                                           : "Tessellated and BVH built in ")
+            << std::fixed << std::setprecision(2) << loadTimer.ElapsedTime() * 1000.0 << " ms"
+            << std::endl;
+  std::cout << "Number of faces: " << raytracer.NbFaces() << std::endl;
+
+  const BRepIntCurveSurface_MemoryUsage memory = raytracer.MemoryUsage();
+  std::cout << "Memory: " << memory.Total() / 1024 << " KB (vertices "
+            << memory.Vertices / 1024 << ", elements " << memory.Elements / 1024 << ", nodes "
+            << memory.Nodes / 1024 << ", triangles " << memory.Triangles / 1024
+            << ", triangle info " << (memory.TriangleInfo + memory.UVNodes) / 1024
+            << ", adaptors " << memory.SurfaceAdaptors / 1024 << ", Embree "
+            << memory.Embree / 1024 << ")" << std::endl;
 
   // Export tessellation as STL if requested
   if (exportStl)
@@ -1158,21 +1333,6 @@ int main(int argc, char* argv[])
     }
   }
 
-  BRepIntCurveSurface_InterBVH raytracer;
-
-  // Configure backend and parallelization
-  raytracer.SetBackend(backend);
-  raytracer.SetUseOpenMP(useOpenMP);
-
-  OSD_Timer loadTimer;
-  loadTimer.Start();
-  raytracer.Load(shape, 0.001, deflection);
-  loadTimer.Stop();
-
-  std::cout << "BVH built in " << std::fixed << std::setprecision(2)
-            << loadTimer.ElapsedTime() * 1000.0 << " ms" << std::endl;
-  std::cout << "Number of faces: " << raytracer.NbFaces() << std::endl;
-
   // Output images if requested
   std::string outDir   = inputFile.empty() ? "." : GetDirectory(inputFile);
   std::string baseName = inputFile.empty() ? "sphere" : GetBasename(inputFile);